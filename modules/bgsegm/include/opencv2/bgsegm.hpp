@@ -87,6 +87,22 @@ CV_EXPORTS_W Ptr<BackgroundSubtractorMOG>
     createBackgroundSubtractorMOG(int history=200, int nmixtures=5,
                                   double backgroundRatio=0.7, double noiseSigma=0);
 
+/** @brief Updates several mixture-of-gaussian background subtractors in one call.
+
+The frames of all the streams are split into bands of rows that are processed by a single parallel
+loop, which keeps the threads busy even when each frame is too small to be worth parallelizing on
+its own. The result for each stream is the same as calling apply() on it.
+
+@param subtractors Distinct background subtractors created by createBackgroundSubtractorMOG(), one
+per stream.
+@param images Next frames of the streams, one per subtractor.
+@param fgmasks Output foreground masks, one per stream.
+@param learningRate Learning rate passed to every subtractor, see BackgroundSubtractor::apply.
+ */
+CV_EXPORTS void applyBackgroundSubtractorMOGBatch(const std::vector< Ptr<BackgroundSubtractorMOG> >& subtractors,
+                                                  InputArrayOfArrays images, OutputArrayOfArrays fgmasks,
+                                                  double learningRate=-1);
+
 
 /** @brief Background Subtractor module based on the algorithm given in @cite Gold2012 .
 
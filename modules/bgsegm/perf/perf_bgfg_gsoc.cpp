@@ -0,0 +1,58 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+CV_ENUM(MotionCompensation, LSBP_CAMERA_MOTION_COMPENSATION_NONE, LSBP_CAMERA_MOTION_COMPENSATION_LK)
+
+typedef tuple<std::string, MotionCompensation> BGSParams;
+typedef perf::TestBaseWithParam<BGSParams> BGS_GSOC_LSBP;
+
+static void generateFrames(std::vector<Mat>& frames, int count)
+{
+    Mat background = imread(getDataPath("cv/shared/fruits.png"));
+    Mat object = imread(getDataPath("cv/shared/baboon.png"));
+    ASSERT_FALSE(background.empty());
+    ASSERT_FALSE(object.empty());
+    resize(object, object, Size(100, 100), 0, 0, INTER_LINEAR_EXACT);
+    Ptr<SyntheticSequenceGenerator> generator = createSyntheticSequenceGenerator(background, object);
+
+    frames.resize(count);
+    Mat gtMask;
+    for (int i = 0; i < count; ++i)
+        generator->getNextFrame(frames[i], gtMask);
+}
+
+PERF_TEST_P(BGS_GSOC_LSBP, apply, testing::Combine(testing::Values("GSOC", "LSBP"), MotionCompensation::all()))
+{
+    const std::string algorithm = get<0>(GetParam());
+    const int mc = get<1>(GetParam());
+
+    std::vector<Mat> frames;
+    generateFrames(frames, 20);
+
+    Ptr<BackgroundSubtractor> bgs;
+    if (algorithm == "GSOC")
+        bgs = createBackgroundSubtractorGSOC(mc);
+    else
+        bgs = createBackgroundSubtractorLSBP(mc);
+
+    // build the background model outside of the measured loop
+    Mat fgMask;
+    for (size_t i = 0; i < frames.size() / 2; ++i)
+        bgs->apply(frames[i], fgMask);
+
+    size_t next = frames.size() / 2;
+    TEST_CYCLE()
+    {
+        bgs->apply(frames[next], fgMask);
+        if (++next == frames.size())
+            next = 0;
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -0,0 +1,82 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+static void generateNoisyFrames(std::vector<Mat>& frames, const Size& sz, int type, int count, RNG& rng)
+{
+    Mat background(sz, type);
+    rng.fill(background, RNG::UNIFORM, 0, 256);
+    frames.resize(count);
+    for (int i = 0; i < count; ++i)
+    {
+        Mat noise(sz, type);
+        rng.fill(noise, RNG::UNIFORM, 0, 10);
+        frames[i] = background + noise;
+        rectangle(frames[i], Rect(i * 4, sz.height / 4, sz.width / 8, sz.height / 4), Scalar::all(255), FILLED);
+    }
+}
+
+typedef tuple<Size, MatType> MOGParams;
+typedef perf::TestBaseWithParam<MOGParams> BGS_MOG;
+
+PERF_TEST_P(BGS_MOG, apply, testing::Combine(testing::Values(szVGA, sz1080p), testing::Values(CV_8UC1, CV_8UC3)))
+{
+    const Size sz = get<0>(GetParam());
+    const int type = get<1>(GetParam());
+
+    std::vector<Mat> frames;
+    generateNoisyFrames(frames, sz, type, 10, theRNG());
+
+    Ptr<BackgroundSubtractorMOG> mog = createBackgroundSubtractorMOG();
+    Mat fgMask;
+    for (size_t i = 0; i < frames.size(); ++i)
+        mog->apply(frames[i], fgMask);
+
+    size_t next = 0;
+    TEST_CYCLE()
+    {
+        mog->apply(frames[next], fgMask);
+        next = (next + 1) % frames.size();
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef tuple<int, bool> MOGBatchParams;
+typedef perf::TestBaseWithParam<MOGBatchParams> BGS_MOG_Batch;
+
+PERF_TEST_P(BGS_MOG_Batch, apply, testing::Combine(testing::Values(8, 32), testing::Bool()))
+{
+    const int nstreams = get<0>(GetParam());
+    const bool batched = get<1>(GetParam());
+    const int nframes = 4;
+
+    std::vector< std::vector<Mat> > streams(nstreams);
+    std::vector< Ptr<BackgroundSubtractorMOG> > mogs(nstreams);
+    for (int i = 0; i < nstreams; ++i)
+    {
+        generateNoisyFrames(streams[i], szQQVGA, CV_8UC3, nframes, theRNG());
+        mogs[i] = createBackgroundSubtractorMOG();
+    }
+
+    std::vector<Mat> frames(nstreams), fgMasks(nstreams);
+    int next = 0;
+    TEST_CYCLE()
+    {
+        for (int i = 0; i < nstreams; ++i)
+            frames[i] = streams[i][next];
+        if (batched)
+            applyBackgroundSubtractorMOGBatch(mogs, frames, fgMasks);
+        else
+            for (int i = 0; i < nstreams; ++i)
+                mogs[i]->apply(frames[i], fgMasks[i]);
+        next = (next + 1) % nframes;
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
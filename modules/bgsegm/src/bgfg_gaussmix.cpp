@@ -104,6 +104,12 @@ public:
     //! the update operator
     virtual void apply(InputArray image, OutputArray fgmask, double learningRate=0) CV_OVERRIDE;
 
+    //! (re)initializes the model if needed, counts the frame and returns the learning rate to use for it
+    double beginFrame(const Mat& image, double learningRate);
+
+    //! updates the model and computes the foreground mask for the given rows of the frame
+    void processRows(const Mat& image, Mat& fgmask, double learningRate, const Range& rowRange);
+
     //! re-initiaization method
     virtual void initialize(Size _frameSize, int _frameType)
     {
@@ -182,19 +188,19 @@ template<typename VT> struct MixData
 
 static void process8uC1( const Mat& image, Mat& fgmask, double learningRate,
                          Mat& bgmodel, int nmixtures, double backgroundRatio,
-                         double varThreshold, double noiseSigma )
+                         double varThreshold, double noiseSigma, const Range& rowRange )
 {
-    int x, y, k, k1, rows = image.rows, cols = image.cols;
+    int x, y, k, k1, cols = image.cols;
     float alpha = (float)learningRate, T = (float)backgroundRatio, vT = (float)varThreshold;
     int K = nmixtures;
-    MixData<float>* mptr = (MixData<float>*)bgmodel.data;
+    MixData<float>* mptr = (MixData<float>*)bgmodel.data + (size_t)rowRange.start*cols*K;
 
     const float w0 = (float)defaultInitialWeight;
     const float sk0 = (float)(w0/(defaultNoiseSigma*2));
     const float var0 = (float)(defaultNoiseSigma*defaultNoiseSigma*4);
     const float minVar = (float)(noiseSigma*noiseSigma);
 
-    for( y = 0; y < rows; y++ )
+    for( y = rowRange.start; y < rowRange.end; y++ )
     {
         const uchar* src = image.ptr<uchar>(y);
         uchar* dst = fgmask.ptr<uchar>(y);
@@ -310,9 +316,9 @@ static void process8uC1( const Mat& image, Mat& fgmask, double learningRate,
 
 static void process8uC3( const Mat& image, Mat& fgmask, double learningRate,
                          Mat& bgmodel, int nmixtures, double backgroundRatio,
-                         double varThreshold, double noiseSigma )
+                         double varThreshold, double noiseSigma, const Range& rowRange )
 {
-    int x, y, k, k1, rows = image.rows, cols = image.cols;
+    int x, y, k, k1, cols = image.cols;
     float alpha = (float)learningRate, T = (float)backgroundRatio, vT = (float)varThreshold;
     int K = nmixtures;
 
@@ -320,9 +326,9 @@ static void process8uC3( const Mat& image, Mat& fgmask, double learningRate,
     const float sk0 = (float)(w0/(defaultNoiseSigma*2*std::sqrt(3.)));
     const float var0 = (float)(defaultNoiseSigma*defaultNoiseSigma*4);
     const float minVar = (float)(noiseSigma*noiseSigma);
-    MixData<Vec3f>* mptr = (MixData<Vec3f>*)bgmodel.data;
+    MixData<Vec3f>* mptr = (MixData<Vec3f>*)bgmodel.data + (size_t)rowRange.start*cols*K;
 
-    for( y = 0; y < rows; y++ )
+    for( y = rowRange.start; y < rowRange.end; y++ )
     {
         const uchar* src = image.ptr<uchar>(y);
         uchar* dst = fgmask.ptr<uchar>(y);
@@ -437,28 +443,43 @@ static void process8uC3( const Mat& image, Mat& fgmask, double learningRate,
     }
 }
 
-void BackgroundSubtractorMOGImpl::apply(InputArray _image, OutputArray _fgmask, double learningRate)
+double BackgroundSubtractorMOGImpl::beginFrame(const Mat& image, double learningRate)
 {
-    Mat image = _image.getMat();
     bool needToInitialize = nframes == 0 || learningRate >= 1 || image.size() != frameSize || image.type() != frameType;
 
     if( needToInitialize )
         initialize(image.size(), image.type());
 
     CV_Assert( image.depth() == CV_8U );
-    _fgmask.create( image.size(), CV_8U );
-    Mat fgmask = _fgmask.getMat();
+    if( image.type() != CV_8UC1 && image.type() != CV_8UC3 )
+        CV_Error( Error::StsUnsupportedFormat, "Only 1- and 3-channel 8-bit images are supported in BackgroundSubtractorMOG" );
 
     ++nframes;
     learningRate = learningRate >= 0 && nframes > 1 ? learningRate : 1./std::min( nframes, history );
     CV_Assert(learningRate >= 0);
+    return learningRate;
+}
 
+void BackgroundSubtractorMOGImpl::processRows(const Mat& image, Mat& fgmask, double learningRate, const Range& rowRange)
+{
     if( image.type() == CV_8UC1 )
-        process8uC1( image, fgmask, learningRate, bgmodel, nmixtures, backgroundRatio, varThreshold, noiseSigma );
-    else if( image.type() == CV_8UC3 )
-        process8uC3( image, fgmask, learningRate, bgmodel, nmixtures, backgroundRatio, varThreshold, noiseSigma );
+        process8uC1( image, fgmask, learningRate, bgmodel, nmixtures, backgroundRatio, varThreshold, noiseSigma, rowRange );
     else
-        CV_Error( Error::StsUnsupportedFormat, "Only 1- and 3-channel 8-bit images are supported in BackgroundSubtractorMOG" );
+        process8uC3( image, fgmask, learningRate, bgmodel, nmixtures, backgroundRatio, varThreshold, noiseSigma, rowRange );
+}
+
+void BackgroundSubtractorMOGImpl::apply(InputArray _image, OutputArray _fgmask, double learningRate)
+{
+    Mat image = _image.getMat();
+    learningRate = beginFrame(image, learningRate);
+
+    _fgmask.create( image.size(), CV_8U );
+    Mat fgmask = _fgmask.getMat();
+
+    // every pixel owns its mixtures, so the rows can be updated independently
+    parallel_for_(Range(0, image.rows), [&](const Range& range) {
+        processRows(image, fgmask, learningRate, range);
+    }, image.total()/(double)(1<<16));
 }
 
 Ptr<BackgroundSubtractorMOG> createBackgroundSubtractorMOG(int history, int nmixtures,
@@ -467,6 +488,48 @@ Ptr<BackgroundSubtractorMOG> createBackgroundSubtractorMOG(int history, int nmix
     return makePtr<BackgroundSubtractorMOGImpl>(history, nmixtures, backgroundRatio, noiseSigma);
 }
 
+void applyBackgroundSubtractorMOGBatch(const std::vector< Ptr<BackgroundSubtractorMOG> >& subtractors,
+                                       InputArrayOfArrays _images, OutputArrayOfArrays _fgmasks, double learningRate)
+{
+    std::vector<Mat> images;
+    _images.getMatVector(images);
+    CV_Assert( images.size() == subtractors.size() );
+
+    const int nstreams = (int)images.size();
+    std::vector<BackgroundSubtractorMOGImpl*> impls(nstreams);
+    std::vector<double> learningRates(nstreams);
+    std::vector<Mat> fgmasks(nstreams);
+
+    _fgmasks.create( nstreams, 1, CV_8U, -1, true );
+    for( int i = 0; i < nstreams; i++ )
+    {
+        impls[i] = dynamic_cast<BackgroundSubtractorMOGImpl*>(subtractors[i].get());
+        CV_Assert( impls[i] != NULL );
+        for( int j = 0; j < i; j++ )
+            CV_Assert( impls[j] != impls[i] );
+
+        learningRates[i] = impls[i]->beginFrame(images[i], learningRate);
+        _fgmasks.create( images[i].size(), CV_8U, i, true );
+        fgmasks[i] = _fgmasks.getMat(i);
+    }
+
+    // split every stream into bands of rows and schedule the bands of all the streams
+    // in a single parallel loop, so that small frames still keep all the threads busy
+    const int bandRows = 16;
+    std::vector< std::pair<int, Range> > bands;
+    for( int i = 0; i < nstreams; i++ )
+        for( int y = 0; y < images[i].rows; y += bandRows )
+            bands.push_back(std::make_pair(i, Range(y, std::min(y + bandRows, images[i].rows))));
+
+    parallel_for_(Range(0, (int)bands.size()), [&](const Range& range) {
+        for( int b = range.start; b < range.end; b++ )
+        {
+            const int i = bands[b].first;
+            impls[i]->processRows(images[i], fgmasks[i], learningRates[i], bands[b].second);
+        }
+    });
+}
+
 }
 }
 
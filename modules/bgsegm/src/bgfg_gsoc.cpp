@@ -53,6 +53,8 @@
 #include <opencv2/calib3d.hpp>
 #include <iostream>
 #include "opencv2/core/cvdef.h"
+#include "opencv2/core/hal/intrin.hpp"
+#include <limits>
 
 namespace cv
 {
@@ -188,14 +190,14 @@ void FindSparseCorrLK(const Mat& src, const Mat& dst, std::vector<Point2f>& srcP
     dstPoints.resize(j);
 }
 
+// 20 bytes per sample; it was 32 with the unused descriptor and 64-bit time and hit counters.
 class BackgroundSampleGSOC {
 public:
     Point3f color;
-    int desc;
-    uint64 time;
-    uint64 hits;
+    unsigned time;
+    unsigned hits;
 
-    BackgroundSampleGSOC(Point3f c = Point3f(), int d = 0, uint64 t = 0, uint64 h = 0) : color(c), desc(d), time(t), hits(h) {}
+    BackgroundSampleGSOC(Point3f c = Point3f(), unsigned t = 0, unsigned h = 0) : color(c), time(t), hits(h) {}
 };
 
 class BackgroundSampleLSBP {
@@ -207,55 +209,52 @@ public:
     BackgroundSampleLSBP(Point3f c = Point3f(), int d = 0, float mdd = 1e9f) : color(c), desc(d), minDecisionDist(mdd) {}
 };
 
-template<typename BackgroundSampleType>
+// The samples are stored as a structure of arrays: each field of the sample has its own plane
+// holding nSamples consecutive values per pixel, so the per-pixel scans read contiguous memory.
 class BackgroundModel {
 protected:
-    std::vector<BackgroundSampleType> samples;
+    std::vector<Mat> planes;
     const Size size;
     const int nSamples;
     const int stride;
 
-public:
-    BackgroundModel(Size sz, int S) : size(sz), nSamples(S), stride(sz.width * S) {
-        samples.resize(sz.area() * S);
+    BackgroundModel(Size sz, int S, const int* types, int nPlanes) : planes(nPlanes), size(sz), nSamples(S), stride(sz.width * S) {
+        for (int p = 0; p < nPlanes; ++p)
+            planes[p].create(sz.height, stride, types[p]);
     }
 
-    void swap(BackgroundModel& bm) {
-        samples.swap(bm.samples);
+    int offset(int i, int j) const {
+        return i * stride + j * nSamples;
     }
 
-    void motionCompensation(const BackgroundModel& bm, const std::vector<Point2f>& points) {
-        for (int i = 0; i < size.height; ++i)
-                for (int j = 0; j < size.width; ++j) {
-                    Point2i p = points[j * size.height + i];
-                    if (p.x < 0)
-                        p.x = 0;
-                    if (p.y < 0)
-                        p.y = 0;
-                    if (p.x >= size.width)
-                        p.x = size.width - 1;
-                    if (p.y >= size.height)
-                        p.y = size.height - 1;
-
-                    for (int k = 0; k < nSamples; k++)
-                        samples[i * stride + j * nSamples + k] = bm.samples[p.y * stride + p.x * nSamples + k];
-                }
+    template<typename T> T* plane(int p) {
+        return planes[p].ptr<T>();
     }
 
-    const BackgroundSampleType& operator()(int k) const {
-        return samples[k];
+    template<typename T> const T* plane(int p) const {
+        return planes[p].ptr<T>();
     }
 
-    BackgroundSampleType& operator()(int k) {
-        return samples[k];
+public:
+    void swap(BackgroundModel& bm) {
+        planes.swap(bm.planes);
     }
 
-    const BackgroundSampleType& operator()(int i, int j, int k) const {
-        return samples[i * stride + j * nSamples + k];
-    }
+    void motionCompensation(const BackgroundModel& bm, const std::vector<Point2f>& points) {
+        CV_Assert(bm.planes.size() == planes.size() && bm.size == size && bm.nSamples == nSamples);
+        const size_t sampleBytes = nSamples * planes[0].elemSize();
+
+        parallel_for_(Range(0, size.height), [&](const Range& range) {
+            for (int i = range.start; i < range.end; ++i)
+                for (int j = 0; j < size.width; ++j) {
+                    Point2i p = points[j * size.height + i];
+                    p.x = std::min(std::max(p.x, 0), size.width - 1);
+                    p.y = std::min(std::max(p.y, 0), size.height - 1);
 
-    BackgroundSampleType& operator()(int i, int j, int k) {
-        return samples[i * stride + j * nSamples + k];
+                    for (size_t n = 0; n < planes.size(); ++n)
+                        memcpy(planes[n].ptr<int>(i) + j * nSamples, bm.planes[n].ptr<int>(p.y) + p.x * nSamples, sampleBytes);
+                }
+        });
     }
 
     Size getSize() const {
@@ -263,49 +262,116 @@ public:
     }
 };
 
-class BackgroundModelGSOC : public BackgroundModel<BackgroundSampleGSOC> {
+class BackgroundModelGSOC : public BackgroundModel {
+    enum { PLANE_X, PLANE_Y, PLANE_Z, PLANE_TIME, PLANE_HITS, NUM_PLANES };
+
+    static const int* planeTypes() {
+        static const int types[NUM_PLANES] = { CV_32F, CV_32F, CV_32F, CV_32S, CV_32S };
+        return types;
+    }
+
 public:
-    BackgroundModelGSOC(Size sz, int S) : BackgroundModel(sz, S) {};
+    BackgroundModelGSOC(Size sz, int S) : BackgroundModel(sz, S, planeTypes(), NUM_PLANES) {};
 
     float findClosest(int i, int j, const Point3f& color, int& indOut) const {
-        const int end = i * stride + (j + 1) * nSamples;
-        int minInd = i * stride + j * nSamples;
-        float minDist = L2sqdist(color - samples[minInd].color);
-        for (int k = minInd + 1; k < end; ++k) {
-            const float dist = L2sqdist(color - samples[k].color);
+        const int start = offset(i, j);
+        const float* cx = plane<float>(PLANE_X) + start;
+        const float* cy = plane<float>(PLANE_Y) + start;
+        const float* cz = plane<float>(PLANE_Z) + start;
+        int minInd = 0, k = 1;
+        float minDist = L2sqdist(color - Point3f(cx[0], cy[0], cz[0]));
+#if CV_SIMD128
+        if (nSamples >= 4) {
+            const v_float32x4 vx = v_setall_f32(color.x), vy = v_setall_f32(color.y), vz = v_setall_f32(color.z);
+            const v_int32x4 vStep = v_setall_s32(4);
+            v_int32x4 vInd(0, 1, 2, 3);
+            v_int32x4 vMinInd = vInd;
+            v_float32x4 vMinDist = v_setall_f32(std::numeric_limits<float>::infinity());
+            for (k = 0; k <= nSamples - 4; k += 4) {
+                const v_float32x4 dx = vx - v_load(cx + k), dy = vy - v_load(cy + k), dz = vz - v_load(cz + k);
+                const v_float32x4 dist = dx * dx + dy * dy + dz * dz;
+                const v_float32x4 mask = dist < vMinDist;
+                vMinDist = v_select(mask, dist, vMinDist);
+                vMinInd = v_select(v_reinterpret_as_s32(mask), vInd, vMinInd);
+                vInd += vStep;
+            }
+            float dists[4];
+            int inds[4];
+            v_store(dists, vMinDist);
+            v_store(inds, vMinInd);
+            // keep the first of equally close samples, as the sequential scan does
+            for (int l = 0; l < 4; ++l)
+                if (dists[l] < minDist || (dists[l] == minDist && inds[l] < minInd)) {
+                    minDist = dists[l];
+                    minInd = inds[l];
+                }
+        }
+#endif
+        for (; k < nSamples; ++k) {
+            const float dist = L2sqdist(color - Point3f(cx[k], cy[k], cz[k]));
             if (dist < minDist) {
                 minInd = k;
                 minDist = dist;
             }
         }
-        indOut = minInd;
+        indOut = start + minInd;
         return minDist;
     }
 
     void replaceOldest(int i, int j, const BackgroundSampleGSOC& sample) {
-        const int end = i * stride + (j + 1) * nSamples;
-        int minInd = i * stride + j * nSamples;
-        for (int k = minInd + 1; k < end; ++k) {
-            if (samples[k].time < samples[minInd].time)
+        const int start = offset(i, j);
+        const unsigned* time = plane<unsigned>(PLANE_TIME) + start;
+        int minInd = 0;
+        for (int k = 1; k < nSamples; ++k) {
+            if (time[k] < time[minInd])
                 minInd = k;
         }
-        samples[minInd] = sample;
+        set(start + minInd, sample);
+    }
+
+    // Pulls the sample towards the given color and marks it as hit at the given time
+    BackgroundSampleGSOC update(int k, const Point3f& color, double learningRate, unsigned currentTime) {
+        float& x = plane<float>(PLANE_X)[k];
+        float& y = plane<float>(PLANE_Y)[k];
+        float& z = plane<float>(PLANE_Z)[k];
+        x = float(x * (1 - learningRate)) + float(learningRate * color.x);
+        y = float(y * (1 - learningRate)) + float(learningRate * color.y);
+        z = float(z * (1 - learningRate)) + float(learningRate * color.z);
+        plane<unsigned>(PLANE_TIME)[k] = currentTime;
+        const unsigned hits = ++plane<unsigned>(PLANE_HITS)[k];
+        return BackgroundSampleGSOC(Point3f(x, y, z), currentTime, hits);
+    }
+
+    void set(int k, const BackgroundSampleGSOC& sample) {
+        plane<float>(PLANE_X)[k] = sample.color.x;
+        plane<float>(PLANE_Y)[k] = sample.color.y;
+        plane<float>(PLANE_Z)[k] = sample.color.z;
+        plane<unsigned>(PLANE_TIME)[k] = sample.time;
+        plane<unsigned>(PLANE_HITS)[k] = sample.hits;
+    }
+
+    void set(int i, int j, int k, const BackgroundSampleGSOC& sample) {
+        set(offset(i, j) + k, sample);
     }
 
     Point3f getMean(int i, int j, uint64 threshold) const {
-        const int end = i * stride + (j + 1) * nSamples;
+        const int start = offset(i, j);
+        const float* cx = plane<float>(PLANE_X) + start;
+        const float* cy = plane<float>(PLANE_Y) + start;
+        const float* cz = plane<float>(PLANE_Z) + start;
+        const unsigned* hits = plane<unsigned>(PLANE_HITS) + start;
         Point3f acc(0, 0, 0);
         int cnt = 0;
-        for (int k = i * stride + j * nSamples; k < end; ++k) {
-            if (samples[k].hits > threshold) {
-                acc += samples[k].color;
+        for (int k = 0; k < nSamples; ++k) {
+            if (hits[k] > threshold) {
+                acc += Point3f(cx[k], cy[k], cz[k]);
                 ++cnt;
             }
         }
         if (cnt == 0) {
             cnt = nSamples;
-            for (int k = i * stride + j * nSamples; k < end; ++k)
-                acc += samples[k].color;
+            for (int k = 0; k < nSamples; ++k)
+                acc += Point3f(cx[k], cy[k], cz[k]);
         }
         acc.x /= cnt;
         acc.y /= cnt;
@@ -314,17 +380,46 @@ public:
     }
 };
 
-class BackgroundModelLSBP : public BackgroundModel<BackgroundSampleLSBP> {
+class BackgroundModelLSBP : public BackgroundModel {
+    enum { PLANE_X, PLANE_Y, PLANE_Z, PLANE_DESC, PLANE_DIST, NUM_PLANES };
+
+    static const int* planeTypes() {
+        static const int types[NUM_PLANES] = { CV_32F, CV_32F, CV_32F, CV_32S, CV_32F };
+        return types;
+    }
+
 public:
-    BackgroundModelLSBP(Size sz, int S) : BackgroundModel(sz, S) {};
+    BackgroundModelLSBP(Size sz, int S) : BackgroundModel(sz, S, planeTypes(), NUM_PLANES) {};
 
     int countMatches(int i, int j, const Point3f& color, int desc, float threshold, int descThreshold, float& minDist) const {
-        const int end = i * stride + (j + 1) * nSamples;
-        int count = 0;
+        const int start = offset(i, j);
+        const float* cx = plane<float>(PLANE_X) + start;
+        const float* cy = plane<float>(PLANE_Y) + start;
+        const float* cz = plane<float>(PLANE_Z) + start;
+        const int* descs = plane<int>(PLANE_DESC) + start;
+        int count = 0, k = 0;
         minDist = 1e9;
-        for (int k = i * stride + j * nSamples; k < end; ++k) {
-            const float dist = L1dist(color - samples[k].color);
-            if (dist < threshold && LSBPDist32(static_cast<unsigned>(desc ^ samples[k].desc)) < descThreshold)
+#if CV_SIMD128
+        if (nSamples >= 4) {
+            const v_float32x4 vx = v_setall_f32(color.x), vy = v_setall_f32(color.y), vz = v_setall_f32(color.z);
+            const v_float32x4 vThreshold = v_setall_f32(threshold);
+            const v_int32x4 vDesc = v_setall_s32(desc), vDescThreshold = v_setall_s32(descThreshold);
+            v_float32x4 vMinDist = v_setall_f32(minDist);
+            v_int32x4 vCount = v_setzero_s32();
+            for (; k <= nSamples - 4; k += 4) {
+                const v_float32x4 dist = v_abs(vx - v_load(cx + k)) + v_abs(vy - v_load(cy + k)) + v_abs(vz - v_load(cz + k));
+                const v_int32x4 bits = v_reinterpret_as_s32(v_popcount(vDesc ^ v_load(descs + k)));
+                // matching lanes are all ones, i.e. -1
+                vCount -= v_reinterpret_as_s32(dist < vThreshold) & (bits < vDescThreshold);
+                vMinDist = v_min(vMinDist, dist);
+            }
+            count = v_reduce_sum(vCount);
+            minDist = v_reduce_min(vMinDist);
+        }
+#endif
+        for (; k < nSamples; ++k) {
+            const float dist = L1dist(color - Point3f(cx[k], cy[k], cz[k]));
+            if (dist < threshold && LSBPDist32(static_cast<unsigned>(desc ^ descs[k])) < descThreshold)
                 ++count;
             if (dist < minDist)
                 minDist = dist;
@@ -332,11 +427,23 @@ public:
         return count;
     }
 
+    void set(int i, int j, int k, const BackgroundSampleLSBP& sample) {
+        k += offset(i, j);
+        plane<float>(PLANE_X)[k] = sample.color.x;
+        plane<float>(PLANE_Y)[k] = sample.color.y;
+        plane<float>(PLANE_Z)[k] = sample.color.z;
+        plane<int>(PLANE_DESC)[k] = sample.desc;
+        plane<float>(PLANE_DIST)[k] = sample.minDecisionDist;
+    }
+
     Point3f getMean(int i, int j) const {
-        const int end = i * stride + (j + 1) * nSamples;
+        const int start = offset(i, j);
+        const float* cx = plane<float>(PLANE_X) + start;
+        const float* cy = plane<float>(PLANE_Y) + start;
+        const float* cz = plane<float>(PLANE_Z) + start;
         Point3f acc(0, 0, 0);
-        for (int k = i * stride + j * nSamples; k < end; ++k) {
-            acc += samples[k].color;
+        for (int k = 0; k < nSamples; ++k) {
+            acc += Point3f(cx[k], cy[k], cz[k]);
         }
         acc.x /= nSamples;
         acc.y /= nSamples;
@@ -345,10 +452,10 @@ public:
     }
 
     float getDMean(int i, int j) const {
-        const int end = i * stride + (j + 1) * nSamples;
+        const float* dists = plane<float>(PLANE_DIST) + offset(i, j);
         float d = 0;
-        for (int k = i * stride + j * nSamples; k < end; ++k)
-            d += samples[k].minDecisionDist;
+        for (int k = 0; k < nSamples; ++k)
+            d += dists[k];
 
         return d / nSamples;
     }
@@ -575,19 +682,15 @@ public:
             distMovingAvg.at<float>(i, j) += float(learningRate) * minDist;
 
             const float threshold = bgs->alpha * distMovingAvg.at<float>(i, j) + bgs->beta;
-            BackgroundSampleGSOC& sample = (* backgroundModel)(k);
 
             if (minDist > threshold) {
                 fgMask.at<uchar>(i, j) = 255;
 
                 if (bgs->rng.uniform(0.0f, 1.0f) < bgs->replaceRate)
-                    backgroundModel->replaceOldest(i, j, BackgroundSampleGSOC(frame.at<Point3f>(i, j), 0, bgs->currentTime));
+                    backgroundModel->replaceOldest(i, j, BackgroundSampleGSOC(frame.at<Point3f>(i, j), unsigned(bgs->currentTime)));
             }
             else {
-                sample.color *= 1 - learningRate;
-                sample.color += learningRate * frame.at<Point3f>(i, j);
-                sample.time = bgs->currentTime;
-                ++sample.hits;
+                const BackgroundSampleGSOC sample = backgroundModel->update(k, frame.at<Point3f>(i, j), learningRate, unsigned(bgs->currentTime));
 
                 // Propagation to neighbors
                 if (sample.hits > bgs->hitsThreshold && bgs->rng.uniform(0.0f, 1.0f) < bgs->propagationRate) {
@@ -649,14 +752,14 @@ public:
                 T.at<float>(i, j) -= bgs->Tdec / DMean;
 
                 if (bgs->rng.uniform(0.0f, 1.0f) < 1 / T.at<float>(i, j))
-                    (* backgroundModel)(i, j, bgs->rng.uniform(0, bgs->nSamples)) = BackgroundSampleLSBP(frame.at<Point3f>(i, j), LSBPDesc.at<int>(i, j), minDist);
+                    backgroundModel->set(i, j, bgs->rng.uniform(0, bgs->nSamples), BackgroundSampleLSBP(frame.at<Point3f>(i, j), LSBPDesc.at<int>(i, j), minDist));
 
                 if (bgs->rng.uniform(0.0f, 1.0f) < 1 / T.at<float>(i, j)) {
                     const int oi = i + bgs->rng.uniform(-1, 2);
                     const int oj = j + bgs->rng.uniform(-1, 2);
 
                     if (oi >= 0 && oi < sz.height && oj >= 0 && oj < sz.width)
-                        (* backgroundModel)(oi, oj, bgs->rng.uniform(0, bgs->nSamples)) = BackgroundSampleLSBP(frame.at<Point3f>(oi, oj), LSBPDesc.at<int>(oi, oj), minDist);
+                        backgroundModel->set(oi, oj, bgs->rng.uniform(0, bgs->nSamples), BackgroundSampleLSBP(frame.at<Point3f>(oi, oj), LSBPDesc.at<int>(oi, oj), minDist));
                 }
             }
 
@@ -736,10 +839,10 @@ void BackgroundSubtractorGSOCImpl::apply(InputArray _image, OutputArray _fgmask,
 
         for (int i = 0; i < sz.height; ++i)
             for (int j = 0; j < sz.width; ++j) {
-                BackgroundSampleGSOC sample(frame.at<Point3f>(i, j), 0);
+                BackgroundSampleGSOC sample(frame.at<Point3f>(i, j));
                 for (int k = 0; k < nSamples; ++k) {
-                    (* backgroundModel)(i, j, k) = sample;
-                    (* backgroundModelPrev)(i, j, k) = sample;
+                    backgroundModel->set(i, j, k, sample);
+                    backgroundModelPrev->set(i, j, k, sample);
                 }
             }
     }
@@ -788,7 +891,7 @@ void BackgroundSubtractorGSOCImpl::apply(InputArray _image, OutputArray _fgmask,
     for (int i = 0; i < sz.height; ++i)
         for (int j = 0; j < sz.width; ++j)
             if (rng.uniform(0.0f, 1.0f) < prob.at<float>(i, j))
-                backgroundModel->replaceOldest(i, j, BackgroundSampleGSOC(frame.at<Point3f>(i, j), 0, currentTime));
+                backgroundModel->replaceOldest(i, j, BackgroundSampleGSOC(frame.at<Point3f>(i, j), unsigned(currentTime)));
 
     this->postprocessing(fgMask);
 }
@@ -885,8 +988,8 @@ void BackgroundSubtractorLSBPImpl::apply(InputArray _image, OutputArray _fgmask,
             for (int j = 0; j < sz.width; ++j) {
                 BackgroundSampleLSBP sample(frame.at<Point3f>(i, j), LSBPDesc.at<int>(i, j));
                 for (int k = 0; k < nSamples; ++k) {
-                    (* backgroundModel)(i, j, k) = sample;
-                    (* backgroundModelPrev)(i, j, k) = sample;
+                    backgroundModel->set(i, j, k, sample);
+                    backgroundModelPrev->set(i, j, k, sample);
                 }
             }
     }
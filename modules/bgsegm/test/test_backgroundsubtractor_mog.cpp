@@ -0,0 +1,66 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+// Streams of different sizes and types learn a noisy static background, then an object appears.
+// The variance of every Gaussian stays above noiseSigma^2, so the noise is always background and
+// the object, far brighter than any background pixel, is always foreground.
+TEST(BackgroundSubtractor_MOG, batch_detects_object)
+{
+    const int nstreams = 5;
+    RNG& rng = theRNG();
+    std::vector< Ptr<BackgroundSubtractorMOG> > batched, single;
+    std::vector<Mat> backgrounds;
+    std::vector<Rect> objects;
+    for (int i = 0; i < nstreams; ++i)
+    {
+        batched.push_back(createBackgroundSubtractorMOG());
+        single.push_back(createBackgroundSubtractorMOG());
+        Mat background(61 + i * 7, 83, i % 2 ? CV_8UC3 : CV_8UC1);
+        rng.fill(background, RNG::UNIFORM, 0, 128);
+        backgrounds.push_back(background);
+        // cross the borders of the 16 row bands of the batch update
+        objects.push_back(Rect(5 + i * 9, 10 + i * 3, 20, 25));
+    }
+
+    for (int frameNum = 0; frameNum <= 21; ++frameNum)
+    {
+        const bool withObject = frameNum == 20;
+        std::vector<Mat> frames(nstreams);
+        for (int i = 0; i < nstreams; ++i)
+        {
+            Mat noise(backgrounds[i].size(), backgrounds[i].type());
+            rng.fill(noise, RNG::UNIFORM, 0, 8);
+            frames[i] = backgrounds[i] + noise;
+            if (withObject)
+                frames[i](objects[i]).setTo(Scalar::all(255));
+        }
+
+        std::vector<Mat> masks;
+        applyBackgroundSubtractorMOGBatch(batched, frames, masks);
+        ASSERT_EQ((size_t)nstreams, masks.size());
+
+        for (int i = 0; i < nstreams; ++i)
+        {
+            ASSERT_EQ(CV_8UC1, masks[i].type());
+            ASSERT_EQ(frames[i].size(), masks[i].size());
+            if (frameNum >= 19)
+            {
+                // the object is learnt with a weight of 1/21 only, so the next frame is background again
+                Mat expected = Mat::zeros(frames[i].size(), CV_8UC1);
+                if (withObject)
+                    expected(objects[i]).setTo(Scalar::all(255));
+                EXPECT_EQ(0, cvtest::norm(expected, masks[i], NORM_INF)) << "stream " << i << ", frame " << frameNum;
+            }
+
+            Mat mask;
+            single[i]->apply(frames[i], mask);
+            EXPECT_EQ(0, cvtest::norm(mask, masks[i], NORM_INF)) << "stream " << i << ", frame " << frameNum;
+        }
+    }
+}
+
+}} // namespace
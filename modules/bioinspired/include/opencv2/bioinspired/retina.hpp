@@ -447,6 +447,19 @@ public:
                                            const float reductionFactor=1.0f, const float samplingStrength=10.0f);
 };
 
+/** @brief Runs several retina models, one per video stream, on their next frames.
+
+The streams are processed concurrently, one thread per stream, which keeps the cores busy when the
+frames are too small for the parallel filters of a single retina to scale. Each retina keeps its own
+spatio-temporal state, so the outputs are the same as calling Retina::run on every stream and are
+retrieved with the getParvo and getMagno methods of each retina. OpenCL (UMat) inputs are processed one
+stream after the other.
+
+@param retinas Distinct retina instances, one per stream.
+@param inputImages Next frames of the streams, one per retina, see Retina::run for the supported formats.
+ */
+CV_EXPORTS void runRetinaBatch(const std::vector< Ptr<Retina> >& retinas, InputArrayOfArrays inputImages);
+
 //! @}
 
 }
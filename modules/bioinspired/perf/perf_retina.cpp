@@ -0,0 +1,65 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef tuple<Size, bool> RetinaRunParams;
+typedef TestBaseWithParam<RetinaRunParams> RetinaRunFixture;
+
+PERF_TEST_P(RetinaRunFixture, run,
+            testing::Combine(testing::Values(szVGA, sz720p), testing::Bool()))
+{
+    const Size sz = get<0>(GetParam());
+    const bool colorMode = get<1>(GetParam());
+
+    Mat input(sz, colorMode ? CV_8UC3 : CV_8UC1);
+    declare.in(input, WARMUP_RNG);
+
+    Ptr<bioinspired::Retina> retina = bioinspired::Retina::create(sz, colorMode);
+    Mat parvo, magno;
+
+    TEST_CYCLE()
+    {
+        retina->run(input);
+        retina->getParvo(parvo);
+        retina->getMagno(magno);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef tuple<int, bool> RetinaBatchParams;
+typedef TestBaseWithParam<RetinaBatchParams> RetinaBatchFixture;
+
+PERF_TEST_P(RetinaBatchFixture, runBatch,
+            testing::Combine(testing::Values(4, 16), testing::Bool()))
+{
+    const int nbStreams = get<0>(GetParam());
+    const bool batched = get<1>(GetParam());
+    const Size sz = szQVGA;
+
+    std::vector<Mat> frames(nbStreams);
+    std::vector< Ptr<bioinspired::Retina> > retinas;
+    RNG& rng = theRNG();
+    for (int i = 0; i < nbStreams; i++)
+    {
+        frames[i].create(sz, CV_8UC3);
+        rng.fill(frames[i], RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+        retinas.push_back(bioinspired::Retina::create(sz, true));
+    }
+
+    TEST_CYCLE()
+    {
+        if (batched)
+            bioinspired::runRetinaBatch(retinas, frames);
+        else
+            for (int i = 0; i < nbStreams; i++)
+                retinas[i]->run(frames[i]);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -521,71 +521,70 @@ void BasicRetinaFilter::_horizontalAnticausalFilter_multGain(float *outputFrame,
     }
 }
 
-//  vertical anticausal filter
-void BasicRetinaFilter::_verticalCausalFilter(float *outputFrame, unsigned int IDcolumnStart, unsigned int IDcolumnEnd)
+// 1D vertical filter kernel: the filter state of each column is kept in a small buffer and the frame is scanned
+// row by row, so the loads are contiguous and several columns are filtered at once in the SIMD lanes
+void BasicRetinaFilter::_verticalFilterColumns(float *outputFrame, const unsigned int nbRows, const unsigned int nbColumns, const int IDcolumnStart, const int IDcolumnEnd, const bool anticausal, const float a, const float *spatialConstants, const float gain, const float *gains)
 {
-#ifdef MAKE_PARALLEL
-        cv::parallel_for_(cv::Range(IDcolumnStart,IDcolumnEnd), Parallel_verticalCausalFilter(outputFrame, _filterOutput.getNBrows(), _filterOutput.getNBcolumns(), _a ));
-#else
-        for (unsigned int IDcolumn=IDcolumnStart; IDcolumn<IDcolumnEnd; ++IDcolumn)
-    {
-        float result=0;
-        float *outputPTR=outputFrame+IDcolumn;
-
-        for (unsigned int index=0; index<_filterOutput.getNBrows(); ++index)
+    const int width=IDcolumnEnd-IDcolumnStart;
+    if (width<=0)
+        return;
+    cv::AutoBuffer<float> resultBuffer(width);
+    float *result=resultBuffer.data();
+    std::fill(result, result+width, 0.f);
+
+    for (unsigned int index=0; index<nbRows; ++index)
+    {
+        const size_t rowOffset=(size_t)(anticausal ? nbRows-1-index : index)*nbColumns+IDcolumnStart;
+        float *outputPTR=outputFrame+rowOffset;
+        const float *spatialConstantPTR=spatialConstants ? spatialConstants+rowOffset : NULL;
+        const float *gainPTR=gains ? gains+rowOffset : NULL;
+        int IDcolumn=0;
+#if CV_SIMD128
+        const v_float32x4 v_a=v_setall_f32(a), v_gain=v_setall_f32(gain);
+        for (; IDcolumn<=width-4; IDcolumn+=4)
         {
-            result = *(outputPTR) + _a * result;
-            *(outputPTR) = result;
-            outputPTR+=_filterOutput.getNBcolumns();
-
+            const v_float32x4 v_constant=spatialConstantPTR ? v_load(spatialConstantPTR+IDcolumn) : v_a;
+            const v_float32x4 v_result=v_load(outputPTR+IDcolumn)+v_constant*v_load(result+IDcolumn);
+            v_store(result+IDcolumn, v_result);
+            v_store(outputPTR+IDcolumn, (gainPTR ? v_load(gainPTR+IDcolumn) : v_gain)*v_result);
+        }
+#endif
+        for (; IDcolumn<width; ++IDcolumn)
+        {
+            result[IDcolumn] = outputPTR[IDcolumn] + (spatialConstantPTR ? spatialConstantPTR[IDcolumn] : a) * result[IDcolumn];
+            outputPTR[IDcolumn] = (gainPTR ? gainPTR[IDcolumn] : gain)*result[IDcolumn];
         }
     }
+}
+
+void BasicRetinaFilter::_runVerticalFilter(float *outputFrame, unsigned int IDcolumnStart, unsigned int IDcolumnEnd, const bool anticausal, const float a, const float *spatialConstants, const float gain, const float *gains)
+{
+#ifdef MAKE_PARALLEL
+    // blocks of at least 16 columns, a stripe per column would leave the vector units idle
+    const double nstripes=std::max(1., std::min((double)std::max(1, cv::getNumThreads())*4., (IDcolumnEnd-IDcolumnStart)/16.));
+    cv::parallel_for_(cv::Range(IDcolumnStart,IDcolumnEnd), Parallel_verticalFilter(outputFrame, _filterOutput.getNBrows(), _filterOutput.getNBcolumns(), anticausal, a, spatialConstants, gain, gains), nstripes);
+#else
+    _verticalFilterColumns(outputFrame, _filterOutput.getNBrows(), _filterOutput.getNBcolumns(), IDcolumnStart, IDcolumnEnd, anticausal, a, spatialConstants, gain, gains);
 #endif
 }
 
+//  vertical causal filter
+void BasicRetinaFilter::_verticalCausalFilter(float *outputFrame, unsigned int IDcolumnStart, unsigned int IDcolumnEnd)
+{
+    _runVerticalFilter(outputFrame, IDcolumnStart, IDcolumnEnd, false, _a, NULL, 1.f, NULL);
+}
+
 
 //  vertical anticausal filter (basic way, no add on)
 void BasicRetinaFilter::_verticalAnticausalFilter(float *outputFrame, unsigned int IDcolumnStart, unsigned int IDcolumnEnd)
 {
-    float* offset=outputFrame+_filterOutput.getNBpixels()-_filterOutput.getNBcolumns();
-    //#pragma omp parallel for
-    for (unsigned int IDcolumn=IDcolumnStart; IDcolumn<IDcolumnEnd; ++IDcolumn)
-    {
-        float result=0;
-        float *outputPTR=offset+IDcolumn;
-
-        for (unsigned int index=0; index<_filterOutput.getNBrows(); ++index)
-        {
-            result = *(outputPTR) + _a * result;
-            *(outputPTR) = result;
-            outputPTR-=_filterOutput.getNBcolumns();
-
-        }
-    }
+    _runVerticalFilter(outputFrame, IDcolumnStart, IDcolumnEnd, true, _a, NULL, 1.f, NULL);
 }
 
 //  vertical anticausal filter which multiplies the output by _gain
 void BasicRetinaFilter::_verticalAnticausalFilter_multGain(float *outputFrame, unsigned int IDcolumnStart, unsigned int IDcolumnEnd)
 {
-#ifdef MAKE_PARALLEL
-        cv::parallel_for_(cv::Range(IDcolumnStart,IDcolumnEnd), Parallel_verticalAnticausalFilter_multGain(outputFrame, _filterOutput.getNBrows(), _filterOutput.getNBcolumns(), _a, _gain ));
-#else
-        float* offset=outputFrame+_filterOutput.getNBpixels()-_filterOutput.getNBcolumns();
-    //#pragma omp parallel for
-    for (unsigned int IDcolumn=IDcolumnStart; IDcolumn<IDcolumnEnd; ++IDcolumn)
-    {
-        float result=0;
-        float *outputPTR=offset+IDcolumn;
-
-        for (unsigned int index=0; index<_filterOutput.getNBrows(); ++index)
-        {
-            result = *(outputPTR) + _a * result;
-            *(outputPTR) = _gain*result;
-            outputPTR-=_filterOutput.getNBcolumns();
-
-        }
-    }
-#endif
+    _runVerticalFilter(outputFrame, IDcolumnStart, IDcolumnEnd, true, _a, NULL, _gain, NULL);
 }
 
 /////////////////////////////////////////
@@ -594,41 +593,36 @@ void BasicRetinaFilter::_verticalAnticausalFilter_multGain(float *outputFrame, u
 // -> squaring horizontal causal filter
 void BasicRetinaFilter::_squaringHorizontalCausalFilter(const float *inputFrame, float *outputFrame, unsigned int IDrowStart, unsigned int IDrowEnd)
 {
-    float* outputPTR=outputFrame+IDrowStart*_filterOutput.getNBcolumns();
-    const float* inputPTR=inputFrame+IDrowStart*_filterOutput.getNBcolumns();
-    for (unsigned int IDrow=IDrowStart; IDrow<IDrowEnd; ++IDrow)
+    const unsigned int nbColumns=_filterOutput.getNBcolumns();
+    const float a=_a, tau=_tau;
+    auto filterRows=[&](const cv::Range& r)
     {
-        float result=0;
-        for (unsigned int index=0; index<_filterOutput.getNBcolumns(); ++index)
+        for (int IDrow=r.start; IDrow<r.end; ++IDrow)
         {
-            result = *(inputPTR)**(inputPTR) + _tau**(outputPTR)+  _a* result;
-            *(outputPTR++) = result;
-            ++inputPTR;
+            float* outputPTR=outputFrame+(size_t)IDrow*nbColumns;
+            const float* inputPTR=inputFrame+(size_t)IDrow*nbColumns;
+            float result=0;
+            for (unsigned int index=0; index<nbColumns; ++index)
+            {
+                result = *(inputPTR)**(inputPTR) + tau**(outputPTR)+  a* result;
+                *(outputPTR++) = result;
+                ++inputPTR;
+            }
         }
-    }
+    };
+#ifdef MAKE_PARALLEL
+    cv::parallel_for_(cv::Range(IDrowStart,IDrowEnd), filterRows);
+#else
+    filterRows(cv::Range(IDrowStart,IDrowEnd));
+#endif
 }
 
 //  vertical anticausal filter that returns the mean value of its result
 float BasicRetinaFilter::_verticalAnticausalFilter_returnMeanValue(float *outputFrame, unsigned int IDcolumnStart, unsigned int IDcolumnEnd)
 {
-    float meanValue=0;
-    float* offset=outputFrame+_filterOutput.getNBpixels()-_filterOutput.getNBcolumns();
-    for (unsigned int IDcolumn=IDcolumnStart; IDcolumn<IDcolumnEnd; ++IDcolumn)
-    {
-        float result=0;
-        float *outputPTR=offset+IDcolumn;
-
-        for (unsigned int index=0; index<_filterOutput.getNBrows(); ++index)
-        {
-            result = *(outputPTR) + _a * result;
-            *(outputPTR) = _gain*result;
-            meanValue+=*(outputPTR);
-            outputPTR-=_filterOutput.getNBcolumns();
-
-        }
-    }
-
-    return meanValue/(float)_filterOutput.getNBpixels();
+    _runVerticalFilter(outputFrame, IDcolumnStart, IDcolumnEnd, true, _a, NULL, _gain, NULL);
+    const cv::Mat outputColumns=cv::Mat((int)_filterOutput.getNBrows(), (int)_filterOutput.getNBcolumns(), CV_32F, outputFrame).colRange((int)IDcolumnStart, (int)IDcolumnEnd);
+    return (float)(cv::sum(outputColumns)[0]/(double)_filterOutput.getNBpixels());
 }
 
 // LP filter with integration in specific areas (regarding true values of a binary parameters image)
@@ -786,35 +780,55 @@ void BasicRetinaFilter::_spatiotemporalLPfilter_Irregular(const float *inputFram
 //  horizontal causal filter wich runs on its input buffer
 void BasicRetinaFilter::_horizontalCausalFilter_Irregular(float *outputFrame, unsigned int IDrowStart, unsigned int IDrowEnd)
 {
-    float* outputPTR=outputFrame+IDrowStart*_filterOutput.getNBcolumns();
-    const float* spatialConstantPTR=&_progressiveSpatialConstant[0]+IDrowStart*_filterOutput.getNBcolumns();
-    for (unsigned int IDrow=IDrowStart; IDrow<IDrowEnd; ++IDrow)
+    const unsigned int nbColumns=_filterOutput.getNBcolumns();
+    const float* spatialConstants=&_progressiveSpatialConstant[0];
+    auto filterRows=[&](const cv::Range& r)
     {
-        float result=0;
-        for (unsigned int index=0; index<_filterOutput.getNBcolumns(); ++index)
+        for (int IDrow=r.start; IDrow<r.end; ++IDrow)
         {
-            result = *(outputPTR)+  *(spatialConstantPTR++)* result;
-            *(outputPTR++) = result;
+            float* outputPTR=outputFrame+(size_t)IDrow*nbColumns;
+            const float* spatialConstantPTR=spatialConstants+(size_t)IDrow*nbColumns;
+            float result=0;
+            for (unsigned int index=0; index<nbColumns; ++index)
+            {
+                result = *(outputPTR)+  *(spatialConstantPTR++)* result;
+                *(outputPTR++) = result;
+            }
         }
-    }
+    };
+#ifdef MAKE_PARALLEL
+    cv::parallel_for_(cv::Range(IDrowStart,IDrowEnd), filterRows);
+#else
+    filterRows(cv::Range(IDrowStart,IDrowEnd));
+#endif
 }
 
 // horizontal causal filter with add input
 void BasicRetinaFilter::_horizontalCausalFilter_Irregular_addInput(const float *inputFrame, float *outputFrame, unsigned int IDrowStart, unsigned int IDrowEnd)
 {
-    float* outputPTR=outputFrame+IDrowStart*_filterOutput.getNBcolumns();
-    const float* inputPTR=inputFrame+IDrowStart*_filterOutput.getNBcolumns();
-    const float* spatialConstantPTR=&_progressiveSpatialConstant[0]+IDrowStart*_filterOutput.getNBcolumns();
-    for (unsigned int IDrow=IDrowStart; IDrow<IDrowEnd; ++IDrow)
+    const unsigned int nbColumns=_filterOutput.getNBcolumns();
+    const float* spatialConstants=&_progressiveSpatialConstant[0];
+    const float tau=_tau;
+    auto filterRows=[&](const cv::Range& r)
     {
-        float result=0;
-        for (unsigned int index=0; index<_filterOutput.getNBcolumns(); ++index)
+        for (int IDrow=r.start; IDrow<r.end; ++IDrow)
         {
-            result = *(inputPTR++) + _tau**(outputPTR)+  *(spatialConstantPTR++)* result;
-            *(outputPTR++) = result;
+            float* outputPTR=outputFrame+(size_t)IDrow*nbColumns;
+            const float* inputPTR=inputFrame+(size_t)IDrow*nbColumns;
+            const float* spatialConstantPTR=spatialConstants+(size_t)IDrow*nbColumns;
+            float result=0;
+            for (unsigned int index=0; index<nbColumns; ++index)
+            {
+                result = *(inputPTR++) + tau**(outputPTR)+  *(spatialConstantPTR++)* result;
+                *(outputPTR++) = result;
+            }
         }
-    }
-
+    };
+#ifdef MAKE_PARALLEL
+    cv::parallel_for_(cv::Range(IDrowStart,IDrowEnd), filterRows);
+#else
+    filterRows(cv::Range(IDrowStart,IDrowEnd));
+#endif
 }
 
 //  horizontal anticausal filter  (basic way, no add on)
@@ -839,50 +853,16 @@ void BasicRetinaFilter::_horizontalAnticausalFilter_Irregular(float *outputFrame
 
 }
 
-//  vertical anticausal filter
+//  vertical causal filter
 void BasicRetinaFilter::_verticalCausalFilter_Irregular(float *outputFrame, unsigned int IDcolumnStart, unsigned int IDcolumnEnd, const float *spatialConstantBuffer)
 {
-#ifdef MAKE_PARALLEL
-        cv::parallel_for_(cv::Range(IDcolumnStart,IDcolumnEnd), Parallel_verticalCausalFilter_Irregular(outputFrame, spatialConstantBuffer, _filterOutput.getNBrows(), _filterOutput.getNBcolumns()));
-#else
-    for (unsigned int IDcolumn=IDcolumnStart; IDcolumn<IDcolumnEnd; ++IDcolumn)
-    {
-        float result=0;
-        float *outputPTR=outputFrame+IDcolumn;
-        const float *spatialConstantPTR=spatialConstantBuffer+IDcolumn;
-        for (unsigned int index=0; index<_filterOutput.getNBrows(); ++index)
-        {
-            result = *(outputPTR) + *(spatialConstantPTR) * result;
-            *(outputPTR) = result;
-            outputPTR+=_filterOutput.getNBcolumns();
-            spatialConstantPTR+=_filterOutput.getNBcolumns();
-        }
-    }
-#endif
+    _runVerticalFilter(outputFrame, IDcolumnStart, IDcolumnEnd, false, 0.f, spatialConstantBuffer, 1.f, NULL);
 }
 
 //  vertical anticausal filter which multiplies the output by _gain
 void BasicRetinaFilter::_verticalAnticausalFilter_Irregular_multGain(float *outputFrame, unsigned int IDcolumnStart, unsigned int IDcolumnEnd)
 {
-    float* outputOffset=outputFrame+_filterOutput.getNBpixels()-_filterOutput.getNBcolumns();
-    const float* constantOffset=&_progressiveSpatialConstant[0]+_filterOutput.getNBpixels()-_filterOutput.getNBcolumns();
-    const float* gainOffset=&_progressiveGain[0]+_filterOutput.getNBpixels()-_filterOutput.getNBcolumns();
-    for (unsigned int IDcolumn=IDcolumnStart; IDcolumn<IDcolumnEnd; ++IDcolumn)
-    {
-        float result=0;
-        float *outputPTR=outputOffset+IDcolumn;
-        const float *spatialConstantPTR=constantOffset+IDcolumn;
-        const float *progressiveGainPTR=gainOffset+IDcolumn;
-        for (unsigned int index=0; index<_filterOutput.getNBrows(); ++index)
-        {
-            result = *(outputPTR) + *(spatialConstantPTR) * result;
-            *(outputPTR) = *(progressiveGainPTR)*result;
-            outputPTR-=_filterOutput.getNBcolumns();
-            spatialConstantPTR-=_filterOutput.getNBcolumns();
-            progressiveGainPTR-=_filterOutput.getNBcolumns();
-        }
-    }
-
+    _runVerticalFilter(outputFrame, IDcolumnStart, IDcolumnEnd, true, 0.f, &_progressiveSpatialConstant[0], 0.f, &_progressiveGain[0]);
 }
 }// end of namespace bioinspired
 }// end of namespace cv
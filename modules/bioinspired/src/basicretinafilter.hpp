@@ -109,6 +109,7 @@
 
 #include <iostream>
 #include "templatebuffer.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 //#define __BASIC_RETINA_ELEMENT_DEBUG
 
@@ -447,6 +448,13 @@ namespace bioinspired
         void _verticalAnticausalFilter_Irregular_multGain(float *outputFrame, unsigned int IDcolumnStart, unsigned int IDcolumnEnd);
 
 
+        // 1D vertical filter kernel shared by all the vertical filters: the columns [IDcolumnStart, IDcolumnEnd) are
+        // processed row after row so that neighbouring columns are filtered together in the SIMD lanes
+        // spatialConstants and gains are either frame sized buffers or NULL to use the scalar a and gain values
+        static void _verticalFilterColumns(float *outputFrame, const unsigned int nbRows, const unsigned int nbColumns, const int IDcolumnStart, const int IDcolumnEnd, const bool anticausal, const float a, const float *spatialConstants, const float gain, const float *gains);
+        // runs _verticalFilterColumns on the columns [IDcolumnStart, IDcolumnEnd), the columns are split in blocks processed in parallel
+        void _runVerticalFilter(float *outputFrame, unsigned int IDcolumnStart, unsigned int IDcolumnEnd, const bool anticausal, const float a, const float *spatialConstants, const float gain, const float *gains);
+
         // 1D filters in which the output is multiplied by _gain
         void _verticalAnticausalFilter_multGain(float *outputFrame, unsigned int IDcolumnStart, unsigned int IDcolumnEnd); // this functions affects _gain at the output // parallelized with TBB
         void _horizontalAnticausalFilter_multGain(float *outputFrame, unsigned int IDcolumnStart, unsigned int IDcolumnEnd); // this functions affects _gain at the output
@@ -535,58 +543,20 @@ namespace bioinspired
             }
         };
 
-        class Parallel_verticalCausalFilter: public cv::ParallelLoopBody
-        {
-        private:
-            float *outputFrame;
-            unsigned int nbRows, nbColumns;
-            float filterParam_a;
-        public:
-            Parallel_verticalCausalFilter(float *bufferToProcess, const unsigned int nbRws, const unsigned int nbCols, const float a )
-                :outputFrame(bufferToProcess), nbRows(nbRws), nbColumns(nbCols), filterParam_a(a){}
-
-            virtual void operator()( const Range& r ) const CV_OVERRIDE {
-                for (int IDcolumn=r.start; IDcolumn!=r.end; ++IDcolumn)
-                {
-                    float result=0;
-                    float *outputPTR=outputFrame+IDcolumn;
-
-                    for (unsigned int index=0; index<nbRows; ++index)
-                    {
-                        result = *(outputPTR) + filterParam_a * result;
-                        *(outputPTR) = result;
-                        outputPTR+=nbColumns;
-
-                    }
-                }
-            }
-        };
-
-        class Parallel_verticalAnticausalFilter_multGain: public cv::ParallelLoopBody
+        class Parallel_verticalFilter: public cv::ParallelLoopBody
         {
         private:
             float *outputFrame;
+            const float *spatialConstants, *gains;
             unsigned int nbRows, nbColumns;
+            bool anticausal;
             float filterParam_a, filterParam_gain;
         public:
-            Parallel_verticalAnticausalFilter_multGain(float *bufferToProcess, const unsigned int nbRws, const unsigned int nbCols, const float a, const float  gain)
-                :outputFrame(bufferToProcess), nbRows(nbRws), nbColumns(nbCols), filterParam_a(a), filterParam_gain(gain){}
+            Parallel_verticalFilter(float *bufferToProcess, const unsigned int nbRws, const unsigned int nbCols, const bool anticausalFilter, const float a, const float *spatialConst, const float gain, const float *gainBuffer)
+                :outputFrame(bufferToProcess), spatialConstants(spatialConst), gains(gainBuffer), nbRows(nbRws), nbColumns(nbCols), anticausal(anticausalFilter), filterParam_a(a), filterParam_gain(gain){}
 
             virtual void operator()( const Range& r ) const CV_OVERRIDE {
-                float* offset=outputFrame+nbColumns*nbRows-nbColumns;
-                for (int IDcolumn=r.start; IDcolumn!=r.end; ++IDcolumn)
-                {
-                    float result=0;
-                    float *outputPTR=offset+IDcolumn;
-
-                    for (unsigned int index=0; index<nbRows; ++index)
-                    {
-                        result = *(outputPTR) + filterParam_a * result;
-                        *(outputPTR) = filterParam_gain*result;
-                        outputPTR-=nbColumns;
-
-                    }
-                }
+                _verticalFilterColumns(outputFrame, nbRows, nbColumns, r.start, r.end, anticausal, filterParam_a, spatialConstants, filterParam_gain, gains);
             }
         };
 
@@ -642,33 +612,6 @@ namespace bioinspired
             }
         };
 
-        class Parallel_verticalCausalFilter_Irregular: public cv::ParallelLoopBody
-        {
-        private:
-            float *outputFrame;
-            const float *spatialConstantBuffer;
-            unsigned int nbRows, nbColumns;
-        public:
-            Parallel_verticalCausalFilter_Irregular(float *bufferToProcess, const float *spatialConst, const unsigned int nbRws, const unsigned int nbCols)
-                :outputFrame(bufferToProcess), spatialConstantBuffer(spatialConst), nbRows(nbRws), nbColumns(nbCols){}
-
-            virtual void operator()( const Range& r ) const CV_OVERRIDE {
-                for (int IDcolumn=r.start; IDcolumn!=r.end; ++IDcolumn)
-                {
-                    float result=0;
-                    float *outputPTR=outputFrame+IDcolumn;
-                    const float* spatialConstantPTR=spatialConstantBuffer+IDcolumn;
-                    for (unsigned int index=0; index<nbRows; ++index)
-                    {
-                        result = *(outputPTR) +  *(spatialConstantPTR) * result;
-                        *(outputPTR) = result;
-                        outputPTR+=nbColumns;
-                        spatialConstantPTR+=nbColumns;
-                    }
-                }
-            }
-        };
-
 #endif
 
     };
@@ -409,17 +409,27 @@ std::valarray<float> &ImageLogPolProjection::runProjection(const std::valarray<f
         _spatiotemporalLPfilter_Irregular(get_data(inputFrame)+_filterOutput.getNBpixels()*2, &_irregularLPfilteredFrame[0]);
         _spatiotemporalLPfilter_Irregular(&_irregularLPfilteredFrame[0], &_tempBuffer[0]+_filterOutput.getNBpixels()*2);
 
-        // applying image projection/resampling
-        unsigned int *transformTablePTR=&_transformTable[0];
-        for (unsigned int i=0 ; i<_usefullpixelIndex ; i+=2, transformTablePTR+=2)
+        // applying image projection/resampling, one color channel per task since some output pixels are sampled
+        // several times by the transform table and the table order must then be kept inside a channel
+        const unsigned int *transformTable=&_transformTable[0];
+        const float *tempBufferPTR=&_tempBuffer[0];
+        float *sampledFramePTR=&_sampledFrame[0];
+        parallelLoop(3, [&](const cv::Range& r)
         {
+            for (int channel=r.start; channel<r.end; ++channel)
+            {
+                const float *inputChannel=tempBufferPTR+channel*_filterOutput.getNBpixels();
+                float *outputChannel=sampledFramePTR+channel*_outputNBpixels;
+                const unsigned int *transformTablePTR=transformTable;
+                for (unsigned int i=0 ; i<_usefullpixelIndex ; i+=2, transformTablePTR+=2)
+                {
 #ifdef IMAGELOGPOLPROJECTION_DEBUG
-            std::cout<<"ImageLogPolProjection::i:"<<i<<"output(max="<<_outputNBpixels<<")="<<_transformTable[i]<<" / intput(max="<<_filterOutput.getNBpixels()<<")="<<_transformTable[i+1]<<std::endl;
+                    std::cout<<"ImageLogPolProjection::i:"<<i<<"output(max="<<_outputNBpixels<<")="<<_transformTable[i]<<" / intput(max="<<_filterOutput.getNBpixels()<<")="<<_transformTable[i+1]<<std::endl;
 #endif
-            _sampledFrame[*(transformTablePTR)]=_tempBuffer[*(transformTablePTR+1)];
-            _sampledFrame[*(transformTablePTR)+_outputNBpixels]=_tempBuffer[*(transformTablePTR+1)+_filterOutput.getNBpixels()];
-            _sampledFrame[*(transformTablePTR)+_outputDoubleNBpixels]=_tempBuffer[*(transformTablePTR+1)+_inputDoubleNBpixels];
-        }
+                    outputChannel[*(transformTablePTR)]=inputChannel[*(transformTablePTR+1)];
+                }
+            }
+        });
 
 #ifdef IMAGELOGPOLPROJECTION_DEBUG
         std::cout<<"ImageLogPolProjection::runProjection: color image projection OK"<<std::endl;
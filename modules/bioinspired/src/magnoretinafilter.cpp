@@ -201,10 +201,13 @@ const std::valarray<float> &MagnoRetinaFilter::runFilter(const std::valarray<flo
 
     /* Compute MagnoY */
     float *magnoYOutput= &(*_magnoYOutput)[0];
-    float *magnoXOutputON_PTR= &_magnoXOutputON[0];
-    float *magnoXOutputOFF_PTR= &_magnoXOutputOFF[0];
-    for (unsigned int IDpixel=0 ; IDpixel<_filterOutput.getNBpixels() ; ++IDpixel)
-        *(magnoYOutput++)=*(magnoXOutputON_PTR++)+*(magnoXOutputOFF_PTR++);
+    const float *magnoXOutputON_PTR= &_magnoXOutputON[0];
+    const float *magnoXOutputOFF_PTR= &_magnoXOutputOFF[0];
+    parallelLoop(_filterOutput.getNBpixels(), [&](const cv::Range& r)
+    {
+        for (int IDpixel=r.start ; IDpixel<r.end ; ++IDpixel)
+            magnoYOutput[IDpixel]=magnoXOutputON_PTR[IDpixel]+magnoXOutputOFF_PTR[IDpixel];
+    });
 
     return (*_magnoYOutput);
 }
@@ -192,11 +192,14 @@ const std::valarray<float> &ParvoRetinaFilter::runFilter(const std::valarray<flo
         //// loop that makes the difference between photoreceptor cells output and horizontal cells
         //// positive part goes on the ON way, negative pat goes on the OFF way
         float *parvocellularOutputONminusOFF_PTR=&(*_parvocellularOutputONminusOFF)[0];
-        float *parvocellularOutputON_PTR=&_parvocellularOutputON[0];
-        float *parvocellularOutputOFF_PTR=&_parvocellularOutputOFF[0];
-
-        for (unsigned int IDpixel=0 ; IDpixel<_filterOutput.getNBpixels() ; ++IDpixel)
-            *(parvocellularOutputONminusOFF_PTR++)= (*(parvocellularOutputON_PTR++)-*(parvocellularOutputOFF_PTR++));
+        const float *parvocellularOutputON_PTR=&_parvocellularOutputON[0];
+        const float *parvocellularOutputOFF_PTR=&_parvocellularOutputOFF[0];
+
+        parallelLoop(_filterOutput.getNBpixels(), [&](const cv::Range& r)
+        {
+            for (int IDpixel=r.start ; IDpixel<r.end ; ++IDpixel)
+                parvocellularOutputONminusOFF_PTR[IDpixel]= parvocellularOutputON_PTR[IDpixel]-parvocellularOutputOFF_PTR[IDpixel];
+        });
     }
     return (*_parvocellularOutputONminusOFF);
 }
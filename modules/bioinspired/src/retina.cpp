@@ -841,5 +841,33 @@ void RetinaImpl::activateMovingContoursProcessing(const bool activate) { _retina
 
 void RetinaImpl::activateContoursProcessing(const bool activate) { _retinaFilter->activateContoursProcessing(activate); }
 
+void runRetinaBatch(const std::vector< Ptr<Retina> >& retinas, InputArrayOfArrays inputImages)
+{
+    const int nbStreams=(int)retinas.size();
+    CV_Assert((int)inputImages.total()==nbStreams);
+    for (int i=0; i<nbStreams; ++i)
+    {
+        CV_Assert(retinas[i]);
+        for (int j=0; j<i; ++j)
+            CV_Assert(retinas[i]!=retinas[j]);
+    }
+
+    if (inputImages.isUMatVector())
+    {
+        for (int i=0; i<nbStreams; ++i)
+            retinas[i]->run(inputImages.getUMat(i));
+        return;
+    }
+
+    // each stream is run by a single thread, the parallel loops inside a retina then run sequentially
+    std::vector<Mat> frames;
+    inputImages.getMatVector(frames);
+    parallel_for_(Range(0, nbStreams), [&](const Range& r)
+    {
+        for (int i=r.start; i<r.end; ++i)
+            retinas[i]->run(frames[i]);
+    });
+}
+
 }// end of namespace bioinspired
 }// end of namespace cv
@@ -258,10 +258,16 @@ void RetinaColor::runColorDemultiplexing(const std::valarray<float> &multiplexed
     // -> first set demultiplexed frame to 0
     _demultiplexedTempBuffer=0;
     // -> demultiplex process
-    unsigned int *colorSamplingPRT=&_colorSampling[0];
+    // each pixel is sampled in a single color layer, the scattered writes never collide
+    const unsigned int nbPixels=_filterOutput.getNBpixels();
+    const unsigned int *colorSamplingPRT=&_colorSampling[0];
     const float *multiplexedColorFramePtr=get_data(multiplexedColorFrame);
-    for (unsigned int indexa=0; indexa<_filterOutput.getNBpixels() ; ++indexa)
-        _demultiplexedTempBuffer[*(colorSamplingPRT++)]=*(multiplexedColorFramePtr++);
+    float *demultiplexedTempBufferPTR=&_demultiplexedTempBuffer[0];
+    parallelLoop(nbPixels, [&](const cv::Range& r)
+    {
+        for (int indexa=r.start; indexa<r.end ; ++indexa)
+            demultiplexedTempBufferPTR[colorSamplingPRT[indexa]]=multiplexedColorFramePtr[indexa];
+    });
 
     // interpolate the demultiplexed frame depending on the color sampling method
     if (!adaptiveFiltering)
@@ -281,62 +287,65 @@ void RetinaColor::runColorDemultiplexing(const std::valarray<float> &multiplexed
 
     // normalize by the photoreceptors local density and retrieve the local luminance
     float *chrominancePTR= &_chrominance[0];
-    float *colorLocalDensityPTR= &_colorLocalDensity[0];
+    const float *colorLocalDensityPTR= &_colorLocalDensity[0];
     float *luminance= &(*_luminance)[0];
     if (!adaptiveFiltering)// compute the gradient on the luminance
     {
-        if (_samplingMethod==RETINA_COLOR_RANDOM)
-            for (unsigned int indexc=0; indexc<_filterOutput.getNBpixels() ; ++indexc, ++chrominancePTR, ++colorLocalDensityPTR, ++luminance)
-            {
-                // normalize by photoreceptors density
-                float Cr=*(chrominancePTR)*_colorLocalDensity[indexc];
-                float Cg=*(chrominancePTR+_filterOutput.getNBpixels())*_colorLocalDensity[indexc+_filterOutput.getNBpixels()];
-                float Cb=*(chrominancePTR+_filterOutput.getDoubleNBpixels())*_colorLocalDensity[indexc+_filterOutput.getDoubleNBpixels()];
-                *luminance=(Cr+Cg+Cb)*_pG;
-                *(chrominancePTR)=Cr-*luminance;
-                *(chrominancePTR+_filterOutput.getNBpixels())=Cg-*luminance;
-                *(chrominancePTR+_filterOutput.getDoubleNBpixels())=Cb-*luminance;
-            }
-        else
-            for (unsigned int indexc=0; indexc<_filterOutput.getNBpixels() ; ++indexc, ++chrominancePTR, ++colorLocalDensityPTR, ++luminance)
+        const bool normalizeByDensity=_samplingMethod==RETINA_COLOR_RANDOM;
+        parallelLoop(nbPixels, [&](const cv::Range& r)
+        {
+            for (int indexc=r.start; indexc<r.end ; ++indexc)
             {
-                float Cr=*(chrominancePTR);
-                float Cg=*(chrominancePTR+_filterOutput.getNBpixels());
-                float Cb=*(chrominancePTR+_filterOutput.getDoubleNBpixels());
-                *luminance=_pR*Cr+_pG*Cg+_pB*Cb;
-                *(chrominancePTR)=Cr-*luminance;
-                *(chrominancePTR+_filterOutput.getNBpixels())=Cg-*luminance;
-                *(chrominancePTR+_filterOutput.getDoubleNBpixels())=Cb-*luminance;
+                float Cr=chrominancePTR[indexc];
+                float Cg=chrominancePTR[indexc+nbPixels];
+                float Cb=chrominancePTR[indexc+2*nbPixels];
+                if (normalizeByDensity)
+                {
+                    // normalize by photoreceptors density
+                    Cr*=colorLocalDensityPTR[indexc];
+                    Cg*=colorLocalDensityPTR[indexc+nbPixels];
+                    Cb*=colorLocalDensityPTR[indexc+2*nbPixels];
+                    luminance[indexc]=(Cr+Cg+Cb)*_pG;
+                }
+                else
+                    luminance[indexc]=_pR*Cr+_pG*Cg+_pB*Cb;
+                chrominancePTR[indexc]=Cr-luminance[indexc];
+                chrominancePTR[indexc+nbPixels]=Cg-luminance[indexc];
+                chrominancePTR[indexc+2*nbPixels]=Cb-luminance[indexc];
             }
+        });
 
         // in order to get the color image, each colored map needs to be added the luminance
         // -> to do so, compute:  multiplexedColorFrame - remultiplexed chrominances
         runColorMultiplexing(_chrominance, _tempMultiplexedFrame);
         //lum = 1/3((f*(ImR))/(f*mR) + (f*(ImG))/(f*mG) + (f*(ImB))/(f*mB));
-        float *luminancePTR= &(*_luminance)[0];
-        chrominancePTR= &_chrominance[0];
+        const float *tempMultiplexedFramePTR= &_tempMultiplexedFrame[0];
         float *demultiplexedColorFramePTR= &_demultiplexedColorFrame[0];
-        for (unsigned int indexp=0; indexp<_filterOutput.getNBpixels() ; ++indexp, ++luminancePTR, ++chrominancePTR, ++demultiplexedColorFramePTR)
+        parallelLoop(nbPixels, [&](const cv::Range& r)
         {
-            *luminancePTR=(multiplexedColorFrame[indexp]-_tempMultiplexedFrame[indexp]);
-            *(demultiplexedColorFramePTR)=*(chrominancePTR)+*luminancePTR;
-            *(demultiplexedColorFramePTR+_filterOutput.getNBpixels())=*(chrominancePTR+_filterOutput.getNBpixels())+*luminancePTR;
-            *(demultiplexedColorFramePTR+_filterOutput.getDoubleNBpixels())=*(chrominancePTR+_filterOutput.getDoubleNBpixels())+*luminancePTR;
-        }
+            for (int indexp=r.start; indexp<r.end ; ++indexp)
+            {
+                luminance[indexp]=(multiplexedColorFramePtr[indexp]-tempMultiplexedFramePTR[indexp]);
+                demultiplexedColorFramePTR[indexp]=chrominancePTR[indexp]+luminance[indexp];
+                demultiplexedColorFramePTR[indexp+nbPixels]=chrominancePTR[indexp+nbPixels]+luminance[indexp];
+                demultiplexedColorFramePTR[indexp+2*nbPixels]=chrominancePTR[indexp+2*nbPixels]+luminance[indexp];
+            }
+        });
 
     }else
     {
-        const float *multiplexedColorFramePTR= get_data(multiplexedColorFrame);
-        for (unsigned int indexc=0; indexc<_filterOutput.getNBpixels() ; ++indexc, ++chrominancePTR, ++colorLocalDensityPTR, ++luminance, ++multiplexedColorFramePTR)
+        parallelLoop(nbPixels, [&](const cv::Range& r)
         {
-            // normalize by photoreceptors density
-            float Cr=*(chrominancePTR)*_colorLocalDensity[indexc];
-            float Cg=*(chrominancePTR+_filterOutput.getNBpixels())*_colorLocalDensity[indexc+_filterOutput.getNBpixels()];
-            float Cb=*(chrominancePTR+_filterOutput.getDoubleNBpixels())*_colorLocalDensity[indexc+_filterOutput.getDoubleNBpixels()];
-            *luminance=(Cr+Cg+Cb)*_pG;
-            _demultiplexedTempBuffer[_colorSampling[indexc]] = *multiplexedColorFramePTR - *luminance;
-
-        }
+            for (int indexc=r.start; indexc<r.end ; ++indexc)
+            {
+                // normalize by photoreceptors density
+                float Cr=chrominancePTR[indexc]*colorLocalDensityPTR[indexc];
+                float Cg=chrominancePTR[indexc+nbPixels]*colorLocalDensityPTR[indexc+nbPixels];
+                float Cb=chrominancePTR[indexc+2*nbPixels]*colorLocalDensityPTR[indexc+2*nbPixels];
+                luminance[indexc]=(Cr+Cg+Cb)*_pG;
+                demultiplexedTempBufferPTR[colorSamplingPRT[indexc]] = multiplexedColorFramePtr[indexc] - luminance[indexc];
+            }
+        });
 
         // compute the gradient of the luminance
 #ifdef MAKE_PARALLEL // call the TemplateBuffer TBB clipping method
@@ -358,36 +367,47 @@ void RetinaColor::runColorDemultiplexing(const std::valarray<float> &multiplexed
         _demultiplexedColorFrame/=_chrominance; // more optimal ;o)
 
         // compute and substract the residual luminance
-        for (unsigned int index=0; index<_filterOutput.getNBpixels() ; ++index)
+        float *demultiplexedColorFramePTR= &_demultiplexedColorFrame[0];
+        parallelLoop(nbPixels, [&](const cv::Range& r)
         {
-            float residu = _pR*_demultiplexedColorFrame[index] + _pG*_demultiplexedColorFrame[index+_filterOutput.getNBpixels()] + _pB*_demultiplexedColorFrame[index+_filterOutput.getDoubleNBpixels()];
-            _demultiplexedColorFrame[index] = _demultiplexedColorFrame[index] - residu;
-            _demultiplexedColorFrame[index+_filterOutput.getNBpixels()] = _demultiplexedColorFrame[index+_filterOutput.getNBpixels()] - residu;
-            _demultiplexedColorFrame[index+_filterOutput.getDoubleNBpixels()] = _demultiplexedColorFrame[index+_filterOutput.getDoubleNBpixels()] - residu;
-        }
+            for (int index=r.start; index<r.end ; ++index)
+            {
+                float residu = _pR*demultiplexedColorFramePTR[index] + _pG*demultiplexedColorFramePTR[index+nbPixels] + _pB*demultiplexedColorFramePTR[index+2*nbPixels];
+                demultiplexedColorFramePTR[index] = demultiplexedColorFramePTR[index] - residu;
+                demultiplexedColorFramePTR[index+nbPixels] = demultiplexedColorFramePTR[index+nbPixels] - residu;
+                demultiplexedColorFramePTR[index+2*nbPixels] = demultiplexedColorFramePTR[index+2*nbPixels] - residu;
+            }
+        });
 
         // multiplex the obtained chrominance
         runColorMultiplexing(_demultiplexedColorFrame, _tempMultiplexedFrame);
         _demultiplexedTempBuffer=0;
 
         // get the luminance, et and add it to each chrominance
-        for (unsigned int index=0; index<_filterOutput.getNBpixels() ; ++index)
+        const float *tempMultiplexedFramePTR= &_tempMultiplexedFrame[0];
+        parallelLoop(nbPixels, [&](const cv::Range& r)
         {
-            (*_luminance)[index]=multiplexedColorFrame[index]-_tempMultiplexedFrame[index];
-            _demultiplexedTempBuffer[_colorSampling[index]] = _demultiplexedColorFrame[_colorSampling[index]];//multiplexedColorFrame[index] - (*_luminance)[index];
-        }
+            for (int index=r.start; index<r.end ; ++index)
+            {
+                luminance[index]=multiplexedColorFramePtr[index]-tempMultiplexedFramePTR[index];
+                demultiplexedTempBufferPTR[colorSamplingPRT[index]] = demultiplexedColorFramePTR[colorSamplingPRT[index]];//multiplexedColorFrame[index] - (*_luminance)[index];
+            }
+        });
 
         _spatiotemporalLPfilter(&_demultiplexedTempBuffer[0], &_demultiplexedTempBuffer[0]);
         _spatiotemporalLPfilter(&_demultiplexedTempBuffer[0]+_filterOutput.getNBpixels(), &_demultiplexedTempBuffer[0]+_filterOutput.getNBpixels());
         _spatiotemporalLPfilter(&_demultiplexedTempBuffer[0]+_filterOutput.getDoubleNBpixels(), &_demultiplexedTempBuffer[0]+_filterOutput.getDoubleNBpixels());
 
         // get the luminance and add it to each chrominance
-        for (unsigned int index=0; index<_filterOutput.getNBpixels() ; ++index)
+        parallelLoop(nbPixels, [&](const cv::Range& r)
         {
-            _demultiplexedColorFrame[index] = _demultiplexedTempBuffer[index]*_colorLocalDensity[index]+ (*_luminance)[index];
-            _demultiplexedColorFrame[index+_filterOutput.getNBpixels()] = _demultiplexedTempBuffer[index+_filterOutput.getNBpixels()]*_colorLocalDensity[index+_filterOutput.getNBpixels()]+ (*_luminance)[index];
-            _demultiplexedColorFrame[index+_filterOutput.getDoubleNBpixels()] = _demultiplexedTempBuffer[index+_filterOutput.getDoubleNBpixels()]*_colorLocalDensity[index+_filterOutput.getDoubleNBpixels()]+ (*_luminance)[index];
-        }
+            for (int index=r.start; index<r.end ; ++index)
+            {
+                demultiplexedColorFramePTR[index] = demultiplexedTempBufferPTR[index]*colorLocalDensityPTR[index]+ luminance[index];
+                demultiplexedColorFramePTR[index+nbPixels] = demultiplexedTempBufferPTR[index+nbPixels]*colorLocalDensityPTR[index+nbPixels]+ luminance[index];
+                demultiplexedColorFramePTR[index+2*nbPixels] = demultiplexedTempBufferPTR[index+2*nbPixels]*colorLocalDensityPTR[index+2*nbPixels]+ luminance[index];
+            }
+        });
     }
 
     // eliminate saturated colors by simple clipping values to the input range
@@ -412,10 +432,14 @@ void RetinaColor::runColorDemultiplexing(const std::valarray<float> &multiplexed
 void RetinaColor::runColorMultiplexing(const std::valarray<float> &demultiplexedInputFrame, std::valarray<float> &multiplexedFrame)
 {
     // multiply each color layer by its bayer mask
-    unsigned int *colorSamplingPTR= &_colorSampling[0];
+    const unsigned int *colorSamplingPTR= &_colorSampling[0];
+    const float *demultiplexedInputFramePTR= get_data(demultiplexedInputFrame);
     float *multiplexedFramePTR= &multiplexedFrame[0];
-    for (unsigned int indexp=0; indexp<_filterOutput.getNBpixels(); ++indexp)
-        *(multiplexedFramePTR++)=demultiplexedInputFrame[*(colorSamplingPTR++)];
+    parallelLoop(_filterOutput.getNBpixels(), [&](const cv::Range& r)
+    {
+        for (int indexp=r.start; indexp<r.end; ++indexp)
+            multiplexedFramePTR[indexp]=demultiplexedInputFramePTR[colorSamplingPTR[indexp]];
+    });
 }
 
 void RetinaColor::normalizeRGBOutput_0_maxOutputValue(const float maxOutputValue)
@@ -608,26 +632,7 @@ void RetinaColor::_adaptiveHorizontalCausalFilter_addInput(const float *inputFra
 //  vertical anticausal filter which multiplies the output by _gain... replaces the parent _verticalAnticausalFilter_multGain by avoiding a product for each pixel and taking into account the second layer of the _imageGradient buffer
 void RetinaColor::_adaptiveVerticalAnticausalFilter_multGain(float *outputFrame, unsigned int IDcolumnStart, unsigned int IDcolumnEnd)
 {
-#ifdef MAKE_PARALLEL
-        cv::parallel_for_(cv::Range(IDcolumnStart,IDcolumnEnd), Parallel_adaptiveVerticalAnticausalFilter_multGain(outputFrame, &_imageGradient[0]+_filterOutput.getNBpixels(), _filterOutput.getNBrows(), _filterOutput.getNBcolumns(), _gain));
-#else
-    float* outputOffset=outputFrame+_filterOutput.getNBpixels()-_filterOutput.getNBcolumns();
-    float* gradOffset= &_imageGradient[0]+_filterOutput.getNBpixels()*2-_filterOutput.getNBcolumns();
-
-    for (unsigned int IDcolumn=IDcolumnStart; IDcolumn<IDcolumnEnd; ++IDcolumn)
-    {
-        float result=0;
-        float *outputPTR=outputOffset+IDcolumn;
-        float *imageGradientPTR=gradOffset+IDcolumn;
-        for (unsigned int index=0; index<_filterOutput.getNBrows(); ++index)
-        {
-            result = *(outputPTR) + (*(imageGradientPTR)) * result;
-            *(outputPTR) = _gain*result;
-            outputPTR-=_filterOutput.getNBcolumns();
-            imageGradientPTR-=_filterOutput.getNBcolumns();
-        }
-    }
-#endif
+    _runVerticalFilter(outputFrame, IDcolumnStart, IDcolumnEnd, true, 0.f, &_imageGradient[0]+_filterOutput.getNBpixels(), _gain, NULL);
 }
 
 ///////////////////////////
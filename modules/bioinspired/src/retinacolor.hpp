@@ -306,36 +306,6 @@ namespace bioinspired
             }
         };
 
-        class Parallel_adaptiveVerticalAnticausalFilter_multGain: public cv::ParallelLoopBody
-        {
-        private:
-            float *outputFrame;
-            const float *imageGradient;
-            unsigned int nbRows, nbColumns;
-            float filterParam_gain;
-        public:
-            Parallel_adaptiveVerticalAnticausalFilter_multGain(float *bufferToProcess, const float *imageGrad, const unsigned int nbRws, const unsigned int nbCols, const float  gain)
-                :outputFrame(bufferToProcess), imageGradient(imageGrad), nbRows(nbRws), nbColumns(nbCols), filterParam_gain(gain) { }
-
-            virtual void operator()( const Range& r ) const CV_OVERRIDE {
-                float* offset=outputFrame+nbColumns*nbRows-nbColumns;
-                const float* gradOffset= imageGradient+nbColumns*nbRows-nbColumns;
-                for (int IDcolumn=r.start; IDcolumn!=r.end; ++IDcolumn)
-                {
-                    float result=0;
-                    float *outputPTR=offset+IDcolumn;
-                    const float *imageGradientPTR=gradOffset+IDcolumn;
-                    for (unsigned int index=0; index<nbRows; ++index)
-                    {
-                        result = *(outputPTR) + *(imageGradientPTR) * result;
-                        *(outputPTR) = filterParam_gain*result;
-                        outputPTR-=nbColumns;
-                        imageGradientPTR-=nbColumns;
-                    }
-                }
-            }
-        };
-
         class Parallel_computeGradient: public cv::ParallelLoopBody
         {
         protected:
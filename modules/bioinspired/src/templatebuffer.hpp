@@ -107,6 +107,17 @@ public:
 };
 #endif
 
+// runs loopBody on the index range [0, nbItems), split by parallel_for_ if MAKE_PARALLEL is defined
+template <class Body>
+inline void parallelLoop(const size_t nbItems, const Body& loopBody)
+{
+#ifdef MAKE_PARALLEL
+    cv::parallel_for_(cv::Range(0, (int)nbItems), loopBody);
+#else
+    loopBody(cv::Range(0, (int)nbItems));
+#endif
+}
+
     /**
     * @class TemplateBuffer
     * @brief this class is a simple template memory buffer which contains basic functions to get information on or normalize the buffer content
@@ -444,9 +455,11 @@ public:
         type factor = maxOutputValue/(maxValue-minValue);
         type offset = (type)(-minValue*factor);
 
-        inputOutputBufferPTR=inputOutputBuffer;
-        for (size_t j = 0; j < processedPixels; ++j, ++inputOutputBufferPTR)
-            *inputOutputBufferPTR=*(inputOutputBufferPTR)*factor+offset;
+        parallelLoop(processedPixels, [&](const cv::Range& r)
+        {
+            for (int j = r.start; j < r.end; ++j)
+                inputOutputBuffer[j]=inputOutputBuffer[j]*factor+offset;
+        });
 
     }
     // normalize data with a sigmoide close to 0 (saturates values for those superior to 0)
@@ -460,15 +473,14 @@ public:
 
         type X0cube=sensitivity*sensitivity*sensitivity;
 
-        type *inputBufferPTR=inputBuffer;
-        type *outputBufferPTR=outputBuffer;
-
-        for (size_t j = 0; j < _NBpixels; ++j, ++inputBufferPTR)
+        parallelLoop(_NBpixels, [&](const cv::Range& r)
         {
-
-            type currentCubeLuminance=*inputBufferPTR**inputBufferPTR**inputBufferPTR;
-            *(outputBufferPTR++)=maxOutputValue*currentCubeLuminance/(currentCubeLuminance+X0cube);
-        }
+            for (int j = r.start; j < r.end; ++j)
+            {
+                type currentCubeLuminance=inputBuffer[j]*inputBuffer[j]*inputBuffer[j];
+                outputBuffer[j]=maxOutputValue*currentCubeLuminance/(currentCubeLuminance+X0cube);
+            }
+        });
     }
 
     // normalize and adjust luminance with a centered to 128 sigmode
@@ -485,11 +497,11 @@ public:
 
         type X0=maxOutputValue/(sensitivity-(type)1.0);
 
-        type *inputBufferPTR=inputBuffer;
-        type *outputBufferPTR=outputBuffer;
-
-        for (size_t j = 0; j < nbPixels; ++j, ++inputBufferPTR)
-            *(outputBufferPTR++)=(meanValue+(meanValue+X0)*(*(inputBufferPTR)-meanValue)/(_abs(*(inputBufferPTR)-meanValue)+X0));
+        parallelLoop(nbPixels, [&](const cv::Range& r)
+        {
+            for (int j = r.start; j < r.end; ++j)
+                outputBuffer[j]=(meanValue+(meanValue+X0)*(inputBuffer[j]-meanValue)/(_abs(inputBuffer[j]-meanValue)+X0));
+        });
 
     }
 
@@ -517,9 +529,11 @@ public:
 
         stdValue=std::sqrt(stdValue/((type)_NBpixels));
         // adjust luminance in regard of mean and std value;
-        inputOutputBufferPTR=inputOutputBuffer;
-        for (size_t index=0;index<_NBpixels;++index, ++inputOutputBufferPTR)
-            *inputOutputBufferPTR=(*(inputOutputBufferPTR)-meanValue)/stdValue;
+        parallelLoop(_NBpixels, [&](const cv::Range& r)
+        {
+            for (int index = r.start; index < r.end; ++index)
+                inputOutputBuffer[index]=(inputOutputBuffer[index]-meanValue)/stdValue;
+        });
     }
 
 
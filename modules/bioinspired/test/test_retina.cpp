@@ -0,0 +1,69 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+static Mat makeRetinaFrame(int side, int shift)
+{
+    Mat img(side, side, CV_8UC1);
+    RNG rng(side);
+    rng.fill(img, RNG::UNIFORM, 0, 64);
+    img(Rect(10 + shift, 25, 40, 20)).setTo(Scalar::all(200));
+    img(Rect(60, 50 + shift, 15, 30)).setTo(Scalar::all(150));
+    return img;
+}
+
+// Without log sampling and color, every gray retina stage is either pointwise or a separable
+// causal/anticausal spatial filter, so feeding the transposed frames must give the transposed
+// outputs: the vertical passes have to match the horizontal ones.
+TEST(Bioinspired_Retina, batch_output_is_transpose_symmetric)
+{
+    const int side = 98; // not a multiple of the SIMD width
+    std::vector< Ptr<bioinspired::Retina> > retinas;
+    retinas.push_back(bioinspired::Retina::create(Size(side, side), false));
+    retinas.push_back(bioinspired::Retina::create(Size(side, side), false));
+
+    for (int frame = 0; frame < 10; frame++)
+    {
+        std::vector<Mat> frames;
+        frames.push_back(makeRetinaFrame(side, 2 * frame));
+        frames.push_back(frames[0].t());
+        bioinspired::runRetinaBatch(retinas, frames);
+    }
+
+    Mat parvo = retinas[0]->getParvoRAW().reshape(1, side);
+    Mat parvoT = Mat(retinas[1]->getParvoRAW().reshape(1, side).t());
+    Mat magno = retinas[0]->getMagnoRAW().reshape(1, side);
+    Mat magnoT = Mat(retinas[1]->getMagnoRAW().reshape(1, side).t());
+    EXPECT_LE(cvtest::norm(parvo, parvoT, NORM_INF), 1e-4 * cvtest::norm(parvo, NORM_INF));
+    EXPECT_LE(cvtest::norm(magno, magnoT, NORM_INF), 1e-4 * cvtest::norm(magno, NORM_INF));
+}
+
+// The magno channel is a temporal high pass: it fades out on a static scene and responds where
+// the scene changes.
+TEST(Bioinspired_Retina, magno_responds_to_motion)
+{
+    const int side = 98;
+    Ptr<bioinspired::Retina> retina = bioinspired::Retina::create(Size(side, side), false);
+
+    Mat still = makeRetinaFrame(side, 0);
+    for (int frame = 0; frame < 50; frame++)
+        retina->run(still);
+    double staticMax = cvtest::norm(retina->getMagnoRAW(), NORM_INF);
+
+    retina->run(makeRetinaFrame(side, 8));
+    Mat magno = retina->getMagnoRAW().reshape(1, side);
+    Point movedLoc;
+    double movedMax = 0;
+    minMaxLoc(cv::abs(magno), NULL, &movedMax, NULL, &movedLoc);
+
+    EXPECT_GT(movedMax, 0.);
+    EXPECT_LT(staticMax, 0.1 * movedMax);
+    // the strongest response lies around one of the moved bars
+    Rect horizontalMotion(5, 20, 60, 30), verticalMotion(55, 45, 25, 48);
+    EXPECT_TRUE(horizontalMotion.contains(movedLoc) || verticalMotion.contains(movedLoc)) << movedLoc;
+}
+
+}} // namespace
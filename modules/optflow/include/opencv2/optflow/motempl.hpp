@@ -119,6 +119,29 @@ smaller weight, as recorded in mhi .
 CV_EXPORTS_W double calcGlobalOrientation( InputArray orientation, InputArray mask, InputArray mhi,
                                            double timestamp, double duration );
 
+/** @brief Updates the motion history image and calculates the global motion orientation of the whole image.
+
+@param silhouette Silhouette mask that has non-zero pixels where the motion occurs.
+@param mhi Motion history image that is updated by the function (single-channel, 32-bit
+floating-point).
+@param timestamp Current time in milliseconds or other units.
+@param duration Maximal duration of the motion track in the same units as timestamp .
+@param delta1 Minimal (or maximal) allowed difference between mhi values within a pixel
+neighborhood, see calcMotionGradient .
+@param delta2 Maximal (or minimal) allowed difference between mhi values within a pixel
+neighborhood, see calcMotionGradient .
+@param apertureSize Aperture size of the Sobel operator.
+
+The function is equivalent to updateMotionHistory followed by calcMotionGradient and
+calcGlobalOrientation with the gradient mask, but the orientation and the mask images are not
+created: they are computed row by row and consumed right away. The mhi derivatives and the
+neighborhood minimum and maximum of mhi are still computed as whole images. Use it when only the
+global orientation of every frame is needed.
+ */
+CV_EXPORTS_W double updateMotionHistoryAndOrientation( InputArray silhouette, InputOutputArray mhi,
+                                                       double timestamp, double duration,
+                                                       double delta1, double delta2, int apertureSize = 3 );
+
 /** @brief Splits a motion history image into a few parts corresponding to separate independent motions (for
 example, left hand, right hand).
 
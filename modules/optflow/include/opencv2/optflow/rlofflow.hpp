@@ -364,6 +364,18 @@ public:
      *    @see setRICSLICType
      */
     CV_WRAP virtual int  getRICSLICType() const = 0;
+    //! @brief Enables the warm start of the grid from the flow of the previous call.
+    /**
+     * When calc() is called on consecutive frames of a video, i.e. I0 is the I1 of the previous call,
+     * the image pyramid of I0 is always reused. With warm start, the tracking of the grid points also starts at the
+     * positions predicted by the previous flow, which helps for large and smooth motions. Disabled by default.
+     *  @see getUseWarmStart
+     */
+    CV_WRAP virtual void setUseWarmStart(bool val) = 0;
+    /** @copybrief setUseWarmStart
+     *    @see setUseWarmStart
+     */
+    CV_WRAP virtual bool getUseWarmStart() const = 0;
     //! @brief Creates instance of optflow::DenseRLOFOpticalFlow
     /**
      *    @param rlofParam see optflow::RLOFOpticalFlowParameter
@@ -53,6 +53,7 @@ the use of this software, even if advised of the possibility of such damage.
 
 #include "opencv2/core.hpp"
 #include "opencv2/imgproc.hpp"
+#include <unordered_map>
 
 namespace cv
 {
@@ -207,6 +208,18 @@ private:
     }
   };
 
+  struct TrailHash
+  {
+    size_t operator()( const Trail &trail ) const
+    {
+      size_t h = 0;
+      for ( int i = 0; i < T; ++i )
+        h ^= trail.leaf[i] + 0x9e3779b9 + ( h << 6 ) + ( h >> 2 );
+      return h;
+    }
+  };
+
+  /* Descends all the trees for a block of patches, tree by tree, so the nodes of one tree stay in cache for the whole block. */
   class ParallelTrailsFilling : public ParallelLoopBody
   {
   private:
@@ -222,9 +235,12 @@ private:
 
     void operator()( const Range &range ) const CV_OVERRIDE
     {
-      for ( int t = range.start; t < range.end; ++t )
-        for ( size_t i = 0; i < descr->size(); ++i )
-          trails->at( i ).leaf[t] = forest->tree[t].findLeafForPatch( descr->at( i ) );
+      for ( int t = 0; t < T; ++t )
+      {
+        const GPCTree &tree = forest->tree[t];
+        for ( int i = range.start; i < range.end; ++i )
+          ( *trails )[i].leaf[t] = tree.findLeafForPatch( ( *descr )[i] );
+      }
     }
   };
 
@@ -332,29 +348,38 @@ void GPCForest< T >::findCorrespondences( InputArray imgFrom, InputArray imgTo,
 
   for ( size_t i = 0; i < descr.size(); ++i )
     GPCDetails::getCoordinatesFromIndex( i, from.size(), trailsFrom[i].coord.x, trailsFrom[i].coord.y );
-  parallel_for_( Range( 0, T ), ParallelTrailsFilling( this, &descr, &trailsFrom ) );
+  parallel_for_( Range( 0, (int)descr.size() ), ParallelTrailsFilling( this, &descr, &trailsFrom ) );
 
   descr.clear();
   GPCDetails::getAllDescriptorsForImage( toCh, descr, params, tree[0].getDescriptorType() );
 
   for ( size_t i = 0; i < descr.size(); ++i )
     GPCDetails::getCoordinatesFromIndex( i, to.size(), trailsTo[i].coord.x, trailsTo[i].coord.y );
-  parallel_for_( Range( 0, T ), ParallelTrailsFilling( this, &descr, &trailsTo ) );
+  parallel_for_( Range( 0, (int)descr.size() ), ParallelTrailsFilling( this, &descr, &trailsTo ) );
 
-  std::sort( trailsFrom.begin(), trailsFrom.end() );
-  std::sort( trailsTo.begin(), trailsTo.end() );
+  // Hash join of the trails. A pair of patches corresponds if each of them is the only patch of its image with this trail.
+  // The value holds the index of the patch in the first and in the second image: -1 if there is none, -2 if there are several.
+  typedef std::unordered_map< Trail, Vec2i, TrailHash > TrailMap;
+  TrailMap joined( trailsFrom.size() );
 
   for ( size_t i = 0; i < trailsFrom.size(); ++i )
   {
-    bool uniq = true;
-    while ( i + 1 < trailsFrom.size() && trailsFrom[i] == trailsFrom[i + 1] )
-      ++i, uniq = false;
-    if ( uniq )
-    {
-      typename std::vector< Trail >::const_iterator lb = std::lower_bound( trailsTo.begin(), trailsTo.end(), trailsFrom[i] );
-      if ( lb != trailsTo.end() && *lb == trailsFrom[i] && ( ( lb + 1 ) == trailsTo.end() || !( *lb == *( lb + 1 ) ) ) )
-        corr.push_back( std::make_pair( trailsFrom[i].coord, lb->coord ) );
-    }
+    Vec2i &idx = joined.insert( std::make_pair( trailsFrom[i], Vec2i( -1, -1 ) ) ).first->second;
+    idx[0] = ( idx[0] == -1 ) ? int( i ) : -2;
+  }
+
+  for ( size_t i = 0; i < trailsTo.size(); ++i )
+  {
+    typename TrailMap::iterator it = joined.find( trailsTo[i] );
+    if ( it != joined.end() )
+      it->second[1] = ( it->second[1] == -1 ) ? int( i ) : -2;
+  }
+
+  for ( size_t i = 0; i < trailsFrom.size(); ++i )
+  {
+    const Vec2i &idx = joined.find( trailsFrom[i] )->second;
+    if ( idx[0] == int( i ) && idx[1] >= 0 )
+      corr.push_back( std::make_pair( trailsFrom[i].coord, trailsTo[idx[1]].coord ) );
   }
 
   GPCDetails::dropOutliers( corr );
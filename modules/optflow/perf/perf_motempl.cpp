@@ -0,0 +1,65 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef TestBaseWithParam<Size> MotionTemplates;
+
+static void makeMotionHistory(const Size& sz, Mat& silh, Mat& mhi)
+{
+    silh = Mat::zeros(sz, CV_8U);
+    mhi = Mat::zeros(sz, CV_32F);
+    for( int frame = 1; frame <= 8; frame++ )
+    {
+        silh.setTo(Scalar::all(0));
+        rectangle(silh, Rect(frame * sz.width / 16, sz.height / 4, sz.width / 4, sz.height / 2), Scalar::all(255), FILLED);
+        cv::motempl::updateMotionHistory(silh, mhi, frame * 0.1, 1.0);
+    }
+}
+
+PERF_TEST_P(MotionTemplates, updateMotionHistory, SZ_TYPICAL)
+{
+    Size sz = GetParam();
+    Mat silh, mhi;
+    makeMotionHistory(sz, silh, mhi);
+
+    declare.in(silh).in(mhi);
+
+    TEST_CYCLE() cv::motempl::updateMotionHistory(silh, mhi, 0.9, 1.0);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(MotionTemplates, gradientAndOrientation, SZ_TYPICAL)
+{
+    Size sz = GetParam();
+    Mat silh, mhi, mask, orient;
+    makeMotionHistory(sz, silh, mhi);
+
+    declare.in(mhi);
+
+    TEST_CYCLE()
+    {
+        cv::motempl::calcMotionGradient(mhi, mask, orient, 0.05, 0.5, 3);
+        cv::motempl::calcGlobalOrientation(orient, mask, mhi, 0.8, 1.0);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(MotionTemplates, updateMotionHistoryAndOrientation, SZ_TYPICAL)
+{
+    Size sz = GetParam();
+    Mat silh, mhi;
+    makeMotionHistory(sz, silh, mhi);
+
+    declare.in(silh).in(mhi);
+
+    TEST_CYCLE() cv::motempl::updateMotionHistoryAndOrientation(silh, mhi, 0.9, 1.0, 0.05, 0.5, 3);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -71,4 +71,35 @@ PERF_TEST_P(INTERP_GRID_Dense, OpticalFlow_DenseRLOF,
     SANITY_CHECK_NOTHING();
 }
 
+PERF_TEST_P(INTERP_GRID_Dense, OpticalFlow_DenseRLOF_video,
+    testing::Combine(
+        testing::Values<std::string>("INTERP_EPIC", "INTERP_GEO", "INTERP_RIC"),
+        testing::Values<int>(4,10))
+)
+{
+    Mat flow;
+    Mat frame1 = imread(getDataPath("cv/optflow/RubberWhale1.png"));
+    Mat frame2 = imread(getDataPath("cv/optflow/RubberWhale2.png"));
+    ASSERT_FALSE(frame1.empty());
+    ASSERT_FALSE(frame2.empty());
+    InterpolationType interp_type = INTERP_EPIC;
+    if (get<0>(GetParam()) == "INTERP_GEO")
+        interp_type = INTERP_GEO;
+    if (get<0>(GetParam()) == "INTERP_RIC")
+        interp_type = INTERP_RIC;
+    Ptr<DenseRLOFOpticalFlow> algo = DenseRLOFOpticalFlow::create(Ptr<RLOFOpticalFlowParameter>(), 1.0f,
+        Size(get<1>(GetParam()), get<1>(GetParam())), interp_type);
+    algo->setUseWarmStart(true);
+    // the frames alternate, so the first frame of each call is the second frame of the previous one
+    algo->calc(frame2, frame1, flow);
+    int n = 0;
+    PERF_SAMPLE_BEGIN()
+        if (n++ % 2 == 0)
+            algo->calc(frame1, frame2, flow);
+        else
+            algo->calc(frame2, frame1, flow);
+    PERF_SAMPLE_END()
+    SANITY_CHECK_NOTHING();
+}
+
 }} // namespace
@@ -42,6 +42,7 @@
 #include "precomp.hpp"
 #include "opencv2/core/utility.hpp"
 #include "opencv2/core/hal/hal.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 #include "opencv2/core/private.hpp"
 #include "opencl_kernels_optflow.hpp"
 
@@ -50,6 +51,150 @@ namespace motempl {
 
 using std::vector;
 
+static void updateMotionHistoryRow( const uchar* silhData, float* mhiData, int width, float ts, float delbound )
+{
+    int x = 0;
+#if CV_SIMD128
+    v_float32x4 v_ts = v_setall_f32(ts), v_db = v_setall_f32(delbound), v_fz = v_setzero_f32();
+    v_uint32x4 v_z = v_setzero_u32();
+    for( ; x <= width - 8; x += 8 )
+    {
+        v_uint32x4 s0, s1;
+        v_expand(v_load_expand(silhData + x), s0, s1);
+        v_float32x4 v0 = v_load(mhiData + x), v1 = v_load(mhiData + x + 4);
+
+        v0 = v_select(v0 >= v_db, v0, v_fz);
+        v1 = v_select(v1 >= v_db, v1, v_fz);
+
+        v_store(mhiData + x, v_select(v_reinterpret_as_f32(s0 != v_z), v_ts, v0));
+        v_store(mhiData + x + 4, v_select(v_reinterpret_as_f32(s1 != v_z), v_ts, v1));
+    }
+#endif
+
+    for( ; x < width; x++ )
+    {
+        float val = mhiData[x];
+        val = silhData[x] ? ts : val < delbound ? 0 : val;
+        mhiData[x] = val;
+    }
+}
+
+static void checkMotionGradientParams( double delta1, double delta2, int aperture_size )
+{
+    if( aperture_size < 3 || aperture_size > 7 || (aperture_size & 1) == 0 )
+        CV_Error( Error::StsOutOfRange, "aperture_size must be 3, 5 or 7" );
+
+    if( delta1 <= 0 || delta2 <= 0 )
+        CV_Error( Error::StsOutOfRange, "both delta's must be positive" );
+}
+
+// derivatives and the minimum/maximum of the MHI over the aperture
+static void calcMotionGradientImages( const Mat& mhi, int aperture_size, Mat& dX, Mat& dY, Mat& mhiMin, Mat& mhiMax )
+{
+    Sobel( mhi, dX, CV_32F, 1, 0, aperture_size, 1, 0, BORDER_REPLICATE );
+    Sobel( mhi, dY, CV_32F, 0, 1, aperture_size, 1, 0, BORDER_REPLICATE );
+    erode( mhi, mhiMin, noArray(), Point(-1,-1), (aperture_size-1)/2, BORDER_REPLICATE );
+    dilate( mhi, mhiMax, noArray(), Point(-1,-1), (aperture_size-1)/2, BORDER_REPLICATE );
+}
+
+// orientation and validity mask of one row; the orientation is zero where the gradient is
+// very small or the motion difference in the neighborhood is out of [min_delta, max_delta]
+static void calcMotionGradientRow( const float* dX, const float* dY, const float* mhiMin, const float* mhiMax,
+                                   float* orient, uchar* mask, int width,
+                                   float gradient_epsilon, float min_delta, float max_delta )
+{
+    cv::hal::fastAtan2(dY, dX, orient, width, true);
+
+    int x = 0;
+#if CV_SIMD128
+    v_float32x4 v_eps = v_setall_f32(gradient_epsilon);
+    v_float32x4 v_min = v_setall_f32(min_delta), v_max = v_setall_f32(max_delta);
+    v_int32x4 v_one = v_setall_s32(1);
+    for( ; x <= width - 8; x += 8 )
+    {
+        v_float32x4 d0 = v_load(mhiMax + x) - v_load(mhiMin + x);
+        v_float32x4 d1 = v_load(mhiMax + x + 4) - v_load(mhiMin + x + 4);
+        v_float32x4 m0 = ((v_abs(v_load(dX + x)) >= v_eps) | (v_abs(v_load(dY + x)) >= v_eps)) &
+                         (d0 >= v_min) & (d0 <= v_max);
+        v_float32x4 m1 = ((v_abs(v_load(dX + x + 4)) >= v_eps) | (v_abs(v_load(dY + x + 4)) >= v_eps)) &
+                         (d1 >= v_min) & (d1 <= v_max);
+
+        v_store(orient + x, v_load(orient + x) & m0);
+        v_store(orient + x + 4, v_load(orient + x + 4) & m1);
+        v_pack_u_store(mask + x, v_pack(v_reinterpret_as_s32(m0) & v_one, v_reinterpret_as_s32(m1) & v_one));
+    }
+#endif
+
+    for( ; x < width; x++ )
+    {
+        float d0 = mhiMax[x] - mhiMin[x];
+
+        if( (std::abs(dX[x]) < gradient_epsilon && std::abs(dY[x]) < gradient_epsilon) ||
+            d0 < min_delta || max_delta < d0 )
+        {
+            mask[x] = (uchar)0;
+            orient[x] = 0.f;
+        }
+        else
+            mask[x] = (uchar)1;
+    }
+}
+
+/*
+ weight of a pixel in the global orientation:
+ a = 254/(255*dt)
+ b = 1 - t*a = 1 - 254*t/(255*dur) =
+ (255*dt - 254*t)/(255*dt) =
+ (dt - (t - dt)*254)/(255*dt);
+ --------------------------------------------------------
+ ax + b = 254*x/(255*dt) + (dt - (t - dt)*254)/(255*dt) =
+ (254*x + dt - (t - dt)*254)/(255*dt) =
+ ((x - (t - dt))*254 + dt)/(255*dt) =
+ (((x - low_time)/dt)*254 + 1)/255 = (((x - low_time)/dt)*254 + 1)/255
+ */
+static void accumulateOrientationShift( const float* mhiptr, const float* oriptr, const uchar* maskptr, int width,
+                                        float fbaseOrient, float a, float b, float delbound,
+                                        float& shiftOrient, float& shiftWeight )
+{
+    for( int x = 0; x < width; x++ )
+    {
+        if( maskptr[x] != 0 && mhiptr[x] > delbound )
+        {
+            /*
+             orient in 0..360, base_orient in 0..360
+             -> (rel_angle = orient - base_orient) in -360..360.
+             rel_angle is translated to -180..180
+             */
+            float weight = mhiptr[x] * a + b;
+            float relAngle = oriptr[x] - fbaseOrient;
+
+            relAngle += (relAngle < -180 ? 360 : 0);
+            relAngle += (relAngle > 180 ? -360 : 0);
+
+            if( fabs(relAngle) < 45 )
+            {
+                shiftOrient += weight * relAngle;
+                shiftWeight += weight;
+            }
+        }
+    }
+}
+
+// adds the dominant orientation and the relative shift
+static double finishGlobalOrientation( float fbaseOrient, float shiftOrient, float shiftWeight )
+{
+    if( shiftWeight == 0 )
+        shiftWeight = 0.01f;
+
+    fbaseOrient += shiftOrient / shiftWeight;
+    fbaseOrient -= (fbaseOrient < 360 ? 0 : 360);
+    fbaseOrient += (fbaseOrient >= 0 ? 0 : 360);
+
+    return fbaseOrient;
+}
+
+static const int globalOrientHistSize = 12;
+
 #ifdef HAVE_OPENCL
 
 static bool ocl_updateMotionHistory( InputArray _silhouette, InputOutputArray _mhi,
@@ -84,71 +229,29 @@ void updateMotionHistory( InputArray _silhouette, InputOutputArray _mhi,
 
     Mat silh = _silhouette.getMat(), mhi = _mhi.getMat();
     Size size = silh.size();
+
 #if defined(HAVE_IPP)
+    Size ippsize = size;
     int silhstep = (int)silh.step, mhistep = (int)mhi.step;
-#endif
 
     if( silh.isContinuous() && mhi.isContinuous() )
     {
-        size.width *= size.height;
-        size.height = 1;
-#if defined(HAVE_IPP)
+        ippsize.width *= ippsize.height;
+        ippsize.height = 1;
         silhstep = (int)silh.total();
         mhistep = (int)mhi.total() * sizeof(Ipp32f);
-#endif
     }
 
-#if defined(HAVE_IPP)
     IppStatus status = ippiUpdateMotionHistory_8u32f_C1IR((const Ipp8u *)silh.data, silhstep, (Ipp32f *)mhi.data, mhistep,
-                                                          ippiSize(size.width, size.height), (Ipp32f)timestamp, (Ipp32f)duration);
+                                                          ippiSize(ippsize.width, ippsize.height), (Ipp32f)timestamp, (Ipp32f)duration);
     if (status >= 0)
         return;
 #endif
 
-#if CV_SSE2
-    volatile bool useSIMD = checkHardwareSupport(CV_CPU_SSE2);
-#endif
-
-    for(int y = 0; y < size.height; y++ )
-    {
-        const uchar* silhData = silh.ptr<uchar>(y);
-        float* mhiData = mhi.ptr<float>(y);
-        int x = 0;
-
-#if CV_SSE2
-        if( useSIMD )
-        {
-            __m128 ts4 = _mm_set1_ps(ts), db4 = _mm_set1_ps(delbound);
-            for( ; x <= size.width - 8; x += 8 )
-            {
-                __m128i z = _mm_setzero_si128();
-                __m128i s = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(silhData + x)), z);
-                __m128 s0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(s, z)), s1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(s, z));
-                __m128 v0 = _mm_loadu_ps(mhiData + x), v1 = _mm_loadu_ps(mhiData + x + 4);
-                __m128 fz = _mm_setzero_ps();
-
-                v0 = _mm_and_ps(v0, _mm_cmpge_ps(v0, db4));
-                v1 = _mm_and_ps(v1, _mm_cmpge_ps(v1, db4));
-
-                __m128 m0 = _mm_and_ps(_mm_xor_ps(v0, ts4), _mm_cmpneq_ps(s0, fz));
-                __m128 m1 = _mm_and_ps(_mm_xor_ps(v1, ts4), _mm_cmpneq_ps(s1, fz));
-
-                v0 = _mm_xor_ps(v0, m0);
-                v1 = _mm_xor_ps(v1, m1);
-
-                _mm_storeu_ps(mhiData + x, v0);
-                _mm_storeu_ps(mhiData + x + 4, v1);
-            }
-        }
-#endif
-
-        for( ; x < size.width; x++ )
-        {
-            float val = mhiData[x];
-            val = silhData[x] ? ts : val < delbound ? 0 : val;
-            mhiData[x] = val;
-        }
-    }
+    parallel_for_(Range(0, size.height), [&](const Range& range) {
+        for( int y = range.start; y < range.end; y++ )
+            updateMotionHistoryRow(silh.ptr<uchar>(y), mhi.ptr<float>(y), size.width, ts, delbound);
+    });
 }
 
 
@@ -166,11 +269,7 @@ void calcMotionGradient( InputArray _mhi, OutputArray _mask,
     Mat mask = _mask.getMat();
     Mat orient = _orientation.getMat();
 
-    if( aperture_size < 3 || aperture_size > 7 || (aperture_size & 1) == 0 )
-        CV_Error( Error::StsOutOfRange, "aperture_size must be 3, 5 or 7" );
-
-    if( delta1 <= 0 || delta2 <= 0 )
-        CV_Error( Error::StsOutOfRange, "both delta's must be positive" );
+    checkMotionGradientParams( delta1, delta2, aperture_size );
 
     if( mhi.type() != CV_32FC1 )
         CV_Error( Error::StsUnsupportedFormat,
@@ -190,68 +289,15 @@ void calcMotionGradient( InputArray _mhi, OutputArray _mask,
     float min_delta = (float)delta1;
     float max_delta = (float)delta2;
 
-    Mat dX_min, dY_max;
-
-    // calc Dx and Dy
-    Sobel( mhi, dX_min, CV_32F, 1, 0, aperture_size, 1, 0, BORDER_REPLICATE );
-    Sobel( mhi, dY_max, CV_32F, 0, 1, aperture_size, 1, 0, BORDER_REPLICATE );
-
-    int x, y;
+    Mat dX, dY, mhiMin, mhiMax;
+    calcMotionGradientImages( mhi, aperture_size, dX, dY, mhiMin, mhiMax );
 
-    if( mhi.isContinuous() && orient.isContinuous() && mask.isContinuous() )
-    {
-        size.width *= size.height;
-        size.height = 1;
-    }
-
-    // calc gradient
-    for( y = 0; y < size.height; y++ )
-    {
-        const float* dX_min_row = dX_min.ptr<float>(y);
-        const float* dY_max_row = dY_max.ptr<float>(y);
-        float* orient_row = orient.ptr<float>(y);
-        uchar* mask_row = mask.ptr<uchar>(y);
-
-        cv::hal::fastAtan2(dY_max_row, dX_min_row, orient_row, size.width, true);
-
-        // make orientation zero where the gradient is very small
-        for( x = 0; x < size.width; x++ )
-        {
-            float dY = dY_max_row[x];
-            float dX = dX_min_row[x];
-
-            if( std::abs(dX) < gradient_epsilon && std::abs(dY) < gradient_epsilon )
-            {
-                mask_row[x] = (uchar)0;
-                orient_row[x] = 0.f;
-            }
-            else
-                mask_row[x] = (uchar)1;
-        }
-    }
-
-    erode( mhi, dX_min, noArray(), Point(-1,-1), (aperture_size-1)/2, BORDER_REPLICATE );
-    dilate( mhi, dY_max, noArray(), Point(-1,-1), (aperture_size-1)/2, BORDER_REPLICATE );
-
-    // mask off pixels which have little motion difference in their neighborhood
-    for( y = 0; y < size.height; y++ )
-    {
-        const float* dX_min_row = dX_min.ptr<float>(y);
-        const float* dY_max_row = dY_max.ptr<float>(y);
-        float* orient_row = orient.ptr<float>(y);
-        uchar* mask_row = mask.ptr<uchar>(y);
-
-        for( x = 0; x < size.width; x++ )
-        {
-            float d0 = dY_max_row[x] - dX_min_row[x];
-
-            if( mask_row[x] == 0 || d0 < min_delta || max_delta < d0 )
-            {
-                mask_row[x] = (uchar)0;
-                orient_row[x] = 0.f;
-            }
-        }
-    }
+    parallel_for_(Range(0, size.height), [&](const Range& range) {
+        for( int y = range.start; y < range.end; y++ )
+            calcMotionGradientRow( dX.ptr<float>(y), dY.ptr<float>(y), mhiMin.ptr<float>(y), mhiMax.ptr<float>(y),
+                                   orient.ptr<float>(y), mask.ptr<uchar>(y), size.width,
+                                   gradient_epsilon, min_delta, max_delta );
+    });
 }
 
 double calcGlobalOrientation( InputArray _orientation, InputArray _mask,
@@ -265,7 +311,7 @@ double calcGlobalOrientation( InputArray _orientation, InputArray _mask,
     CV_Assert( mask.size() == size && orient.size() == size );
     CV_Assert( duration > 0 );
 
-    int histSize = 12;
+    int histSize = globalOrientHistSize;
     float _ranges[] = { 0.f, 360.f };
     const float* ranges = _ranges;
     Mat hist;
@@ -286,65 +332,127 @@ double calcGlobalOrientation( InputArray _orientation, InputArray _mask,
     float b = (float)(1. - timestamp * a);
     float delbound = (float)(timestamp - duration);
 
-    if( mhi.isContinuous() && mask.isContinuous() && orient.isContinuous() )
-    {
-        size.width *= size.height;
-        size.height = 1;
-    }
+    // the sums of the rows are added in order, so the result does not depend on the number of threads
+    std::vector<Vec2f> rowShifts(size.height);
+    parallel_for_(Range(0, size.height), [&](const Range& range) {
+        for( int y = range.start; y < range.end; y++ )
+            accumulateOrientationShift( mhi.ptr<float>(y), orient.ptr<float>(y), mask.ptr<uchar>(y), size.width,
+                                        fbaseOrient, a, b, delbound, rowShifts[y][0], rowShifts[y][1] );
+    });
 
-    /*
-     a = 254/(255*dt)
-     b = 1 - t*a = 1 - 254*t/(255*dur) =
-     (255*dt - 254*t)/(255*dt) =
-     (dt - (t - dt)*254)/(255*dt);
-     --------------------------------------------------------
-     ax + b = 254*x/(255*dt) + (dt - (t - dt)*254)/(255*dt) =
-     (254*x + dt - (t - dt)*254)/(255*dt) =
-     ((x - (t - dt))*254 + dt)/(255*dt) =
-     (((x - (t - dt))/dt)*254 + 1)/255 = (((x - low_time)/dt)*254 + 1)/255
-     */
     float shiftOrient = 0, shiftWeight = 0;
     for( int y = 0; y < size.height; y++ )
     {
-        const float* mhiptr = mhi.ptr<float>(y);
-        const float* oriptr = orient.ptr<float>(y);
-        const uchar* maskptr = mask.ptr<uchar>(y);
+        shiftOrient += rowShifts[y][0];
+        shiftWeight += rowShifts[y][1];
+    }
+
+    return finishGlobalOrientation( fbaseOrient, shiftOrient, shiftWeight );
+}
 
-        for( int x = 0; x < size.width; x++ )
+double updateMotionHistoryAndOrientation( InputArray _silhouette, InputOutputArray _mhi,
+                                          double timestamp, double duration,
+                                          double delta1, double delta2, int aperture_size )
+{
+    CV_Assert( _silhouette.type() == CV_8UC1 && _mhi.type() == CV_32FC1 );
+    CV_Assert( _silhouette.sameSize(_mhi) );
+    CV_Assert( duration > 0 );
+    checkMotionGradientParams( delta1, delta2, aperture_size );
+
+    if( delta1 > delta2 )
+        std::swap(delta1, delta2);
+
+    Mat silh = _silhouette.getMat(), mhi = _mhi.getMat();
+    const int rows = mhi.rows, cols = mhi.cols;
+    const float ts = (float)timestamp;
+    const float delbound = (float)(timestamp - duration);
+
+    parallel_for_(Range(0, rows), [&](const Range& range) {
+        for( int y = range.start; y < range.end; y++ )
+            updateMotionHistoryRow(silh.ptr<uchar>(y), mhi.ptr<float>(y), cols, ts, delbound);
+    });
+
+    const float gradient_epsilon = 1e-4f * aperture_size * aperture_size;
+    const float min_delta = (float)delta1;
+    const float max_delta = (float)delta2;
+
+    Mat dX, dY, mhiMin, mhiMax;
+    calcMotionGradientImages( mhi, aperture_size, dX, dY, mhiMin, mhiMax );
+
+    // Only the derivatives and the neighborhood extrema are whole images. The orientation and the mask
+    // of a row are computed into row buffers and used right away, once for the histogram and the
+    // maximal MHI value and once for the weighted sum.
+    const int histSize = globalOrientHistSize;
+    std::vector<int> rowHist(rows * histSize, 0);
+    std::vector<float> rowMaxTime(rows, -FLT_MAX);
+    parallel_for_(Range(0, rows), [&](const Range& range) {
+        AutoBuffer<float> _orient(cols);
+        AutoBuffer<uchar> _mask(cols);
+        float* orient = _orient.data();
+        uchar* mask = _mask.data();
+        for( int y = range.start; y < range.end; y++ )
         {
-            if( maskptr[x] != 0 && mhiptr[x] > delbound )
+            calcMotionGradientRow( dX.ptr<float>(y), dY.ptr<float>(y), mhiMin.ptr<float>(y), mhiMax.ptr<float>(y),
+                                   orient, mask, cols, gradient_epsilon, min_delta, max_delta );
+            const float* mhiptr = mhi.ptr<float>(y);
+            int* hist = &rowHist[y * histSize];
+            float maxTime = -FLT_MAX;
+            for( int x = 0; x < cols; x++ )
             {
-                /*
-                 orient in 0..360, base_orient in 0..360
-                 -> (rel_angle = orient - base_orient) in -360..360.
-                 rel_angle is translated to -180..180
-                 */
-                float weight = mhiptr[x] * a + b;
-                float relAngle = oriptr[x] - fbaseOrient;
-
-                relAngle += (relAngle < -180 ? 360 : 0);
-                relAngle += (relAngle > 180 ? -360 : 0);
-
-                if( fabs(relAngle) < 45 )
-                {
-                    shiftOrient += weight * relAngle;
-                    shiftWeight += weight;
-                }
+                if( !mask[x] )
+                    continue;
+                int bin = cvFloor(orient[x] * (histSize / 360.f));
+                if( (unsigned)bin < (unsigned)histSize )
+                    hist[bin]++;
+                maxTime = std::max(maxTime, mhiptr[x]);
             }
+            rowMaxTime[y] = maxTime;
         }
+    });
+
+    int hist[globalOrientHistSize] = { 0 };
+    float maxTime = -FLT_MAX;
+    for( int y = 0; y < rows; y++ )
+    {
+        for( int i = 0; i < histSize; i++ )
+            hist[i] += rowHist[y * histSize + i];
+        maxTime = std::max(maxTime, rowMaxTime[y]);
     }
 
-    // add the dominant orientation and the relative shift
-    if( shiftWeight == 0 )
-        shiftWeight = 0.01f;
+    // find the maximum index (the dominant orientation)
+    int baseOrientIdx = (int)(std::max_element(hist, hist + histSize) - hist);
+    float fbaseOrient = baseOrientIdx*360.f/histSize;
 
-    fbaseOrient += shiftOrient / shiftWeight;
-    fbaseOrient -= (fbaseOrient < 360 ? 0 : 360);
-    fbaseOrient += (fbaseOrient >= 0 ? 0 : 360);
+    // override timestamp with the maximum value in MHI
+    double maxTimestamp = maxTime == -FLT_MAX ? 0. : (double)maxTime;
+    float a = (float)(254. / 255. / duration);
+    float b = (float)(1. - maxTimestamp * a);
+    float shiftDelbound = (float)(maxTimestamp - duration);
+
+    std::vector<Vec2f> rowShifts(rows);
+    parallel_for_(Range(0, rows), [&](const Range& range) {
+        AutoBuffer<float> _orient(cols);
+        AutoBuffer<uchar> _mask(cols);
+        float* orient = _orient.data();
+        uchar* mask = _mask.data();
+        for( int y = range.start; y < range.end; y++ )
+        {
+            calcMotionGradientRow( dX.ptr<float>(y), dY.ptr<float>(y), mhiMin.ptr<float>(y), mhiMax.ptr<float>(y),
+                                   orient, mask, cols, gradient_epsilon, min_delta, max_delta );
+            accumulateOrientationShift( mhi.ptr<float>(y), orient, mask, cols,
+                                        fbaseOrient, a, b, shiftDelbound, rowShifts[y][0], rowShifts[y][1] );
+        }
+    });
 
-    return fbaseOrient;
-}
+    float shiftOrient = 0, shiftWeight = 0;
+    for( int y = 0; y < rows; y++ )
+    {
+        shiftOrient += rowShifts[y][0];
+        shiftWeight += rowShifts[y][1];
+    }
 
+    return finishGlobalOrientation( fbaseOrient, shiftOrient, shiftWeight );
+}
 
 void segmentMotion(InputArray _mhi, OutputArray _segmask,
                    vector<Rect>& boundingRects,
@@ -364,17 +472,9 @@ void segmentMotion(InputArray _mhi, OutputArray _segmask,
     int x, y;
 
     // protect zero mhi pixels from floodfill.
-    for( y = 0; y < mhi.rows; y++ )
-    {
-        const float* mhiptr = mhi.ptr<float>(y);
-        uchar* maskptr = mask.ptr<uchar>(y+1) + 1;
-
-        for( x = 0; x < mhi.cols; x++ )
-        {
-            if( mhiptr[x] == 0 )
-                maskptr[x] = 1;
-        }
-    }
+    Mat innerMask = mask(Rect(1, 1, mhi.cols, mhi.rows));
+    compare( mhi, Scalar::all(0), innerMask, CMP_EQ );
+    bitwise_and( innerMask, Scalar::all(1), innerMask );
 
     float ts = (float)timestamp;
     float comp_idx = 1.f;
@@ -358,10 +358,20 @@ int CImageBuffer::buildPyramid(cv::Size winSize, int maxLevel, float levelScale[
 {
     if (! m_Overwrite)
         return m_maxLevel;
+    if (m_Keep && !m_ImagePyramid.empty() && winSize.width <= m_builtWinSize.width && winSize.height <= m_builtWinSize.height)
+    {
+        // less levels than built are requested, or the number of levels was limited by the image size
+        if (maxLevel <= m_maxLevel)
+            return maxLevel;
+        if (m_maxLevel < m_builtMaxLevel)
+            return m_maxLevel;
+    }
     if (withBlurredImage)
         m_maxLevel = buildOpticalFlowPyramidScale(m_BlurredImage, m_ImagePyramid, winSize, maxLevel, false, 4, 0, true, levelScale);
     else
         m_maxLevel = buildOpticalFlowPyramidScale(m_Image, m_ImagePyramid, winSize, maxLevel, false, 4, 0, true, levelScale);
+    m_builtWinSize = winSize;
+    m_builtMaxLevel = maxLevel;
     return m_maxLevel;
 }
 
@@ -75,21 +75,24 @@ class CImageBuffer
 {
 public:
     CImageBuffer()
-        : m_Overwrite(true)
+        : m_maxLevel(0)
+        , m_Overwrite(true)
+        , m_Keep(false)
+        , m_builtMaxLevel(-1)
     {}
     void setGrayFromRGB(const cv::Mat & inp)
     {
-        if(m_Overwrite)
+        if(m_Overwrite && !m_Keep)
             cv::cvtColor(inp, m_Image, cv::COLOR_BGR2GRAY);
     }
     void setImage(const cv::Mat & inp)
     {
-        if(m_Overwrite)
+        if(m_Overwrite && !m_Keep)
             inp.copyTo(m_Image);
     }
     void setBlurFromRGB(const cv::Mat & inp)
     {
-        if(m_Overwrite)
+        if(m_Overwrite && !m_Keep)
             cv::GaussianBlur(inp, m_BlurredImage, cv::Size(7,7), -1);
     }
 
@@ -102,6 +105,11 @@ public:
     std::vector<cv::Mat>     m_CrossPyramid;
     int                      m_maxLevel;
     bool                     m_Overwrite;
+    //! the buffer already holds the image, which is not set again, and its pyramid is reused
+    //! if it has been built with enough levels and a large enough border
+    bool                     m_Keep;
+    cv::Size                 m_builtWinSize;
+    int                      m_builtMaxLevel;
 };
 
 void calcLocalOpticalFlow(
@@ -87,6 +87,7 @@ public:
         , use_variational_refinement(false)
         , sp_size(15)
         , slic_type(ximgproc::SLIC)
+        , use_warm_start(false)
 
     {
         prevPyramid[0] = cv::Ptr<CImageBuffer>(new CImageBuffer);
@@ -133,6 +134,9 @@ public:
     virtual void setRICSLICType(int val) CV_OVERRIDE { slic_type = static_cast<ximgproc::SLICType>(val); }
     virtual int  getRICSLICType() const CV_OVERRIDE { return slic_type; }
 
+    virtual void setUseWarmStart(bool val) CV_OVERRIDE { use_warm_start = val; }
+    virtual bool getUseWarmStart() const CV_OVERRIDE { return use_warm_start; }
+
     virtual void calc(InputArray I0, InputArray I1, InputOutputArray flow) CV_OVERRIDE
     {
         CV_Assert(!I0.empty() && I0.depth() == CV_8U && (I0.channels() == 3 || I0.channels() == 1));
@@ -147,21 +151,55 @@ public:
 
         Mat prevImage = I0.getMat();
         Mat currImage = I1.getMat();
-        int noPoints = prevImage.cols * prevImage.rows;
-        std::vector<cv::Point2f> prevPoints(noPoints);
-        std::vector<cv::Point2f> currPoints, refPoints;
-        noPoints = 0;
-        cv::Size grid_h = gridStep / 2;
-        for (int r = grid_h.height; r < prevImage.rows - grid_h.height; r += gridStep.height)
+
+        // on a video the first frame is usually the second frame of the previous call,
+        // then its pyramid is reused instead of being built again
+        bool isNextFrame = !lastImage.empty() && lastImage.size() == prevImage.size() && lastImage.type() == prevImage.type()
+            && cv::norm(lastImage, prevImage, NORM_INF) == 0;
+        for (int i = 0; i < 2; i++)
         {
-            for (int c = grid_h.width; c < prevImage.cols - grid_h.width; c += gridStep.width)
+            prevPyramid[i]->m_Keep = false;
+            currPyramid[i]->m_Keep = false;
+        }
+        if (isNextFrame)
+        {
+            std::swap(prevPyramid[0], currPyramid[0]);
+            prevPyramid[0]->m_Keep = true;
+        }
+        currImage.copyTo(lastImage);
+
+        if (gridStep != cachedGridStep || prevImage.size() != cachedGridSize)
+        {
+            int noPoints = prevImage.cols * prevImage.rows;
+            gridPoints.resize(noPoints);
+            noPoints = 0;
+            cv::Size grid_h = gridStep / 2;
+            for (int r = grid_h.height; r < prevImage.rows - grid_h.height; r += gridStep.height)
             {
-                prevPoints[noPoints++] = cv::Point2f(static_cast<float>(c), static_cast<float>(r));
+                for (int c = grid_h.width; c < prevImage.cols - grid_h.width; c += gridStep.width)
+                {
+                    gridPoints[noPoints++] = cv::Point2f(static_cast<float>(c), static_cast<float>(r));
+                }
             }
+            gridPoints.erase(gridPoints.begin() + noPoints, gridPoints.end());
+            cachedGridStep = gridStep;
+            cachedGridSize = prevImage.size();
         }
-        prevPoints.erase(prevPoints.begin() + noPoints, prevPoints.end());
+        const std::vector<cv::Point2f> & prevPoints = gridPoints;
+        std::vector<cv::Point2f> & currPoints = gridCurrPoints;
+        std::vector<cv::Point2f> & refPoints = gridRefPoints;
+        int noPoints = 0;
         currPoints.resize(prevPoints.size());
-        calcLocalOpticalFlow(prevImage, currImage, prevPyramid, currPyramid, prevPoints, currPoints, *(param.get()));
+
+        RLOFOpticalFlowParameter forwardParam = *(param.get());
+        if (use_warm_start && isNextFrame && lastFlow.size() == prevImage.size())
+        {
+            // start the search at the position predicted by the previous flow
+            for (size_t n = 0; n < prevPoints.size(); n++)
+                currPoints[n] = prevPoints[n] + lastFlow.at<Point2f>(prevPoints[n]);
+            forwardParam.useInitialFlow = true;
+        }
+        calcLocalOpticalFlow(prevImage, currImage, prevPyramid, currPyramid, prevPoints, currPoints, forwardParam);
         flow.create(prevImage.size(), CV_32FC2);
         Mat dense_flow = flow.getMat();
 
@@ -173,11 +211,14 @@ public:
             {
                 dense_flow.at<Point2f>(prevPoints[n]) = currPoints[n] - prevPoints[n];
             }
+            storeFlow(dense_flow);
             return;
         }
         if (forwardBackwardThreshold > 0)
         {
             // reuse image pyramids
+            prevPyramid[0]->m_Keep = true;
+            currPyramid[0]->m_Keep = true;
             calcLocalOpticalFlow(currImage, prevImage, currPyramid, prevPyramid, currPoints, refPoints, *(param.get()));
 
             filtered_prevPoints.resize(prevPoints.size());
@@ -206,11 +247,14 @@ public:
         // Interpolators below expect non empty matches
         if (filtered_prevPoints.empty()) {
             flow.setTo(0);
+            storeFlow(dense_flow);
             return;
         }
         if (interp_type == InterpolationType::INTERP_EPIC)
         {
-            Ptr<ximgproc::EdgeAwareInterpolator> gd = ximgproc::createEdgeAwareInterpolator();
+            if (epicInterpolator.empty())
+                epicInterpolator = ximgproc::createEdgeAwareInterpolator();
+            Ptr<ximgproc::EdgeAwareInterpolator> gd = epicInterpolator;
             gd->setK(k);
             gd->setSigma(sigma);
             gd->setLambda(lambda);
@@ -221,7 +265,9 @@ public:
         }
         else if (interp_type == InterpolationType::INTERP_RIC)
         {
-            Ptr<ximgproc::RICInterpolator> gd = ximgproc::createRICInterpolator();
+            if (ricInterpolator.empty())
+                ricInterpolator = ximgproc::createRICInterpolator();
+            Ptr<ximgproc::RICInterpolator> gd = ricInterpolator;
             gd->setK(k);
             gd->setFGSLambda(fgs_lambda);
             gd->setFGSSigma(fgs_sigma);
@@ -257,6 +303,7 @@ public:
             variationalrefine->setOmega(1.9f);
             variationalrefine->calc(prevGrey, currGrey, flow);
         }
+        storeFlow(flow.getMat());
     }
 
     virtual void collectGarbage() CV_OVERRIDE
@@ -265,6 +312,28 @@ public:
         prevPyramid[1].release();
         currPyramid[0].release();
         currPyramid[1].release();
+        prevPyramid[0] = makePtr<CImageBuffer>();
+        prevPyramid[1] = makePtr<CImageBuffer>();
+        currPyramid[0] = makePtr<CImageBuffer>();
+        currPyramid[1] = makePtr<CImageBuffer>();
+        lastImage.release();
+        lastFlow.release();
+        std::vector<Point2f>().swap(gridPoints);
+        std::vector<Point2f>().swap(gridCurrPoints);
+        std::vector<Point2f>().swap(gridRefPoints);
+        cachedGridSize = Size();
+        epicInterpolator.release();
+        ricInterpolator.release();
+    }
+
+protected:
+    void storeFlow(const Mat & dense_flow)
+    {
+        // the flow is only needed to warm start the next call
+        if (use_warm_start)
+            dense_flow.copyTo(lastFlow);
+        else
+            lastFlow.release();
     }
 
 protected:
@@ -283,6 +352,17 @@ protected:
     bool                          use_variational_refinement;
     int                           sp_size;
     ximgproc::SLICType            slic_type;
+    bool                          use_warm_start;
+    // state kept between the calls on a video
+    Mat                           lastImage;
+    Mat                           lastFlow;
+    std::vector<Point2f>          gridPoints;
+    std::vector<Point2f>          gridCurrPoints;
+    std::vector<Point2f>          gridRefPoints;
+    Size                          cachedGridStep;
+    Size                          cachedGridSize;
+    Ptr<ximgproc::EdgeAwareInterpolator> epicInterpolator;
+    Ptr<ximgproc::RICInterpolator> ricInterpolator;
 };
 
 Ptr<DenseRLOFOpticalFlow> DenseRLOFOpticalFlow::create(
@@ -404,6 +484,8 @@ class SparseRLOFOpticalFlowImpl : public SparseRLOFOpticalFlow
             errorMat.setTo(0);
         }
 
+        prevPyramid[0]->m_Keep = false;
+        currPyramid[0]->m_Keep = false;
         calcLocalOpticalFlow(prevImage, nextImage, prevPyramid, currPyramid, prevPoints, nextPoints, *(param.get()));
         cv::Mat(1,npoints , CV_32FC2, &nextPoints[0]).copyTo(nextPtsMat);
         if (forwardBackwardThreshold > 0)
@@ -413,6 +495,8 @@ class SparseRLOFOpticalFlowImpl : public SparseRLOFOpticalFlow
             bool temp_param = param->getUseInitialFlow();
             param->setUseInitialFlow(false);
             // reuse image pyramids
+            prevPyramid[0]->m_Keep = true;
+            currPyramid[0]->m_Keep = true;
             calcLocalOpticalFlow(nextImage, prevImage, currPyramid, prevPyramid, nextPoints, refPoints, *(param.get()));
             param->setUseInitialFlow(temp_param);
         }
@@ -41,6 +41,7 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 #ifdef _MSC_VER
 #   pragma warning(disable: 4512)
@@ -90,15 +91,16 @@ static void removeOcclusions(const Mat& flow,
   if (!confidence.data) {
     confidence = Mat::zeros(rows, cols, CV_32F);
   }
-  for (int r = 0; r < rows; ++r) {
-    for (int c = 0; c < cols; ++c) {
-      if (dist(flow.at<Vec2f>(r, c), -flow_inv.at<Vec2f>(r, c)) > occ_thr) {
-        confidence.at<float>(r, c) = 0;
-      } else {
-        confidence.at<float>(r, c) = 1;
+  parallel_for_(Range(0, rows), [&](const Range& range) {
+    for (int r = range.start; r < range.end; ++r) {
+      const Vec2f* flowRow = flow.ptr<Vec2f>(r);
+      const Vec2f* flowInvRow = flow_inv.ptr<Vec2f>(r);
+      float* confidenceRow = confidence.ptr<float>(r);
+      for (int c = 0; c < cols; ++c) {
+        confidenceRow[c] = (dist(flowRow[c], -flowInvRow[c]) > occ_thr) ? 0.f : 1.f;
       }
     }
-  }
+  });
 }
 
 static void wd(Mat& d, int top_shift, int bottom_shift, int left_shift, int right_shift, double sigma) {
@@ -231,44 +233,64 @@ static void calcConfidence(const Mat& prev,
   const int cols = prev.cols;
   confidence = Mat::zeros(rows, cols, CV_32F);
 
-  for (int r0 = 0; r0 < rows; ++r0) {
-    for (int c0 = 0; c0 < cols; ++c0) {
-      Vec2f flow_at_point = flow.at<Vec2f>(r0, c0);
-      int u0 = cvRound(flow_at_point[0]);
-      if (r0 + u0 < 0) { u0 = -r0; }
-      if (r0 + u0 >= rows) { u0 = rows - 1 - r0; }
-      int v0 = cvRound(flow_at_point[1]);
-      if (c0 + v0 < 0) { v0 = -c0; }
-      if (c0 + v0 >= cols) { v0 = cols - 1 - c0; }
-
-      const int top_row_shift = -std::min(r0 + u0, max_flow);
-      const int bottom_row_shift = std::min(rows - 1 - (r0 + u0), max_flow);
-      const int left_col_shift = -std::min(c0 + v0, max_flow);
-      const int right_col_shift = std::min(cols - 1 - (c0 + v0), max_flow);
-
-      bool first_flow_iteration = true;
-      int sum_e = 0, min_e = 0;
-
-      for (int u = top_row_shift; u <= bottom_row_shift; ++u) {
-        for (int v = left_col_shift; v <= right_col_shift; ++v) {
-          int e = dist(prev.at<Vec3b>(r0, c0), next.at<Vec3b>(r0 + u0 + u, c0 + v0 + v));
-          if (first_flow_iteration) {
-            sum_e = e;
-            min_e = e;
-            first_flow_iteration = false;
-          } else {
+  parallel_for_(Range(0, rows), [&](const Range& range) {
+    for (int r0 = range.start; r0 < range.end; ++r0) {
+      const Vec3b* prevRow = prev.ptr<Vec3b>(r0);
+      const Vec2f* flowRow = flow.ptr<Vec2f>(r0);
+      float* confidenceRow = confidence.ptr<float>(r0);
+      for (int c0 = 0; c0 < cols; ++c0) {
+        Vec2f flow_at_point = flowRow[c0];
+        int u0 = cvRound(flow_at_point[0]);
+        if (r0 + u0 < 0) { u0 = -r0; }
+        if (r0 + u0 >= rows) { u0 = rows - 1 - r0; }
+        int v0 = cvRound(flow_at_point[1]);
+        if (c0 + v0 < 0) { v0 = -c0; }
+        if (c0 + v0 >= cols) { v0 = cols - 1 - c0; }
+
+        const int top_row_shift = -std::min(r0 + u0, max_flow);
+        const int bottom_row_shift = std::min(rows - 1 - (r0 + u0), max_flow);
+        const int left_col_shift = -std::min(c0 + v0, max_flow);
+        const int right_col_shift = std::min(cols - 1 - (c0 + v0), max_flow);
+
+        const Vec3b& p = prevRow[c0];
+        int sum_e = 0, min_e = INT_MAX;
+
+        for (int u = top_row_shift; u <= bottom_row_shift; ++u) {
+          const Vec3b* nextRow = next.ptr<Vec3b>(r0 + u0 + u) + c0 + v0;
+          for (int v = left_col_shift; v <= right_col_shift; ++v) {
+            int e = dist(p, nextRow[v]);
             sum_e += e;
             min_e = std::min(min_e, e);
           }
         }
+        int windows_square = (bottom_row_shift - top_row_shift + 1) *
+                             (right_col_shift - left_col_shift + 1);
+        confidenceRow[c0] = (windows_square == 0) ? 0
+                                                  : static_cast<float>(sum_e) / windows_square - min_e;
+        CV_Assert(confidenceRow[c0] >= 0);
       }
-      int windows_square = (bottom_row_shift - top_row_shift + 1) *
-                           (right_col_shift - left_col_shift + 1);
-      confidence.at<float>(r0, c0) = (windows_square == 0) ? 0
-                                                           : static_cast<float>(sum_e) / windows_square - min_e;
-      CV_Assert(confidence.at<float>(r0, c0) >= 0);
     }
+  });
+}
+
+// weighted sum of squared differences between a row of the window in the next image and
+// the same row of the window in the previous image, converted to float
+static inline float weightedSqDiffRow(const uchar* next, const float* prev, const float* weights, int n) {
+  int k = 0;
+  float cost = 0;
+#if CV_SIMD128
+  v_float32x4 vcost = v_setzero_f32();
+  for (; k <= n - 4; k += 4) {
+    v_float32x4 diff = v_cvt_f32(v_reinterpret_as_s32(v_load_expand_q(next + k))) - v_load(prev + k);
+    vcost = v_fma(diff * diff, v_load(weights + k), vcost);
+  }
+  cost = v_reduce_sum(vcost);
+#endif
+  for (; k < n; k++) {
+    float diff = next[k] - prev[k];
+    cost += weights[k] * diff * diff;
   }
+  return cost;
 }
 
 template<typename SrcVec, typename DstVec>
@@ -297,17 +319,19 @@ public:
     }
 
     void operator()(const Range &range) const CV_OVERRIDE {
-      int d = 2 * radius + 1;
-      Mat weights(d, d, CV_32F);
+      // the images are 8-bit, the channels of a window row are processed as one array
+      const int d = 2 * radius + 1;
+      const int dcn = d * SrcVec::channels;
+      AutoBuffer<float> _weights(d * dcn), _prevWindow(d * dcn);
+      float *weights = _weights.data(), *prevWindow = _prevWindow.data();
       for (int i = range.start; i < range.end; i++) {
         const uchar *maskRow = mask.ptr<uchar>(i);
-        const DstVec *dstRow = dst.ptr<DstVec>(i);
+        DstVec *dstRow = dst.ptr<DstVec>(i);
         for (int j = 0; j < dst.cols; j++) {
           if (!maskRow[j]) {
             continue;
           }
 
-          // TODO: do smth with this creepy staff
           const DstVec &flowAtPoint = dstRow[j];
           int u0 = cvRound(flowAtPoint[0]);
           if (i + u0 < 0) {u0 = -i;}
@@ -325,17 +349,21 @@ public:
 
           const SrcVec& centeralPoint = prev.at<SrcVec>(i+radius, j+radius);
 
-          int left_border = j, right_border = j + d;
-          for (int dr = i, r = 0; dr < i + d; ++dr, ++r) {
-            const SrcVec *prevRow = prev.ptr<SrcVec>(dr);
+          // the weights and the window of prev do not depend on the tested flow
+          for (int r = 0; r < d; ++r) {
+            const SrcVec *prevRow = prev.ptr<SrcVec>(i + r) + j;
             const float* spaceWeightsRow = spaceWeights.ptr<float>(r);
-            float *weightsRow = weights.ptr<float>(r);
-            for (int dc = left_border, c = 0; dc < right_border; ++dc, ++c) {
+            float *weightsRow = weights + r * dcn;
+            float *prevWindowRow = prevWindow + r * dcn;
+            for (int c = 0; c < d; ++c) {
               double weight = spaceWeightsRow[c];
               for(int cn=0;cn<SrcVec::channels;cn++){
-                weight *= expLut[std::abs(centeralPoint[cn]-prevRow[dc][cn])];
+                weight *= expLut[std::abs(centeralPoint[cn]-prevRow[c][cn])];
+              }
+              for(int cn=0;cn<SrcVec::channels;cn++){
+                weightsRow[c * SrcVec::channels + cn] = static_cast<float>(weight);
+                prevWindowRow[c * SrcVec::channels + cn] = prevRow[c][cn];
               }
-              weightsRow[c] = static_cast<float>(weight);
             }
           }
 
@@ -346,14 +374,9 @@ public:
 
               float cost = 0;
               for (int r = 0; r < d; ++r) {
-                const SrcVec *prev_extended_window_row = prev.ptr<SrcVec>(i + r);
                 const SrcVec *next_extended_window_row = next.ptr<SrcVec>(next_extended_top_window_row + r);
-                const float *weight_window_row = weights.ptr<float>(r);
-                for (int c = 0; c < d; ++c) {
-                  cost += weight_window_row[c] *
-                          dist(prev_extended_window_row[j + c],
-                               next_extended_window_row[next_extended_left_window_col + c]);
-                }
+                cost += weightedSqDiffRow(next_extended_window_row[next_extended_left_window_col].val,
+                                          prevWindow + r * dcn, weights + r * dcn, dcn);
               }
               // cost should be divided by sum(weight_window), but because
               // we interested only in min(cost) and sum(weight_window) is constant
@@ -367,7 +390,7 @@ public:
             }
           }
 
-          dst.at<DstVec>(i, j) = DstVec(bestU, bestV);
+          dstRow[j] = DstVec(bestU, bestV);
         }
       }
     }
@@ -424,22 +447,27 @@ static Mat calcIrregularityMat(const Mat& flow, int radius) {
   const int rows = flow.rows;
   const int cols = flow.cols;
   Mat irregularity = Mat::zeros(rows, cols, CV_32F);
-  for (int r = 0; r < rows; ++r) {
-    const int start_row = std::max(0, r - radius);
-    const int end_row = std::min(rows - 1, r + radius);
-    for (int c = 0; c < cols; ++c) {
-      const int start_col = std::max(0, c - radius);
-      const int end_col = std::min(cols - 1, c + radius);
-      for (int dr = start_row; dr <= end_row; ++dr) {
-        for (int dc = start_col; dc <= end_col; ++dc) {
-          const float diff = dist(flow.at<Vec2f>(r, c), flow.at<Vec2f>(dr, dc));
-          if (diff > irregularity.at<float>(r, c)) {
-            irregularity.at<float>(r, c) = diff;
+  parallel_for_(Range(0, rows), [&](const Range& range) {
+    for (int r = range.start; r < range.end; ++r) {
+      const int start_row = std::max(0, r - radius);
+      const int end_row = std::min(rows - 1, r + radius);
+      const Vec2f* flowRow = flow.ptr<Vec2f>(r);
+      float* irregularityRow = irregularity.ptr<float>(r);
+      for (int c = 0; c < cols; ++c) {
+        const int start_col = std::max(0, c - radius);
+        const int end_col = std::min(cols - 1, c + radius);
+        const Vec2f& f = flowRow[c];
+        float maxDiff = irregularityRow[c];
+        for (int dr = start_row; dr <= end_row; ++dr) {
+          const Vec2f* neighborRow = flow.ptr<Vec2f>(dr);
+          for (int dc = start_col; dc <= end_col; ++dc) {
+            maxDiff = std::max(maxDiff, dist(f, neighborRow[dc]));
           }
         }
+        irregularityRow[c] = maxDiff;
       }
     }
-  }
+  });
   return irregularity;
 }
 
@@ -548,9 +576,11 @@ static void extrapolateFlow(Mat& flow,
   const int cols = flow.cols;
   Mat done = Mat::zeros(rows, cols, CV_8U);
   for (int r = 0; r < rows; ++r) {
+    const uchar* speedUpRow = speed_up.ptr<uchar>(r);
+    const uchar* doneRow = done.ptr<uchar>(r);
     for (int c = 0; c < cols; ++c) {
-      if (!done.at<uchar>(r, c) && speed_up.at<uchar>(r, c) > 1) {
-        int step = (1 << speed_up.at<uchar>(r, c)) - 1;
+      if (!doneRow[c] && speedUpRow[c] > 1) {
+        int step = (1 << speedUpRow[c]) - 1;
         int top = r;
         int bottom = std::min(r + step, rows - 1);
         int left = c;
@@ -558,14 +588,17 @@ static void extrapolateFlow(Mat& flow,
 
         int height = bottom - top;
         int width = right - left;
+        // the corners keep their values, so they are read once for the whole rectangle
+        const Vec2f top_left = flow.at<Vec2f>(top, left);
+        const Vec2f top_right = flow.at<Vec2f>(top, right);
+        const Vec2f bottom_left = flow.at<Vec2f>(bottom, left);
+        const Vec2f bottom_right = flow.at<Vec2f>(bottom, right);
         for (int rr = top; rr <= bottom; ++rr) {
+          uchar* doneRectRow = done.ptr<uchar>(rr);
+          Vec2f* flowRow = flow.ptr<Vec2f>(rr);
           for (int cc = left; cc <= right; ++cc) {
-            done.at<uchar>(rr, cc) = 1;
+            doneRectRow[cc] = 1;
             Vec2f flow_at_point;
-            Vec2f top_left = flow.at<Vec2f>(top, left);
-            Vec2f top_right = flow.at<Vec2f>(top, right);
-            Vec2f bottom_left = flow.at<Vec2f>(bottom, left);
-            Vec2f bottom_right = flow.at<Vec2f>(bottom, right);
 
             flow_at_point[0] = extrapolateValueInRect(height, width,
                                                       top_left[0], top_right[0],
@@ -576,7 +609,7 @@ static void extrapolateFlow(Mat& flow,
                                                       top_left[1], top_right[1],
                                                       bottom_left[1], bottom_right[1],
                                                       rr-top, cc-left);
-            flow.at<Vec2f>(rr, cc) = flow_at_point;
+            flowRow[cc] = flow_at_point;
           }
         }
       }
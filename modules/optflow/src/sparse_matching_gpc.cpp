@@ -84,6 +84,8 @@ const unsigned scoreGainNeg = 1;
 const unsigned negSearchKNN = 5;
 const double simulatedAnnealingTemperatureCoef = 200.0;
 const double sigmaGrowthRate = 0.2;
+const int minSamplesForParallelSplit = 4096;
+const int splitScoreStripes = 64;
 
 RNG rng;
 
@@ -469,6 +471,93 @@ void getRandomCauchyVector( Vec< double, GPCPatchDescriptor::nFeatures > &v )
 }
 
 double getRobustMedian( double m ) { return m < 0 ? m * ( 1.0 + epsTolerance ) : m * ( 1.0 - epsTolerance ); }
+
+class ParallelProjections : public ParallelLoopBody
+{
+private:
+  const GPCPatchSample *samples;
+  const Vec< double, GPCPatchDescriptor::nFeatures > &coef;
+  double *values;
+
+  ParallelProjections &operator=( const ParallelProjections & );
+
+public:
+  ParallelProjections( const GPCPatchSample *_samples, const Vec< double, GPCPatchDescriptor::nFeatures > &_coef, double *_values )
+      : samples( _samples ), coef( _coef ), values( _values ){};
+
+  void operator()( const Range &range ) const CV_OVERRIDE
+  {
+    for ( int i = range.start; i < range.end; ++i )
+      values[i] = samples[i].ref.dot( coef );
+  }
+};
+
+class ParallelSplitScore : public ParallelLoopBody
+{
+private:
+  const GPCPatchSample *samples;
+  const int nSamples;
+  const Vec< double, GPCPatchDescriptor::nFeatures > &coef;
+  const double rhs;
+  unsigned *stripeScores;
+
+  ParallelSplitScore &operator=( const ParallelSplitScore & );
+
+public:
+  ParallelSplitScore( const GPCPatchSample *_samples, int _nSamples, const Vec< double, GPCPatchDescriptor::nFeatures > &_coef,
+                      double _rhs, unsigned *_stripeScores )
+      : samples( _samples ), nSamples( _nSamples ), coef( _coef ), rhs( _rhs ), stripeScores( _stripeScores ){};
+
+  void operator()( const Range &range ) const CV_OVERRIDE
+  {
+    for ( int s = range.start; s < range.end; ++s )
+    {
+      const int begin = int( int64( nSamples ) * s / splitScoreStripes );
+      const int end = int( int64( nSamples ) * ( s + 1 ) / splitScoreStripes );
+      unsigned score = 0;
+      for ( int i = begin; i < end; ++i )
+      {
+        bool refdir, posdir, negdir;
+        samples[i].getDirections( refdir, posdir, negdir, coef, rhs );
+        if ( refdir == posdir )
+          score += scoreGainPos;
+        if ( refdir != negdir )
+          score += scoreGainNeg;
+      }
+      stripeScores[s] = score;
+    }
+  }
+};
+
+/* Projections of the reference patches onto the hyperplane normal. Large nodes are processed in parallel. */
+void getProjections( const GPCPatchSample *samples, int nSamples, const Vec< double, GPCPatchDescriptor::nFeatures > &coef,
+                     std::vector< double > &values )
+{
+  values.resize( nSamples );
+  ParallelProjections body( samples, coef, &values[0] );
+  if ( nSamples < minSamplesForParallelSplit )
+    body( Range( 0, nSamples ) );
+  else
+    parallel_for_( Range( 0, nSamples ), body );
+}
+
+/* Score of the split of the samples by the hyperplane. The stripes are summed in a fixed order, so the result does not
+ * depend on the number of threads. */
+unsigned getSplitScore( const GPCPatchSample *samples, int nSamples, const Vec< double, GPCPatchDescriptor::nFeatures > &coef,
+                        double rhs )
+{
+  unsigned stripeScores[splitScoreStripes];
+  ParallelSplitScore body( samples, nSamples, coef, rhs, stripeScores );
+  if ( nSamples < minSamplesForParallelSplit )
+    body( Range( 0, splitScoreStripes ) );
+  else
+    parallel_for_( Range( 0, splitScoreStripes ), body );
+
+  unsigned score = 0;
+  for ( int s = 0; s < splitScoreStripes; ++s )
+    score += stripeScores[s];
+  return score;
+}
 }
 
 double GPCPatchDescriptor::dot( const Vec< double, nFeatures > &coef ) const
@@ -536,7 +625,7 @@ bool GPCTree::trainNode( size_t nodeId, SIter begin, SIter end, unsigned depth )
   // Select the best hyperplane
   unsigned globalBestScore = 0;
   std::vector< double > values;
-  values.reserve( nSamples * 2 );
+  const GPCPatchSample *samples = &*begin;
 
   for ( int j = 0; j < globalIters; ++j )
   { // Global search step
@@ -549,10 +638,7 @@ bool GPCTree::trainNode( size_t nodeId, SIter begin, SIter end, unsigned depth )
       double randomModification = getRandomCauchyScalar() * ( 1.0 + sigmaGrowthRate * int( i / GPCPatchDescriptor::nFeatures ) );
       const int pos = i % GPCPatchDescriptor::nFeatures;
       std::swap( coef[pos], randomModification );
-      values.clear();
-
-      for ( SIter iter = begin; iter != end; ++iter )
-        values.push_back( iter->ref.dot( coef ) );
+      getProjections( samples, nSamples, coef, values );
 
       std::nth_element( values.begin(), values.begin() + nSamples / 2, values.end() );
       double median = values[nSamples / 2];
@@ -565,16 +651,7 @@ bool GPCTree::trainNode( size_t nodeId, SIter begin, SIter end, unsigned depth )
 
       median = getRobustMedian( median );
 
-      unsigned score = 0;
-      for ( SIter iter = begin; iter != end; ++iter )
-      {
-        bool refdir, posdir, negdir;
-        iter->getDirections( refdir, posdir, negdir, coef, median );
-        if ( refdir == posdir )
-          score += scoreGainPos;
-        if ( refdir != negdir )
-          score += scoreGainNeg;
-      }
+      const unsigned score = getSplitScore( samples, nSamples, coef, median );
 
       if ( score > localBestScore )
         localBestScore = score;
@@ -272,6 +272,31 @@ TEST(DenseOpticalFlow_RLOF, ReferenceAccuracy)
 
 }
 
+TEST(DenseOpticalFlow_RLOF, VideoStreaming)
+{
+    Mat frame1, frame2, GT;
+    ASSERT_TRUE(readRubberWhale(frame1, frame2, GT));
+    Mat flow, flowReused, flowWarm;
+
+    Ptr<DenseRLOFOpticalFlow> algo = DenseRLOFOpticalFlow::create();
+    algo->calc(frame1, frame2, flow);
+
+    // frame1 is the second frame of the previous call, so its pyramid is reused
+    Ptr<DenseRLOFOpticalFlow> algoVideo = DenseRLOFOpticalFlow::create();
+    algoVideo->calc(frame2, frame1, flowReused);
+    algoVideo->calc(frame1, frame2, flowReused);
+    EXPECT_EQ(0, cvtest::norm(flow, flowReused, NORM_INF));
+
+    Ptr<DenseRLOFOpticalFlow> algoWarm = DenseRLOFOpticalFlow::create();
+    algoWarm->setUseWarmStart(true);
+    // a static frame followed by the motion
+    algoWarm->calc(frame1, frame1, flowWarm);
+    algoWarm->calc(frame1, frame2, flowWarm);
+    ASSERT_EQ(GT.rows, flowWarm.rows);
+    ASSERT_EQ(GT.cols, flowWarm.cols);
+    EXPECT_LE(calcRMSE(GT, flowWarm), 0.55f);
+}
+
 TEST(DenseOpticalFlow_SparseToDenseFlow, ReferenceAccuracy)
 {
     Mat frame1, frame2, GT;
@@ -349,5 +374,110 @@ TEST(DenseOpticalFlow_GlobalPatchColliderWHT, ReferenceAccuracy)
     ASSERT_LE(calcAvgEPE(corr, GT), 0.5f);
 }
 
+/* Reference matching of the leaf trails by sorting both trail sets, as findCorrespondences used to do it. */
+static void findCorrespondencesBySorting(const vector< Ptr<GPCTree> >& trees, const Mat& imgFrom, const Mat& imgTo,
+                                         vector< pair<Point2i, Point2i> >& corr)
+{
+    typedef pair< vector<unsigned>, Point2i > Trail;
+    vector<Trail> trails[2];
+    const Mat* imgs[2] = { &imgFrom, &imgTo };
+
+    for (int k = 0; k < 2; ++k)
+    {
+        Mat img, ch[3];
+        imgs[k]->convertTo(img, CV_32FC3);
+        cvtColor(img, img, COLOR_BGR2YCrCb);
+        split(img, ch);
+
+        vector<GPCPatchDescriptor> descr;
+        GPCDetails::getAllDescriptorsForImage(ch, descr, GPCMatchingParams(), trees[0]->getDescriptorType());
+        trails[k].resize(descr.size());
+        for (size_t i = 0; i < descr.size(); ++i)
+        {
+            GPCDetails::getCoordinatesFromIndex(i, img.size(), trails[k][i].second.x, trails[k][i].second.y);
+            for (size_t t = 0; t < trees.size(); ++t)
+                trails[k][i].first.push_back(trees[t]->findLeafForPatch(descr[i]));
+        }
+    }
+
+    struct TrailLess
+    {
+        bool operator()(const Trail& a, const Trail& b) const { return a.first < b.first; }
+    };
+    const vector<Trail>& from = trails[0];
+    const vector<Trail>& to = trails[1];
+    std::sort(trails[0].begin(), trails[0].end(), TrailLess());
+    std::sort(trails[1].begin(), trails[1].end(), TrailLess());
+
+    for (size_t i = 0; i < from.size(); ++i)
+    {
+        bool uniq = true;
+        while (i + 1 < from.size() && from[i].first == from[i + 1].first)
+            ++i, uniq = false;
+        if (uniq)
+        {
+            vector<Trail>::const_iterator lb = std::lower_bound(to.begin(), to.end(), from[i], TrailLess());
+            if (lb != to.end() && lb->first == from[i].first && (lb + 1 == to.end() || (lb + 1)->first != lb->first))
+                corr.push_back(std::make_pair(from[i].second, lb->second));
+        }
+    }
+
+    GPCDetails::dropOutliers(corr);
+}
+
+static bool lessCorrespondence(const pair<Point2i, Point2i>& a, const pair<Point2i, Point2i>& b)
+{
+    if (a.first.y != b.first.y) return a.first.y < b.first.y;
+    if (a.first.x != b.first.x) return a.first.x < b.first.x;
+    if (a.second.y != b.second.y) return a.second.y < b.second.y;
+    return a.second.x < b.second.x;
+}
+
+TEST(DenseOpticalFlow_GlobalPatchColliderWHT, SameCorrespondencesAsSortedTrails)
+{
+    Mat frame1, frame2, GT;
+    ASSERT_TRUE(readRubberWhale(frame1, frame2, GT));
+
+    const Size sz = frame1.size() / 2;
+    frame1 = frame1(Rect(0, 0, sz.width, sz.height));
+    frame2 = frame2(Rect(0, 0, sz.width, sz.height));
+    GT = GT(Rect(0, 0, sz.width, sz.height));
+
+    vector<Mat> img1, img2, gt;
+    img1.push_back(frame1);
+    img2.push_back(frame2);
+    gt.push_back(GT);
+
+    Ptr< GPCForest<5> > forest = GPCForest<5>::create();
+    forest->train(img1, img2, gt, GPCTrainingParams(8, 3, GPC_DESCRIPTOR_WHT, false));
+
+    // Read the trained trees back, so the reference matching descends exactly the same forest
+    FileStorage fsWrite("forest.yml", FileStorage::WRITE + FileStorage::MEMORY);
+    forest->write(fsWrite);
+    FileStorage fsRead(fsWrite.releaseAndGetString(), FileStorage::READ + FileStorage::MEMORY);
+    vector< Ptr<GPCTree> > trees;
+    FileNode treesNode = fsRead["trees"];
+    for (FileNodeIterator it = treesNode.begin(); it != treesNode.end(); ++it)
+    {
+        trees.push_back(GPCTree::create());
+        trees.back()->read(*it);
+    }
+    ASSERT_EQ(5U, trees.size());
+
+    vector< pair<Point2i, Point2i> > corr, ref;
+    forest->findCorrespondences(frame1, frame2, corr);
+    findCorrespondencesBySorting(trees, frame1, frame2, ref);
+
+    // The hash join returns the correspondences in scan order, the sort-based matching in trail order
+    std::sort(corr.begin(), corr.end(), lessCorrespondence);
+    std::sort(ref.begin(), ref.end(), lessCorrespondence);
+    ASSERT_FALSE(ref.empty());
+    ASSERT_EQ(ref.size(), corr.size());
+    for (size_t i = 0; i < ref.size(); ++i)
+    {
+        ASSERT_EQ(ref[i].first, corr[i].first) << "i=" << i;
+        ASSERT_EQ(ref[i].second, corr[i].second) << "i=" << i;
+    }
+}
 
 }} // namespace
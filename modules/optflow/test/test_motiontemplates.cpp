@@ -494,6 +494,32 @@ int CV_MHIGlobalOrientTest::validate_test_results( int test_case_idx )
 }
 
 
+TEST(Video_MHIUpdateAndOrientation, matches_separate_calls)
+{
+    const Size size(160, 120);
+    const double duration = 1.0, delta1 = 0.05, delta2 = 0.5;
+    Mat mhi1 = Mat::zeros(size, CV_32F), mhi2 = Mat::zeros(size, CV_32F);
+
+    for( int frame = 1; frame <= 10; frame++ )
+    {
+        double timestamp = frame * 0.1;
+        Mat silh = Mat::zeros(size, CV_8U);
+        rectangle(silh, Rect(10 + frame * 8, 20 + frame * 3, 40, 30), Scalar::all(255), FILLED);
+
+        cv::motempl::updateMotionHistory(silh, mhi1, timestamp, duration);
+        Mat mask, orient;
+        cv::motempl::calcMotionGradient(mhi1, mask, orient, delta1, delta2, 3);
+        double angle = cv::motempl::calcGlobalOrientation(orient, mask, mhi1, timestamp, duration);
+
+        double fusedAngle = cv::motempl::updateMotionHistoryAndOrientation(silh, mhi2, timestamp, duration,
+                                                                           delta1, delta2, 3);
+
+        EXPECT_EQ(0, cvtest::norm(mhi1, mhi2, NORM_INF));
+        double diff = std::abs(angle - fusedAngle);
+        EXPECT_LT(std::min(diff, 360 - diff), 1e-2) << "frame " << frame;
+    }
+}
+
 TEST(Video_MHIUpdate, accuracy) { CV_UpdateMHITest test; test.safe_run(); }
 TEST(Video_MHIGradient, accuracy) { CV_MHIGradientTest test; test.safe_run(); }
 TEST(Video_MHIGlobalOrient, accuracy) { CV_MHIGlobalOrientTest test; test.safe_run(); }
@@ -199,7 +199,9 @@ namespace cv
             enum
             {
                 MODE_SGBM = 0,
-                MODE_HH   = 1
+                MODE_HH   = 1,
+                MODE_HH4  = 3,
+                MODE_HH8  = 4
             };
 
             virtual int getPreFilterCap() const = 0;
@@ -257,7 +259,9 @@ namespace cv
             Normally, 1 or 2 is good enough.
             @param mode Set it to StereoSGBM::MODE_HH to run the full-scale two-pass dynamic programming
             algorithm. It will consume O(W\*H\*numDisparities) bytes, which is large for 640x480 stereo and
-            huge for HD-size pictures. By default, it is set to false .
+            huge for HD-size pictures. StereoBinarySGBM::MODE_HH4 and StereoBinarySGBM::MODE_HH8 aggregate
+            the costs along 4 (horizontal and vertical) or 8 (also diagonal) paths using all the available
+            threads, with the same memory requirements as MODE_HH. By default, it is set to MODE_SGBM .
 
             The first constructor initializes StereoSGBM with all the default parameters. So, you only have to
             set StereoSGBM::numDisparities at minimum. The second constructor enables you to set each parameter
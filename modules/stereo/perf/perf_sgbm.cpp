@@ -0,0 +1,40 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+CV_ENUM(SGBMModes, StereoBinarySGBM::MODE_SGBM, StereoBinarySGBM::MODE_HH, StereoBinarySGBM::MODE_HH4, StereoBinarySGBM::MODE_HH8)
+
+typedef tuple<Size, int, SGBMModes> s_sgbm_test_t;
+typedef perf::TestBaseWithParam<s_sgbm_test_t> s_sgbm;
+
+PERF_TEST_P( s_sgbm, compute,
+            testing::Combine(
+            testing::Values( cv::Size(320, 240), cv::Size(640, 480) ),
+            testing::Values( 16, 64 ),
+            SGBMModes::all()
+            )
+            )
+{
+    Size sz = get<0>(GetParam());
+    int numDisparities = get<1>(GetParam());
+    int mode = get<2>(GetParam());
+
+    Mat left(sz, CV_8UC1);
+    Mat right(sz, CV_8UC1);
+    Mat disp(sz, CV_16S);
+    Ptr<StereoBinarySGBM> sgbm = StereoBinarySGBM::create(0, numDisparities, 5);
+    sgbm->setMode(mode);
+    declare
+        .in(left, WARMUP_RNG)
+        .in(right, WARMUP_RNG)
+        .out(disp);
+
+    TEST_CYCLE() sgbm->compute(left, right, disp);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
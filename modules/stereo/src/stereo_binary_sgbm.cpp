@@ -49,6 +49,7 @@ SGBM (Semi-global block matching)
 */
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 #include <limits.h>
 
 namespace cv
@@ -110,6 +111,97 @@ namespace cv
             int subpixelInterpolationMethod;
         };
 
+        /*
+        uniqueness check, disp2 bookkeeping and sub-pixel refinement for the winning disparity
+        bestDisp (with summary cost minS) of pixel x, Sp points to the summary costs of the pixel.
+        */
+        static inline void storeDisparity( const CostType* Sp, int x, int minS, int bestDisp,
+            int D, int minD, int minX1, int uniquenessRatio, int subpixelInterpolationMethod,
+            DispType* disp1ptr, CostType* disp2cost, DispType* disp2ptr )
+        {
+            const int DISP_SCALE = (1 << StereoMatcher::DISP_SHIFT);
+            int d;
+            for( d = 0; d < D; d++ )
+            {
+                if( Sp[d]*(100 - uniquenessRatio) < minS*100 && std::abs(bestDisp - d) > 1 )
+                    return;
+            }
+            d = bestDisp;
+            const int _x2 = x + minX1 - d - minD;
+            if( disp2cost[_x2] > minS )
+            {
+                disp2cost[_x2] = (CostType)minS;
+                disp2ptr[_x2] = (DispType)(d + minD);
+            }
+            if( 0 < d && d < D-1 )
+            {
+                if(subpixelInterpolationMethod == CV_SIMETRICV_INTERPOLATION)
+                {
+                    const double m2 = Sp[d - 1];
+                    const double m3 = Sp[d + 1];
+                    const double m1 = Sp[d];
+                    const double m2m1 = m2 - m1;
+                    const double m3m1 = m3 - m1;
+                    if (!(m2m1 == 0 || m3m1 == 0))
+                    {
+                        double p = 0;
+                        if (m2 > m3)
+                        {
+                            p = (0.5 - 0.25 * ((m3m1 * m3m1) / (m2m1 * m2m1) + (m3m1 / m2m1)));
+                        }
+                        else
+                        {
+                            p = -1 * (0.5 - 0.25 * ((m2m1 * m2m1) / (m3m1 * m3m1) + (m2m1 / m3m1)));
+                        }
+                        if (p >= -0.5 && p <= 0.5)
+                            d = (int)(d * DISP_SCALE + p * DISP_SCALE );
+                    }
+                    else
+                    {
+                        d *= DISP_SCALE;
+                    }
+                }
+                else if(subpixelInterpolationMethod == CV_QUADRATIC_INTERPOLATION)
+                {
+                    // do subpixel quadratic interpolation:
+                    //   fit parabola into (x1=d-1, y1=Sp[d-1]), (x2=d, y2=Sp[d]), (x3=d+1, y3=Sp[d+1])
+                    //   then find minimum of the parabola.
+                    const int denom2 = std::max(Sp[d-1] + Sp[d+1] - 2*Sp[d], 1);
+                    d = d*DISP_SCALE + ((Sp[d-1] - Sp[d+1])*DISP_SCALE + denom2)/(denom2*2);
+                }
+            }
+            else
+                d *= DISP_SCALE;
+            disp1ptr[x + minX1] = (DispType)(d + minD*DISP_SCALE);
+        }
+
+        /*
+        left-right consistency check of one row of disp1 against the reverse disparities in disp2.
+        */
+        static inline void checkDisparityConsistency( DispType* disp1ptr, const DispType* disp2ptr,
+            int minX1, int maxX1, int width, int minD, int disp12MaxDiff )
+        {
+            const int DISP_SHIFT = StereoMatcher::DISP_SHIFT;
+            const int DISP_SCALE = (1 << DISP_SHIFT);
+            const int INVALID_DISP_SCALED = (minD - 1)*DISP_SCALE;
+            for( int x = minX1; x < maxX1; x++ )
+            {
+                // we round the computed disparity both towards -inf and +inf and check
+                // if either of the corresponding disparities in disp2 is consistent.
+                // This is to give the computed disparity a chance to look valid if it is.
+                const int d1 = disp1ptr[x];
+                if( d1 == INVALID_DISP_SCALED )
+                    continue;
+                const int _d = d1 >> DISP_SHIFT;
+                const int d_ = (d1 + DISP_SCALE-1) >> DISP_SHIFT;
+                const int _x = x - _d;
+                const int x_ = x - d_;
+                if( 0 <= _x && _x < width && disp2ptr[_x] >= minD && std::abs(disp2ptr[_x] - _d) > disp12MaxDiff &&
+                    0 <= x_ && x_ < width && disp2ptr[x_] >= minD && std::abs(disp2ptr[x_] - d_) > disp12MaxDiff )
+                    disp1ptr[x] = (DispType)INVALID_DISP_SCALED;
+            }
+        }
+
         /*
         computes disparity for "roi" in img1 w.r.t. img2 and write it to disp1buf.
         that is, disp1buf(x, y)=d means that img1(x+roi.x, y+roi.y) ~ img2(x+roi.x-d, y+roi.y).
@@ -131,20 +223,8 @@ namespace cv
             Mat& disp1, const StereoBinarySGBMParams& params,
             Mat& buffer,const Mat& hamDist)
         {
-#if CV_SSE2
-            static const uchar LSBTab[] =
-            {
-                0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
-                5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
-                6, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
-                5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
-                7, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
-                5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
-                6, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
-                5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0
-            };
-
-            volatile bool useSIMD = checkHardwareSupport(CV_CPU_SSE2);
+#if CV_SIMD128
+            const bool useSIMD = hasSIMD128();
 #endif
 
             const int ALIGN = 16;
@@ -278,21 +358,17 @@ namespace cv
                                         const CostType* pixAdd = pixDiff + std::min(x + SW2*D, (width1-1)*D);
                                         const CostType* pixSub = pixDiff + std::max(x - (SW2+1)*D, 0);
 
-#if CV_SSE2
+#if CV_SIMD128
                                         if( useSIMD )
                                         {
                                             for( d = 0; d < D; d += 8 )
                                             {
-                                                __m128i hv = _mm_load_si128((const __m128i*)(hsumAdd + x - D + d));
-                                                __m128i Cx = _mm_load_si128((__m128i*)(Cprev + x + d));
-                                                hv = _mm_adds_epi16(_mm_subs_epi16(hv,
-                                                    _mm_load_si128((const __m128i*)(pixSub + d))),
-                                                    _mm_load_si128((const __m128i*)(pixAdd + d)));
-                                                Cx = _mm_adds_epi16(_mm_subs_epi16(Cx,
-                                                    _mm_load_si128((const __m128i*)(hsumSub + x + d))),
-                                                    hv);
-                                                _mm_store_si128((__m128i*)(hsumAdd + x + d), hv);
-                                                _mm_store_si128((__m128i*)(C + x + d), Cx);
+                                                v_int16x8 hv = v_load(hsumAdd + x - D + d);
+                                                v_int16x8 Cx = v_load(Cprev + x + d);
+                                                hv = (hv - v_load(pixSub + d)) + v_load(pixAdd + d);
+                                                Cx = (Cx - v_load(hsumSub + x + d)) + hv;
+                                                v_store(hsumAdd + x + d, hv);
+                                                v_store(C + x + d, Cx);
                                             }
                                         }
                                         else
@@ -368,56 +444,54 @@ namespace cv
                         CostType* Lr_p = Lr[0] + xd;
                         const CostType* Cp = C + x*D;
                         CostType* Sp = S + x*D;
-#if CV_SSE2
+#if CV_SIMD128
                         if( useSIMD )
                         {
-                            __m128i _P1 = _mm_set1_epi16((short)P1);
-                            __m128i _delta0 = _mm_set1_epi16((short)delta0);
-                            __m128i _delta1 = _mm_set1_epi16((short)delta1);
-                            __m128i _delta2 = _mm_set1_epi16((short)delta2);
-                            __m128i _delta3 = _mm_set1_epi16((short)delta3);
-                            __m128i _minL0 = _mm_set1_epi16((short)MAX_COST);
+                            v_int16x8 _P1 = v_setall_s16((short)P1);
+                            v_int16x8 _delta0 = v_setall_s16((short)delta0);
+                            v_int16x8 _delta1 = v_setall_s16((short)delta1);
+                            v_int16x8 _delta2 = v_setall_s16((short)delta2);
+                            v_int16x8 _delta3 = v_setall_s16((short)delta3);
+                            v_int16x8 _minL0 = v_setall_s16((short)MAX_COST);
                             for( d = 0; d < D; d += 8 )
                             {
-                                __m128i Cpd = _mm_load_si128((const __m128i*)(Cp + d));
-                                __m128i L0, L1, L2, L3;
-                                L0 = _mm_load_si128((const __m128i*)(Lr_p0 + d));
-                                L1 = _mm_load_si128((const __m128i*)(Lr_p1 + d));
-                                L2 = _mm_load_si128((const __m128i*)(Lr_p2 + d));
-                                L3 = _mm_load_si128((const __m128i*)(Lr_p3 + d));
-                                L0 = _mm_min_epi16(L0, _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(Lr_p0 + d - 1)), _P1));
-                                L0 = _mm_min_epi16(L0, _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(Lr_p0 + d + 1)), _P1));
-                                L1 = _mm_min_epi16(L1, _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(Lr_p1 + d - 1)), _P1));
-                                L1 = _mm_min_epi16(L1, _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(Lr_p1 + d + 1)), _P1));
-                                L2 = _mm_min_epi16(L2, _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(Lr_p2 + d - 1)), _P1));
-                                L2 = _mm_min_epi16(L2, _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(Lr_p2 + d + 1)), _P1));
-                                L3 = _mm_min_epi16(L3, _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(Lr_p3 + d - 1)), _P1));
-                                L3 = _mm_min_epi16(L3, _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(Lr_p3 + d + 1)), _P1));
-                                L0 = _mm_min_epi16(L0, _delta0);
-                                L0 = _mm_adds_epi16(_mm_subs_epi16(L0, _delta0), Cpd);
-                                L1 = _mm_min_epi16(L1, _delta1);
-                                L1 = _mm_adds_epi16(_mm_subs_epi16(L1, _delta1), Cpd);
-                                L2 = _mm_min_epi16(L2, _delta2);
-                                L2 = _mm_adds_epi16(_mm_subs_epi16(L2, _delta2), Cpd);
-                                L3 = _mm_min_epi16(L3, _delta3);
-                                L3 = _mm_adds_epi16(_mm_subs_epi16(L3, _delta3), Cpd);
-                                _mm_store_si128( (__m128i*)(Lr_p + d), L0);
-                                _mm_store_si128( (__m128i*)(Lr_p + d + D2), L1);
-                                _mm_store_si128( (__m128i*)(Lr_p + d + D2*2), L2);
-                                _mm_store_si128( (__m128i*)(Lr_p + d + D2*3), L3);
-                                __m128i t0 = _mm_min_epi16(_mm_unpacklo_epi16(L0, L2), _mm_unpackhi_epi16(L0, L2));
-                                __m128i t1 = _mm_min_epi16(_mm_unpacklo_epi16(L1, L3), _mm_unpackhi_epi16(L1, L3));
-                                t0 = _mm_min_epi16(_mm_unpacklo_epi16(t0, t1), _mm_unpackhi_epi16(t0, t1));
-                                _minL0 = _mm_min_epi16(_minL0, t0);
-                                __m128i Sval = _mm_load_si128((const __m128i*)(Sp + d));
-                                L0 = _mm_adds_epi16(L0, L1);
-                                L2 = _mm_adds_epi16(L2, L3);
-                                Sval = _mm_adds_epi16(Sval, L0);
-                                Sval = _mm_adds_epi16(Sval, L2);
-                                _mm_store_si128((__m128i*)(Sp + d), Sval);
+                                v_int16x8 Cpd = v_load(Cp + d);
+                                v_int16x8 L0, L1, L2, L3;
+                                L0 = v_load(Lr_p0 + d);
+                                L1 = v_load(Lr_p1 + d);
+                                L2 = v_load(Lr_p2 + d);
+                                L3 = v_load(Lr_p3 + d);
+                                L0 = v_min(L0, v_load(Lr_p0 + d - 1) + _P1);
+                                L0 = v_min(L0, v_load(Lr_p0 + d + 1) + _P1);
+                                L1 = v_min(L1, v_load(Lr_p1 + d - 1) + _P1);
+                                L1 = v_min(L1, v_load(Lr_p1 + d + 1) + _P1);
+                                L2 = v_min(L2, v_load(Lr_p2 + d - 1) + _P1);
+                                L2 = v_min(L2, v_load(Lr_p2 + d + 1) + _P1);
+                                L3 = v_min(L3, v_load(Lr_p3 + d - 1) + _P1);
+                                L3 = v_min(L3, v_load(Lr_p3 + d + 1) + _P1);
+                                L0 = (v_min(L0, _delta0) - _delta0) + Cpd;
+                                L1 = (v_min(L1, _delta1) - _delta1) + Cpd;
+                                L2 = (v_min(L2, _delta2) - _delta2) + Cpd;
+                                L3 = (v_min(L3, _delta3) - _delta3) + Cpd;
+                                v_store(Lr_p + d, L0);
+                                v_store(Lr_p + d + D2, L1);
+                                v_store(Lr_p + d + D2*2, L2);
+                                v_store(Lr_p + d + D2*3, L3);
+                                // transpose-and-min, lanes 0..3 end up with the minima of L0..L3
+                                v_int16x8 t0, t1, t2, t3;
+                                v_zip(L0, L2, t0, t1);
+                                v_zip(L1, L3, t2, t3);
+                                t0 = v_min(t0, t1);
+                                t2 = v_min(t2, t3);
+                                v_zip(t0, t2, t1, t3);
+                                _minL0 = v_min(_minL0, v_min(t1, t3));
+                                v_int16x8 Sval = v_load(Sp + d);
+                                Sval = Sval + (L0 + L1);
+                                Sval = Sval + (L2 + L3);
+                                v_store(Sp + d, Sval);
                             }
-                            _minL0 = _mm_min_epi16(_minL0, _mm_srli_si128(_minL0, 8));
-                            _mm_storel_epi64((__m128i*)&minLr[0][xm], _minL0);
+                            _minL0 = v_min(_minL0, v_rotate_right<4>(_minL0));
+                            v_store_low(&minLr[0][xm], _minL0);
                         }
                         else
 #endif
@@ -478,45 +552,40 @@ namespace cv
                                 Lr_p0[-1] = Lr_p0[D] = MAX_COST;
                                 CostType* Lr_p = Lr[0] + xd;
                                 const CostType* Cp = C + x*D;
-#if CV_SSE2
+#if CV_SIMD128
                                 if( useSIMD )
                                 {
-                                    __m128i _P1 = _mm_set1_epi16((short)P1);
-                                    __m128i _delta0 = _mm_set1_epi16((short)delta0);
-                                    __m128i _minL0 = _mm_set1_epi16((short)minL0);
-                                    __m128i _minS = _mm_set1_epi16(MAX_COST), _bestDisp = _mm_set1_epi16(-1);
-                                    __m128i _d8 = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7), _8 = _mm_set1_epi16(8);
+                                    v_int16x8 _P1 = v_setall_s16((short)P1);
+                                    v_int16x8 _delta0 = v_setall_s16((short)delta0);
+                                    v_int16x8 _minL0 = v_setall_s16((short)minL0);
+                                    v_int16x8 _minS = v_setall_s16(MAX_COST), _bestDisp = v_setall_s16(-1);
+                                    v_int16x8 _d8(0, 1, 2, 3, 4, 5, 6, 7), _8 = v_setall_s16(8);
                                     for( d = 0; d < D; d += 8 )
                                     {
-                                        __m128i Cpd = _mm_load_si128((const __m128i*)(Cp + d)), L0;
-                                        L0 = _mm_load_si128((const __m128i*)(Lr_p0 + d));
-                                        L0 = _mm_min_epi16(L0, _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(Lr_p0 + d - 1)), _P1));
-                                        L0 = _mm_min_epi16(L0, _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(Lr_p0 + d + 1)), _P1));
-                                        L0 = _mm_min_epi16(L0, _delta0);
-                                        L0 = _mm_adds_epi16(_mm_subs_epi16(L0, _delta0), Cpd);
-                                        _mm_store_si128((__m128i*)(Lr_p + d), L0);
-                                        _minL0 = _mm_min_epi16(_minL0, L0);
-                                        L0 = _mm_adds_epi16(L0, *(__m128i*)(Sp + d));
-                                        _mm_store_si128((__m128i*)(Sp + d), L0);
-                                        __m128i mask = _mm_cmpgt_epi16(_minS, L0);
-                                        _minS = _mm_min_epi16(_minS, L0);
-                                        _bestDisp = _mm_xor_si128(_bestDisp, _mm_and_si128(_mm_xor_si128(_bestDisp,_d8), mask));
-                                        _d8 = _mm_adds_epi16(_d8, _8);
+                                        v_int16x8 Cpd = v_load(Cp + d), L0;
+                                        L0 = v_load(Lr_p0 + d);
+                                        L0 = v_min(L0, v_load(Lr_p0 + d - 1) + _P1);
+                                        L0 = v_min(L0, v_load(Lr_p0 + d + 1) + _P1);
+                                        L0 = (v_min(L0, _delta0) - _delta0) + Cpd;
+                                        v_store(Lr_p + d, L0);
+                                        _minL0 = v_min(_minL0, L0);
+                                        L0 = L0 + v_load(Sp + d);
+                                        v_store(Sp + d, L0);
+                                        v_int16x8 mask = _minS > L0;
+                                        _minS = v_min(_minS, L0);
+                                        _bestDisp = v_select(mask, _d8, _bestDisp);
+                                        _d8 = _d8 + _8;
                                     }
-                                    short CV_DECL_ALIGNED(16) bestDispBuf[8];
-                                    _mm_store_si128((__m128i*)bestDispBuf, _bestDisp);
-                                    _minL0 = _mm_min_epi16(_minL0, _mm_srli_si128(_minL0, 8));
-                                    _minL0 = _mm_min_epi16(_minL0, _mm_srli_si128(_minL0, 4));
-                                    _minL0 = _mm_min_epi16(_minL0, _mm_srli_si128(_minL0, 2));
-                                    __m128i qS = _mm_min_epi16(_minS, _mm_srli_si128(_minS, 8));
-                                    qS = _mm_min_epi16(qS, _mm_srli_si128(qS, 4));
-                                    qS = _mm_min_epi16(qS, _mm_srli_si128(qS, 2));
-                                    minLr[0][xm] = (CostType)_mm_cvtsi128_si32(_minL0);
-                                    minS = (CostType)_mm_cvtsi128_si32(qS);
-                                    qS = _mm_shuffle_epi32(_mm_unpacklo_epi16(qS, qS), 0);
-                                    qS = _mm_cmpeq_epi16(_minS, qS);
-                                    int idx = _mm_movemask_epi8(_mm_packs_epi16(qS, qS)) & 255;
-                                    bestDisp = bestDispBuf[LSBTab[idx]];
+                                    minLr[0][xm] = (CostType)v_reduce_min(_minL0);
+                                    minS = v_reduce_min(_minS);
+                                    // like before, ties are resolved in favour of the lowest lane holding the minimum
+                                    short CV_DECL_ALIGNED(16) minSBuf[8], bestDispBuf[8];
+                                    v_store_aligned(minSBuf, _minS);
+                                    v_store_aligned(bestDispBuf, _bestDisp);
+                                    int idx = 0;
+                                    while( minSBuf[idx] != minS )
+                                        idx++;
+                                    bestDisp = bestDispBuf[idx];
                                 }
                                 else
 #endif
@@ -548,83 +617,263 @@ namespace cv
                                     }
                                 }
                             }
-                            for( d = 0; d < D; d++ )
-                            {
-                                if( Sp[d]*(100 - uniquenessRatio) < minS*100 && std::abs(bestDisp - d) > 1 )
-                                    break;
-                            }
-                            if( d < D )
-                                continue;
-                            d = bestDisp;
-                            const int _x2 = x + minX1 - d - minD;
-                            if( disp2cost[_x2] > minS )
-                            {
-                                disp2cost[_x2] = (CostType)minS;
-                                disp2ptr[_x2] = (DispType)(d + minD);
-                            }
-                            if( 0 < d && d < D-1 )
+                            storeDisparity( Sp, x, minS, bestDisp, D, minD, minX1, uniquenessRatio,
+                                            params.subpixelInterpolationMethod, disp1ptr, disp2cost, disp2ptr );
+                        }
+                        checkDisparityConsistency( disp1ptr, disp2ptr, minX1, maxX1, width, minD, disp12MaxDiff );
+                    }
+                    // now shift the cyclic buffers
+                    std::swap( Lr[0], Lr[1] );
+                    std::swap( minLr[0], minLr[1] );
+                }
+            }
+        }
+        /*
+        one step of the dynamic programming along a path:
+        L_r(p, d) = C(p, d) + min(L_r(p-r, d), L_r(p-r, d-1) + P1, L_r(p-r, d+1) + P1, min_k L_r(p-r, k) + P2) - min_k L_r(p-r, k)
+        Lprev must have MAX_COST at indices -1 and D, C already contains the added P2, delta = min_k L_r(p-r, k) + P2.
+        L_r(p, .) is written to Lcur, added to the summary cost Sp, and its minimum is returned.
+        */
+        static inline int aggregatePathCost( const CostType* Cp, const CostType* Lprev, CostType* Lcur, CostType* Sp,
+            int D, int P1, int delta )
+        {
+            int d = 0, minL = SHRT_MAX;
+#if CV_SIMD128
+            if( hasSIMD128() )
+            {
+                v_int16x8 _P1 = v_setall_s16((short)P1);
+                v_int16x8 _delta = v_setall_s16((short)delta);
+                v_int16x8 _minL = v_setall_s16(SHRT_MAX);
+                for( ; d < D; d += 8 )
+                {
+                    v_int16x8 L = v_load(Lprev + d);
+                    L = v_min(L, v_load(Lprev + d - 1) + _P1);
+                    L = v_min(L, v_load(Lprev + d + 1) + _P1);
+                    L = (v_min(L, _delta) - _delta) + v_load(Cp + d);
+                    v_store(Lcur + d, L);
+                    _minL = v_min(_minL, L);
+                    v_store(Sp + d, v_load(Sp + d) + L);
+                }
+                minL = v_reduce_min(_minL);
+            }
+#endif
+            for( ; d < D; d++ )
+            {
+                const int L = Cp[d] + std::min((int)Lprev[d], std::min(Lprev[d-1] + P1, std::min(Lprev[d+1] + P1, delta))) - delta;
+                Lcur[d] = (CostType)L;
+                minL = std::min(minL, L);
+                Sp[d] = saturate_cast<CostType>(Sp[d] + L);
+            }
+            return minL;
+        }
+
+        /*
+        box-filters one row of the hamming cost volume horizontally, replicating the border pixels
+        */
+        static void computeHSumRow( const short* ham, int k, int width, int width1, int D, int numDisparities, int SW2,
+            CostType* pixDiff, CostType* hsumAdd )
+        {
+            for( int x = 0; x < width1; x++ )
+            {
+                const short* hamRow = ham + ((size_t)k * width + x) * (numDisparities + 1);
+                for( int d = 0; d < D; d++ )
+                    pixDiff[x*D + d] = (CostType)hamRow[d];
+            }
+            for( int d = 0; d < D; d++ )
+                hsumAdd[d] = (CostType)(pixDiff[d]*(SW2 + 1));
+            for( int x = D; x <= SW2*D; x += D )
+                for( int d = 0; d < D; d++ )
+                    hsumAdd[d] = (CostType)(hsumAdd[d] + pixDiff[x + d]);
+            for( int x = D; x < width1*D; x += D )
+            {
+                const CostType* pixAdd = pixDiff + std::min(x + SW2*D, (width1-1)*D);
+                const CostType* pixSub = pixDiff + std::max(x - (SW2+1)*D, 0);
+                int d = 0;
+#if CV_SIMD128
+                if( hasSIMD128() )
+                {
+                    for( ; d < D; d += 8 )
+                        v_store(hsumAdd + x + d, (v_load(hsumAdd + x - D + d) - v_load(pixSub + d)) + v_load(pixAdd + d));
+                }
+#endif
+                for( ; d < D; d++ )
+                    hsumAdd[x + d] = (CostType)(hsumAdd[x - D + d] + pixAdd[d] - pixSub[d]);
+            }
+        }
+
+        /*
+        the multi-threaded variant used by MODE_HH4 and MODE_HH8.
+        The whole matching cost volume C and summary cost volume S are kept in memory, like in MODE_HH.
+        C is computed by row stripes in parallel. Every aggregation direction is then processed
+        as a set of independent scanlines (rows, columns or diagonals) that are distributed among
+        the threads, the directions themselves are accumulated into S one after another.
+        Finally, the disparities of all rows are selected in parallel.
+        */
+        static void computeDisparityBinarySGBMParallel( Mat& disp1, const StereoBinarySGBMParams& params,
+            Mat& buffer, const Mat& hamDist )
+        {
+            const int ALIGN = 16;
+            const int DISP_SCALE = (1 << StereoMatcher::DISP_SHIFT);
+            const CostType MAX_COST = SHRT_MAX;
+            const int minD = params.minDisparity;
+            const int maxD = minD + params.numDisparities;
+            const int kernelSize = params.kernelSize > 0 ? params.kernelSize : 5;
+            const int uniquenessRatio = params.uniquenessRatio >= 0 ? params.uniquenessRatio : 10;
+            const int disp12MaxDiff = params.disp12MaxDiff > 0 ? params.disp12MaxDiff : 1;
+            const int P1 = params.P1 > 0 ? params.P1 : 2;
+            const int P2 = std::max(params.P2 > 0 ? params.P2 : 5, P1+1);
+            const int width = disp1.cols, height = disp1.rows;
+            const int minX1 = std::max(-maxD, 0);
+            const int maxX1 = width + std::min(minD, 0);
+            const int D = maxD - minD;
+            const int width1 = maxX1 - minX1;
+            const int INVALID_DISP_SCALED = (minD - 1)*DISP_SCALE;
+            const int SW2 = kernelSize/2, SH2 = kernelSize/2;
+            const int hsumBufNRows = SH2*2 + 2;
+            const short* ham = hamDist.ptr<short>();
+
+            if( minX1 >= maxX1 )
+            {
+                disp1 = Scalar::all(INVALID_DISP_SCALED);
+                return;
+            }
+            CV_Assert( D % 16 == 0 );
+
+            const size_t costBufSize = (size_t)width1*D;
+            const size_t totalBufSize = costBufSize*height*2*sizeof(CostType) + ALIGN;
+            if( buffer.empty() || !buffer.isContinuous() ||
+                buffer.cols*buffer.rows*buffer.elemSize() < totalBufSize )
+                buffer.create(1, (int)totalBufSize, CV_8U);
+            CostType* Cbuf = (CostType*)alignPtr(buffer.ptr(), ALIGN);
+            CostType* Sbuf = Cbuf + costBufSize*height;
+
+            // the stripes do not depend on the number of threads, so neither does the result
+            const int stripeHeight = 32;
+            const int nstripes = (height + stripeHeight - 1)/stripeHeight;
+
+            // C(y) = P2 + sum of hsum(clamp(j)) for j = y-SH2..y+SH2, every stripe slides its own window
+            parallel_for_(Range(0, nstripes), [&](const Range& range)
+            {
+                AutoBuffer<CostType> _buf(costBufSize*(hsumBufNRows + 1) + 16);
+                CostType* hsumBuf = alignPtr(_buf.data(), ALIGN);
+                CostType* pixDiff = hsumBuf + costBufSize*hsumBufNRows;
+                for( int stripe = range.start; stripe < range.end; stripe++ )
+                {
+                    const int y0 = stripe*stripeHeight, y1 = std::min(y0 + stripeHeight, height);
+                    for( int y = y0; y < y1; y++ )
+                    {
+                        CostType* C = Cbuf + y*costBufSize;
+                        if( y == y0 )
+                        {
+                            for( int k = std::max(y - SH2, 0); k <= std::min(y + SH2, height - 1); k++ )
+                                computeHSumRow(ham, k, width, width1, D, params.numDisparities, SW2, pixDiff,
+                                               hsumBuf + (k % hsumBufNRows)*costBufSize);
+                            for( size_t i = 0; i < costBufSize; i++ )
+                                C[i] = (CostType)P2;
+                            for( int j = y - SH2; j <= y + SH2; j++ )
                             {
-                                if(params.subpixelInterpolationMethod == CV_SIMETRICV_INTERPOLATION)
-                                {
-                                    const double m2 = Sp[d - 1];
-                                    const double m3 = Sp[d + 1];
-                                    const double m1 = Sp[d];
-                                    const double m2m1 = m2 - m1;
-                                    const double m3m1 = m3 - m1;
-                                    if (!(m2m1 == 0 || m3m1 == 0))
-                                    {
-                                        double p = 0;
-                                        if (m2 > m3)
-                                        {
-                                            p = (0.5 - 0.25 * ((m3m1 * m3m1) / (m2m1 * m2m1) + (m3m1 / m2m1)));
-                                        }
-                                        else
-                                        {
-                                            p = -1 * (0.5 - 0.25 * ((m2m1 * m2m1) / (m3m1 * m3m1) + (m2m1 / m3m1)));
-                                        }
-                                        if (p >= -0.5 && p <= 0.5)
-                                            d = (int)(d * DISP_SCALE + p * DISP_SCALE );
-                                    }
-                                    else
-                                    {
-                                        d *= DISP_SCALE;
-                                    }
-                                }
-                                else if(params.subpixelInterpolationMethod == CV_QUADRATIC_INTERPOLATION)
-                                {
-                                    // do subpixel quadratic interpolation:
-                                    //   fit parabola into (x1=d-1, y1=Sp[d-1]), (x2=d, y2=Sp[d]), (x3=d+1, y3=Sp[d+1])
-                                    //   then find minimum of the parabola.
-                                    const int denom2 = std::max(Sp[d-1] + Sp[d+1] - 2*Sp[d], 1);
-                                    d = d*DISP_SCALE + ((Sp[d-1] - Sp[d+1])*DISP_SCALE + denom2)/(denom2*2);
-                                }
+                                const CostType* hsum = hsumBuf + (std::min(std::max(j, 0), height - 1) % hsumBufNRows)*costBufSize;
+                                for( size_t i = 0; i < costBufSize; i++ )
+                                    C[i] = (CostType)(C[i] + hsum[i]);
                             }
-                            else
-                                d *= DISP_SCALE;
-                            disp1ptr[x + minX1] = (DispType)(d + minD*DISP_SCALE);
+                            continue;
                         }
-                        for( x = minX1; x < maxX1; x++ )
+                        if( y + SH2 < height )
+                            computeHSumRow(ham, y + SH2, width, width1, D, params.numDisparities, SW2, pixDiff,
+                                           hsumBuf + ((y + SH2) % hsumBufNRows)*costBufSize);
+                        const CostType* hsumAdd = hsumBuf + (std::min(y + SH2, height - 1) % hsumBufNRows)*costBufSize;
+                        const CostType* hsumSub = hsumBuf + (std::max(y - SH2 - 1, 0) % hsumBufNRows)*costBufSize;
+                        const CostType* Cprev = C - costBufSize;
+                        size_t i = 0;
+#if CV_SIMD128
+                        if( hasSIMD128() )
                         {
-                            // we round the computed disparity both towards -inf and +inf and check
-                            // if either of the corresponding disparities in disp2 is consistent.
-                            // This is to give the computed disparity a chance to look valid if it is.
-                            const int d1 = disp1ptr[x];
-                            if( d1 == INVALID_DISP_SCALED )
-                                continue;
-                            const int _d = d1 >> DISP_SHIFT;
-                            const int d_ = (d1 + DISP_SCALE-1) >> DISP_SHIFT;
-                            const int _x = x - _d;
-                            const int x_ = x - d_;
-                            if( 0 <= _x && _x < width && disp2ptr[_x] >= minD && std::abs(disp2ptr[_x] - _d) > disp12MaxDiff &&
-                                0 <= x_ && x_ < width && disp2ptr[x_] >= minD && std::abs(disp2ptr[x_] - d_) > disp12MaxDiff )
-                                disp1ptr[x] = (DispType)INVALID_DISP_SCALED;
+                            for( ; i < costBufSize; i += 8 )
+                                v_store(C + i, (v_load(Cprev + i) - v_load(hsumSub + i)) + v_load(hsumAdd + i));
                         }
+#endif
+                        for( ; i < costBufSize; i++ )
+                            C[i] = (CostType)(Cprev[i] + hsumAdd[i] - hsumSub[i]);
                     }
-                    // now shift the cyclic buffers
-                    std::swap( Lr[0], Lr[1] );
-                    std::swap( minLr[0], minLr[1] );
                 }
+            });
+
+            memset(Sbuf, 0, costBufSize*height*sizeof(CostType));
+
+            // directions r = (dx, dy) of the paths, the last four are only used by MODE_HH8
+            static const int dirs[8][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {-1, -1}, {-1, 1}, {1, -1} };
+            const int ndirs = params.mode == StereoBinarySGBM::MODE_HH8 ? 8 : 4;
+            for( int dir = 0; dir < ndirs; dir++ )
+            {
+                const int dx = dirs[dir][0], dy = dirs[dir][1];
+                // the scanlines start on the first row (if dy != 0) and on the first column (if dx != 0)
+                const int nRowStarts = dy != 0 ? width1 : 0;
+                const int nColStarts = dx != 0 ? (dy != 0 ? height - 1 : height) : 0;
+                parallel_for_(Range(0, nRowStarts + nColStarts), [&](const Range& range)
+                {
+                    AutoBuffer<CostType> _Lr((D + 16)*2);
+                    CostType* Lr[2] = { alignPtr(_Lr.data(), ALIGN) + 8, 0 };
+                    Lr[1] = Lr[0] + D + 8;
+                    for( int line = range.start; line < range.end; line++ )
+                    {
+                        int x, y;
+                        if( line < nRowStarts )
+                        {
+                            x = line;
+                            y = dy > 0 ? 0 : height - 1;
+                        }
+                        else
+                        {
+                            const int j = line - nRowStarts + (dy != 0 ? 1 : 0);
+                            x = dx > 0 ? 0 : width1 - 1;
+                            y = dy < 0 ? height - 1 - j : j;
+                        }
+                        memset(Lr[1], 0, D*sizeof(CostType));
+                        Lr[1][-1] = Lr[1][D] = Lr[0][-1] = Lr[0][D] = MAX_COST;
+                        int minLr = 0;
+                        for( ; 0 <= x && x < width1 && 0 <= y && y < height; x += dx, y += dy )
+                        {
+                            const size_t ofs = (size_t)y*costBufSize + (size_t)x*D;
+                            minLr = aggregatePathCost(Cbuf + ofs, Lr[1], Lr[0], Sbuf + ofs, D, P1, minLr + P2);
+                            std::swap(Lr[0], Lr[1]);
+                        }
+                    }
+                });
             }
+
+            parallel_for_(Range(0, height), [&](const Range& range)
+            {
+                AutoBuffer<CostType> _disp2cost(width);
+                AutoBuffer<DispType> _disp2(width);
+                CostType* disp2cost = _disp2cost.data();
+                DispType* disp2ptr = _disp2.data();
+                for( int y = range.start; y < range.end; y++ )
+                {
+                    DispType* disp1ptr = disp1.ptr<DispType>(y);
+                    const CostType* S = Sbuf + y*costBufSize;
+                    for( int x = 0; x < width; x++ )
+                    {
+                        disp1ptr[x] = disp2ptr[x] = (DispType)INVALID_DISP_SCALED;
+                        disp2cost[x] = MAX_COST;
+                    }
+                    for( int x = width1 - 1; x >= 0; x-- )
+                    {
+                        const CostType* Sp = S + x*D;
+                        int minS = MAX_COST, bestDisp = -1;
+                        for( int d = 0; d < D; d++ )
+                        {
+                            if( Sp[d] < minS )
+                            {
+                                minS = Sp[d];
+                                bestDisp = d;
+                            }
+                        }
+                        storeDisparity( Sp, x, minS, bestDisp, D, minD, minX1, uniquenessRatio,
+                                        params.subpixelInterpolationMethod, disp1ptr, disp2cost, disp2ptr );
+                    }
+                    checkDisparityConsistency( disp1ptr, disp2ptr, minX1, maxX1, width, minD, disp12MaxDiff );
+                }
+            });
         }
         class StereoBinarySGBMImpl CV_FINAL : public StereoBinarySGBM, public Matching
         {
@@ -689,7 +938,10 @@ namespace cv
 
                 hammingDistanceBlockMatching(censusImageLeft, censusImageRight, hamDist, params.kernelSize);
 
-                computeDisparityBinarySGBM( left, disp, params, buffer,hamDist);
+                if( params.mode == MODE_HH4 || params.mode == MODE_HH8 )
+                    computeDisparityBinarySGBMParallel( disp, params, buffer, hamDist );
+                else
+                    computeDisparityBinarySGBM( left, disp, params, buffer,hamDist);
 
                 if(params.regionRemoval == CV_SPECKLE_REMOVAL_AVG_ALGORITHM)
                 {
@@ -232,5 +232,36 @@ void CV_SGBlockMatchingTest::run(int )
 TEST(block_matching_simple_test, accuracy) { CV_BlockMatchingTest test; test.safe_run(); }
 TEST(SG_block_matching_simple_test, accuracy) { CV_SGBlockMatchingTest test; test.safe_run(); }
 
+typedef testing::TestWithParam<int> SG_block_matching_parallel;
+
+TEST_P(SG_block_matching_parallel, accuracy)
+{
+    Mat image1 = imread(cvtest::findDataFile("stereomatching/datasets/tsukuba/im2.png"), IMREAD_GRAYSCALE);
+    Mat image2 = imread(cvtest::findDataFile("stereomatching/datasets/tsukuba/im6.png"), IMREAD_GRAYSCALE);
+    Mat gt = imread(cvtest::findDataFile("stereomatching/datasets/tsukuba/disp2.png"), IMREAD_GRAYSCALE);
+    ASSERT_FALSE(image1.empty() || image2.empty() || gt.empty());
+
+    Ptr<StereoBinarySGBM> sgbm = StereoBinarySGBM::create(0, 16, 9, 10, 100, 1, 0, 1, 400, 200, GetParam());
+    sgbm->setSpekleRemovalTechnique(CV_SPECKLE_REMOVAL_AVG_ALGORITHM);
+    sgbm->setSubPixelInterpolationMethod(CV_SIMETRICV_INTERPOLATION);
+
+    Mat disp, dispSingleThread;
+    sgbm->compute(image1, image2, disp);
+    int nthreads = getNumThreads();
+    setNumThreads(1);
+    sgbm->compute(image1, image2, dispSingleThread);
+    setNumThreads(nthreads);
+    // the scanlines are split among the threads, the result must not depend on their number
+    EXPECT_EQ(0, cvtest::norm(disp, dispSingleThread, NORM_INF));
+
+    double minVal, maxVal;
+    minMaxLoc(disp, &minVal, &maxVal);
+    Mat test;
+    disp.convertTo(test, CV_8UC1, 255 / (maxVal - minVal));
+    EXPECT_LE(errorLevel(gt, test), 20);
+}
+
+INSTANTIATE_TEST_CASE_P(/**/, SG_block_matching_parallel, testing::Values((int)StereoBinarySGBM::MODE_HH4, (int)StereoBinarySGBM::MODE_HH8));
+
 
 }} // namespace
\ No newline at end of file
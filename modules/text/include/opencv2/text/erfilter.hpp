@@ -347,6 +347,22 @@ An example of MSERsToERStats in use can be found in the text detection webcam_de
 CV_EXPORTS void MSERsToERStats(InputArray image, std::vector<std::vector<Point> > &contours,
                                std::vector<std::vector<ERStat> > &regions);
 
+/** @brief Applies the 1st and 2nd stage filters to a set of independent channels.
+
+@param channels Input channels, e.g. the output of computeNMChannels(). Each one should be CV_8UC1.
+@param er_filter1 Extremal Region Filter for the 1st stage classifier of N&M algorithm @cite Neumann12
+@param er_filter2 Extremal Region Filter for the 2nd stage classifier, can be empty.
+@param regions Output vector with the filtered regions of each channel.
+
+The result is the same as calling er_filter1->run() and er_filter2->run() on every channel. The
+filters created by createERFilterNM1() and createERFilterNM2() keep a worker per channel and reuse
+it between calls. When they use the classifiers returned by loadClassifierNM1() and loadClassifierNM2() the channels
+are processed in parallel; a user supplied ERFilter::Callback is never called concurrently, the
+channels are then processed one after another.
+ */
+CV_EXPORTS void runERFilter(InputArrayOfArrays channels, const Ptr<ERFilter>& er_filter1, const Ptr<ERFilter>& er_filter2,
+                            std::vector< std::vector<ERStat> >& regions);
+
 // Utility funtion for scripting
 CV_EXPORTS_W void detectRegions(InputArray image, const Ptr<ERFilter>& er_filter1, const Ptr<ERFilter>& er_filter2, CV_OUT std::vector< std::vector<Point> >& regions);
 
@@ -225,6 +225,9 @@ public:
     provides also the Rects for individual text elements found (e.g. words), and the list of those
     text elements with their confidence values.
 
+    Every call decodes from the emission probabilities table given to create(), the table is not
+    modified by the decoding.
+
     @param image Input binary image CV_8UC1 with a single text line (or word).
 
     @param output_text Output text. Most likely character sequence found by the HMM decoder.
@@ -271,6 +274,34 @@ public:
                      std::vector<std::string>* component_texts=NULL, std::vector<float>* component_confidences=NULL,
                      int component_level=0) CV_OVERRIDE;
 
+    /** @brief Recognizes text in a batch of images.
+
+    Every image is processed as in run() and its results are stored at the same index of the
+    output vectors. The images are processed in parallel when the decoder uses a classifier
+    returned by loadOCRHMMClassifierNM() or loadOCRHMMClassifierCNN(); a user supplied
+    ClassifierCallback is never called concurrently.
+
+    @param images Input images, see run().
+
+    @param output_texts Output text found in every image.
+
+    @param component_rects If provided the method will output the Rects of the text elements
+    found in every image.
+
+    @param component_texts If provided the method will output the text strings of the text
+    elements found in every image.
+
+    @param component_confidences If provided the method will output the confidence values of
+    the text elements found in every image.
+
+    @param component_level Only OCR_LEVEL_WORD is supported.
+     */
+    virtual void runBatch(InputArrayOfArrays images, std::vector<std::string>& output_texts,
+                          std::vector<std::vector<Rect> >* component_rects=NULL,
+                          std::vector<std::vector<std::string> >* component_texts=NULL,
+                          std::vector<std::vector<float> >* component_confidences=NULL,
+                          int component_level=0);
+
     // aliases for scripting
     CV_WRAP String run(InputArray image, int min_confidence, int component_level=0);
 
@@ -419,6 +450,18 @@ public:
          */
         virtual void eval( InputArray image, std::vector< std::vector<double> >& recognition_probabilities, std::vector<int>& oversegmentation );
 
+        /** @brief Classifies the sliding windows of a batch of images.
+
+        The default implementation calls eval() for every image.
+
+        @param images Input images CV_8UC1 or CV_8UC3, each one with a single word.
+        @param recognition_probabilities The recognition probabilities returned by eval() for
+        every image.
+        @param oversegmentation The oversegmentation returned by eval() for every image.
+         */
+        virtual void evalBatch( InputArrayOfArrays images, std::vector< std::vector< std::vector<double> > >& recognition_probabilities,
+                                std::vector< std::vector<int> >& oversegmentation );
+
         int getWindowSize() {return 0;}
         int getStepSize() {return 0;}
     };
@@ -453,6 +496,33 @@ public:
                      std::vector<std::string>* component_texts=NULL, std::vector<float>* component_confidences=NULL,
                      int component_level=0) CV_OVERRIDE;
 
+    /** @brief Recognizes text in a batch of images.
+
+    Every image is processed as in run() and its results are stored at the same index of the
+    output vectors. The sliding windows of all the images are classified by one call to
+    ClassifierCallback::evalBatch(), then the words are decoded in parallel.
+
+    @param images Input images, see run().
+
+    @param output_texts Output text found in every image.
+
+    @param component_rects If provided the method will output the Rects of the text elements
+    found in every image.
+
+    @param component_texts If provided the method will output the text strings of the text
+    elements found in every image.
+
+    @param component_confidences If provided the method will output the confidence values of
+    the text elements found in every image.
+
+    @param component_level Only OCR_LEVEL_WORD is supported.
+     */
+    virtual void runBatch(InputArrayOfArrays images, std::vector<std::string>& output_texts,
+                          std::vector<std::vector<Rect> >* component_rects=NULL,
+                          std::vector<std::vector<std::string> >* component_texts=NULL,
+                          std::vector<std::vector<float> >* component_confidences=NULL,
+                          int component_level=0);
+
     // aliases for scripting
     CV_WRAP String run(InputArray image, int min_confidence, int component_level=0);
 
@@ -18,6 +18,17 @@ namespace text {
     @param chainBBs an optional parameter which chains the letter candidates according to heuristics in the paper and returns all possible regions where text is likely to occur.
     */
     CV_EXPORTS_W void detectTextSWT (InputArray input, CV_OUT std::vector<cv::Rect>& result, bool dark_on_light, OutputArray& draw=noArray(), OutputArray & chainBBs =noArray());
+
+/** @brief Applies detectTextSWT() for both text polarities. The edges and gradients of the image are computed once and
+    shared by the dark on light and light on dark detections.
+    @param input the input image with 3 channels.
+    @param result_dark_on_light the letter candidates found for text darker than the background.
+    @param result_light_on_dark the letter candidates found for text lighter than the background.
+    @param chainBBs_dark_on_light if not NULL, the chained text regions found for text darker than the background.
+    @param chainBBs_light_on_dark if not NULL, the chained text regions found for text lighter than the background.
+    */
+    CV_EXPORTS void detectTextSWT (InputArray input, std::vector<cv::Rect>& result_dark_on_light, std::vector<cv::Rect>& result_light_on_dark,
+                                   std::vector<cv::Rect>* chainBBs_dark_on_light = NULL, std::vector<cv::Rect>* chainBBs_light_on_dark = NULL);
 }
 }
 
@@ -0,0 +1,50 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+CV_ENUM(GroupingMode, ERGROUPING_ORIENTATION_HORIZ, ERGROUPING_ORIENTATION_ANY)
+
+typedef tuple<std::string, GroupingMode> ERGroupingParams;
+typedef TestBaseWithParam<ERGroupingParams> ERGroupingTest;
+
+PERF_TEST_P(ERGroupingTest, erGrouping,
+            testing::Combine(
+                testing::Values("text/scenetext01.jpg", "text/scenetext03.jpg", "text/scenetext05.jpg"),
+                GroupingMode::all()))
+{
+    const std::string imageName = get<0>(GetParam());
+    const int mode = get<1>(GetParam());
+
+    Mat src = imread(getDataPath(imageName));
+    ASSERT_FALSE(src.empty());
+
+    std::vector<Mat> channels;
+    computeNMChannels(src, channels);
+    for (size_t c = channels.size(); c > 0; c--)
+        channels.push_back(255 - channels[c - 1]);
+
+    Ptr<ERFilter> er_filter1 = createERFilterNM1(loadClassifierNM1(getDataPath("trained_classifierNM1.xml")),
+                                                 16, 0.00015f, 0.13f, 0.2f, true, 0.1f);
+    Ptr<ERFilter> er_filter2 = createERFilterNM2(loadClassifierNM2(getDataPath("trained_classifierNM2.xml")), 0.5);
+    std::vector<std::vector<ERStat> > regions;
+    runERFilter(channels, er_filter1, er_filter2, regions);
+
+    const std::string groupingClassifier = (mode == ERGROUPING_ORIENTATION_ANY) ?
+        getDataPath("trained_classifier_erGrouping.xml") : std::string();
+    std::vector<std::vector<Vec2i> > groups;
+    std::vector<Rect> groupRects;
+
+    TEST_CYCLE()
+    {
+        groups.clear();
+        groupRects.clear();
+        erGrouping(src, channels, regions, groups, groupRects, mode, groupingClassifier, 0.5f);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
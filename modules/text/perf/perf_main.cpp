@@ -0,0 +1,9 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+CV_PERF_TEST_MAIN(text,
+    cvtest::addDataSearchSubDirectory("contrib"),
+    cvtest::addDataSearchSubDirectory("contrib/text")
+)
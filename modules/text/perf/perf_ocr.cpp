@@ -0,0 +1,60 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef tuple<int, bool> OCRBatchParams;
+typedef TestBaseWithParam<OCRBatchParams> OCRBeamSearchBatch;
+
+PERF_TEST_P(OCRBeamSearchBatch, run,
+            testing::Combine(testing::Values(16, 64), testing::Bool()))
+{
+    const int nwords = get<0>(GetParam());
+    const bool batched = get<1>(GetParam());
+
+    const std::string vocabulary = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    FileStorage fs(getDataPath("OCRHMM_transitions_table.xml"), FileStorage::READ);
+    Mat transition_p;
+    fs["transition_probabilities"] >> transition_p;
+    ASSERT_FALSE(transition_p.empty());
+    Ptr<OCRBeamSearchDecoder> ocr = OCRBeamSearchDecoder::create(
+            loadOCRBeamSearchClassifierCNN(getDataPath("OCRBeamSearch_CNN_model_data.xml.gz")),
+            vocabulary, transition_p, Mat::eye(62, 62, CV_64FC1), OCR_DECODER_VITERBI, 50);
+
+    RNG rng(0);
+    std::vector<Mat> images(nwords);
+    for (int i = 0; i < nwords; i++)
+    {
+        std::string word;
+        int len = rng.uniform(3, 9);
+        for (int c = 0; c < len; c++)
+            word += vocabulary[rng.uniform(0, (int)vocabulary.size())];
+        images[i] = Mat(48, 40 + 28*len, CV_8UC1, Scalar::all(255));
+        putText(images[i], word, Point(20, 38), FONT_HERSHEY_SIMPLEX, 1.2, Scalar::all(0), 3);
+    }
+
+    std::vector<std::string> texts(nwords);
+    std::vector<std::vector<float> > confidences;
+
+    TEST_CYCLE()
+    {
+        if (batched)
+        {
+            ocr->runBatch(images, texts, NULL, NULL, &confidences, OCR_LEVEL_WORD);
+        }
+        else
+        {
+            std::vector<Rect> rects;
+            std::vector<std::string> componentTexts;
+            std::vector<float> componentConfidences;
+            for (int i = 0; i < nwords; i++)
+                ocr->run(images[i], texts[i], &rects, &componentTexts, &componentConfidences, OCR_LEVEL_WORD);
+        }
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
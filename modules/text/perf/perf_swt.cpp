@@ -0,0 +1,34 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef TestBaseWithParam<std::string> SWTTest;
+
+PERF_TEST_P(SWTTest, detectTextSWT,
+            testing::Values("text/scenetext01.jpg", "text/scenetext03.jpg", "text/scenetext05.jpg"))
+{
+    Mat src = imread(getDataPath(GetParam()), IMREAD_COLOR);
+    ASSERT_FALSE(src.empty());
+    std::vector<Rect> components;
+
+    TEST_CYCLE() detectTextSWT(src, components, true);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(SWTTest, detectTextSWT_both_polarities,
+            testing::Values("text/scenetext01.jpg", "text/scenetext03.jpg", "text/scenetext05.jpg"))
+{
+    Mat src = imread(getDataPath(GetParam()), IMREAD_COLOR);
+    ASSERT_FALSE(src.empty());
+    std::vector<Rect> darkOnLight, lightOnDark;
+
+    TEST_CYCLE() detectTextSWT(src, darkOnLight, lightOnDark);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
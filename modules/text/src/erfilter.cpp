@@ -71,27 +71,6 @@ using namespace cv::ml;
 using namespace std;
 using namespace cv::ml;
 
-// Deletes a tree of ERStat regions starting at root. Used only
-// internally to this implementation.
-static void deleteERStatTree(ERStat* root) {
-    queue<ERStat*> to_delete;
-    to_delete.push(root);
-    while (!to_delete.empty()) {
-        ERStat* n = to_delete.front();
-        to_delete.pop();
-        ERStat* c = n->child;
-        if (c != NULL) {
-            to_delete.push(c);
-            ERStat* sibling = c->next;
-            while (sibling != NULL) {
-                to_delete.push(sibling);
-                sibling = sibling->next;
-            }
-        }
-        delete n;
-    }
-}
-
 ERStat::ERStat(int init_level, int init_pixel, int init_x, int init_y) : pixel(init_pixel),
                level(init_level), area(0), perimeter(0), euler(0), probability(1.0),
                parent(0), child(0), next(0), prev(0), local_maxima(0),
@@ -108,6 +87,90 @@ ERStat::ERStat(int init_level, int init_pixel, int init_x, int init_y) : pixel(i
 }
 
 
+// Pool of the ERStat nodes used while extracting a component tree. The nodes live in a deque,
+// so their addresses stay valid while the pool grows, and the nodes (and the crossings buffers)
+// released during the extraction are recycled. The pool is kept by the filter and reused by
+// the following runs, so that the allocator is not called for every extracted region.
+class ERStatPool
+{
+public:
+    ERStatPool() : used(0) {}
+
+    ERStat* create(int level = 256, int pixel = 0, int x = 0, int y = 0)
+    {
+        ERStat* er;
+        if (!free_nodes.empty())
+        {
+            er = free_nodes.back();
+            free_nodes.pop_back();
+        }
+        else
+        {
+            if (used == nodes.size())
+                nodes.push_back(ERStat());
+            er = &nodes[used++];
+        }
+
+        // same initial state as the ERStat constructor
+        Ptr<deque<int> > crossings;
+        if (er->crossings && er->crossings.use_count() == 1)
+            crossings = er->crossings;
+        else if (!free_crossings.empty())
+        {
+            crossings = free_crossings.back();
+            free_crossings.pop_back();
+        }
+        else
+            crossings = makePtr<deque<int> >();
+        crossings->clear();
+        crossings->push_back(0);
+
+        er->pixel = pixel;
+        er->level = level;
+        er->area = 0;
+        er->perimeter = 0;
+        er->euler = 0;
+        er->rect = Rect(x, y, 1, 1);
+        er->raw_moments[0] = er->raw_moments[1] = 0.0;
+        er->central_moments[0] = er->central_moments[1] = er->central_moments[2] = 0.0;
+        er->crossings = crossings;
+        er->probability = 1.0;
+        er->parent = er->child = er->next = er->prev = NULL;
+        er->local_maxima = false;
+        er->max_probability_ancestor = er->min_probability_ancestor = NULL;
+        return er;
+    }
+
+    // drops the crossings of a node, keeping the buffer for later nodes if nobody else shares it
+    void releaseCrossings(ERStat* er)
+    {
+        if (er->crossings && er->crossings.use_count() == 1)
+            free_crossings.push_back(er->crossings);
+        er->crossings.release();
+    }
+
+    void release(ERStat* er)
+    {
+        releaseCrossings(er);
+        free_nodes.push_back(er);
+    }
+
+    // makes all the nodes available again
+    void reset()
+    {
+        for (size_t i = 0; i < used; i++)
+            releaseCrossings(&nodes[i]);
+        used = 0;
+        free_nodes.clear();
+    }
+
+private:
+    deque<ERStat> nodes;
+    size_t used;
+    vector<ERStat*> free_nodes;
+    vector< Ptr<deque<int> > > free_crossings;
+};
+
 // derivative classes
 
 
@@ -128,6 +191,11 @@ public:
     // input/output - for the second one.
     void run( InputArray image, vector<ERStat>& regions ) CV_OVERRIDE;
 
+    // runs the filter on independent channels, each channel is processed by a worker filter sharing
+    // the settings and the classifier of this one. Channels run in parallel only with the built-in
+    // classifiers
+    void runChannels( const vector<Mat>& channels, vector< vector<ERStat> >& regions );
+
 protected:
     int thresholdDelta;
     float maxArea;
@@ -156,6 +224,10 @@ private:
     vector<ERStat> *regions;
     // image mask used for feature calculations
     Mat region_mask;
+    // nodes of the component tree, reused between runs
+    ERStatPool er_pool;
+    // per channel filters used by runChannels, reused between calls
+    vector< Ptr<ERFilterNM> > channel_workers;
 
     // extract the component tree and store all the ER regions
     void er_tree_extract( InputArray image );
@@ -262,6 +334,51 @@ void ERFilterNM::run( InputArray image, vector<ERStat>& _regions )
     }
 }
 
+static bool isBuiltinClassifier( const Ptr<ERFilter::Callback>& cb );
+
+void ERFilterNM::runChannels( const vector<Mat>& channels, vector< vector<ERStat> >& _regions )
+{
+    CV_Assert( channels.size() == _regions.size() );
+
+    while (channel_workers.size() < channels.size())
+        channel_workers.push_back(makePtr<ERFilterNM>());
+
+    for (size_t c = 0; c < channels.size(); c++)
+    {
+        ERFilterNM& worker = *channel_workers[c];
+        worker.minProbability = minProbability;
+        worker.nonMaxSuppression = nonMaxSuppression;
+        worker.minProbabilityDiff = minProbabilityDiff;
+        worker.thresholdDelta = thresholdDelta;
+        worker.maxArea = maxArea;
+        worker.minArea = minArea;
+        worker.classifier = classifier;
+    }
+
+    // user supplied callbacks are not required to be thread safe, so only the built-in
+    // classifiers are evaluated from several channels at once
+    if (isBuiltinClassifier(classifier))
+    {
+        parallel_for_(Range(0, (int)channels.size()), [&](const Range& range) {
+            for (int c = range.start; c < range.end; c++)
+                channel_workers[c]->run(channels[c], _regions[c]);
+        }, (double)channels.size());
+    }
+    else
+    {
+        for (size_t c = 0; c < channels.size(); c++)
+            channel_workers[c]->run(channels[c], _regions[c]);
+    }
+
+    num_rejected_regions = 0;
+    num_accepted_regions = 0;
+    for (size_t c = 0; c < channels.size(); c++)
+    {
+        num_rejected_regions += channel_workers[c]->num_rejected_regions;
+        num_accepted_regions += channel_workers[c]->num_accepted_regions;
+    }
+}
+
 // extract the component tree and store all the ER regions
 // uses the algorithm described in
 // Linear time maximally stable extremal regions, D Nistér, H Stewénius – ECCV 2008
@@ -282,6 +399,7 @@ void ERFilterNM::er_tree_extract( InputArray image )
 
     // the component stack
     vector<ERStat*> er_stack;
+    er_pool.reset();
 
     // the quads for Euler's number calculation
     // quads[2][2] and quads[2][3] are never used.
@@ -305,7 +423,7 @@ void ERFilterNM::er_tree_extract( InputArray image )
     vector<int> boundary_edges[256];
 
     // add a dummy-component before start
-    er_stack.push_back(new ERStat);
+    er_stack.push_back(er_pool.create());
 
     // we'll look initially for all pixels with grey-level lower than a grey-level higher than any allowed in the image
     int threshold_level = (255/thresholdDelta)+1;
@@ -325,7 +443,7 @@ void ERFilterNM::er_tree_extract( InputArray image )
 
         // push a component with current level in the component stack
         if (push_new_component)
-            er_stack.push_back(new ERStat(current_level, current_pixel, x, y));
+            er_stack.push_back(er_pool.create(current_level, current_pixel, x, y));
         push_new_component = false;
 
         // explore the (remaining) edges to the neighbors to the current pixel
@@ -522,16 +640,8 @@ void ERFilterNM::er_tree_extract( InputArray image )
             regions->reserve(num_accepted_regions+1);
             er_save(er_stack.back(), NULL, NULL);
 
-            // clean memory
-            for (size_t r=0; r<er_stack.size(); r++)
-            {
-                ERStat *stat = er_stack.at(r);
-                if (stat->crossings)
-                {
-                    stat->crossings.release();
-                }
-                deleteERStatTree(stat);
-            }
+            // give all the nodes back to the pool
+            er_pool.reset();
             er_stack.clear();
 
             return;
@@ -563,7 +673,7 @@ void ERFilterNM::er_tree_extract( InputArray image )
 
                 if (new_level < er_stack.back()->level)
                 {
-                    er_stack.push_back(new ERStat(new_level, current_pixel, current_pixel%width, current_pixel/width));
+                    er_stack.push_back(er_pool.create(new_level, current_pixel, current_pixel%width, current_pixel/width));
                     er_merge(er_stack.back(), er);
                     break;
                 }
@@ -665,7 +775,7 @@ void ERFilterNM::er_merge(ERStat *parent, ERStat *child)
     child->med_crossings = (float)m_crossings.at(1);
 
     // free unnecessary mem
-    child->crossings.release();
+    er_pool.releaseCrossings(child);
 
     // recover the original grey-level
     child->level = child->level*thresholdDelta;
@@ -710,11 +820,7 @@ void ERFilterNM::er_merge(ERStat *parent, ERStat *child)
         }
 
         // free mem
-        if(child->crossings)
-        {
-            child->crossings.release();
-        }
-        delete(child);
+        er_pool.release(child);
     }
 
 }
@@ -1204,6 +1310,15 @@ Ptr<ERFilter::Callback> loadDummyClassifier()
     return makePtr<ERDummyClassifier>();
 }
 
+/* The built-in classifiers only read their models in eval(), so they can be shared by the channel workers */
+static bool isBuiltinClassifier( const Ptr<ERFilter::Callback>& cb )
+{
+    return cb.empty() ||
+           dynamic_cast<ERClassifierNM1*>(cb.get()) != NULL ||
+           dynamic_cast<ERClassifierNM2*>(cb.get()) != NULL ||
+           dynamic_cast<ERDummyClassifier*>(cb.get()) != NULL;
+}
+
 /* ------------------------------------------------------------------------------------*/
 /* -------------------------------- Compute Channels NM -------------------------------*/
 /* ------------------------------------------------------------------------------------*/
@@ -1785,6 +1900,76 @@ static void MST_linkage_core_vector(const int_fast32_t N,
     }
 }
 
+/*
+     Same as MST_linkage_core_vector, but the distance update of every iteration is split in
+     chunks of active nodes that are processed in parallel. Only valid when all the distances
+     are finite: the NaN elimination of the sequential version is not done here. Ties are
+     resolved to the first active node, so the result is identical to the sequential one.
+*/
+template <typename t_dissimilarity>
+static void MST_linkage_core_vector_parallel(const int_fast32_t N,
+                                             const t_dissimilarity & dist,
+                                             cluster_result & Z2) {
+    const size_t chunk_size = 1024;
+    const size_t min_parallel_size = 2048;
+
+    // active nodes are kept compact and in increasing order
+    std::vector<int_fast32_t> active_nodes(N-1);
+    for (int_fast32_t i=1; i<N; i++)
+        active_nodes[i-1] = i;
+    std::vector<double> d(N);
+    std::vector<double> chunk_min;
+    std::vector<size_t> chunk_pos;
+
+    int_fast32_t prev_node = 0;
+    for (int_fast32_t j=0; j<N-1; j++)
+    {
+        const size_t nactive = active_nodes.size();
+        const int nchunks = (int)((nactive + chunk_size - 1) / chunk_size);
+        chunk_min.resize(nchunks);
+        chunk_pos.resize(nchunks);
+
+        auto update_chunks = [&](const Range& range) {
+            for (int c = range.start; c < range.end; c++)
+            {
+                const size_t begin = c*chunk_size;
+                const size_t end = std::min(nactive, begin + chunk_size);
+                size_t pos = begin;
+                for (size_t k=begin; k<end; k++)
+                {
+                    const int_fast32_t i = active_nodes[k];
+                    if (j == 0)
+                        d[i] = dist(0, i);
+                    else
+                    {
+                        double tmp = dist(i, prev_node);
+                        if (d[i] > tmp)
+                            d[i] = tmp;
+                    }
+                    if (d[i] < d[active_nodes[pos]])
+                        pos = k;
+                }
+                chunk_min[c] = d[active_nodes[pos]];
+                chunk_pos[c] = pos;
+            }
+        };
+        if (nactive >= min_parallel_size)
+            parallel_for_(Range(0, nchunks), update_chunks);
+        else
+            update_chunks(Range(0, nchunks));
+
+        int best = 0;
+        for (int c=1; c<nchunks; c++)
+            if (chunk_min[c] < chunk_min[best])
+                best = c;
+
+        const int_fast32_t idx2 = active_nodes[chunk_pos[best]];
+        Z2.append(prev_node, idx2, chunk_min[best]);
+        active_nodes.erase(active_nodes.begin() + chunk_pos[best]);
+        prev_node = idx2;
+    }
+}
+
 class linkage_output {
 private:
     double * Z;
@@ -2012,7 +2197,10 @@ static int linkage_vector(double *X, int N, int dim, double * Z, unsigned char m
         cluster_result Z2(N-1);
         auto_array_ptr<int_fast32_t> members;
         dissimilarity dist(X, N, dim, members, method, metric, false);
-        MST_linkage_core_vector(N, dist, Z2);
+        if (N > 2 && checkRange(Mat(N, dim, CV_64F, X)))
+            MST_linkage_core_vector_parallel(N, dist, Z2);
+        else
+            MST_linkage_core_vector(N, dist, Z2);
         dist.postprocess(Z2);
         generate_dendrogram(Z, Z2, N);
     } // try
@@ -2740,122 +2928,125 @@ static float extract_features(Mat &grey, Mat& channel, vector<ERStat> &regions,
     Mat gradient_magnitude = Mat_<double>(grey.size());
     get_gradient_magnitude( grey, gradient_magnitude);
 
-    Mat region_mask = Mat::zeros(grey.rows+2, grey.cols+2, CV_8UC1);
-
-    float max_stroke = 0;
+    // the features of every region are computed independently, each stripe has its own mask
+    features.resize(regions.size());
+    parallel_for_(Range(0, (int)regions.size()), [&](const Range& range) {
+        Mat region_mask = Mat::zeros(grey.rows+2, grey.cols+2, CV_8UC1);
+        for (int r = range.start; r < range.end; r++)
+        {
+            ERFeatures f;
+            ERStat *stat = &regions.at(r);
 
-    for (int r=0; r<(int)regions.size(); r++)
-    {
-        ERFeatures f;
-        ERStat *stat = &regions.at(r);
+            f.area = stat->area;
+            f.rect = stat->rect;
+            f.center = Point(f.rect.x+(f.rect.width/2),f.rect.y+(f.rect.height/2));
 
-        f.area = stat->area;
-        f.rect = stat->rect;
-        f.center = Point(f.rect.x+(f.rect.width/2),f.rect.y+(f.rect.height/2));
+            if (regions.at(r).parent != NULL)
+            {
 
-        if (regions.at(r).parent != NULL)
-        {
+                //Fill the region and calculate features
+                Mat region = region_mask(Rect(stat->rect.tl(),
+                                              stat->rect.br() + Point(2,2)));
+                region = Scalar(0);
+                int newMaskVal = 255;
+                int flags = 4 + (newMaskVal << 8) + FLOODFILL_FIXED_RANGE + FLOODFILL_MASK_ONLY;
+
+                floodFill( channel(stat->rect),
+                           region, Point(stat->pixel%channel.cols - stat->rect.x, stat->pixel/channel.cols - stat->rect.y),
+                           Scalar(255), NULL, Scalar(stat->level), Scalar(0), flags );
+                Mat rect_mask = region_mask(Rect(stat->rect.x+1,stat->rect.y+1,stat->rect.width,stat->rect.height));
+
+
+                Scalar mean,std;
+                meanStdDev( grey(stat->rect), mean, std, rect_mask);
+                f.intensity_mean = (float)mean[0];
+                f.intensity_std  = (float)std[0];
+
+                Mat tmp,bw;
+                rect_mask.copyTo(bw);
+                distanceTransform(bw, tmp, DIST_L1,3); //L1 gives distance in round integers while L2 floats
+
+                // Add border because if region span all the image size skeleton will crash
+                copyMakeBorder(bw, bw, 5, 5, 5, 5, BORDER_CONSTANT, Scalar(0));
+                Mat skeleton = Mat::zeros(bw.size(),CV_8UC1);
+                guo_hall_thinning(bw,skeleton);
+                Mat mask;
+                skeleton(Rect(5,5,bw.cols-10,bw.rows-10)).copyTo(mask);
+                bw(Rect(5,5,bw.cols-10,bw.rows-10)).copyTo(bw);
+                meanStdDev(tmp,mean,std,mask);
+                f.stroke_mean = mean[0];
+                f.stroke_std  = std[0];
+
+                Mat element = getStructuringElement( MORPH_RECT, Size(5, 5), Point(2, 2) );
+                dilate(rect_mask, tmp, element);
+                absdiff(tmp, rect_mask, tmp);
+
+                meanStdDev( grey(stat->rect), mean, std, tmp);
+                f.boundary_intensity_mean = (float)mean[0];
+                f.boundary_intensity_std  = (float)std[0];
+
+                Mat tmp2;
+                dilate(rect_mask, tmp, element);
+                erode (rect_mask, tmp2, element);
+                absdiff(tmp, tmp2, tmp);
+
+                meanStdDev( gradient_magnitude(stat->rect), mean, std, tmp);
+                f.gradient_mean = mean[0];
+                f.gradient_std  = std[0];
+
+                copyMakeBorder(bw, bw, 5, 5, 5, 5, BORDER_CONSTANT, Scalar(0));
+
+                vector<vector<Point> > contours0;
+                vector<Vec4i> hierarchy;
+                findContours( bw, contours0, hierarchy, RETR_TREE, CHAIN_APPROX_SIMPLE);
+
+                RotatedRect rrect = minAreaRect(contours0.at(0));
+
+                f.axial_ratio = max(rrect.size.width, rrect.size.height) / min(rrect.size.width, rrect.size.height);
+
+                Moments mu = moments(contours0.at(0));
+                HuMoments (mu, f.hu_moments);
+
+                vector<Point> hull;
+                convexHull(contours0[0],hull);
+                f.convex_hull_ratio = (float)contourArea(hull)/contourArea(contours0[0]);
+                vector<Vec4i> cx;
+                vector<int> hull_idx;
+                //TODO check epsilon parameter of approxPolyDP (set empirically) : we want more precision
+                //     if the region is very small because otherwise we'll loose all the convexities
+                approxPolyDP( Mat(contours0[0]), contours0[0], (float)min(rrect.size.width,rrect.size.height)/17, true );
+                convexHull(contours0[0],hull_idx,false,false);
+                f.convexities = 0;
+                if (hull_idx.size()>2)
+                    if (contours0[0].size()>3)
+                        convexityDefects(contours0[0],hull_idx,cx);
+                f.convexities = (int)cx.size();
+
+                rect_mask = Scalar(0);
 
-            //Fill the region and calculate features
-            Mat region = region_mask(Rect(stat->rect.tl(),
-                                          stat->rect.br() + Point(2,2)));
-            region = Scalar(0);
-            int newMaskVal = 255;
-            int flags = 4 + (newMaskVal << 8) + FLOODFILL_FIXED_RANGE + FLOODFILL_MASK_ONLY;
-
-            floodFill( channel(stat->rect),
-                       region, Point(stat->pixel%channel.cols - stat->rect.x, stat->pixel/channel.cols - stat->rect.y),
-                       Scalar(255), NULL, Scalar(stat->level), Scalar(0), flags );
-            Mat rect_mask = region_mask(Rect(stat->rect.x+1,stat->rect.y+1,stat->rect.width,stat->rect.height));
-
-
-            Scalar mean,std;
-            meanStdDev( grey(stat->rect), mean, std, rect_mask);
-            f.intensity_mean = (float)mean[0];
-            f.intensity_std  = (float)std[0];
-
-            Mat tmp,bw;
-            rect_mask.copyTo(bw);
-            distanceTransform(bw, tmp, DIST_L1,3); //L1 gives distance in round integers while L2 floats
-
-            // Add border because if region span all the image size skeleton will crash
-            copyMakeBorder(bw, bw, 5, 5, 5, 5, BORDER_CONSTANT, Scalar(0));
-            Mat skeleton = Mat::zeros(bw.size(),CV_8UC1);
-            guo_hall_thinning(bw,skeleton);
-            Mat mask;
-            skeleton(Rect(5,5,bw.cols-10,bw.rows-10)).copyTo(mask);
-            bw(Rect(5,5,bw.cols-10,bw.rows-10)).copyTo(bw);
-            meanStdDev(tmp,mean,std,mask);
-            f.stroke_mean = mean[0];
-            f.stroke_std  = std[0];
-
-            if (f.stroke_mean > max_stroke)
-                max_stroke = (float)f.stroke_mean;
-
-            Mat element = getStructuringElement( MORPH_RECT, Size(5, 5), Point(2, 2) );
-            dilate(rect_mask, tmp, element);
-            absdiff(tmp, rect_mask, tmp);
-
-            meanStdDev( grey(stat->rect), mean, std, tmp);
-            f.boundary_intensity_mean = (float)mean[0];
-            f.boundary_intensity_std  = (float)std[0];
-
-            Mat tmp2;
-            dilate(rect_mask, tmp, element);
-            erode (rect_mask, tmp2, element);
-            absdiff(tmp, tmp2, tmp);
-
-            meanStdDev( gradient_magnitude(stat->rect), mean, std, tmp);
-            f.gradient_mean = mean[0];
-            f.gradient_std  = std[0];
-
-            copyMakeBorder(bw, bw, 5, 5, 5, 5, BORDER_CONSTANT, Scalar(0));
-
-            vector<vector<Point> > contours0;
-            vector<Vec4i> hierarchy;
-            findContours( bw, contours0, hierarchy, RETR_TREE, CHAIN_APPROX_SIMPLE);
-
-            RotatedRect rrect = minAreaRect(contours0.at(0));
-
-            f.axial_ratio = max(rrect.size.width, rrect.size.height) / min(rrect.size.width, rrect.size.height);
-
-            Moments mu = moments(contours0.at(0));
-            HuMoments (mu, f.hu_moments);
-
-            vector<Point> hull;
-            convexHull(contours0[0],hull);
-            f.convex_hull_ratio = (float)contourArea(hull)/contourArea(contours0[0]);
-            vector<Vec4i> cx;
-            vector<int> hull_idx;
-            //TODO check epsilon parameter of approxPolyDP (set empirically) : we want more precision
-            //     if the region is very small because otherwise we'll loose all the convexities
-            approxPolyDP( Mat(contours0[0]), contours0[0], (float)min(rrect.size.width,rrect.size.height)/17, true );
-            convexHull(contours0[0],hull_idx,false,false);
-            f.convexities = 0;
-            if (hull_idx.size()>2)
-                if (contours0[0].size()>3)
-                    convexityDefects(contours0[0],hull_idx,cx);
-            f.convexities = (int)cx.size();
-
-            rect_mask = Scalar(0);
+            } else {
 
-        } else {
+                f.intensity_mean = 0;
+                f.intensity_std  = 0;
 
-            f.intensity_mean = 0;
-            f.intensity_std  = 0;
+                f.stroke_mean = 0;
+                f.stroke_std  = 0;
 
-            f.stroke_mean = 0;
-            f.stroke_std  = 0;
+                f.boundary_intensity_mean = 0;
+                f.boundary_intensity_std  = 0;
 
-            f.boundary_intensity_mean = 0;
-            f.boundary_intensity_std  = 0;
+                f.gradient_mean = 0;
+                f.gradient_std  = 0;
+            }
 
-            f.gradient_mean = 0;
-            f.gradient_std  = 0;
+            features[r] = f;
         }
+    }, max(1, getNumThreads()) * 4.);
 
-        features.push_back(f);
-    }
+    float max_stroke = 0;
+    for (size_t r=0; r<features.size(); r++)
+        if (features[r].stroke_mean > max_stroke)
+            max_stroke = (float)features[r].stroke_mean;
 
     return max_stroke;
 }
@@ -3585,6 +3776,75 @@ bool haveCommonRegion(region_sequence &sequence1, region_sequence &sequence2)
 bool sort_couples (Vec3i i,Vec3i j);
 bool sort_couples (Vec3i i,Vec3i j) { return (i[0]<j[0]); }
 
+// Uniform grid over the regions of a channel, used to skip the pairs of regions that can not pass
+// the geometric tests of isValidPair (the distance between the regions and their centroid angle)
+class RegionPairGrid
+{
+public:
+    RegionPairGrid(const vector<ERStat>& _regions, Size img_size) : regions(_regions), max_width(0)
+    {
+        for (size_t r=0; r<regions.size(); r++)
+            if (regions[r].parent != NULL)
+                max_width = max(max_width, regions[r].rect.width);
+
+        grid_size = Size(img_size.width/cell_size + 1, img_size.height/cell_size + 1);
+        cells.resize(grid_size.area());
+        for (int r=0; r<(int)regions.size(); r++)
+        {
+            // the root region never makes a valid pair
+            if (regions[r].parent == NULL)
+                continue;
+            Point cell = cellOf(regions[r].rect.x, regions[r].rect.y + regions[r].rect.height/2);
+            cells[cell.y*grid_size.width + cell.x].push_back(r);
+        }
+    }
+
+    // indices greater than i of the regions that may make a valid pair with regions[i], sorted
+    void candidates(int i, vector<int>& out) const
+    {
+        out.clear();
+        const ERStat& er = regions[i];
+        if (er.parent == NULL)
+            return;
+
+        // the horizontal gap between the regions is at most PAIR_MAX_REGION_DIST times their
+        // average width, which bounds the distance between their left sides on both directions
+        const double half_dist = PAIR_MAX_REGION_DIST/2;
+        const double reach_left  = (1 + half_dist)*max_width + half_dist*er.rect.width + 1;
+        const double reach_right = (1 + half_dist)*er.rect.width + half_dist*max_width + 1;
+        // and the centroid angle bounds the vertical distance between the centroids
+        const double max_slope = tan(max(fabs(PAIR_MIN_CENTROID_ANGLE), fabs(PAIR_MAX_CENTROID_ANGLE)));
+        const double reach_y = max_slope*(max(reach_left, reach_right) + max_width/2 + 1) + 1;
+
+        const int center_y = er.rect.y + er.rect.height/2;
+        Point tl = cellOf(cvFloor(er.rect.x - reach_left), cvFloor(center_y - reach_y));
+        Point br = cellOf(cvCeil(er.rect.x + reach_right), cvCeil(center_y + reach_y));
+        for (int y=tl.y; y<=br.y; y++)
+            for (int x=tl.x; x<=br.x; x++)
+            {
+                const vector<int>& cell = cells[y*grid_size.width + x];
+                for (size_t k=0; k<cell.size(); k++)
+                    if (cell[k] > i)
+                        out.push_back(cell[k]);
+            }
+        sort(out.begin(), out.end());
+    }
+
+private:
+    static const int cell_size = 32;
+
+    const vector<ERStat>& regions;
+    int max_width;
+    Size grid_size;
+    vector< vector<int> > cells;
+
+    Point cellOf(int x, int y) const
+    {
+        return Point(min(max(x/cell_size, 0), grid_size.width-1),
+                     min(max(y/cell_size, 0), grid_size.height-1));
+    }
+};
+
 /*!
     Find groups of Extremal Regions that are organized as text lines. This function implements
     the grouping algorithm described in:
@@ -3612,6 +3872,11 @@ void erGroupingNM(InputArray _img, InputArrayOfArrays _src, vector< vector<ERSta
 
     Mat img = _img.getMat();
 
+    Mat mask = Mat::zeros(img.rows+2, img.cols+2, CV_8UC1);
+    Mat grey,lab;
+    cvtColor(img, lab, COLOR_RGB2Lab);
+    cvtColor(img, grey, COLOR_RGB2GRAY);
+
     //process each channel independently
     for(size_t c=0; c<num_channels; c++)
     {
@@ -3622,79 +3887,91 @@ void erGroupingNM(InputArray _img, InputArrayOfArrays _src, vector< vector<ERSta
             all_regions.push_back(Vec2i((int)c,(int)r));
         }
 
-        vector< region_pair > valid_pairs;
-        Mat mask = Mat::zeros(img.rows+2, img.cols+2, CV_8UC1);
-        Mat grey,lab;
-        cvtColor(img, lab, COLOR_RGB2Lab);
-        cvtColor(img, grey, COLOR_RGB2GRAY);
+        // all the pairs of a region i are searched and chosen independently of the other regions,
+        // so the regions are processed in parallel and their pairs concatenated in order
+        RegionPairGrid grid(regions[c], img.size());
+        vector< vector<region_pair> > region_pairs(all_regions.size());
+        const double nstripes = max(1, getNumThreads()) * 4.;
 
         //check every possible pair of regions
-        for (size_t i=0; i<all_regions.size(); i++)
-        {
-            vector<int> i_siblings;
-            int first_i_sibling_idx = (int)valid_pairs.size();
-            for (size_t j=i+1; j<all_regions.size(); j++)
+        parallel_for_(Range(0, (int)all_regions.size()), [&](const Range& range) {
+            Mat stripe_mask = Mat::zeros(img.rows+2, img.cols+2, CV_8UC1);
+            vector<int> candidates;
+            for (int i = range.start; i < range.end; i++)
             {
-                // check height ratio, centroid angle and region distance normalized by region width
-                // fall within a given interval
-                if (isValidPair(grey, lab, mask, src, regions, all_regions[i],all_regions[j]))
+                vector<region_pair>& i_pairs = region_pairs[i];
+                vector<int> i_siblings;
+                grid.candidates(i, candidates);
+                for (size_t n = 0; n < candidates.size(); n++)
                 {
-                    bool isCycle = false;
-                    for (size_t k=0; k<i_siblings.size(); k++)
+                    const int j = candidates[n];
+                    // check height ratio, centroid angle and region distance normalized by region width
+                    // fall within a given interval
+                    if (isValidPair(grey, lab, stripe_mask, src, regions, all_regions[i],all_regions[j]))
                     {
-                      if (isValidPair(grey, lab, mask, src, regions, all_regions[j],all_regions[i_siblings[k]]))
-                      {
-                        // choose as sibling the closer and not the first that was "paired" with i
-                        Point i_center = Point( regions[all_regions[i][0]][all_regions[i][1]].rect.x +
-                                                regions[all_regions[i][0]][all_regions[i][1]].rect.width/2,
-                                                regions[all_regions[i][0]][all_regions[i][1]].rect.y +
-                                                regions[all_regions[i][0]][all_regions[i][1]].rect.height/2 );
-                        Point j_center = Point( regions[all_regions[j][0]][all_regions[j][1]].rect.x +
-                                                regions[all_regions[j][0]][all_regions[j][1]].rect.width/2,
-                                                regions[all_regions[j][0]][all_regions[j][1]].rect.y +
-                                                regions[all_regions[j][0]][all_regions[j][1]].rect.height/2 );
-                        Point k_center = Point( regions[all_regions[i_siblings[k]][0]][all_regions[i_siblings[k]][1]].rect.x +
-                                                regions[all_regions[i_siblings[k]][0]][all_regions[i_siblings[k]][1]].rect.width/2,
-                                                regions[all_regions[i_siblings[k]][0]][all_regions[i_siblings[k]][1]].rect.y +
-                                                regions[all_regions[i_siblings[k]][0]][all_regions[i_siblings[k]][1]].rect.height/2 );
-
-                        if ( norm(i_center - j_center) < norm(i_center - k_center) )
+                        bool isCycle = false;
+                        for (size_t k=0; k<i_siblings.size(); k++)
                         {
-                          valid_pairs[first_i_sibling_idx+k] = region_pair(all_regions[i],all_regions[j]);
-                          i_siblings[k] = (int)j;
+                          if (isValidPair(grey, lab, stripe_mask, src, regions, all_regions[j],all_regions[i_siblings[k]]))
+                          {
+                            // choose as sibling the closer and not the first that was "paired" with i
+                            Point i_center = Point( regions[all_regions[i][0]][all_regions[i][1]].rect.x +
+                                                    regions[all_regions[i][0]][all_regions[i][1]].rect.width/2,
+                                                    regions[all_regions[i][0]][all_regions[i][1]].rect.y +
+                                                    regions[all_regions[i][0]][all_regions[i][1]].rect.height/2 );
+                            Point j_center = Point( regions[all_regions[j][0]][all_regions[j][1]].rect.x +
+                                                    regions[all_regions[j][0]][all_regions[j][1]].rect.width/2,
+                                                    regions[all_regions[j][0]][all_regions[j][1]].rect.y +
+                                                    regions[all_regions[j][0]][all_regions[j][1]].rect.height/2 );
+                            Point k_center = Point( regions[all_regions[i_siblings[k]][0]][all_regions[i_siblings[k]][1]].rect.x +
+                                                    regions[all_regions[i_siblings[k]][0]][all_regions[i_siblings[k]][1]].rect.width/2,
+                                                    regions[all_regions[i_siblings[k]][0]][all_regions[i_siblings[k]][1]].rect.y +
+                                                    regions[all_regions[i_siblings[k]][0]][all_regions[i_siblings[k]][1]].rect.height/2 );
+
+                            if ( norm(i_center - j_center) < norm(i_center - k_center) )
+                            {
+                              i_pairs[k] = region_pair(all_regions[i],all_regions[j]);
+                              i_siblings[k] = j;
+                            }
+                            isCycle = true;
+                            break;
+                          }
+                        }
+                        if (!isCycle)
+                        {
+                          i_pairs.push_back(region_pair(all_regions[i],all_regions[j]));
+                          i_siblings.push_back(j);
                         }
-                        isCycle = true;
-                        break;
-                      }
-                    }
-                    if (!isCycle)
-                    {
-                      valid_pairs.push_back(region_pair(all_regions[i],all_regions[j]));
-                      i_siblings.push_back((int)j);
-                      //cout << "Valid pair (" << all_regions[i][0] << ","  << all_regions[i][1] << ") (" << all_regions[j][0] << ","  << all_regions[j][1] << ")" << endl;
                     }
                 }
             }
-        }
+        }, nstripes);
+
+        vector< region_pair > valid_pairs;
+        for (size_t i=0; i<region_pairs.size(); i++)
+            valid_pairs.insert(valid_pairs.end(), region_pairs[i].begin(), region_pairs[i].end());
 
         //cout << "GroupingNM : detected " << valid_pairs.size() << " valid pairs" << endl;
 
-        vector< region_triplet > valid_triplets;
+        vector< vector<region_triplet> > pair_triplets(valid_pairs.size());
 
         //check every possible triplet of regions
-        for (size_t i=0; i<valid_pairs.size(); i++)
-        {
-            for (size_t j=i+1; j<valid_pairs.size(); j++)
+        parallel_for_(Range(0, (int)valid_pairs.size()), [&](const Range& range) {
+            for (int i = range.start; i < range.end; i++)
             {
-                // check collinearity rules
-                region_triplet valid_triplet(Vec2i(0,0),Vec2i(0,0),Vec2i(0,0));
-                if (isValidTriplet(regions, valid_pairs[i],valid_pairs[j], valid_triplet))
+                for (size_t j=i+1; j<valid_pairs.size(); j++)
                 {
-                    valid_triplets.push_back(valid_triplet);
-                    //cout << "Valid triplet (" << valid_triplet.a[1] << "," <<  valid_triplet.b[1] << "," <<  valid_triplet.c[1] << ")" << endl;
+                    // check collinearity rules
+                    region_triplet valid_triplet(Vec2i(0,0),Vec2i(0,0),Vec2i(0,0));
+                    if (isValidTriplet(regions, valid_pairs[i],valid_pairs[j], valid_triplet))
+                        pair_triplets[i].push_back(valid_triplet);
                 }
             }
-        }
+        }, nstripes);
+
+        vector< region_triplet > valid_triplets;
+        for (size_t i=0; i<pair_triplets.size(); i++)
+            valid_triplets.insert(valid_triplets.end(), pair_triplets[i].begin(), pair_triplets[i].end());
 
         //cout << "GroupingNM : detected " << valid_triplets.size() << " valid triplets" << endl;
 
@@ -4035,6 +4312,30 @@ void MSERsToERStats(InputArray image, vector<vector<Point> > &contours, vector<v
   }
 }
 
+void runERFilter(InputArrayOfArrays _channels, const Ptr<ERFilter>& er_filter1, const Ptr<ERFilter>& er_filter2,
+                 vector< vector<ERStat> >& regions)
+{
+    CV_Assert( !er_filter1.empty() );
+
+    vector<Mat> channels;
+    _channels.getMatVector(channels);
+    regions.resize(channels.size());
+
+    const Ptr<ERFilter> filters[2] = { er_filter1, er_filter2 };
+    for (int f = 0; f < 2; f++)
+    {
+        if (filters[f].empty())
+            continue;
+
+        ERFilterNM* nm = dynamic_cast<ERFilterNM*>(filters[f].get());
+        if (nm)
+            nm->runChannels(channels, regions);
+        else
+            for (size_t c = 0; c < channels.size(); c++)
+                filters[f]->run(channels[c], regions[c]);
+    }
+}
+
 // Utility function for scripting
 void detectRegions(InputArray image, const Ptr<ERFilter>& er_filter1, const Ptr<ERFilter>& er_filter2, CV_OUT vector< vector<Point> >& regions)
 {
@@ -4107,12 +4408,8 @@ void detectRegions(InputArray image, const Ptr<ERFilter>& er_filter1, const Ptr<
 
     vector<vector<ERStat> > regions(channels.size());
 
-    // Apply the default cascade classifier to each independent channel (could be done in parallel)
-    for (int c=0; c<(int)channels.size(); c++)
-    {
-        er_filter1->run(channels[c], regions[c]);
-        er_filter2->run(channels[c], regions[c]);
-    }
+    // Apply the default cascade classifier to the independent channels in parallel
+    runERFilter(channels, er_filter1, er_filter2, regions);
    // Detect character groups
     vector< vector<Vec2i> > nm_region_groups;
     erGrouping(image, channels, regions, nm_region_groups, groups_rects, method, filename, minProbability);
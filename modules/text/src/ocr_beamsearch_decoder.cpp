@@ -88,6 +88,29 @@ void OCRBeamSearchDecoder::run(Mat& image, Mat& mask, string& output_text, vecto
         component_confidences->clear();
 }
 
+void OCRBeamSearchDecoder::runBatch(InputArrayOfArrays _images, vector<string>& output_texts,
+                                    vector< vector<Rect> >* component_rects, vector< vector<string> >* component_texts,
+                                    vector< vector<float> >* component_confidences, int component_level)
+{
+    vector<Mat> images;
+    _images.getMatVector(images);
+    output_texts.assign(images.size(), string());
+    if (component_rects != NULL)
+        component_rects->assign(images.size(), vector<Rect>());
+    if (component_texts != NULL)
+        component_texts->assign(images.size(), vector<string>());
+    if (component_confidences != NULL)
+        component_confidences->assign(images.size(), vector<float>());
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        run(images[i], output_texts[i],
+            component_rects != NULL ? &(*component_rects)[i] : NULL,
+            component_texts != NULL ? &(*component_texts)[i] : NULL,
+            component_confidences != NULL ? &(*component_confidences)[i] : NULL,
+            component_level);
+    }
+}
+
 CV_WRAP String OCRBeamSearchDecoder::run(InputArray image, int min_confidence, int component_level)
 {
     std::string output1;
@@ -140,6 +163,17 @@ void OCRBeamSearchDecoder::ClassifierCallback::eval( InputArray image, vector< v
     oversegmentation.clear();
 }
 
+void OCRBeamSearchDecoder::ClassifierCallback::evalBatch( InputArrayOfArrays _images, vector< vector< vector<double> > >& recognition_probabilities,
+                                                          vector< vector<int> >& oversegmentation)
+{
+    vector<Mat> images;
+    _images.getMatVector(images);
+    recognition_probabilities.resize(images.size());
+    oversegmentation.resize(images.size());
+    for (size_t i=0; i<images.size(); i++)
+        eval(images[i], recognition_probabilities[i], oversegmentation[i]);
+}
+
 struct beamSearch_node {
     double score;
     vector<int> segmentation;
@@ -154,6 +188,14 @@ bool beam_sort_function ( beamSearch_node a, beamSearch_node b )
     return (a.score > b.score);
 }
 
+// Working buffers of the beam search of a single word. They are kept by the decoder and reused
+// between calls.
+struct beamSearch_state {
+    vector< beamSearch_node > beam;
+    vector< vector<double> > recognition_probabilities;
+    vector<int> oversegmentation;
+};
+
 
 class OCRBeamSearchDecoderImpl CV_FINAL : public OCRBeamSearchDecoder
 {
@@ -232,10 +274,107 @@ public:
         // TODO if input is a text line (not a word) we may need to split into words here!
 
         // do sliding window classification along a cropped word image
-        classifier->eval(src, recognition_probabilities, oversegmentation);
+        classifier->eval(src, state.recognition_probabilities, state.oversegmentation);
+
+        double lp = 0;
+        if (!decode(state, out_sequence, lp))
+            return;
+
+        // fill other (dummy) output parameters
+        if (component_rects != NULL)
+            component_rects->push_back(Rect(0,0,src.cols,src.rows));
+        if (component_texts != NULL)
+            component_texts->push_back(out_sequence);
+        if (component_confidences != NULL)
+            component_confidences->push_back((float)exp(lp));
+    }
+
+    void runBatch( InputArrayOfArrays _images,
+                   vector<string>& out_sequences,
+                   vector< vector<Rect> >* component_rects,
+                   vector< vector<string> >* component_texts,
+                   vector< vector<float> >* component_confidences,
+                   int component_level) CV_OVERRIDE
+    {
+        CV_Assert( component_level == OCR_LEVEL_WORD );
+        vector<Mat> images;
+        _images.getMatVector(images);
+
+        const int nimages = (int)images.size();
+        out_sequences.assign(nimages, string());
+        if (component_rects != NULL)
+            component_rects->assign(nimages, vector<Rect>());
+        if (component_texts != NULL)
+            component_texts->assign(nimages, vector<string>());
+        if (component_confidences != NULL)
+            component_confidences->assign(nimages, vector<float>());
+        if (nimages == 0)
+            return;
+
+        vector<Mat> grey(nimages);
+        for (int i = 0; i < nimages; i++)
+        {
+            CV_Assert( (images[i].type() == CV_8UC1) || (images[i].type() == CV_8UC3) );
+            CV_Assert( (images[i].cols > 0) && (images[i].rows > 0) );
+            if (images[i].type() == CV_8UC3)
+                cvtColor(images[i], grey[i], COLOR_RGB2GRAY);
+            else
+                grey[i] = images[i];
+        }
+
+        // all the sliding windows are classified at once
+        vector< vector< vector<double> > > recognition_probabilities;
+        vector< vector<int> > oversegmentation;
+        classifier->evalBatch(grey, recognition_probabilities, oversegmentation);
+        CV_Assert( ((int)recognition_probabilities.size() == nimages) && ((int)oversegmentation.size() == nimages) );
+
+        // words are decoded in parallel, each stripe reuses its own beam search buffers
+        const int nstripes = std::min(nimages, std::max(1, getNumThreads()) * 4);
+        if ((int)batch_states.size() < nstripes)
+            batch_states.resize(nstripes);
+        parallel_for_(Range(0, nstripes), [&](const Range& range) {
+            for (int s = range.start; s < range.end; s++)
+            {
+                beamSearch_state& st = batch_states[s];
+                for (int i = nimages*s/nstripes; i < nimages*(s+1)/nstripes; i++)
+                {
+                    st.recognition_probabilities.swap(recognition_probabilities[i]);
+                    st.oversegmentation.swap(oversegmentation[i]);
+
+                    double lp = 0;
+                    if (!decode(st, out_sequences[i], lp))
+                        continue;
+
+                    if (component_rects != NULL)
+                        (*component_rects)[i].push_back(Rect(0,0,grey[i].cols,grey[i].rows));
+                    if (component_texts != NULL)
+                        (*component_texts)[i].push_back(out_sequences[i]);
+                    if (component_confidences != NULL)
+                        (*component_confidences)[i].push_back((float)exp(lp));
+                }
+            }
+        }, nstripes);
+    }
+
+private:
+    int win_size;
+    int step_size;
+
+    beamSearch_state state;
+    vector< beamSearch_state > batch_states;
+
+    // Runs the beam search over the classifier output stored in st. Returns false if no
+    // segmentation can be evaluated.
+    bool decode( beamSearch_state& st, string& out_sequence, double& lp ) const
+    {
+        out_sequence.clear();
+        st.beam.clear();
+
+        vector< vector<double> >& recognition_probabilities = st.recognition_probabilities;
+        vector<int>& oversegmentation = st.oversegmentation;
 
         // if the number of oversegmentation points found is less than 2 we can not do nothing!!
-        if (oversegmentation.size() < 2) return;
+        if (oversegmentation.size() < 2) return false;
 
 
         //NMS of recognitions
@@ -302,14 +441,14 @@ public:
             beamSearch_node node;
             node.segmentation.push_back((int)i);
             node.segmentation.push_back((int)j);
-            node.score = score_segmentation(node.segmentation, out_sequence);
-            vector< vector<int> > childs = generate_childs( node.segmentation );
+            node.score = score_segmentation(st, node.segmentation, out_sequence);
+            vector< vector<int> > childs = generate_childs( st, node.segmentation );
             node.expanded = true;
 
-            beam.push_back( node );
+            st.beam.push_back( node );
 
             if (!childs.empty())
-              update_beam( childs );
+              update_beam( st, childs );
 
             generated_chids += (int)childs.size();
 
@@ -320,44 +459,33 @@ public:
         {
             generated_chids = 0;
 
-            for (size_t i=0; i<beam.size(); i++)
+            for (size_t i=0; i<st.beam.size(); i++)
             {
                 vector< vector<int> > childs;
-                if (!beam[i].expanded)
+                if (!st.beam[i].expanded)
                 {
-                  childs = generate_childs( beam[i].segmentation );
-                  beam[i].expanded = true;
+                  childs = generate_childs( st, st.beam[i].segmentation );
+                  st.beam[i].expanded = true;
                 }
                 if (!childs.empty())
-                    update_beam( childs );
+                    update_beam( st, childs );
                 generated_chids += (int)childs.size();
             }
         }
 
-        // Done! Get the best prediction found into out_sequence
-        double lp = score_segmentation( beam[0].segmentation, out_sequence );
+        if (st.beam.empty())
+            return false;
 
-        // fill other (dummy) output parameters
-        component_rects->push_back(Rect(0,0,src.cols,src.rows));
-        component_texts->push_back(out_sequence);
-        component_confidences->push_back((float)exp(lp));
-
-        return;
+        // Done! Get the best prediction found into out_sequence
+        lp = score_segmentation( st, st.beam[0].segmentation, out_sequence );
+        return true;
     }
 
-private:
-    int win_size;
-    int step_size;
-
-    vector< beamSearch_node > beam;
-    vector< vector<double> > recognition_probabilities;
-    vector<int> oversegmentation;
-
-    vector< vector<int> > generate_childs( vector<int> &segmentation )
+    vector< vector<int> > generate_childs( const beamSearch_state& st, vector<int> &segmentation ) const
     {
 
         vector< vector<int> > childs;
-        for (size_t i=segmentation[segmentation.size()-1]+1; i<oversegmentation.size(); i++)
+        for (size_t i=segmentation[segmentation.size()-1]+1; i<st.oversegmentation.size(); i++)
         {
             int seg_point = (int)i;
             if (find(segmentation.begin(), segmentation.end(), seg_point) == segmentation.end())
@@ -370,8 +498,9 @@ private:
         return childs;
     }
 
-    void update_beam ( vector< vector<int> > &childs )
+    void update_beam ( beamSearch_state& st, vector< vector<int> > &childs ) const
     {
+        vector< beamSearch_node >& beam = st.beam;
         string out_sequence;
         double min_score = -DBL_MAX; //min score value to be part of the beam
         if ((int)beam.size() >= beam_size)
@@ -379,7 +508,7 @@ private:
 
         for (size_t i=0; i<childs.size(); i++)
         {
-            double score = score_segmentation(childs[i], out_sequence);
+            double score = score_segmentation(st, childs[i], out_sequence);
             if (score > min_score)
             {
                 beamSearch_node node;
@@ -398,8 +527,10 @@ private:
     }
 
 
-    double score_segmentation( vector<int> &segmentation, string& outstring )
+    double score_segmentation( const beamSearch_state& st, vector<int> &segmentation, string& outstring ) const
     {
+        const vector< vector<double> >& recognition_probabilities = st.recognition_probabilities;
+        const vector<int>& oversegmentation = st.oversegmentation;
 
         // Score Heuristics:
         // No need to use Viterbi to know a given segmentation is bad
@@ -518,14 +649,16 @@ public:
     ~OCRBeamSearchClassifierCNN() CV_OVERRIDE {}
 
     void eval( InputArray src, vector< vector<double> >& recognition_probabilities, vector<int>& oversegmentation ) CV_OVERRIDE;
+    void evalBatch( InputArrayOfArrays images, vector< vector< vector<double> > >& recognition_probabilities,
+                    vector< vector<int> >& oversegmentation ) CV_OVERRIDE;
 
     int getWindowSize() {return window_size;}
     int getStepSize() {return step_size;}
     void setStepSize(int _step_size) {step_size = _step_size;}
 
 protected:
-    void normalizeAndZCA(Mat& patches);
-    double eval_feature(Mat& feature, double* prob_estimates);
+    void extractFeatures(const Mat& src, Mat& features) const;
+    void classifyFeatures(const Mat& features, Mat& probabilities) const;
 
 private:
     int window_size; // window size
@@ -537,6 +670,9 @@ private:
     Mat weights;     // Logistic Regression weights
     Mat kernels;     // CNN kernels
     Mat M, P;        // ZCA Whitening parameters
+    Mat zca_kernels; // P*kernels^T, whitening and convolution in a single product
+    Mat zca_offset;  // M*P*kernels^T
+    Mat weights64;   // weights as CV_64F
     int quad_size;
     int patch_size;
     int num_quads;   // extract 25 quads (12x12) from each image
@@ -563,6 +699,8 @@ OCRBeamSearchClassifierCNN::OCRBeamSearchClassifierCNN (const string& filename)
     else
         CV_Error(Error::StsBadArg, "Default classifier data file not found!");
 
+    CV_Assert( !kernels.empty() && !M.empty() && !P.empty() && !weights.empty() );
+
     nr_feature = weights.rows;
     nr_class   = weights.cols;
     patch_size  = cvRound(sqrt((float)kernels.cols));
@@ -572,22 +710,35 @@ OCRBeamSearchClassifierCNN::OCRBeamSearchClassifierCNN (const string& filename)
     num_quads   = 25;
     num_tiles   = 25;
     alpha       = 0.5; // used in non-linear activation function z = max(0, |D*a| - alpha)
-}
 
-void OCRBeamSearchClassifierCNN::eval( InputArray _src, vector< vector<double> >& recognition_probabilities, vector<int>& oversegmentation)
-{
+    CV_Assert( nr_feature == 9*kernels.rows );
 
-    CV_Assert(( _src.getMat().type() == CV_8UC3 ) || ( _src.getMat().type() == CV_8UC1 ));
-    if (!recognition_probabilities.empty())
-    {
-        for (size_t i=0; i<recognition_probabilities.size(); i++)
-            recognition_probabilities[i].clear();
-    }
-    recognition_probabilities.clear();
-    oversegmentation.clear();
+    // (x - M)*P*kernels^T == x*(P*kernels^T) - M*(P*kernels^T)
+    zca_kernels = P * kernels.t();
+    zca_offset  = M * zca_kernels;
+    weights.convertTo(weights64, CV_64F);
+}
 
+// quads of a detection window (numbered 1..25 along the columns) that are averaged in each pool,
+// the lists are zero terminated
+static const int pool_quads[9][10] = {
+    { 1, 2, 6, 7, 0 },
+    { 2, 7, 3, 8, 4, 9, 0 },
+    { 4, 9, 5, 10, 0 },
+    { 6, 11, 16, 7, 12, 17, 0 },
+    { 7, 12, 17, 8, 13, 18, 9, 14, 19, 0 },
+    { 9, 14, 19, 10, 15, 20, 0 },
+    { 16, 21, 17, 22, 0 },
+    { 17, 22, 18, 23, 19, 24, 0 },
+    { 19, 24, 20, 25, 0 }
+};
 
-    Mat src = _src.getMat();
+// Computes the scaled feature vector of every sliding window of src, one per row. The patches of
+// neighbouring windows overlap, so the responses of every patch position of the word are computed
+// once with a single matrix product and then pooled for each window.
+void OCRBeamSearchClassifierCNN::extractFeatures(const Mat& _src, Mat& features) const
+{
+    Mat src = _src;
     if(src.type() == CV_8UC3)
     {
         cvtColor(src,src,COLOR_RGB2GRAY);
@@ -595,187 +746,198 @@ void OCRBeamSearchClassifierCNN::eval( InputArray _src, vector< vector<double> >
 
     resize(src,src,Size(window_size*src.cols/src.rows,window_size),0,0,INTER_LINEAR_EXACT);
 
-    int seg_points = 0;
+    int sz = src.cols - window_size;
+    int nwindows = (sz >= 0) ? sz/step_size + 1 : 0;
+    features.create(nwindows, nr_feature, CV_64FC1);
+    if (nwindows == 0)
+        return;
 
-    Mat quad;
-    Mat tmp;
-    Mat img;
+    const int nr_kernels = kernels.rows;
+    const int patch_dim  = patch_size*patch_size;
+    const int cols_p     = src.cols - patch_size + 1;   // patch positions along a row
+    const int rows_p     = window_size - patch_size + 1; // patch positions along a column
 
-    int sz = src.cols - window_size;
-    int sz_window_quad = window_size - quad_size;
-    int sz_half_quad = (int)(quad_size/2-1);
-    int sz_quad_patch = quad_size - patch_size;
-    // begin sliding window loop foreach detection window
-    for (int x_c = 0; x_c <= sz; x_c += step_size)
+    // normalize every patch for contrast
+    Mat patches(rows_p*cols_p, patch_dim, CV_64FC1);
+    for (int y = 0; y < rows_p; y++)
     {
+        for (int x = 0; x < cols_p; x++)
+        {
+            double* p = patches.ptr<double>(y*cols_p + x);
+            double sum = 0, sqsum = 0;
+            for (int py = 0; py < patch_size; py++)
+            {
+                const uchar* s = src.ptr<uchar>(y + py) + x;
+                for (int px = 0; px < patch_size; px++)
+                {
+                    double v = s[px];
+                    p[py*patch_size + px] = v;
+                    sum += v;
+                    sqsum += v*v;
+                }
+            }
+            double mean = sum/patch_dim;
+            double var  = std::max(sqsum/patch_dim - mean*mean, 0.);
+            double row_std = sqrt(var*patch_dim/(patch_dim-1)+10);
+            for (int k = 0; k < patch_dim; k++)
+                p[k] = (p[k] - mean) / row_std;
+        }
+    }
 
-        img = src(Rect(Point(x_c,0),Size(window_size,window_size)));
-
-        vector< vector<double> > data_pool(9);
+    // ZCA whitening and dot product with the kernels, followed by the non-linear activation
+    Mat responses;
+    gemm(patches, zca_kernels, 1, noArray(), 0, responses);
+    const double* offset = zca_offset.ptr<double>();
+    for (int r = 0; r < responses.rows; r++)
+    {
+        double* resp = responses.ptr<double>(r);
+        for (int f = 0; f < nr_kernels; f++)
+            resp[f] = max(0.0, std::abs(resp[f] - offset[f]) - alpha);
+    }
 
+    int sz_window_quad = window_size - quad_size;
+    int sz_half_quad = (int)(quad_size/2-1);
+    int sz_quad_patch = quad_size - patch_size;
 
-        int quad_id = 1;
+    Mat quads(num_quads, nr_kernels, CV_64FC1);
+    const double lower = -1.0;
+    const double upper =  1.0;
+    for (int w = 0; w < nwindows; w++)
+    {
+        int x_c = w*step_size;
 
+        // sum of the patch responses of every quad
+        int quad_id = 0;
         for (int q_x = 0; q_x <= sz_window_quad; q_x += sz_half_quad)
         {
             for (int q_y = 0; q_y <= sz_window_quad; q_y += sz_half_quad)
             {
-                Rect quad_rect = Rect(q_x,q_y,quad_size,quad_size);
-                quad = img(quad_rect);
-
-                //start sliding window (8x8) in each tile and store the patch as row in data_pool
+                CV_Assert( quad_id < num_quads );
+                double* q = quads.ptr<double>(quad_id++);
+                for (int f = 0; f < nr_kernels; f++)
+                    q[f] = 0;
                 for (int w_x = 0; w_x <= sz_quad_patch; w_x++)
                 {
                     for (int w_y = 0; w_y <= sz_quad_patch; w_y++)
                     {
-                        quad(Rect(w_x,w_y,patch_size,patch_size)).convertTo(tmp, CV_64F);
-                        tmp = tmp.reshape(0,1);
-                        normalizeAndZCA(tmp);
-                        vector<double> patch;
-                        tmp.copyTo(patch);
-                        if ((quad_id == 1)||(quad_id == 2)||(quad_id == 6)||(quad_id == 7))
-                            data_pool[0].insert(data_pool[0].end(),patch.begin(),patch.end());
-                        if ((quad_id == 2)||(quad_id == 7)||(quad_id == 3)||(quad_id == 8)||(quad_id == 4)||(quad_id == 9))
-                            data_pool[1].insert(data_pool[1].end(),patch.begin(),patch.end());
-                        if ((quad_id == 4)||(quad_id == 9)||(quad_id == 5)||(quad_id == 10))
-                            data_pool[2].insert(data_pool[2].end(),patch.begin(),patch.end());
-                        if ((quad_id == 6)||(quad_id == 11)||(quad_id == 16)||(quad_id == 7)||(quad_id == 12)||(quad_id == 17))
-                            data_pool[3].insert(data_pool[3].end(),patch.begin(),patch.end());
-                        if ((quad_id == 7)||(quad_id == 12)||(quad_id == 17)||(quad_id == 8)||(quad_id == 13)||(quad_id == 18)||(quad_id == 9)||(quad_id == 14)||(quad_id == 19))
-                            data_pool[4].insert(data_pool[4].end(),patch.begin(),patch.end());
-                        if ((quad_id == 9)||(quad_id == 14)||(quad_id == 19)||(quad_id == 10)||(quad_id == 15)||(quad_id == 20))
-                            data_pool[5].insert(data_pool[5].end(),patch.begin(),patch.end());
-                        if ((quad_id == 16)||(quad_id == 21)||(quad_id == 17)||(quad_id == 22))
-                            data_pool[6].insert(data_pool[6].end(),patch.begin(),patch.end());
-                        if ((quad_id == 17)||(quad_id == 22)||(quad_id == 18)||(quad_id == 23)||(quad_id == 19)||(quad_id == 24))
-                            data_pool[7].insert(data_pool[7].end(),patch.begin(),patch.end());
-                        if ((quad_id == 19)||(quad_id == 24)||(quad_id == 20)||(quad_id == 25))
-                            data_pool[8].insert(data_pool[8].end(),patch.begin(),patch.end());
+                        const double* resp = responses.ptr<double>((q_y + w_y)*cols_p + x_c + q_x + w_x);
+                        for (int f = 0; f < nr_kernels; f++)
+                            q[f] += resp[f];
                     }
                 }
-
-                quad_id++;
             }
         }
 
-
-        //do dot product of each normalized and whitened patch
-        //each pool is averaged and this yields a representation of 9xD
-        Mat feature = Mat::zeros(9,kernels.rows,CV_64FC1);
-        for (int i=0; i<9; i++)
+        // each pool is averaged and this yields a representation of 9xD
+        double* feature = features.ptr<double>(w);
+        for (int i = 0; i < 9; i++)
         {
-            Mat pool = Mat(data_pool[i]);
-            pool = pool.reshape(0,(int)data_pool[i].size()/kernels.cols);
-            for (int p=0; p<pool.rows; p++)
+            double* pool = feature + i*nr_kernels;
+            for (int f = 0; f < nr_kernels; f++)
+                pool[f] = 0;
+            for (const int* qid = pool_quads[i]; *qid != 0; qid++)
             {
-                for (int f=0; f<kernels.rows; f++)
-                {
-                    feature.row(i).at<double>(0,f) = feature.row(i).at<double>(0,f) + max(0.0,std::abs(pool.row(p).dot(kernels.row(f)))-alpha);
-                }
+                const double* q = quads.ptr<double>(*qid - 1);
+                for (int f = 0; f < nr_kernels; f++)
+                    pool[f] += q[f];
             }
         }
-        feature = feature.reshape(0,1);
-
 
         // data must be normalized within the range obtained during training
-        double lower = -1.0;
-        double upper =  1.0;
-        for (int k=0; k<feature.cols; k++)
+        for (int k = 0; k < nr_feature; k++)
         {
-            feature.at<double>(0,k) = lower + (upper-lower) *
-                    (feature.at<double>(0,k)-feature_min.at<double>(0,k))/
+            feature[k] = lower + (upper-lower) *
+                    (feature[k]-feature_min.at<double>(0,k))/
                     (feature_max.at<double>(0,k)-feature_min.at<double>(0,k));
         }
-
-        double *p = new double[nr_class];
-        double predict_label = eval_feature(feature,p);
-
-        if ( (predict_label < 0) || (predict_label > nr_class) )
-            CV_Error(Error::StsOutOfRange, "OCRBeamSearchClassifierCNN::eval Error: unexpected prediction in eval_feature()");
-
-
-        vector<double> recognition_p(p, p+nr_class);
-        recognition_probabilities.push_back(recognition_p);
-        oversegmentation.push_back(seg_points);
-        seg_points++;
     }
-
 }
 
-// normalize for contrast and apply ZCA whitening to a set of image patches
-void OCRBeamSearchClassifierCNN::normalizeAndZCA(Mat& patches)
+// Logistic Regression of a set of features (one per row), the class probabilities of every
+// feature are normalized to sum up to one.
+void OCRBeamSearchClassifierCNN::classifyFeatures(const Mat& features, Mat& probabilities) const
 {
-
-    //Normalize for contrast
-    for (int i=0; i<patches.rows; i++)
+    gemm(features, weights64, 1, noArray(), 0, probabilities);
+    for (int r = 0; r < probabilities.rows; r++)
     {
-        Scalar row_mean, row_std;
-        meanStdDev(patches.row(i),row_mean,row_std);
-        row_std[0] = sqrt(pow(row_std[0],2)*patches.cols/(patches.cols-1)+10);
-        patches.row(i) = (patches.row(i) - row_mean[0]) / row_std[0];
-    }
-
-
-    //ZCA whitening
-    if ((M.dims == 0) || (P.dims == 0))
-    {
-        Mat CC;
-        calcCovarMatrix(patches,CC,M,COVAR_NORMAL|COVAR_ROWS|COVAR_SCALE);
-        CC = CC * patches.rows / (patches.rows-1);
-
-
-        Mat e_val,e_vec;
-        eigen(CC.t(),e_val,e_vec);
-        e_vec = e_vec.t();
-        sqrt(1./(e_val + 0.1), e_val);
-
-
-        Mat V = Mat::zeros(e_vec.rows, e_vec.cols, CV_64FC1);
-        Mat D = Mat::eye(e_vec.rows, e_vec.cols, CV_64FC1);
-
-        for (int i=0; i<e_vec.cols; i++)
+        double* prob_estimates = probabilities.ptr<double>(r);
+        double sum = 0;
+        for (int i = 0; i < nr_class; i++)
         {
-            e_vec.col(e_vec.cols-i-1).copyTo(V.col(i));
-            D.col(i) = D.col(i) * e_val.at<double>(0,e_val.rows-i-1);
+            prob_estimates[i] = 1/(1+exp(-prob_estimates[i]));
+            sum += prob_estimates[i];
         }
-
-        P = V * D * V.t();
+        for (int i = 0; i < nr_class; i++)
+            prob_estimates[i] = prob_estimates[i]/sum;
     }
-
-    for (int i=0; i<patches.rows; i++)
-        patches.row(i) = patches.row(i) - M;
-
-    patches = patches * P;
-
 }
 
-double OCRBeamSearchClassifierCNN::eval_feature(Mat& feature, double* prob_estimates)
+void OCRBeamSearchClassifierCNN::eval( InputArray _src, vector< vector<double> >& recognition_probabilities, vector<int>& oversegmentation)
 {
-    for(int i=0;i<nr_class;i++)
-        prob_estimates[i] = 0;
 
-    for(int idx=0; idx<nr_feature; idx++)
-        for(int i=0;i<nr_class;i++)
-            prob_estimates[i] += weights.at<float>(idx,i)*feature.at<double>(0,idx); //TODO use vectorized dot product
-
-    int dec_max_idx = 0;
-    for(int i=1;i<nr_class;i++)
+    CV_Assert(( _src.getMat().type() == CV_8UC3 ) || ( _src.getMat().type() == CV_8UC1 ));
+    if (!recognition_probabilities.empty())
     {
-        if(prob_estimates[i] > prob_estimates[dec_max_idx])
-            dec_max_idx = i;
+        for (size_t i=0; i<recognition_probabilities.size(); i++)
+            recognition_probabilities[i].clear();
     }
+    recognition_probabilities.clear();
+    oversegmentation.clear();
 
-    for(int i=0;i<nr_class;i++)
-        prob_estimates[i]=1/(1+exp(-prob_estimates[i]));
+    Mat features, probabilities;
+    extractFeatures(_src.getMat(), features);
+    if (features.empty())
+        return;
+    classifyFeatures(features, probabilities);
 
-    double sum=0;
-    for(int i=0; i<nr_class; i++)
-        sum+=prob_estimates[i];
+    for (int w = 0; w < probabilities.rows; w++)
+    {
+        const double* p = probabilities.ptr<double>(w);
+        recognition_probabilities.push_back(vector<double>(p, p+nr_class));
+        oversegmentation.push_back(w);
+    }
+}
 
-    for(int i=0; i<nr_class; i++)
-        prob_estimates[i]=prob_estimates[i]/sum;
+void OCRBeamSearchClassifierCNN::evalBatch( InputArrayOfArrays _images, vector< vector< vector<double> > >& recognition_probabilities,
+                                            vector< vector<int> >& oversegmentation)
+{
+    vector<Mat> images;
+    _images.getMatVector(images);
+    const int nimages = (int)images.size();
+    recognition_probabilities.assign(nimages, vector< vector<double> >());
+    oversegmentation.assign(nimages, vector<int>());
+
+    // the features of every word are extracted in parallel
+    vector<Mat> features(nimages);
+    parallel_for_(Range(0, nimages), [&](const Range& range) {
+        for (int i = range.start; i < range.end; i++)
+        {
+            CV_Assert(( images[i].type() == CV_8UC3 ) || ( images[i].type() == CV_8UC1 ));
+            extractFeatures(images[i], features[i]);
+        }
+    });
+
+    // and then the windows of all the words are classified with a single matrix product
+    vector<Mat> nonempty;
+    for (int i = 0; i < nimages; i++)
+        if (!features[i].empty())
+            nonempty.push_back(features[i]);
+    if (nonempty.empty())
+        return;
+    Mat all_features, probabilities;
+    vconcat(nonempty, all_features);
+    classifyFeatures(all_features, probabilities);
 
-    return dec_max_idx;
+    int row = 0;
+    for (int i = 0; i < nimages; i++)
+    {
+        for (int w = 0; w < features[i].rows; w++, row++)
+        {
+            const double* p = probabilities.ptr<double>(row);
+            recognition_probabilities[i].push_back(vector<double>(p, p+nr_class));
+            oversegmentation[i].push_back(w);
+        }
+    }
 }
 
 Ptr<OCRBeamSearchDecoder::ClassifierCallback> loadOCRBeamSearchClassifierCNN(const String& filename)
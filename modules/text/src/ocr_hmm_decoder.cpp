@@ -90,6 +90,29 @@ void OCRHMMDecoder::run(Mat& image, Mat& mask, string& output_text, vector<Rect>
         component_confidences->clear();
 }
 
+void OCRHMMDecoder::runBatch(InputArrayOfArrays _images, vector<string>& output_texts,
+                             vector< vector<Rect> >* component_rects, vector< vector<string> >* component_texts,
+                             vector< vector<float> >* component_confidences, int component_level)
+{
+    vector<Mat> images;
+    _images.getMatVector(images);
+    output_texts.assign(images.size(), string());
+    if (component_rects != NULL)
+        component_rects->assign(images.size(), vector<Rect>());
+    if (component_texts != NULL)
+        component_texts->assign(images.size(), vector<string>());
+    if (component_confidences != NULL)
+        component_confidences->assign(images.size(), vector<float>());
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        run(images[i], output_texts[i],
+            component_rects != NULL ? &(*component_rects)[i] : NULL,
+            component_texts != NULL ? &(*component_texts)[i] : NULL,
+            component_confidences != NULL ? &(*component_confidences)[i] : NULL,
+            component_level);
+    }
+}
+
 String OCRHMMDecoder::run(InputArray image, int min_confidence, int component_level)
 {
     std::string output1;
@@ -141,6 +164,8 @@ void OCRHMMDecoder::ClassifierCallback::eval( InputArray image, vector<int>& out
 bool sort_rect_horiz (Rect a,Rect b);
 bool sort_rect_horiz (Rect a,Rect b) { return (a.x<b.x); }
 
+static bool isBuiltinClassifier( const Ptr<OCRHMMDecoder::ClassifierCallback>& cb );
+
 class OCRHMMDecoderImpl : public OCRHMMDecoder
 {
 public:
@@ -169,10 +194,65 @@ public:
               vector<float>* component_confidences,
               int component_level) CV_OVERRIDE
     {
+        CV_Assert( component_level == OCR_LEVEL_WORD );
+        // the Viterbi decoding writes into the emission table, decode from a copy so that every
+        // call starts from the table given at creation, as every image of runBatch() does
+        Mat emission = emission_p.clone();
+        recognizeLine(image, emission, out_sequence, component_rects, component_texts, component_confidences);
+    }
+
+    void runBatch( InputArrayOfArrays _images,
+                   vector<string>& out_sequences,
+                   vector< vector<Rect> >* component_rects,
+                   vector< vector<string> >* component_texts,
+                   vector< vector<float> >* component_confidences,
+                   int component_level) CV_OVERRIDE
+    {
+        CV_Assert( component_level == OCR_LEVEL_WORD );
+        vector<Mat> images;
+        _images.getMatVector(images);
 
+        const int nimages = (int)images.size();
+        out_sequences.assign(nimages, string());
+        if (component_rects != NULL)
+            component_rects->assign(nimages, vector<Rect>());
+        if (component_texts != NULL)
+            component_texts->assign(nimages, vector<string>());
+        if (component_confidences != NULL)
+            component_confidences->assign(nimages, vector<float>());
+
+        // every image is decoded from its own copy of the emission table, as in run()
+        auto recognizeImages = [&](const Range& range) {
+            Mat emission;
+            for (int i = range.start; i < range.end; i++)
+            {
+                emission_p.copyTo(emission);
+                recognizeLine(images[i], emission, out_sequences[i],
+                              component_rects != NULL ? &(*component_rects)[i] : NULL,
+                              component_texts != NULL ? &(*component_texts)[i] : NULL,
+                              component_confidences != NULL ? &(*component_confidences)[i] : NULL);
+            }
+        };
+        // user supplied callbacks are not required to be thread safe, so only the built-in
+        // classifiers are evaluated from several images at once
+        if (isBuiltinClassifier(classifier))
+            parallel_for_(Range(0, nimages), recognizeImages);
+        else
+            recognizeImages(Range(0, nimages));
+    }
+
+private:
+    // Splits a text line into words and decodes each of them with Viterbi. The emission table
+    // is used as scratch space by the decoding.
+    void recognizeLine( const Mat& image,
+                        Mat& emission,
+                        string& out_sequence,
+                        vector<Rect>* component_rects,
+                        vector<string>* component_texts,
+                        vector<float>* component_confidences) const
+    {
         CV_Assert( (image.type() == CV_8UC1) || (image.type() == CV_8UC3) );
         CV_Assert( (image.cols > 0) && (image.rows > 0) );
-        CV_Assert( component_level == OCR_LEVEL_WORD );
 
         out_sequence.clear();
         if (component_rects != NULL)
@@ -337,9 +417,9 @@ public:
             {
                 for (int j=0; j<(int)observations[0].size(); j++)
                 {
-                    emission_p.at<double>(observations[0][j],obs[0]) = confidences[0][j];
+                    emission.at<double>(observations[0][j],obs[0]) = confidences[0][j];
                 }
-                V.at<double>(0,i) = start_p[i] * emission_p.at<double>(i,obs[0]);
+                V.at<double>(0,i) = start_p[i] * emission.at<double>(i,obs[0]);
                 path[i] = vocabulary.at(i);
             }
 
@@ -349,10 +429,10 @@ public:
             {
 
                 //Dude this has to be done each time!!
-                emission_p = Mat::eye(62,62,CV_64FC1);
+                emission = Mat::eye(62,62,CV_64FC1);
                 for (int e=0; e<(int)observations[t].size(); e++)
                 {
-                    emission_p.at<double>(observations[t][e],obs[t]) = confidences[t][e];
+                    emission.at<double>(observations[t][e],obs[t]) = confidences[t][e];
                 }
 
                 vector<string> newpath(vocabulary.size());
@@ -363,7 +443,7 @@ public:
                     int best_idx = 0;
                     for (int j=0; j<(int)vocabulary.size(); j++)
                     {
-                        double prob = V.at<double>(t-1,j) * transition_p.at<double>(j,i) * emission_p.at<double>(i,obs[t]);
+                        double prob = V.at<double>(t-1,j) * transition_p.at<double>(j,i) * emission.at<double>(i,obs[t]);
                         if ( prob > max_prob)
                         {
                             max_prob = prob;
@@ -407,6 +487,7 @@ public:
         return;
     }
 
+public:
     void run( Mat& image,
               Mat& mask,
               string& out_sequence,
@@ -430,6 +511,9 @@ public:
         if (component_confidences != NULL)
             component_confidences->clear();
 
+        // decode from a copy of the emission table, as the image-only run() does
+        Mat emission = emission_p.clone();
+
         // First we split a line into words
         vector<Mat> words_mask;
         vector<Rect> words_rect;
@@ -594,9 +678,9 @@ public:
             {
                 for (int j=0; j<(int)observations[0].size(); j++)
                 {
-                    emission_p.at<double>(observations[0][j],obs[0]) = confidences[0][j];
+                    emission.at<double>(observations[0][j],obs[0]) = confidences[0][j];
                 }
-                V.at<double>(0,i) = start_p[i] * emission_p.at<double>(i,obs[0]);
+                V.at<double>(0,i) = start_p[i] * emission.at<double>(i,obs[0]);
                 path[i] = vocabulary.at(i);
             }
 
@@ -606,10 +690,10 @@ public:
             {
 
                 //Dude this has to be done each time!!
-                emission_p = Mat::eye(62,62,CV_64FC1);
+                emission = Mat::eye(62,62,CV_64FC1);
                 for (int e=0; e<(int)observations[t].size(); e++)
                 {
-                    emission_p.at<double>(observations[t][e],obs[t]) = confidences[t][e];
+                    emission.at<double>(observations[t][e],obs[t]) = confidences[t][e];
                 }
 
                 vector<string> newpath(vocabulary.size());
@@ -620,7 +704,7 @@ public:
                     int best_idx = 0;
                     for (int j=0; j<(int)vocabulary.size(); j++)
                     {
-                        double prob = V.at<double>(t-1,j) * transition_p.at<double>(j,i) * emission_p.at<double>(i,obs[t]);
+                        double prob = V.at<double>(t-1,j) * transition_p.at<double>(j,i) * emission.at<double>(i,obs[t]);
                         if ( prob > max_prob)
                         {
                             max_prob = prob;
@@ -1205,6 +1289,13 @@ Ptr<OCRHMMDecoder::ClassifierCallback> loadOCRHMMClassifierCNN(const String& fil
     return makePtr<OCRHMMClassifierCNN>(std::string(filename));
 }
 
+/* The built-in classifiers only read their models in eval(), so they can be shared by the images of a batch */
+static bool isBuiltinClassifier( const Ptr<OCRHMMDecoder::ClassifierCallback>& cb )
+{
+    return dynamic_cast<OCRHMMClassifierKNN*>(cb.get()) != NULL ||
+           dynamic_cast<OCRHMMClassifierCNN*>(cb.get()) != NULL;
+}
+
 /** @brief Utility function to create a tailored language model transitions table from a given list of words (lexicon).
 
 @param vocabulary The language vocabulary (chars when ascii english text).
@@ -5,9 +5,7 @@
 #include "opencv2/core.hpp"
 #include "opencv2/imgproc.hpp"
 
-#include <unordered_map>
 #include <limits>
-#include <stack>
 
 using namespace std;
 
@@ -25,6 +23,7 @@ struct SWTPoint {
 struct Ray {
     SWTPoint p;
     SWTPoint q;
+    float length;
     std::vector<SWTPoint> points;
 };
 
@@ -68,7 +67,6 @@ const Scalar GREEN(0, 255, 0);
 const Scalar RED  (0, 0, 255);
 void SWTFirstPass (const Mat& edgeImage, const Mat& gradientX, const Mat& gradientY, bool dark_on_light, Mat & SWTImage, std::vector<Ray> & rays);
 void SWTSecondPass (Mat & SWTImage, std::vector<Ray> & rays);
-void normalizeAndScale (const Mat& SWTImage, Mat& output);
 std::vector<std::vector<SWTPoint>> getComponents (const Mat& SWTImage);
 ComponentAttr getAttributes(const vector<SWTPoint>& component, const Mat& SWTImage);
 void renderComponents (const Mat& SWTImage, const std::vector<Component>& components, Mat& output);
@@ -78,267 +76,180 @@ vector<cv::Rect> findValidChains(const Mat& input_image, const Mat& SWTImage, co
 vector<cv::Rect> getComponentBBs (const std::vector<Component>& components);
 bool chainSortDist (const ChainedComponent& Chainl, const ChainedComponent& Chainr);
 bool chainSortLength (const ChainedComponent& Chainl, const ChainedComponent& Chainr);
+void prepareSWTInput(const Mat& input, Mat& canny_edge_image, Mat& gradientX, Mat& gradientY);
+vector<cv::Rect> runSWT(const Mat& input, const Mat& canny_edge_image, const Mat& gradientX, const Mat& gradientY,
+                        bool dark_on_light, OutputArray draw, std::vector<cv::Rect>& outTextRegions);
 
 
-// A utility function to add an edge in an
-// undirected graph.
-static inline
-void addEdge(std::vector< std::vector<int> >& adj, int u, int v)
-{
-    adj[u].push_back(v);
-    adj[v].push_back(u);
-}
-
-static
-void DFSUtil(int v, std::vector<bool> & visited, std::vector< std::vector<int> >& adj, int label, std::vector<int> &component_id)
-{
-    stack<int> s;
-    s.push(v);
-    while(!s.empty()){
-        v = s.top();
-        s.pop();
-        if(!visited[v])
-        {
-            // Mark the current node as visited and label it as belonging to the current component
-            visited[v] = true;
-            component_id[v] = label;
-            // Recur for all the vertices
-            // adjacent to this vertex
-            for (size_t i = 0; i < adj[v].size(); i++) {
-                int neighbour = adj[v][i];
-                if(!visited[neighbour])
-                {
-                    s.push(neighbour);
-                }
-            }
-        }
-    }
-}
-
-static
-int connected_components(std::vector< std::vector<int> >& adj, std::vector<int> &component_id, int num_vertices)
-{
-    std::vector<bool> visited(num_vertices, false);
-
-    int label = 0;
-    for (int v=0; v<num_vertices; v++)
-    {
-        if (visited[v] == false)
-        {
-            DFSUtil(v, visited, adj, label, component_id);
-            label++;
-        }
-    }
-
-    return label;
-}
-
 void SWTFirstPass(const Mat& edgeImage, const Mat& gradientX, const Mat& gradientY, bool dark_on_light, Mat & SWTImage, std::vector<Ray> & rays)
 {
     SWTImage.setTo(Scalar::all(-1));
 
-    for(int row = 0; row < edgeImage.rows; row++ ){
-        for ( int col = 0; col < edgeImage.cols; col++ ){
-            uchar canny = edgeImage.at<uchar>(row, col);
-            if (canny <= 0) continue;
-
-            float dx = gradientX.at<float>(row, col);
-            float dy = gradientY.at<float>(row, col);
-            float mag = sqrt(dx * dx + dy * dy);
-            dx = dx / mag;
-            dy = dy / mag;
-
-            if (dark_on_light){
-                dx = -dx;
-                dy = -dy;
-            }
+    // the rays of every row are cast in parallel, they are gathered in row order afterwards
+    std::vector< std::vector<Ray> > rowRays(edgeImage.rows);
+    parallel_for_(Range(0, edgeImage.rows), [&](const Range& range) {
+        for(int row = range.start; row < range.end; row++ ){
+            for ( int col = 0; col < edgeImage.cols; col++ ){
+                uchar canny = edgeImage.at<uchar>(row, col);
+                if (canny <= 0) continue;
+
+                float dx = gradientX.at<float>(row, col);
+                float dy = gradientY.at<float>(row, col);
+                float mag = sqrt(dx * dx + dy * dy);
+                dx = dx / mag;
+                dy = dy / mag;
+
+                if (dark_on_light){
+                    dx = -dx;
+                    dy = -dy;
+                }
 
-            Ray ray;
-            SWTPoint p;
-            p.x = col;
-            p.y = row;
-            ray.p = p;
-            std::vector<SWTPoint> points;
-            points.push_back(p);
-            float curPosX = (float) col + (float) 0.5;
-            float curPosY = (float) row + (float) 0.5;
-            int curPixX = col;
-            int curPixY = row;
-            float inc = (float) 0.05;
-            while (true) {
-                curPosX += inc * dx;
-                curPosY += inc * dy;
-                if ((int)(floor(curPosX)) != curPixX || (int)(floor(curPosY)) != curPixY) {
-                    curPixX = (int)(floor(curPosX));
-                    curPixY = (int)(floor(curPosY));
-                    if (curPixX < 0 || (curPixX >= SWTImage.cols) || curPixY < 0 || (curPixY >= SWTImage.rows)) {
-                        break;
-                    }
-                    SWTPoint pt;
-                    pt.x = curPixX;
-                    pt.y = curPixY;
-                    points.push_back(pt);
-                    if (edgeImage.at<uchar>(curPixY, curPixX) > 0) {
-                        ray.q = pt;
-                        float G_xt = gradientX.at<float>(curPixY,curPixX);
-                        float G_yt = gradientY.at<float>(curPixY,curPixX);
-                        mag = sqrt( (G_xt * G_xt) + (G_yt * G_yt) );
-                        G_xt = G_xt / mag;
-                        G_yt = G_yt / mag;
-                        if (dark_on_light){
-                            G_xt = -G_xt;
-                            G_yt = -G_yt;
+                Ray ray;
+                SWTPoint p;
+                p.x = col;
+                p.y = row;
+                ray.p = p;
+                std::vector<SWTPoint> points;
+                points.push_back(p);
+                float curPosX = (float) col + (float) 0.5;
+                float curPosY = (float) row + (float) 0.5;
+                int curPixX = col;
+                int curPixY = row;
+                float inc = (float) 0.05;
+                while (true) {
+                    curPosX += inc * dx;
+                    curPosY += inc * dy;
+                    if ((int)(floor(curPosX)) != curPixX || (int)(floor(curPosY)) != curPixY) {
+                        curPixX = (int)(floor(curPosX));
+                        curPixY = (int)(floor(curPosY));
+                        if (curPixX < 0 || (curPixX >= SWTImage.cols) || curPixY < 0 || (curPixY >= SWTImage.rows)) {
+                            break;
                         }
+                        SWTPoint pt;
+                        pt.x = curPixX;
+                        pt.y = curPixY;
+                        points.push_back(pt);
+                        if (edgeImage.at<uchar>(curPixY, curPixX) > 0) {
+                            ray.q = pt;
+                            float G_xt = gradientX.at<float>(curPixY,curPixX);
+                            float G_yt = gradientY.at<float>(curPixY,curPixX);
+                            mag = sqrt( (G_xt * G_xt) + (G_yt * G_yt) );
+                            G_xt = G_xt / mag;
+                            G_yt = G_yt / mag;
+                            if (dark_on_light){
+                                G_xt = -G_xt;
+                                G_yt = -G_yt;
+                            }
 
-                        if (acos(dx * -G_xt + dy * -G_yt) < CV_PI/2.0 ) {
-                            float length = sqrt( ((float)ray.q.x - (float)ray.p.x)*((float)ray.q.x - (float)ray.p.x) + ((float)ray.q.y - (float)ray.p.y)*((float)ray.q.y - (float)ray.p.y));
-                            for (std::vector<SWTPoint>::iterator pit = points.begin(); pit != points.end(); pit++) {
-                                if (SWTImage.at<float>(pit->y, pit->x) < 0) {
-                                    SWTImage.at<float>(pit->y, pit->x) = length;
-                                } else {
-                                    SWTImage.at<float>(pit->y, pit->x) = std::min(length, SWTImage.at<float>(pit->y, pit->x));
-                                }
+                            if (acos(dx * -G_xt + dy * -G_yt) < CV_PI/2.0 ) {
+                                ray.length = sqrt( ((float)ray.q.x - (float)ray.p.x)*((float)ray.q.x - (float)ray.p.x) + ((float)ray.q.y - (float)ray.p.y)*((float)ray.q.y - (float)ray.p.y));
+                                ray.points.swap(points);
+                                rowRays[row].push_back(std::move(ray));
                             }
-                            ray.points = points;
-                            rays.push_back(ray);
+                            break;
                         }
-                        break;
                     }
                 }
-            }
-
-        }
-    }
-
-}
-
-static inline
-bool sortBySWT(const SWTPoint &lhs, const SWTPoint &rhs)
-{
-    return lhs.SWT < rhs.SWT;
-}
-
 
-void SWTSecondPass (Mat & SWTImage, std::vector<Ray> & rays) {
-    for (std::vector<Ray>::iterator rit = rays.begin(); rit != rays.end(); rit++) {
-        for (std::vector<SWTPoint>::iterator pit = rit->points.begin(); pit != rit->points.end(); pit++) {
-            pit->SWT = SWTImage.at<float>(pit->y, pit->x);
+            }
         }
-        std::sort(rit->points.begin(), rit->points.end(), sortBySWT);
-        float median = (rit -> points[rit -> points.size()/2]).SWT;
-        for (std::vector<SWTPoint>::iterator pit = rit->points.begin(); pit != rit->points.end(); pit++) {
-            SWTImage.at<float>(pit->y, pit->x) = std::min(pit->SWT, median);
+    }, std::max(1, getNumThreads()) * 4.);
+
+    // the minimum stroke width of every pixel does not depend on the order of the rays
+    for (int row = 0; row < edgeImage.rows; row++) {
+        for (std::vector<Ray>::iterator rit = rowRays[row].begin(); rit != rowRays[row].end(); rit++) {
+            for (std::vector<SWTPoint>::iterator pit = rit->points.begin(); pit != rit->points.end(); pit++) {
+                float& swt = SWTImage.at<float>(pit->y, pit->x);
+                if (swt < 0) {
+                    swt = rit->length;
+                } else {
+                    swt = std::min(rit->length, swt);
+                }
+            }
+            rays.push_back(std::move(*rit));
         }
     }
 }
 
-void normalizeAndScale (const Mat& SWTImage, Mat& output) {
-    CV_CheckTypeEQ(SWTImage.type(), CV_32FC1, "");
-    CV_CheckTypeEQ(output.type(), CV_8UC1, "");
-
-    Mat outputTemp(output.size(), CV_32FC1);
-
-    float maxSWT = 0;
-    float minSWT = (float) FLT_MAX;
-    for(int row = 0; row < SWTImage.rows; row++){
-        for (int col = 0; col < SWTImage.cols; col++){
-            float val = SWTImage.at<float>(row, col);
-            if (val < 0)
-                continue;
-            maxSWT = std::max(val, maxSWT);
-            minSWT = std::min(val, minSWT);
-        }
+void SWTSecondPass (Mat & SWTImage, std::vector<Ray> & rays) {
+    // Every ray, in order, clamps its pixels to the median of their current stroke widths, so a ray
+    // depends on the earlier rays it shares a pixel with. The rays are grouped into waves where each
+    // ray comes after all of those; the rays of a wave have no pixel in common and are processed in
+    // parallel, which gives the same stroke widths as processing the rays one by one.
+    Mat_<int> pixelWave(SWTImage.size(), -1);
+    std::vector<int> rayWave(rays.size());
+    int nwaves = 0;
+    for (size_t r = 0; r < rays.size(); r++) {
+        int wave = 0;
+        for (std::vector<SWTPoint>::const_iterator pit = rays[r].points.begin(); pit != rays[r].points.end(); pit++)
+            wave = std::max(wave, pixelWave(pit->y, pit->x) + 1);
+        for (std::vector<SWTPoint>::const_iterator pit = rays[r].points.begin(); pit != rays[r].points.end(); pit++)
+            pixelWave(pit->y, pit->x) = wave;
+        rayWave[r] = wave;
+        nwaves = std::max(nwaves, wave + 1);
     }
 
-    float amplitude = maxSWT - minSWT;
-    for(int row = 0; row < SWTImage.rows; row++){
-        for (int col = 0; col < SWTImage.cols; col++){
-            float val = SWTImage.at<float>(row, col);
-            if (val < 0) {
-                outputTemp.at<float>(row, col) = 1;
-            }
-            else {
-                outputTemp.at<float>(row, col) = (val - minSWT) / amplitude;
+    // the rays of every wave, in their original order
+    std::vector<int> waveStart(nwaves + 1, 0), order(rays.size());
+    for (size_t r = 0; r < rays.size(); r++)
+        waveStart[rayWave[r] + 1]++;
+    for (int w = 0; w < nwaves; w++)
+        waveStart[w + 1] += waveStart[w];
+    std::vector<int> wavePos(waveStart.begin(), waveStart.end() - 1);
+    for (size_t r = 0; r < rays.size(); r++)
+        order[wavePos[rayWave[r]]++] = (int)r;
+
+    auto clampRays = [&](const Range& range) {
+        std::vector<float> widths;
+        for (int i = range.start; i < range.end; i++) {
+            std::vector<SWTPoint>& points = rays[order[i]].points;
+            widths.resize(points.size());
+            for (size_t k = 0; k < points.size(); k++)
+                widths[k] = SWTImage.at<float>(points[k].y, points[k].x);
+            std::nth_element(widths.begin(), widths.begin() + widths.size()/2, widths.end());
+            const float median = widths[widths.size()/2];
+            for (std::vector<SWTPoint>::iterator pit = points.begin(); pit != points.end(); pit++) {
+                float& swt = SWTImage.at<float>(pit->y, pit->x);
+                swt = std::min(swt, median);
             }
         }
+    };
+    for (int w = 0; w < nwaves; w++) {
+        const Range waveRange(waveStart[w], waveStart[w + 1]);
+        if (waveRange.size() < 64)
+            clampRays(waveRange);
+        else
+            parallel_for_(waveRange, clampRays, std::max(1, getNumThreads()) * 4.);
     }
-    outputTemp.convertTo(output, CV_8UC1, 255);
 }
 
 std::vector<std::vector<SWTPoint>> getComponents (const Mat& SWTImage) {
-    std::unordered_map<int, int> Pix2Node;
-    std::unordered_map<int, SWTPoint> Node2Pix;
-
-
-    int num_vertices = 0;
-
-    for(int row = 0; row < SWTImage.rows; row++){
-        for (int col = 0; col < SWTImage.cols; col++){
-            float val = SWTImage.at<float>(row, col);
-            if (val < 0) {
-                continue;
-            }
-            else {
-                Pix2Node[row * SWTImage.cols + col] = num_vertices;
-                SWTPoint p;
-                p.x = col;
-                p.y = row;
-                Node2Pix[num_vertices] = p;
-                num_vertices++;
-            }
-        }
-    }
-
-    std::vector< vector<int> > graph(num_vertices);
-
-    for(int row = 0; row < SWTImage.rows; row++){
-        for (int col = 0; col < SWTImage.cols; col++){
-            float val = SWTImage.at<float>(row, col);
-            if (val < 0) {
+    // Stroke widths are either -1 or at least 1 and any two positive widths pass the ratio test,
+    // so the components are the 8-connected components of the pixels with a stroke width.
+    Mat mask = SWTImage >= 0;
+    Mat labels;
+    int num_labels = connectedComponents(mask, labels, 8, CV_32S);
+
+    // components are ordered by their first pixel in raster order
+    std::vector<int> component_id(num_labels, -1);
+    std::vector<std::vector<SWTPoint> > components;
+    for(int row = 0; row < labels.rows; row++){
+        const int* label_row = labels.ptr<int>(row);
+        for (int col = 0; col < labels.cols; col++){
+            int label = label_row[col];
+            if (label == 0)
                 continue;
+            if (component_id[label] < 0) {
+                component_id[label] = (int)components.size();
+                components.push_back(std::vector<SWTPoint>());
             }
-            else {
-                int currentNode = Pix2Node[row * SWTImage.cols + col];
-                if (col+1 < SWTImage.cols) {
-                    float right = SWTImage.at<float>(row, col+1);
-                    if (right > 0 && (val/right <= 3.0 || right/val <= 3.0))
-                        addEdge(graph, currentNode, Pix2Node.at(row * SWTImage.cols + col + 1));
-                }
-                if (row+1 < SWTImage.rows) {
-                    if (col+1 < SWTImage.cols) {
-                        float right_down = SWTImage.at<float>(row+1, col+1);
-                        if (right_down > 0 && (val/right_down <= 3.0 || right_down/val <= 3.0))
-                            addEdge(graph, currentNode, Pix2Node.at((row+1) * SWTImage.cols + col + 1));
-                    }
-                    float down = SWTImage.at<float>(row+1, col);
-                    if (down > 0 && (val/down <= 3.0 || down/val <= 3.0))
-                        addEdge(graph, currentNode, Pix2Node.at((row+1) * SWTImage.cols + col));
-                    if (col-1 >= 0) {
-                        float left_down = SWTImage.at<float>(row+1, col-1);
-                        if (left_down > 0 && (val/left_down <= 3.0 || left_down/val <= 3.0))
-                            addEdge(graph, currentNode, Pix2Node.at((row+1) * SWTImage.cols + col - 1));
-                    }
-                }
-            }
+            SWTPoint p;
+            p.x = col;
+            p.y = row;
+            components[component_id[label]].push_back(p);
         }
     }
 
-    std::vector<int> component_id(num_vertices);
-
-    int num_comp = connected_components(graph, component_id, num_vertices);
-
-    std::vector<std::vector<SWTPoint> > components;
-    components.reserve(num_comp);
-
-    for (int j = 0; j < num_comp; j++) {
-        std::vector<SWTPoint> tmp;
-        components.push_back(tmp);
-    }
-    for (int j = 0; j < num_vertices; j++) {
-        SWTPoint p = Node2Pix[j];
-        components[component_id[j]].push_back(p);
-    }
-
     return components;
 }
 
@@ -439,69 +350,89 @@ std::vector<Component> filterComponents(const Mat& SWTImage, const std::vector<s
 {
     const int NUM_THETA = 36;  // in 180 (CV_PI)
 
-    std::vector<Component> filteredComponents;
-    filteredComponents.reserve(components.size());
-    for (size_t i = 0; i < components.size(); i++)
+    float cos_theta[NUM_THETA / 2], sin_theta[NUM_THETA / 2];
+    for (int theta_i = 0; theta_i < (NUM_THETA / 2); theta_i++)
     {
-        const vector<SWTPoint>& component = components[i];
-        ComponentAttr attributes = getAttributes(component, SWTImage);
-        if (!skipChecks && attributes.variance > 0.5 * attributes.mean) continue;
-        if (!skipChecks && attributes.width > 300) continue;
+        float theta = (float)(theta_i * (CV_PI / NUM_THETA));
+        cos_theta[theta_i] = cos(theta);
+        sin_theta[theta_i] = sin(theta);
+    }
 
+    // components are checked in parallel and the accepted ones are gathered in order
+    std::vector<Component> candidates(components.size());
+    std::vector<uchar> accepted(components.size(), 0);
+    parallel_for_(Range(0, (int)components.size()), [&](const Range& range) {
+        for (int i = range.start; i < range.end; i++)
+        {
+            const vector<SWTPoint>& component = components[i];
+            ComponentAttr attributes = getAttributes(component, SWTImage);
+            if (!skipChecks && attributes.variance > 0.5 * attributes.mean) continue;
+            if (!skipChecks && attributes.width > 300) continue;
 
-        float area = attributes.length * attributes.width;
 
-        // compute the rotated bounding box
-        for (int theta_i = 0; theta_i < (NUM_THETA / 2); theta_i++)
-        {
-            float theta = (float)(theta_i * (CV_PI / NUM_THETA));
-            float
-                xmin = 1000000,
-                ymin = 1000000,
-                xmax = 0,
-                ymax = 0;
-            for (size_t j = 0; j < component.size(); j++)
+            float area = attributes.length * attributes.width;
+
+            // compute the rotated bounding box
+            for (int theta_i = 0; theta_i < (NUM_THETA / 2); theta_i++)
             {
-                // TODO(optimization) use pre-calculated cos/sin table through [theta_i] indexing
-                float xtemp = component[j].x * cos(theta) + component[j].y * -sin(theta);
-                float ytemp = component[j].x * sin(theta) + component[j].y * cos(theta);
-                xmin = std::min(xtemp,xmin);
-                xmax = std::max(xtemp,xmax);
-                ymin = std::min(ytemp,ymin);
-                ymax = std::max(ytemp,ymax);
-            }
-            float ltemp = xmax - xmin + 1;
-            float wtemp = ymax - ymin + 1;
-            if (ltemp*wtemp < area) {
-                area = ltemp*wtemp;
-                attributes.length = ltemp;
-                attributes.width = wtemp;
+                const float cos_t = cos_theta[theta_i];
+                const float sin_t = sin_theta[theta_i];
+                float
+                    xmin = 1000000,
+                    ymin = 1000000,
+                    xmax = 0,
+                    ymax = 0;
+                for (size_t j = 0; j < component.size(); j++)
+                {
+                    float xtemp = component[j].x * cos_t + component[j].y * -sin_t;
+                    float ytemp = component[j].x * sin_t + component[j].y * cos_t;
+                    xmin = std::min(xtemp,xmin);
+                    xmax = std::max(xtemp,xmax);
+                    ymin = std::min(ytemp,ymin);
+                    ymax = std::max(ytemp,ymax);
+                }
+                float ltemp = xmax - xmin + 1;
+                float wtemp = ymax - ymin + 1;
+                if (ltemp*wtemp < area) {
+                    area = ltemp*wtemp;
+                    attributes.length = ltemp;
+                    attributes.width = wtemp;
+                }
             }
-        }
 
-        if (!skipChecks && (attributes.length/attributes.width < 1./10. || attributes.length/attributes.width > 10.)) continue;
+            if (!skipChecks && (attributes.length/attributes.width < 1./10. || attributes.length/attributes.width > 10.)) continue;
 
-        Component acceptedComponent;
-        acceptedComponent.length = (int) attributes.length;
+            Component acceptedComponent;
+            acceptedComponent.length = (int) attributes.length;
 
-        acceptedComponent.cx = ((float) (attributes.xmax+attributes.xmin)) / 2;
-        acceptedComponent.cy = ((float) (attributes.ymax+attributes.ymin)) / 2;
+            acceptedComponent.cx = ((float) (attributes.xmax+attributes.xmin)) / 2;
+            acceptedComponent.cy = ((float) (attributes.ymax+attributes.ymin)) / 2;
 
-        acceptedComponent.BB_pointP.x = attributes.xmin;
-        acceptedComponent.BB_pointP.y = attributes.ymin;
+            acceptedComponent.BB_pointP.x = attributes.xmin;
+            acceptedComponent.BB_pointP.y = attributes.ymin;
 
-        acceptedComponent.BB_pointQ.x = attributes.xmax;
-        acceptedComponent.BB_pointQ.y = attributes.ymax;
+            acceptedComponent.BB_pointQ.x = attributes.xmax;
+            acceptedComponent.BB_pointQ.y = attributes.ymax;
 
-        acceptedComponent.length = attributes.xmax - attributes.xmin + 1;
-        acceptedComponent.width = attributes.ymax - attributes.ymin + 1;
+            acceptedComponent.length = attributes.xmax - attributes.xmin + 1;
+            acceptedComponent.width = attributes.ymax - attributes.ymin + 1;
 
-        acceptedComponent.mean = attributes.mean;
-        acceptedComponent.median = attributes.median;
+            acceptedComponent.mean = attributes.mean;
+            acceptedComponent.median = attributes.median;
 
-        acceptedComponent.points = component;
+            acceptedComponent.points = component;
 
-        filteredComponents.push_back(acceptedComponent);
+            candidates[i] = acceptedComponent;
+            accepted[i] = 1;
+        }
+    }, std::max(1, getNumThreads()) * 4.);
+
+    std::vector<Component> filteredComponents;
+    filteredComponents.reserve(components.size());
+    for (size_t i = 0; i < components.size(); i++)
+    {
+        if (accepted[i])
+            filteredComponents.push_back(std::move(candidates[i]));
     }
     if (!skipChecks){
         std::vector<Component> tempComp;
@@ -805,21 +736,15 @@ vector<cv::Rect> findValidChains(const Mat& input_image, const Mat& SWTImage, co
     return getComponentBBs(finalComponents);
 }
 
-}  // namespace
-
-void detectTextSWT(InputArray input_, CV_OUT std::vector<cv::Rect>& result, bool dark_on_light, OutputArray & draw /*=noArray()*/, OutputArray & chainBBs /*=noArray()*/)
+// Computes the edges and the gradients used by the Stroke Width Transform, they do not depend on the text polarity
+void prepareSWTInput(const Mat& input, Mat& canny_edge_image, Mat& gradientX, Mat& gradientY)
 {
-    CV_CheckTypeEQ(input_.type(), CV_8UC3, "");
-
-    Mat input = input_.getMat();
-
     // Convert to grayscale
     Mat grayImage;
     cvtColor(input, grayImage, COLOR_BGR2GRAY);
     // Create Canny Image
     double threshold_low = 175;
     double threshold_high = 320;
-    Mat canny_edge_image;
     Canny (grayImage, canny_edge_image, threshold_low, threshold_high, 3);
 
     // Create gradient X, gradient Y
@@ -827,14 +752,16 @@ void detectTextSWT(InputArray input_, CV_OUT std::vector<cv::Rect>& result, bool
     grayImage.convertTo(gaussianImage, CV_32FC1, 1./255.);
 
 
-    Mat gradientX;
-    Mat gradientY;
     GaussianBlur(gaussianImage, gaussianImage, Size(5, 5), 0);
     Scharr(gaussianImage, gradientX, -1, 1, 0);
     Scharr(gaussianImage, gradientY, -1, 0, 1);
     GaussianBlur(gradientX, gradientX, Size(3, 3), 0);
     GaussianBlur(gradientY, gradientY, Size(3, 3), 0);
+}
 
+vector<cv::Rect> runSWT(const Mat& input, const Mat& canny_edge_image, const Mat& gradientX, const Mat& gradientY,
+                        bool dark_on_light, OutputArray draw, std::vector<cv::Rect>& outTextRegions)
+{
     std::vector<Ray> rays;
     Mat SWTImage( input.size(), CV_32FC1 );
 
@@ -842,22 +769,55 @@ void detectTextSWT(InputArray input_, CV_OUT std::vector<cv::Rect>& result, bool
 
     SWTSecondPass ( SWTImage, rays );
 
-    Mat normalised_image(input.size(), CV_8UC1);
-    normalizeAndScale(SWTImage, normalised_image);
-
     // Calculate legally connected components from SWT and gradient image.
     // return type is a vector of vectors, where each outer vector is a component and
     // the inner vector contains the (y,x) of each pixel in that component.
     std::vector<std::vector<SWTPoint> > components = getComponents(SWTImage);
     std::vector<Component> validComponents = filterComponents(SWTImage, components, false);
 
+    return findValidChains(input, SWTImage, validComponents, draw, outTextRegions);
+}
+
+}  // namespace
+
+void detectTextSWT(InputArray input_, CV_OUT std::vector<cv::Rect>& result, bool dark_on_light, OutputArray & draw /*=noArray()*/, OutputArray & chainBBs /*=noArray()*/)
+{
+    CV_CheckTypeEQ(input_.type(), CV_8UC3, "");
+
+    Mat input = input_.getMat();
+
+    Mat canny_edge_image, gradientX, gradientY;
+    prepareSWTInput(input, canny_edge_image, gradientX, gradientY);
+
     vector<cv::Rect> outTextRegions;
 
-    result = findValidChains(input, SWTImage, validComponents, draw, outTextRegions);
+    result = runSWT(input, canny_edge_image, gradientX, gradientY, dark_on_light, draw, outTextRegions);
 
     if (chainBBs.needed()) {
          _InputArray(outTextRegions).copyTo(chainBBs);
     }
 }
 
+void detectTextSWT(InputArray input_, std::vector<cv::Rect>& result_dark_on_light, std::vector<cv::Rect>& result_light_on_dark,
+                   std::vector<cv::Rect>* chainBBs_dark_on_light, std::vector<cv::Rect>* chainBBs_light_on_dark)
+{
+    CV_CheckTypeEQ(input_.type(), CV_8UC3, "");
+
+    Mat input = input_.getMat();
+
+    Mat canny_edge_image, gradientX, gradientY;
+    prepareSWTInput(input, canny_edge_image, gradientX, gradientY);
+
+    // both polarities share the edges and gradients. They run one after the other, so that the
+    // passes of each one keep their own parallel loops (nested loops would run serially)
+    std::vector<cv::Rect> chains_dark_on_light, chains_light_on_dark;
+    result_dark_on_light = runSWT(input, canny_edge_image, gradientX, gradientY, true, noArray(), chains_dark_on_light);
+    result_light_on_dark = runSWT(input, canny_edge_image, gradientX, gradientY, false, noArray(), chains_light_on_dark);
+
+    if (chainBBs_dark_on_light != NULL)
+        chainBBs_dark_on_light->swap(chains_dark_on_light);
+    if (chainBBs_light_on_dark != NULL)
+        chainBBs_light_on_dark->swap(chains_light_on_dark);
+}
+
 }}  // namespace
@@ -4,6 +4,7 @@
 
 #include "test_precomp.hpp"
 #include "opencv2/imgcodecs.hpp"
+#include "opencv2/imgproc.hpp"
 
 namespace opencv_test { namespace {
 
@@ -74,6 +75,95 @@ TEST_P(Detection, sample)
     EXPECT_GT(groups_boxes.size(), 3u);
 }
 
+TEST_P(Detection, parallel_channels)
+{
+    InitERFilter();
+
+    std::string imageName = GET_PARAM(0);
+    if (GET_PARAM(1))
+        throw SkipTestException("Orientation does not affect the region extraction");
+    Mat src = cv::imread(findDataFile(imageName));
+    ASSERT_FALSE(src.empty());
+
+    std::vector<Mat> channels;
+    computeNMChannels(src, channels);
+    for (size_t c = channels.size(); c > 0; c--)
+        channels.push_back(255 - channels[c - 1]);
+
+    std::vector<std::vector<ERStat> > regions(channels.size());
+    for (size_t c = 0; c < channels.size(); c++)
+    {
+        er_filter1->run(channels[c], regions[c]);
+        er_filter2->run(channels[c], regions[c]);
+    }
+
+    // run twice to make sure that the reused workers start from a clean state
+    std::vector<std::vector<ERStat> > parallelRegions;
+    for (int iter = 0; iter < 2; iter++)
+    {
+        parallelRegions.clear();
+        runERFilter(channels, er_filter1, er_filter2, parallelRegions);
+        ASSERT_EQ(regions.size(), parallelRegions.size());
+        for (size_t c = 0; c < regions.size(); c++)
+        {
+            ASSERT_EQ(regions[c].size(), parallelRegions[c].size()) << "channel " << c;
+            for (size_t r = 0; r < regions[c].size(); r++)
+            {
+                EXPECT_EQ(regions[c][r].rect, parallelRegions[c][r].rect);
+                EXPECT_EQ(regions[c][r].level, parallelRegions[c][r].level);
+                EXPECT_EQ(regions[c][r].area, parallelRegions[c][r].area);
+                EXPECT_EQ(regions[c][r].probability, parallelRegions[c][r].probability);
+            }
+        }
+    }
+}
+
+// Every extremal region must be the 4-connected component of pixels not brighter than its level that
+// contains its seed pixel, independently of how the component tree was extracted
+TEST_P(Detection, parallel_regions_match_flood_fill)
+{
+    std::string imageName = GET_PARAM(0);
+    if (GET_PARAM(1))
+        throw SkipTestException("Orientation does not affect the region extraction");
+    Mat src = cv::imread(findDataFile(imageName));
+    ASSERT_FALSE(src.empty());
+    src = src(Rect(src.cols / 2 - 80, src.rows / 2 - 60, 160, 120)).clone();
+
+    // keep every region: no probability threshold, no non maximum suppression, unit threshold step
+    Ptr<ERFilter> er_filter = createERFilterNM1(loadClassifierNM1(findDataFile("trained_classifierNM1.xml")),
+                                                1, 0.f, 1.f, 0.f, false);
+
+    std::vector<Mat> channels;
+    computeNMChannels(src, channels);
+    for (size_t c = channels.size(); c > 0; c--)
+        channels.push_back(255 - channels[c - 1]);
+
+    std::vector<std::vector<ERStat> > regions;
+    runERFilter(channels, er_filter, Ptr<ERFilter>(), regions);
+    ASSERT_EQ(channels.size(), regions.size());
+
+    const int flags = 4 + (255 << 8) + FLOODFILL_FIXED_RANGE + FLOODFILL_MASK_ONLY;
+    Mat mask(src.rows + 2, src.cols + 2, CV_8UC1);
+    for (size_t c = 0; c < channels.size(); c++)
+    {
+        ASSERT_FALSE(regions[c].empty()) << "channel " << c;
+        for (size_t r = 0; r < regions[c].size(); r++)
+        {
+            const ERStat& stat = regions[c][r];
+            const Point seed(stat.pixel % src.cols, stat.pixel / src.cols);
+            const int seed_v = channels[c].at<uchar>(seed);
+            ASSERT_LE(seed_v, stat.level) << "channel " << c << " region " << r;
+
+            mask = Scalar(0);
+            Rect rect;
+            int area = floodFill(channels[c], mask, seed, Scalar(255), &rect,
+                                 Scalar(255), Scalar(stat.level - seed_v), flags);
+            EXPECT_EQ(area, stat.area) << "channel " << c << " region " << r;
+            EXPECT_EQ(rect, stat.rect) << "channel " << c << " region " << r;
+        }
+    }
+}
+
 INSTANTIATE_TEST_CASE_P(Text, Detection,
     testing::Combine(
         testing::Values(
@@ -46,4 +46,33 @@ TEST (TextDetectionSWT, accuracy_chaining) {
     EXPECT_LT(0.95 * image.total(), (double)chain.area());
 }
 
+TEST (TextDetectionSWT, independent_of_thread_count) {
+    const string dataPath = cvtest::findDataFile("cv/cloning/Mixed_Cloning/source1.png");
+    Mat image = imread(dataPath, IMREAD_COLOR);
+    const int threads = getNumThreads();
+    setNumThreads(1);
+    vector<Rect> expected, expectedChains;
+    detectTextSWT(image, expected, true, noArray(), expectedChains);
+    setNumThreads(threads);
+    vector<Rect> components, chains;
+    detectTextSWT(image, components, true, noArray(), chains);
+    EXPECT_EQ(expected, components);
+    EXPECT_EQ(expectedChains, chains);
+}
+
+TEST (TextDetectionSWT, both_polarities) {
+    const string dataPath = cvtest::findDataFile("cv/mser/mser_test.png");
+    Mat image = imread(dataPath, IMREAD_COLOR);
+    vector<Rect> darkOnLight, lightOnDark, chainsDarkOnLight, chainsLightOnDark;
+    detectTextSWT(image, darkOnLight, lightOnDark, &chainsDarkOnLight, &chainsLightOnDark);
+
+    vector<Rect> expected, expectedChains;
+    detectTextSWT(image, expected, true, noArray(), expectedChains);
+    EXPECT_EQ(expected, darkOnLight);
+    EXPECT_EQ(expectedChains, chainsDarkOnLight);
+    detectTextSWT(image, expected, false, noArray(), expectedChains);
+    EXPECT_EQ(expected, lightOnDark);
+    EXPECT_EQ(expectedChains, chainsLightOnDark);
+}
+
 }} // namespace
@@ -0,0 +1,131 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+#include "opencv2/imgproc.hpp"
+#include "opencv2/imgcodecs.hpp"
+
+namespace opencv_test { namespace {
+
+// Just skip test in case of missed testdata
+static cv::String findDataFile(const String& path)
+{
+    return cvtest::findDataFile(path, false);
+}
+
+static const std::string vocabulary = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+static Mat lexiconTransitions(const char* const* lexicon, size_t n)
+{
+    std::string voc = vocabulary;
+    std::vector<std::string> words(lexicon, lexicon + n);
+    Mat transition_p;
+    createOCRHMMTransitionsTable(voc, words, transition_p);
+    return transition_p;
+}
+
+static const char* const cropped_lexicon[] = { "abb", "riser", "CHINA", "HERE", "President", "smash",
+                                               "KUALA", "Produkt", "NINTENDO" };
+static const char* const cropped_words[][2] = {
+    { "scenetext_word01.jpg", "CHINA" },
+    { "scenetext_word02.jpg", "HERE" },
+    { "scenetext_word03.jpg", "riser" },
+    { "scenetext_word04.jpg", "Produkt" }
+};
+
+TEST(OCRBeamSearchDecoder, recognizes_cropped_words)
+{
+    Mat transition_p = lexiconTransitions(cropped_lexicon, sizeof(cropped_lexicon)/sizeof(cropped_lexicon[0]));
+    Mat emission_p = Mat::eye(62, 62, CV_64FC1);
+    Ptr<OCRBeamSearchDecoder> ocr = OCRBeamSearchDecoder::create(
+            loadOCRBeamSearchClassifierCNN(findDataFile("OCRBeamSearch_CNN_model_data.xml.gz")),
+            vocabulary, transition_p, emission_p, OCR_DECODER_VITERBI, 50);
+
+    const size_t nwords = sizeof(cropped_words)/sizeof(cropped_words[0]);
+    std::vector<Mat> images;
+    for (size_t i = 0; i < nwords; i++)
+    {
+        images.push_back(imread(findDataFile(cropped_words[i][0])));
+        ASSERT_FALSE(images.back().empty()) << cropped_words[i][0];
+    }
+
+    std::vector<std::string> texts;
+    std::vector<std::vector<std::string> > componentTexts;
+    std::vector<std::vector<float> > confidences;
+    // run twice to make sure that the reused beam buffers start from a clean state
+    for (int iter = 0; iter < 2; iter++)
+    {
+        ocr->runBatch(images, texts, NULL, &componentTexts, &confidences, OCR_LEVEL_WORD);
+        ASSERT_EQ(nwords, texts.size());
+        ASSERT_EQ(nwords, componentTexts.size());
+        ASSERT_EQ(nwords, confidences.size());
+        for (size_t i = 0; i < nwords; i++)
+        {
+            EXPECT_EQ(cropped_words[i][1], texts[i]) << cropped_words[i][0];
+            ASSERT_EQ(1u, componentTexts[i].size()) << cropped_words[i][0];
+            EXPECT_EQ(cropped_words[i][1], componentTexts[i][0]) << cropped_words[i][0];
+            // the word confidence is the probability of the decoded path
+            ASSERT_EQ(1u, confidences[i].size()) << cropped_words[i][0];
+            EXPECT_GT(confidences[i][0], 0.f) << cropped_words[i][0];
+            EXPECT_LE(confidences[i][0], 1.f) << cropped_words[i][0];
+
+            std::string text;
+            std::vector<float> wordConfidences;
+            Mat img = images[i].clone();
+            ocr->run(img, text, NULL, NULL, &wordConfidences, OCR_LEVEL_WORD);
+            EXPECT_EQ(texts[i], text) << cropped_words[i][0];
+            ASSERT_EQ(confidences[i].size(), wordConfidences.size());
+            EXPECT_NEAR(confidences[i][0], wordConfidences[0], 1e-4);
+        }
+    }
+}
+
+static const char* const segmented_lexicon[] = { "HOTEL", "FOSTERS", "Private", "Hire", "Stationery", "Box" };
+static const char* const segmented_words[][2] = {
+    { "scenetext_segmented_word01_mask.png", "HOTEL" },
+    { "scenetext_segmented_word04_mask.png", "FOSTERS" }
+};
+
+TEST(OCRHMMDecoder, recognizes_segmented_words)
+{
+    Mat transition_p = lexiconTransitions(segmented_lexicon, sizeof(segmented_lexicon)/sizeof(segmented_lexicon[0]));
+    Ptr<OCRHMMDecoder> ocr = OCRHMMDecoder::create(
+            loadOCRHMMClassifierNM(findDataFile("OCRHMM_knn_model_data.xml.gz")),
+            vocabulary, transition_p, Mat::eye(62, 62, CV_64FC1));
+
+    // the same word twice, every image must be decoded from the initial emission table
+    std::vector<Mat> masks;
+    std::vector<std::string> expected;
+    for (int iter = 0; iter < 2; iter++)
+    {
+        for (size_t i = 0; i < sizeof(segmented_words)/sizeof(segmented_words[0]); i++)
+        {
+            Mat mask = imread(findDataFile(segmented_words[i][0]), IMREAD_GRAYSCALE);
+            ASSERT_FALSE(mask.empty()) << segmented_words[i][0];
+            threshold(mask, mask, 128., 255, THRESH_BINARY);
+            masks.push_back(mask);
+            expected.push_back(segmented_words[i][1]);
+        }
+    }
+
+    std::vector<std::string> texts;
+    std::vector<std::vector<std::string> > componentTexts;
+    ocr->runBatch(masks, texts, NULL, &componentTexts, NULL, OCR_LEVEL_WORD);
+    ASSERT_EQ(masks.size(), texts.size());
+    ASSERT_EQ(masks.size(), componentTexts.size());
+
+    for (size_t i = 0; i < masks.size(); i++)
+    {
+        EXPECT_EQ(expected[i], texts[i]);
+
+        std::string text;
+        std::vector<std::string> words;
+        Mat mask = masks[i].clone();
+        ocr->run(mask, text, NULL, &words, NULL, OCR_LEVEL_WORD);
+        EXPECT_EQ(texts[i], text);
+        EXPECT_EQ(componentTexts[i], words);
+    }
+}
+
+}} // namespace
@@ -1210,6 +1210,16 @@ public:
     CV_WRAP virtual float getScaleFactor() const = 0;
     CV_WRAP virtual void setNScales(int n_scales) = 0;
     CV_WRAP virtual int getNScales() const = 0;
+
+    /** @brief Keeps the component trees of all the pyramid levels between detect() calls.
+
+    Intended for video: consecutive frames of the same size then reuse all the tree memory instead
+    of allocating it again. The buffers take about 110 bytes per pixel of every pyramid level and
+    are released when the frame size changes or when the reuse is disabled. Disabled by default,
+    the buffers are then released at the end of every detect() call.
+    */
+    CV_WRAP virtual void setReuseBuffers(bool reuse) = 0;
+    CV_WRAP virtual bool getReuseBuffers() const = 0;
 };
 
 /** @brief Estimates cornerness for prespecified KeyPoints using the FAST algorithm
@@ -0,0 +1,36 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef perf::TestBaseWithParam<std::string> affine_feature2d;
+
+#define AFFINE_FEATURE2D_IMAGES \
+    "cv/detectors_descriptors_evaluation/images_datasets/leuven/img1.png",\
+    "stitching/a3.png"
+
+PERF_TEST_P(affine_feature2d, detectAndCompute, testing::Values(AFFINE_FEATURE2D_IMAGES))
+{
+    string filename = getDataPath(GetParam());
+    Mat frame = imread(filename, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    Mat mask;
+    declare.in(frame).time(90);
+
+    Ptr<AffineFeature2D> affine = AffineFeature2D::create(HarrisLaplaceFeatureDetector::create(), BriefDescriptorExtractor::create());
+    vector<Elliptic_KeyPoint> points;
+    Mat descriptors;
+
+    TEST_CYCLE()
+    {
+        points.clear();
+        affine->detectAndCompute(frame, mask, points, descriptors);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -0,0 +1,38 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef tuple<int, bool, bool> GMSParams;
+typedef perf::TestBaseWithParam<GMSParams> gms;
+
+PERF_TEST_P(gms, matchGMS, testing::Combine(testing::Values(10000, 100000), testing::Bool(), testing::Bool()))
+{
+    const int numMatches = get<0>(GetParam());
+    const bool withRotation = get<1>(GetParam());
+    const bool withScale = get<2>(GetParam());
+    const Size size(1280, 720);
+
+    // Keypoints of the second image are shifted copies of the first ones, a quarter of the matches are random
+    RNG rng(0);
+    vector<KeyPoint> keypoints1(numMatches), keypoints2(numMatches);
+    vector<DMatch> matches(numMatches);
+    for (int i = 0; i < numMatches; i++)
+    {
+        Point2f pt((float)rng.uniform(0, size.width - 40), (float)rng.uniform(0, size.height - 20));
+        keypoints1[i] = KeyPoint(pt, 7.f);
+        keypoints2[i] = KeyPoint(pt + Point2f(30.f, 15.f), 7.f);
+        int trainIdx = (i % 4 == 0) ? rng.uniform(0, numMatches) : i;
+        matches[i] = DMatch(i, trainIdx, 0.f);
+    }
+
+    vector<DMatch> matchesGMS;
+
+    TEST_CYCLE() matchGMS(size, size, keypoints1, keypoints2, matches, matchesGMS, withRotation, withScale);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
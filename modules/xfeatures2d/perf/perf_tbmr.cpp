@@ -0,0 +1,34 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef tuple<std::string, int> TBMRParams;
+typedef perf::TestBaseWithParam<TBMRParams> tbmr;
+
+#define TBMR_IMAGES \
+    "cv/detectors_descriptors_evaluation/images_datasets/leuven/img1.png",\
+    "stitching/a3.png"
+
+PERF_TEST_P(tbmr, detect, testing::Combine(testing::Values(TBMR_IMAGES), testing::Values(1, 3)))
+{
+    string filename = getDataPath(get<0>(GetParam()));
+    int nScales = get<1>(GetParam());
+    Mat frame = imread(filename, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    Mat mask;
+    declare.in(frame);
+    Ptr<TBMR> detector = TBMR::create(60, 0.01f, 1.25f, nScales);
+    // consecutive calls on frames of the same size reuse the component trees, as for a video
+    detector->setReuseBuffers(true);
+    vector<KeyPoint> points;
+
+    TEST_CYCLE() detector->detect(frame, points, mask);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
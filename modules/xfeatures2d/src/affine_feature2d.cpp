@@ -27,6 +27,7 @@ float selIntegrationScale(const Mat & image, float si, Point c);
 float selDifferentiationScale(const Mat & image, Mat & Lxm2smooth, Mat & Lxmysmooth, Mat & Lym2smooth, float si, Point c);
 float calcSecondMomentSqrt(const Mat & dx2, const Mat & dxy, const Mat & dy2, Point p, Matx22f& Mk);
 float normMaxEval(Matx22f & U, Mat& uVal, Mat& uVect);
+static bool isSimilarAffineRegion(const Elliptic_KeyPoint& kp1, const Elliptic_KeyPoint& kp2);
 
 /*
  * Calculates second moments matrix in point p
@@ -450,45 +451,95 @@ float selDifferentiationScale(const Mat & img, Mat & Lxm2smooth, Mat & Lxmysmoot
     return sdk;
 }
 
+/*
+ * Checks whether kp2 is a duplicate of kp1
+ */
+static bool isSimilarAffineRegion(const Elliptic_KeyPoint& kp1, const Elliptic_KeyPoint& kp2)
+{
+    const float maxDiff = 4;
+    if (norm(kp1.pt - kp2.pt) > maxDiff)
+        return false;
+
+    float phi1, phi2;
+    Size axes1, axes2;
+    float si1, si2;
+    phi1 = kp1.angle;
+    phi2 = kp2.angle;
+    axes1 = kp1.axes;
+    axes2 = kp2.axes;
+    si1 = kp1.si;
+    si2 = kp2.si;
+    return std::abs(phi1-phi2)<15 && std::max(si1,si2)/std::min(si1,si2)<1.4f && axes1.width-axes2.width<5 && axes1.height-axes2.height<5;
+}
+
+struct AffineRegionXLess
+{
+    const std::vector<Elliptic_KeyPoint>& regions;
+    AffineRegionXLess(const std::vector<Elliptic_KeyPoint>& regions_) : regions(regions_) {}
+    bool operator()(int a, int b) const { return regions[a].pt.x < regions[b].pt.x; }
+    bool operator()(int a, float x) const { return regions[a].pt.x < x; }
+};
+
 void calcAffineCovariantRegions(const Mat & image, const std::vector<KeyPoint> & keypoints,
         std::vector<Elliptic_KeyPoint> & affRegions)
 {
-    for (size_t i = 0; i < keypoints.size(); ++i)
+    // Every keypoint is adapted independently, the converged ones are appended in the input order
+    const int n = (int)keypoints.size();
+    std::vector<Elliptic_KeyPoint> adapted(n);
+    std::vector<uchar> converged(n, 0);
+    parallel_for_(Range(0, n), [&](const Range& range)
     {
-        KeyPoint kp = keypoints[i];
-        Elliptic_KeyPoint ex(kp.pt, 0, Size_<float> (kp.size / 2, kp.size / 2), kp.size,
-                kp.size / 6);
+        for (int i = range.start; i < range.end; ++i)
+        {
+            const KeyPoint& kp = keypoints[i];
+            Elliptic_KeyPoint ex(kp.pt, 0, Size_<float> (kp.size / 2, kp.size / 2), kp.size,
+                    kp.size / 6);
 
-        if (calcAffineAdaptation(image, ex))
-            affRegions.push_back(ex);
+            if (calcAffineAdaptation(image, ex))
+            {
+                adapted[i] = ex;
+                converged[i] = 1;
+            }
+        }
+    });
+
+    std::vector<Elliptic_KeyPoint> regions;
+    for (int i = 0; i < n; ++i)
+    {
+        if (converged[i])
+            regions.push_back(adapted[i]);
     }
+
     //Erase similar keypoint
-    float maxDiff = 4;
-    Mat colorimg;
-    for (size_t i = 0; i < affRegions.size(); i++)
+    //A region removes the later similar regions, in the order of the regions. Only regions closer than
+    //the maximal distance in x can be similar, they are found in the list of regions sorted by x.
+    const float maxDiff = 4;
+    const int m = (int)regions.size();
+    std::vector<int> byX(m);
+    for (int i = 0; i < m; ++i)
+        byX[i] = i;
+    AffineRegionXLess xLess(regions);
+    std::stable_sort(byX.begin(), byX.end(), xLess);
+
+    std::vector<uchar> removed(m, 0);
+    for (int i = 0; i < m; ++i)
     {
-        Elliptic_KeyPoint kp1 = affRegions[i];
-        for (size_t j = i+1; j < affRegions.size(); j++){
-
-            Elliptic_KeyPoint kp2 = affRegions[j];
-
-            if(norm(kp1.pt-kp2.pt)<=maxDiff){
-                float phi1, phi2;
-                Size axes1, axes2;
-                float si1, si2;
-                phi1 = kp1.angle;
-                phi2 = kp2.angle;
-                axes1 = kp1.axes;
-                axes2 = kp2.axes;
-                si1 = kp1.si;
-                si2 = kp2.si;
-                if(std::abs(phi1-phi2)<15 && std::max(si1,si2)/std::min(si1,si2)<1.4f && axes1.width-axes2.width<5 && axes1.height-axes2.height<5){
-                    affRegions.erase(affRegions.begin()+j);
-                    j--;
-                }
-            }
+        if (removed[i])
+            continue;
+        std::vector<int>::const_iterator it = std::lower_bound(byX.begin(), byX.end(), regions[i].pt.x - maxDiff, xLess);
+        for (; it != byX.end() && regions[*it].pt.x <= regions[i].pt.x + maxDiff; ++it)
+        {
+            int j = *it;
+            if (j > i && !removed[j] && isSimilarAffineRegion(regions[i], regions[j]))
+                removed[j] = 1;
         }
     }
+
+    for (int i = 0; i < m; ++i)
+    {
+        if (!removed[i])
+            affRegions.push_back(regions[i]);
+    }
 }
 
 void calcAffineCovariantDescriptors(const Ptr<DescriptorExtractor>& dextractor, const Mat& img,
@@ -501,84 +552,91 @@ void calcAffineCovariantDescriptors(const Ptr<DescriptorExtractor>& dextractor,
     descriptors.create(Size(descriptorSize, int(affRegions.size())), descriptorType);
     descriptors.setTo(0);
 
-    int i = 0;
+    // The regions are warped in parallel, the extractor is called sequentially since it may be not thread-safe
+    const int n = int(affRegions.size());
+    std::vector<Mat> patches(n);
+    std::vector<KeyPoint> patchKeypoints(n);
 
-    for (std::vector<Elliptic_KeyPoint>::iterator it = affRegions.begin(); it < affRegions.end(); ++it)
+    parallel_for_(Range(0, n), [&](const Range& range)
     {
-        Point p = it->pt;
+        for (int i = range.start; i < range.end; ++i)
+        {
+            const Elliptic_KeyPoint* it = &affRegions[i];
+            Point p = it->pt;
 
-        Matx21f size;
-        size(0, 0) = size(1, 0) = it->size;
+            Matx21f size;
+            size(0, 0) = size(1, 0) = it->size;
 
-        //U matrix
-        Matx23f transf = it->transf;
-        Matx22f U(
-            transf(0,0), transf(0,1),
-            transf(1,0), transf(1,1)
-        );
+            //U matrix
+            Matx23f transf = it->transf;
+            Matx22f U(
+                transf(0,0), transf(0,1),
+                transf(1,0), transf(1,1)
+            );
 
-        float radius = it->size / 2;
-        float si = it->si;
+            float radius = it->size / 2;
+            float si = it->si;
 
-        Size_<float> boundingBox;
+            Size_<float> boundingBox;
 
-        float ac_b2 = float(determinant(U));
-        boundingBox.width  = ceil(U(1, 1)/ac_b2 * 3 * si );
-        boundingBox.height = ceil(U(0, 0)/ac_b2 * 3 * si );
+            float ac_b2 = float(determinant(U));
+            boundingBox.width  = ceil(U(1, 1)/ac_b2 * 3 * si );
+            boundingBox.height = ceil(U(0, 0)/ac_b2 * 3 * si );
 
-        //Create window around interest point
-        float half_width = std::min((float) std::min(img.cols - p.x-1, p.x), boundingBox.width);
-        float half_height = std::min((float) std::min(img.rows - p.y-1, p.y), boundingBox.height);
-        int roix = max(p.x - (int) boundingBox.width, 0);
-        int roiy = max(p.y - (int) boundingBox.height, 0);
-        Rect roi = Rect(roix, roiy, p.x - roix + int(half_width)+1, p.y - roiy + int(half_height)+1);
+            //Create window around interest point
+            float half_width = std::min((float) std::min(img.cols - p.x-1, p.x), boundingBox.width);
+            float half_height = std::min((float) std::min(img.rows - p.y-1, p.y), boundingBox.height);
+            int roix = max(p.x - (int) boundingBox.width, 0);
+            int roiy = max(p.y - (int) boundingBox.height, 0);
+            Rect roi = Rect(roix, roiy, p.x - roix + int(half_width)+1, p.y - roiy + int(half_height)+1);
 
-        Mat img_roi = img(roi);
+            Mat img_roi = img(roi);
 
-        size(0, 0) = float(img_roi.cols);
-        size(1, 0) = float(img_roi.rows);
+            size(0, 0) = float(img_roi.cols);
+            size(1, 0) = float(img_roi.rows);
 
-        size = U * size;
+            size = U * size;
 
-        Mat transfImgRoi, transfImg;
-        warpAffine(img_roi, transfImgRoi, transf, Size(int(ceil(size(0, 0))), int(ceil(size(1, 0)))),
-                INTER_AREA, BORDER_DEFAULT);
+            Mat transfImgRoi, transfImg;
+            warpAffine(img_roi, transfImgRoi, transf, Size(int(ceil(size(0, 0))), int(ceil(size(1, 0)))),
+                    INTER_AREA, BORDER_DEFAULT);
 
-        Matx21f c; //Transformed point
-        Matx21f pt; //Image point
-        //Point within the Roi
-        pt(0, 0) = float(p.x - roix);
-        pt(1, 0) = float(p.y - roiy);
+            Matx21f c; //Transformed point
+            Matx21f pt; //Image point
+            //Point within the Roi
+            pt(0, 0) = float(p.x - roix);
+            pt(1, 0) = float(p.y - roiy);
 
-        //Point in U-Normalized coordinates
-        c = U * pt;
-        float cx = c(0, 0);
-        float cy = c(1, 0);
+            //Point in U-Normalized coordinates
+            c = U * pt;
+            float cx = c(0, 0);
+            float cy = c(1, 0);
 
-        //Cut around point to have patch of 2*keypoint->size
+            //Cut around point to have patch of 2*keypoint->size
 
-        roix = std::max(int(ceil(cx - radius)), 0);
-        roiy = std::max(int(ceil(cy - radius)), 0);
+            roix = std::max(int(ceil(cx - radius)), 0);
+            roiy = std::max(int(ceil(cy - radius)), 0);
 
-        roi = Rect(roix, roiy, int(ceil(std::min(cx - roix + radius, size(0, 0)))),
-                int(ceil(std::min(cy - roiy + radius, size(1, 0)))));
-        transfImg = transfImgRoi(roi);
+            roi = Rect(roix, roiy, int(ceil(std::min(cx - roix + radius, size(0, 0)))),
+                    int(ceil(std::min(cy - roiy + radius, size(1, 0)))));
+            transfImg = transfImgRoi(roi);
 
-        cx = c(0, 0) - roix;
-        cy = c(1, 0) - roiy;
+            cx = c(0, 0) - roix;
+            cy = c(1, 0) - roiy;
 
-        Mat tmpDesc;
-        KeyPoint kp(Point(int(cx), int(cy)), it->size);
+            patchKeypoints[i] = KeyPoint(Point(int(cx), int(cy)), it->size);
+            transfImg.convertTo(patches[i], CV_8U);
+        }
+    });
 
-        std::vector<KeyPoint> k(1, kp);
+    for (int i = 0; i < n; ++i)
+    {
+        Mat tmpDesc;
+        std::vector<KeyPoint> k(1, patchKeypoints[i]);
 
-        transfImg.convertTo(transfImg, CV_8U);
-        dextractor->compute(transfImg, k, tmpDesc);
+        dextractor->compute(patches[i], k, tmpDesc);
 
         tmpDesc.row(0).copyTo(descriptors.row(i));
-
-        i++;
-
     }
 
 }
@@ -120,62 +120,71 @@ inline int smoothedSum(const Mat& sum, const KeyPoint& pt, int y, int x, bool us
 
 static void pixelTests16(InputArray _sum, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, bool use_orientation )
 {
-    Matx21f R;
     Mat sum = _sum.getMat(), descriptors = _descriptors.getMat();
-    for (size_t i = 0; i < keypoints.size(); ++i)
+    parallel_for_(Range(0, (int)keypoints.size()), [&](const Range& range)
     {
-        uchar* desc = descriptors.ptr(static_cast<int>(i));
-        const KeyPoint& pt = keypoints[i];
-        if ( use_orientation )
+        Matx21f R;
+        for (int i = range.start; i < range.end; ++i)
         {
-          float angle = pt.angle;
-          angle *= (float)(CV_PI/180.f);
-          R(0,0) = sin(angle);
-          R(1,0) = cos(angle);
-        }
+            uchar* desc = descriptors.ptr(i);
+            const KeyPoint& pt = keypoints[i];
+            if ( use_orientation )
+            {
+              float angle = pt.angle;
+              angle *= (float)(CV_PI/180.f);
+              R(0,0) = sin(angle);
+              R(1,0) = cos(angle);
+            }
 
 #include "generated_16.i"
-    }
+        }
+    });
 }
 
 static void pixelTests32(InputArray _sum, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, bool use_orientation)
 {
-    Matx21f R;
     Mat sum = _sum.getMat(), descriptors = _descriptors.getMat();
-    for (size_t i = 0; i < keypoints.size(); ++i)
+    parallel_for_(Range(0, (int)keypoints.size()), [&](const Range& range)
     {
-        uchar* desc = descriptors.ptr(static_cast<int>(i));
-        const KeyPoint& pt = keypoints[i];
-        if ( use_orientation )
+        Matx21f R;
+        for (int i = range.start; i < range.end; ++i)
         {
-          float angle = pt.angle;
-          angle *= (float)(CV_PI / 180.f);
-          R(0,0) = sin(angle);
-          R(1,0) = cos(angle);
-        }
+            uchar* desc = descriptors.ptr(i);
+            const KeyPoint& pt = keypoints[i];
+            if ( use_orientation )
+            {
+              float angle = pt.angle;
+              angle *= (float)(CV_PI / 180.f);
+              R(0,0) = sin(angle);
+              R(1,0) = cos(angle);
+            }
 
 #include "generated_32.i"
-    }
+        }
+    });
 }
 
 static void pixelTests64(InputArray _sum, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, bool use_orientation)
 {
-    Matx21f R;
     Mat sum = _sum.getMat(), descriptors = _descriptors.getMat();
-    for (size_t i = 0; i < keypoints.size(); ++i)
+    parallel_for_(Range(0, (int)keypoints.size()), [&](const Range& range)
     {
-        uchar* desc = descriptors.ptr(static_cast<int>(i));
-        const KeyPoint& pt = keypoints[i];
-        if ( use_orientation )
+        Matx21f R;
+        for (int i = range.start; i < range.end; ++i)
         {
-          float angle = pt.angle;
-          angle *= (float)(CV_PI/180.f);
-          R(0,0) = sin(angle);
-          R(1,0) = cos(angle);
-        }
+            uchar* desc = descriptors.ptr(i);
+            const KeyPoint& pt = keypoints[i];
+            if ( use_orientation )
+            {
+              float angle = pt.angle;
+              angle *= (float)(CV_PI/180.f);
+              R(0,0) = sin(angle);
+              R(1,0) = cos(angle);
+            }
 
 #include "generated_64.i"
-    }
+        }
+    });
 }
 
 BriefDescriptorExtractorImpl::BriefDescriptorExtractorImpl(int bytes, bool use_orientation) :
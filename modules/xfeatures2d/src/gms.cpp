@@ -85,6 +85,15 @@ public:
         // Initialize the neighbor of left grid
         mGridNeighborLeft = Mat::zeros(mGridNumberLeft, 9, CV_32SC1);
         initalizeNeighbors(mGridNeighborLeft, mGridSizeLeft);
+
+        // The left cells of the matches do not depend on the scale and the rotation
+        for (int gridType = 1; gridType <= 4; gridType++)
+        {
+            vector<int> &cells = mLeftCells[gridType - 1];
+            cells.resize(mNumberMatches);
+            for (size_t i = 0; i < mNumberMatches; i++)
+                cells[i] = getGridIndexLeft(mvP1[mvMatches[i].first], gridType);
+        }
     }
 
     ~GMSMatcher() {}
@@ -95,6 +104,16 @@ public:
 
 
 private:
+    // Grid of the right image for one scale
+    struct RightGrid
+    {
+        Size size;
+        int number;
+        Mat neighbor;
+        // Right cell of every match
+        vector<int> cells;
+    };
+
     // Normalized Points
     vector<Point2f> mvP1, mvP2;
 
@@ -105,84 +124,64 @@ private:
     size_t mNumberMatches;
 
     // Grid Size
-    Size mGridSizeLeft, mGridSizeRight;
+    Size mGridSizeLeft;
     int mGridNumberLeft;
-    int mGridNumberRight;
-
-    // x      : left grid idx
-    // y      : right grid idx
-    // value  : how many matches from idx_left to idx_right
-    Mat mMotionStatistics;
 
-    //
-    vector<int> mNumberPointsInPerCellLeft;
-
-    // Inldex  : grid_idx_left
-    // Value   : grid_idx_right
-    vector<int> mCellPairs;
-
-    // Every Matches has a cell-pair
-    // first  : grid_idx_left
-    // second : grid_idx_right
-    vector<pair<int, int> > mvMatchPairs;
-
-    // Inlier Mask for output
-    vector<bool> mvbInlierMask;
+    // Left cell of every match for the 4 grid types
+    vector<int> mLeftCells[4];
 
     //
     Mat mGridNeighborLeft;
-    Mat mGridNeighborRight;
 
     double mThresholdFactor;
 
 
-    // Assign Matches to Cell Pairs
-    void assignMatchPairs(const int GridType);
+    // Count the matches of every cell pair for one grid type and scale
+    // x      : left grid idx
+    // y      : right grid idx
+    // value  : how many matches from idx_left to idx_right
+    void assignMatchPairs(const int gridType, const RightGrid &right, Mat &motionStatistics,
+                          vector<int> &numberPointsInPerCellLeft) const;
 
     void convertMatches(const vector<DMatch> &vDMatches, vector<pair<int, int> > &vMatches);
 
-    int getGridIndexLeft(const Point2f &pt, const int type);
+    int getGridIndexLeft(const Point2f &pt, const int type) const;
 
-    int getGridIndexRight(const Point2f &pt);
+    int getGridIndexRight(const Point2f &pt, const Size &gridSize) const;
 
-    vector<int> getNB9(const int idx, const Size& GridSize);
-
-    void initalizeNeighbors(Mat &neighbor, const Size& GridSize);
+    void initalizeNeighbors(Mat &neighbor, const Size& GridSize) const;
 
     void normalizePoints(const vector<KeyPoint> &kp, const Size &size, vector<Point2f> &npts);
 
-    // Run
-    int run(const int rotationType);
+    // Count the inliers of one hypothesis, optionally filling the inlier mask
+    int markInliers(const int *cellPairs, size_t gridTypeStride, const RightGrid &right, vector<bool> *inlierMask) const;
 
-    void setScale(const int scale);
+    void setScale(const int scale, RightGrid &right) const;
 
     // Verify Cell Pairs
-    void verifyCellPairs(const int rotationType);
+    // Index  : grid_idx_left
+    // Value  : grid_idx_right
+    void verifyCellPairs(const int rotationType, const Mat &motionStatistics, const vector<int> &numberPointsInPerCellLeft,
+                         const vector<int> &bestCells, const RightGrid &right, int *cellPairs) const;
 };
 
-void GMSMatcher::assignMatchPairs(const int gridType)
+void GMSMatcher::assignMatchPairs(const int gridType, const RightGrid &right, Mat &motionStatistics,
+                                  vector<int> &numberPointsInPerCellLeft) const
 {
-    for (size_t i = 0; i < mNumberMatches; i++)
-    {
-        Point2f &lp = mvP1[mvMatches[i].first];
-        Point2f &rp = mvP2[mvMatches[i].second];
+    const vector<int> &leftCells = mLeftCells[gridType - 1];
 
-        int lgidx = mvMatchPairs[i].first = getGridIndexLeft(lp, gridType);
-        int rgidx = -1;
+    motionStatistics = Mat::zeros(mGridNumberLeft, right.number, CV_32SC1);
+    numberPointsInPerCellLeft.assign(mGridNumberLeft, 0);
 
-        if (gridType == 1)
-        {
-            rgidx = mvMatchPairs[i].second = getGridIndexRight(rp);
-        }
-        else
-        {
-            rgidx = mvMatchPairs[i].second;
-        }
+    for (size_t i = 0; i < mNumberMatches; i++)
+    {
+        int lgidx = leftCells[i];
+        int rgidx = right.cells[i];
 
         if (lgidx < 0 || rgidx < 0) continue;
 
-        mMotionStatistics.at<int>(lgidx, rgidx)++;
-        mNumberPointsInPerCellLeft[lgidx]++;
+        motionStatistics.at<int>(lgidx, rgidx)++;
+        numberPointsInPerCellLeft[lgidx]++;
     }
 }
 
@@ -194,7 +193,7 @@ void GMSMatcher::convertMatches(const vector<DMatch> &vDMatches, vector<pair<int
         vMatches[i] = pair<int, int>(vDMatches[i].queryIdx, vDMatches[i].trainIdx);
 }
 
-int GMSMatcher::getGridIndexLeft(const Point2f &pt, const int type)
+int GMSMatcher::getGridIndexLeft(const Point2f &pt, const int type) const
 {
     int x = 0, y = 0;
 
@@ -225,113 +224,125 @@ int GMSMatcher::getGridIndexLeft(const Point2f &pt, const int type)
     return x + y * mGridSizeLeft.width;
 }
 
-int GMSMatcher::getGridIndexRight(const Point2f &pt)
+int GMSMatcher::getGridIndexRight(const Point2f &pt, const Size &gridSize) const
 {
-    int x = cvFloor(pt.x * mGridSizeRight.width);
-    int y = cvFloor(pt.y * mGridSizeRight.height);
+    int x = cvFloor(pt.x * gridSize.width);
+    int y = cvFloor(pt.y * gridSize.height);
+
+    if (x < 0 || y < 0 || x >= gridSize.width || y >= gridSize.height)
+        return -1;
 
-    return x + y * mGridSizeRight.width;
+    return x + y * gridSize.width;
 }
 
 int GMSMatcher::getInlierMask(vector<bool> &vbInliers, const bool withRotation, const bool withScale)
 {
-    int max_inlier = 0;
-
-    if (!withScale && !withRotation)
+    const int numScales = withScale ? 5 : 1;
+    const int numRotations = withRotation ? 8 : 1;
+    const size_t gridTypeStride = (size_t)numRotations * mGridNumberLeft;
+    const size_t scaleStride = 4 * gridTypeStride;
+
+    // The right grid, its neighbors and the right cells of the matches only depend on the scale
+    vector<RightGrid> rightGrids(numScales);
+    for (int scale = 0; scale < numScales; scale++)
+        setScale(scale, rightGrids[scale]);
+
+    // The motion statistics only depend on the scale and the grid type, so they are collected once
+    // and verified for all the rotations. Cell pairs are stored by scale, grid type, rotation and left cell.
+    vector<int> cellPairs(numScales * scaleStride);
+    parallel_for_(Range(0, numScales * 4), [&](const Range& range)
     {
-        setScale(0);
-        max_inlier = run(1);
-        vbInliers = mvbInlierMask;
-        return max_inlier;
-    }
-
-    if (withRotation && withScale)
-    {
-        for (int scale = 0; scale < 5; scale++)
+        Mat motionStatistics;
+        vector<int> numberPointsInPerCellLeft, bestCells;
+        for (int task = range.start; task < range.end; task++)
         {
-            setScale(scale);
-            for (int rotationType = 1; rotationType <= 8; rotationType++)
+            const int scale = task / 4, gridType = task % 4 + 1;
+            const RightGrid &right = rightGrids[scale];
+            assignMatchPairs(gridType, right, motionStatistics, numberPointsInPerCellLeft);
+
+            // Right cell with most matches for every left cell
+            bestCells.assign(mGridNumberLeft, -1);
+            for (int i = 0; i < mGridNumberLeft; i++)
             {
-                int num_inlier = run(rotationType);
+                if (numberPointsInPerCellLeft[i] == 0)
+                    continue;
 
-                if (num_inlier > max_inlier)
+                const int *value = motionStatistics.ptr<int>(i);
+                int max_number = 0;
+                for (int j = 0; j < right.number; j++)
                 {
-                    vbInliers = mvbInlierMask;
-                    max_inlier = num_inlier;
+                    if (value[j] > max_number)
+                    {
+                        bestCells[i] = j;
+                        max_number = value[j];
+                    }
                 }
             }
+
+            int *pairs = &cellPairs[scale * scaleStride + (gridType - 1) * gridTypeStride];
+            for (int rotation = 0; rotation < numRotations; rotation++)
+                verifyCellPairs(rotation + 1, motionStatistics, numberPointsInPerCellLeft, bestCells, right,
+                                pairs + rotation * mGridNumberLeft);
         }
-        return max_inlier;
-    }
+    });
 
-    if (withRotation && !withScale)
+    // Count the inliers of every scale and rotation hypothesis
+    vector<int> numInliers(numScales * numRotations);
+    parallel_for_(Range(0, (int)numInliers.size()), [&](const Range& range)
     {
-        setScale(0);
-        for (int rotationType = 1; rotationType <= 8; rotationType++)
+        for (int h = range.start; h < range.end; h++)
         {
-            int num_inlier = run(rotationType);
-
-            if (num_inlier > max_inlier)
-            {
-                vbInliers = mvbInlierMask;
-                max_inlier = num_inlier;
-            }
+            const int scale = h / numRotations, rotation = h % numRotations;
+            numInliers[h] = markInliers(&cellPairs[scale * scaleStride + rotation * mGridNumberLeft], gridTypeStride,
+                                        rightGrids[scale], NULL);
         }
-        return max_inlier;
-    }
+    });
 
-    if (!withRotation && withScale)
+    // The first hypothesis with most inliers wins, as in the sequential search
+    int best = 0, max_inlier = numInliers[0];
+    for (int h = 1; h < (int)numInliers.size(); h++)
     {
-        for (int scale = 0; scale < 5; scale++)
+        if (numInliers[h] > max_inlier)
         {
-            setScale(scale);
-            int num_inlier = run(1);
-
-            if (num_inlier > max_inlier)
-            {
-                vbInliers = mvbInlierMask;
-                max_inlier = num_inlier;
-            }
-
+            best = h;
+            max_inlier = numInliers[h];
         }
-        return max_inlier;
     }
 
+    vbInliers.assign(mNumberMatches, false);
+    if (max_inlier > 0)
+    {
+        const int scale = best / numRotations, rotation = best % numRotations;
+        markInliers(&cellPairs[scale * scaleStride + rotation * mGridNumberLeft], gridTypeStride, rightGrids[scale],
+                    &vbInliers);
+    }
     return max_inlier;
 }
 
-// Get Neighbor 9
-vector<int> GMSMatcher::getNB9(const int idx, const Size& gridSize)
+void GMSMatcher::initalizeNeighbors(Mat &neighbor, const Size& gridSize) const
 {
-    vector<int> NB9(9, -1);
+    for (int idx = 0; idx < neighbor.rows; idx++)
+    {
+        // Get Neighbor 9
+        int *NB9 = neighbor.ptr<int>(idx);
 
-    int idx_x = idx % gridSize.width;
-    int idx_y = idx / gridSize.width;
+        int idx_x = idx % gridSize.width;
+        int idx_y = idx / gridSize.width;
 
-    for (int yi = -1; yi <= 1; yi++)
-    {
-        for (int xi = -1; xi <= 1; xi++)
+        for (int yi = -1; yi <= 1; yi++)
         {
-            int idx_xx = idx_x + xi;
-            int idx_yy = idx_y + yi;
-
-            if (idx_xx < 0 || idx_xx >= gridSize.width || idx_yy < 0 || idx_yy >= gridSize.height)
-                continue;
+            for (int xi = -1; xi <= 1; xi++)
+            {
+                int idx_xx = idx_x + xi;
+                int idx_yy = idx_y + yi;
 
-            NB9[xi + 4 + yi * 3] = idx_xx + idx_yy * gridSize.width;
+                if (idx_xx < 0 || idx_xx >= gridSize.width || idx_yy < 0 || idx_yy >= gridSize.height)
+                    NB9[xi + 4 + yi * 3] = -1;
+                else
+                    NB9[xi + 4 + yi * 3] = idx_xx + idx_yy * gridSize.width;
+            }
         }
     }
-    return NB9;
-}
-
-void GMSMatcher::initalizeNeighbors(Mat &neighbor, const Size& gridSize)
-{
-    for (int i = 0; i < neighbor.rows; i++)
-    {
-        vector<int> NB9 = getNB9(i, gridSize);
-        int *data = neighbor.ptr<int>(i);
-        memcpy(data, &NB9[0], sizeof(int) * 9);
-    }
 }
 
 // Normalize Key Points to Range(0 - 1)
@@ -349,74 +360,64 @@ void GMSMatcher::normalizePoints(const vector<KeyPoint> &kp, const Size &size, v
     }
 }
 
-int GMSMatcher::run(const int rotationType)
+int GMSMatcher::markInliers(const int *cellPairs, size_t gridTypeStride, const RightGrid &right,
+                            vector<bool> *inlierMask) const
 {
-    mvbInlierMask.assign(mNumberMatches, false);
-
-    // Initialize Motion Statisctics
-    mMotionStatistics = Mat::zeros(mGridNumberLeft, mGridNumberRight, CV_32SC1);
-    mvMatchPairs.assign(mNumberMatches, pair<int, int>(0, 0));
-
-    for (int gridType = 1; gridType <= 4; gridType++)
+    int numInliers = 0;
+    for (size_t i = 0; i < mNumberMatches; i++)
     {
-        // initialize
-        mMotionStatistics.setTo(0);
-        mCellPairs.assign(mGridNumberLeft, -1);
-        mNumberPointsInPerCellLeft.assign(mGridNumberLeft, 0);
+        const int rgidx = right.cells[i];
+        if (rgidx < 0)
+            continue;
 
-        assignMatchPairs(gridType);
-        verifyCellPairs(rotationType);
+        // A match is an inlier if its cell pair is verified for any of the grid types
+        bool inlier = false;
+        for (int gridType = 0; gridType < 4 && !inlier; gridType++)
+        {
+            const int lgidx = mLeftCells[gridType][i];
+            inlier = lgidx >= 0 && cellPairs[gridType * gridTypeStride + lgidx] == rgidx;
+        }
 
-        // Mark inliers
-        for (size_t i = 0; i < mNumberMatches; i++)
+        if (inlier)
         {
-            if (mvMatchPairs[i].first >= 0 && mCellPairs[mvMatchPairs[i].first] == mvMatchPairs[i].second)
-                mvbInlierMask[i] = true;
+            numInliers++;
+            if (inlierMask)
+                (*inlierMask)[i] = true;
         }
     }
-
-    return (int) count(mvbInlierMask.begin(), mvbInlierMask.end(), true); //number of inliers
+    return numInliers;
 }
 
-void GMSMatcher::setScale(const int scale)
+void GMSMatcher::setScale(const int scale, RightGrid &right) const
 {
     // Set Scale
-    mGridSizeRight.width = cvRound(mGridSizeLeft.width  * mScaleRatios[scale]);
-    mGridSizeRight.height = cvRound(mGridSizeLeft.height * mScaleRatios[scale]);
-    mGridNumberRight = mGridSizeRight.width * mGridSizeRight.height;
+    right.size.width = cvRound(mGridSizeLeft.width  * mScaleRatios[scale]);
+    right.size.height = cvRound(mGridSizeLeft.height * mScaleRatios[scale]);
+    right.number = right.size.width * right.size.height;
 
     // Initialize the neighbor of right grid
-    mGridNeighborRight = Mat::zeros(mGridNumberRight, 9, CV_32SC1);
-    initalizeNeighbors(mGridNeighborRight, mGridSizeRight);
+    right.neighbor = Mat::zeros(right.number, 9, CV_32SC1);
+    initalizeNeighbors(right.neighbor, right.size);
+
+    right.cells.resize(mNumberMatches);
+    for (size_t i = 0; i < mNumberMatches; i++)
+        right.cells[i] = getGridIndexRight(mvP2[mvMatches[i].second], right.size);
 }
 
-void GMSMatcher::verifyCellPairs(const int rotationType)
+void GMSMatcher::verifyCellPairs(const int rotationType, const Mat &motionStatistics,
+                                 const vector<int> &numberPointsInPerCellLeft, const vector<int> &bestCells,
+                                 const RightGrid &right, int *cellPairs) const
 {
     const int *CurrentRP = mRotationPatterns[rotationType - 1];
 
     for (int i = 0; i < mGridNumberLeft; i++)
     {
-        if (sum(mMotionStatistics.row(i))[0] == 0)
-        {
-            mCellPairs[i] = -1;
+        int idx_grid_rt = cellPairs[i] = bestCells[i];
+        if (idx_grid_rt < 0)
             continue;
-        }
-
-        int max_number = 0;
-        for (int j = 0; j < mGridNumberRight; j++)
-        {
-            int *value = mMotionStatistics.ptr<int>(i);
-            if (value[j] > max_number)
-            {
-                mCellPairs[i] = j;
-                max_number = value[j];
-            }
-        }
-
-        int idx_grid_rt = mCellPairs[i];
 
         const int *NB9_lt = mGridNeighborLeft.ptr<int>(i);
-        const int *NB9_rt = mGridNeighborRight.ptr<int>(idx_grid_rt);
+        const int *NB9_rt = right.neighbor.ptr<int>(idx_grid_rt);
 
         int score = 0;
         double thresh = 0;
@@ -429,15 +430,15 @@ void GMSMatcher::verifyCellPairs(const int rotationType)
             if (ll == -1 || rr == -1)
                 continue;
 
-            score += mMotionStatistics.at<int>(ll, rr);
-            thresh += mNumberPointsInPerCellLeft[ll];
+            score += motionStatistics.at<int>(ll, rr);
+            thresh += numberPointsInPerCellLeft[ll];
             numpair++;
         }
 
         thresh = mThresholdFactor * std::sqrt(thresh / numpair);
 
         if (score < thresh)
-            mCellPairs[i] = -2;
+            cellPairs[i] = -2;
     }
 }
 
@@ -433,29 +433,36 @@ void HarrisLaplaceFeatureDetector_Impl::detect(InputArray img, std::vector<KeyPo
         CV_Assert(mask.type() == CV_8UC1);
         CV_Assert(mask.size == image.size);
     }
-    Mat_<float> dx2, dy2, dxy;
-    Mat Lx, Ly;
-    float si, sd;
-    int gsize;
     Mat fimage;
     image.convertTo(fimage, CV_32F, 1.f/255);
     /*Build gaussian pyramid*/
     Pyramid pyr(fimage, numOctaves, num_layers, 1, -1, true);
     keypoints = std::vector<KeyPoint> (0);
 
-    /*Find Harris corners on each layer*/
+    /*Every (octave, layer) pair is processed independently, first octave only has its last layer*/
     //Use pyr.params.octavesN instead of numOctaves. See issue #1513
-    for (int octave = 0; octave <= pyr.params.octavesN; octave++)
-    {
+    std::vector<Point> scales;
+    scales.push_back(Point(0, num_layers));
+    for (int octave = 1; octave <= pyr.params.octavesN; octave++)
         for (int layer = 1; layer <= num_layers; layer++)
+            scales.push_back(Point(octave, layer));
+
+    std::vector<std::vector<KeyPoint> > scaleKeypoints(scales.size());
+
+    /*Find Harris corners on each layer*/
+    parallel_for_(Range(0, (int)scales.size()), [&](const Range& range)
+    {
+        for (int s = range.start; s < range.end; s++)
         {
-            if (octave == 0)
-                layer = num_layers;
+            const int octave = scales[s].x;
+            const int layer = scales[s].y;
+            std::vector<KeyPoint>& kps = scaleKeypoints[s];
 
+            Mat Lx, Ly;
             Mat Lxm2smooth, Lxmysmooth, Lym2smooth;
 
-            si = powf(2.f, layer / (float) num_layers);
-            sd = si * 0.7f;
+            float si = powf(2.f, layer / (float) num_layers);
+            float sd = si * 0.7f;
 
             Mat curr_layer;
             if (num_layers == 4)
@@ -475,19 +482,15 @@ void HarrisLaplaceFeatureDetector_Impl::detect(InputArray img, std::vector<KeyPo
 
             /*Calculates second moment matrix*/
 
-            /*Derivatives*/
-            Sobel(curr_layer, Lx, CV_32F, 1, 0, 1);
-            Sobel(curr_layer, Ly, CV_32F, 0, 1, 1);
-
-            /*Normalization*/
-            Lx = Lx * sd;
-            Ly = Ly * sd;
+            /*Derivatives, normalization is folded into the Sobel scale*/
+            Sobel(curr_layer, Lx, CV_32F, 1, 0, 1, sd);
+            Sobel(curr_layer, Ly, CV_32F, 0, 1, 1, sd);
 
             Mat Lxm2 = Lx.mul(Lx);
             Mat Lym2 = Ly.mul(Ly);
             Mat Lxmy = Lx.mul(Ly);
 
-            gsize = int(ceil(si * 3)) * 2 + 1;
+            int gsize = int(ceil(si * 3)) * 2 + 1;
 
             /*Convolution*/
             GaussianBlur(Lxm2, Lxm2smooth, Size(gsize, gsize), si, si, BORDER_REPLICATE);
@@ -499,15 +502,15 @@ void HarrisLaplaceFeatureDetector_Impl::detect(InputArray img, std::vector<KeyPo
             /*Calculates cornerness in each pixel of the image*/
             for (int row = 0; row < curr_layer.rows; row++)
             {
+                const float* dx2 = Lxm2smooth.ptr<float>(row);
+                const float* dy2 = Lym2smooth.ptr<float>(row);
+                const float* dxy = Lxmysmooth.ptr<float>(row);
+                float* corn = cornern_mat.ptr<float>(row);
                 for (int col = 0; col < curr_layer.cols; col++)
                 {
-                    float dx2f = Lxm2smooth.at<float> (row, col);
-                    float dy2f = Lym2smooth.at<float> (row, col);
-                    float dxyf = Lxmysmooth.at<float> (row, col);
-                    float det = dx2f * dy2f - dxyf * dxyf;
-                    float tr = dx2f + dy2f;
-                    float cornerness = det - (0.04f * tr * tr);
-                    cornern_mat.at<float> (row, col) = cornerness;
+                    float det = dx2[col] * dy2[col] - dxy[col] * dxy[col];
+                    float tr = dx2[col] + dy2[col];
+                    corn[col] = det - (0.04f * tr * tr);
                 }
             }
 
@@ -527,12 +530,16 @@ void HarrisLaplaceFeatureDetector_Impl::detect(InputArray img, std::vector<KeyPo
             curDOG = pyr.getDOGLayer(octave, layer);
             succDOG = pyr.getDOGLayer(octave, layer + 1);
 
+            const float scale = powf(2.0f, (float) octave - 1);
+
             for (int y = 1; y < imgsize.height - 1; y++)
             {
+                const float* corn = cornern_mat.ptr<float>(y);
+                const float* dil = corn_dilate.ptr<float>(y);
                 for (int x = 1; x < imgsize.width - 1; x++)
                 {
-                    float val = cornern_mat.at<float> (y, x);
-                    if (val != 0 && val == corn_dilate.at<float> (y, x))
+                    float val = corn[x];
+                    if (val != 0 && val == dil[x])
                     {
 
                         float curVal = curDOG.at<float> (y, x);
@@ -540,9 +547,8 @@ void HarrisLaplaceFeatureDetector_Impl::detect(InputArray img, std::vector<KeyPo
                         float succVal = succDOG.at<float> (y, x);
 
                         KeyPoint kp(
-                                Point2f(x * powf(2.0f, (float) octave - 1) + powf(2.0f, (float) octave - 1) / 2,
-                                        y * powf(2.0f, (float) octave - 1) + powf(2.0f, (float) octave - 1) / 2),
-                                3 * powf(2.0f, (float) octave - 1) * si * 2, 0, val, octave);
+                                Point2f(x * scale + scale / 2, y * scale + scale / 2),
+                                3 * scale * si * 2, 0, val, octave);
 
                         if(!mask.empty() && mask.at<unsigned char>(int(kp.pt.y), int(kp.pt.x)) == 0)
                         {
@@ -559,35 +565,42 @@ void HarrisLaplaceFeatureDetector_Impl::detect(InputArray img, std::vector<KeyPo
                         if (curVal > prevVal && curVal > succVal && curVal >= DOG_thresh
                                 && start_kp_x > 0 && start_kp_y > 0 && end_kp_x < image.cols
                                 && end_kp_y < image.rows)
-                            keypoints.push_back(kp);
+                            kps.push_back(kp);
 
                     }
                 }
             }
-
         }
+    });
 
-    }
+    /*Merge in scale order to keep the result independent of the threads count*/
+    for (size_t s = 0; s < scaleKeypoints.size(); s++)
+        keypoints.insert(keypoints.end(), scaleKeypoints[s].begin(), scaleKeypoints[s].end());
 
     /*Sort keypoints in decreasing cornerness order*/
     sort(keypoints.begin(), keypoints.end(), sort_func);
+
+    /*Merge neighbouring duplicates in place, the merged point replaces its predecessor*/
+    size_t kept = 0;
     for (size_t i = 1; i < keypoints.size(); i++)
     {
         float max_diff = powf(2, keypoints[i].octave + 1.f / 2);
 
-        if (keypoints[i].response == keypoints[i - 1].response && norm(
-                keypoints[i].pt - keypoints[i - 1].pt) <= max_diff)
+        if (keypoints[i].response == keypoints[kept].response && norm(
+                keypoints[i].pt - keypoints[kept].pt) <= max_diff)
         {
 
-            float x = (keypoints[i].pt.x + keypoints[i - 1].pt.x) / 2;
-            float y = (keypoints[i].pt.y + keypoints[i - 1].pt.y) / 2;
-
-            keypoints[i].pt = Point2f(x, y);
-            --i;
-            keypoints.erase(keypoints.begin() + i);
+            float x = (keypoints[i].pt.x + keypoints[kept].pt.x) / 2;
+            float y = (keypoints[i].pt.y + keypoints[kept].pt.y) / 2;
 
+            keypoints[kept] = keypoints[i];
+            keypoints[kept].pt = Point2f(x, y);
         }
+        else
+            keypoints[++kept] = keypoints[i];
     }
+    if (!keypoints.empty())
+        keypoints.resize(kept + 1);
 
     /*Select strongest keypoints*/
     if (maxCorners > 0 && maxCorners < (int) keypoints.size())
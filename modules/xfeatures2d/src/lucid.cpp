@@ -157,34 +157,39 @@ namespace cv {
 
             blur(src_input, src, cv::Size(b_kernel, b_kernel));
 
-            int x, y, j, d, p, m = (l_kernel*2+1)*(l_kernel*2+1)*3, width = src.cols, height = src.rows, r, c;
+            if (!_desc.needed())
+                return;
 
-            Mat_<uchar> desc(static_cast<int>(keypoints.size()), m);
+            const int m = (l_kernel*2+1)*(l_kernel*2+1)*3, width = src.cols, height = src.rows;
 
-            for (std::size_t i = 0; i < keypoints.size(); ++i) {
-                x = static_cast<int>(keypoints[i].pt.x)-l_kernel, y = static_cast<int>(keypoints[i].pt.y)-l_kernel, d = x+2*l_kernel, p = y+2*l_kernel, j = x, r = static_cast<int>(i), c = 0;
+            _desc.create(static_cast<int>(keypoints.size()), m, CV_8U);
+            Mat_<uchar> desc = _desc.getMat();
 
-                while (x <= d) {
-                    Vec3b &pix = src((y < 0 ? height+y : y >= height ? y-height : y), (x < 0 ? width+x : x >= width ? x-width : x));
+            // every keypoint copies its window and sorts its own descriptor row
+            parallel_for_(Range(0, static_cast<int>(keypoints.size())), [&](const Range& range) {
+                for (int r = range.start; r < range.end; ++r) {
+                    const int x0 = static_cast<int>(keypoints[r].pt.x)-l_kernel, y0 = static_cast<int>(keypoints[r].pt.y)-l_kernel;
+                    const int rowLength = (2*l_kernel+1)*3;
+                    uchar* dst = desc[r];
 
-                    desc(r, c++) = pix[0];
-                    desc(r, c++) = pix[1];
-                    desc(r, c++) = pix[2];
-
-                    ++x;
-                    if (x > d) {
-                        if (y < p) {
-                            ++y;
-                            x = j;
+                    for (int y = y0; y <= y0+2*l_kernel; ++y, dst += rowLength) {
+                        const Vec3b* srcRow = src[y < 0 ? height+y : y >= height ? y-height : y];
+                        if (x0 >= 0 && x0+2*l_kernel < width) {
+                            memcpy(dst, srcRow + x0, rowLength);
+                        }
+                        else {
+                            for (int x = x0, c = 0; x <= x0+2*l_kernel; ++x, c += 3) {
+                                const Vec3b &pix = srcRow[x < 0 ? width+x : x >= width ? x-width : x];
+                                dst[c] = pix[0];
+                                dst[c+1] = pix[1];
+                                dst[c+2] = pix[2];
+                            }
                         }
-                        else
-                            break;
                     }
-                }
-            }
 
-            if (_desc.needed())
-                sort(desc, _desc, SORT_EVERY_ROW | SORT_ASCENDING);
+                    std::sort(desc[r], desc[r] + m);
+                }
+            });
         }
 
         String LUCID::getDefaultName() const
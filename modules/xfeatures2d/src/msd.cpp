@@ -71,46 +71,42 @@ namespace cv
         {
         public:
 
-            // Multi-threaded contextualSelfDissimilarity method
+            // Multi-threaded contextualSelfDissimilarity method, the column chunks of all
+            // pyramid levels are scanned in a single parallel region
             struct MSDSelfDissimilarityScan : ParallelLoopBody
             {
 
-                MSDSelfDissimilarityScan(MSDDetector_Impl& _detector, std::vector< std::vector<float> >* _saliency, cv::Mat& _img, int _level, int _border, int _split)
+                MSDSelfDissimilarityScan(MSDDetector_Impl& _detector, std::vector< std::vector<float> >* _saliency, std::vector<cv::Mat>& _imgs, int _border, int _split)
                 {
                     detector = &_detector;
                     saliency = _saliency;
-                    img = &_img;
+                    imgs = &_imgs;
                     split = _split;
-                    level = _level;
                     border = _border;
-                    int w = img->cols - border * 2;
-                    chunkSize = w / split;
-                    remains = w - chunkSize*split;
                 }
 
                 void operator()(const Range& range) const CV_OVERRIDE
                 {
-                    for (int i = range.start; i < range.end; i++)
+                    for (int t = range.start; t < range.end; t++)
                     {
+                        int level = t / split, i = t % split;
+                        cv::Mat& img = imgs->at(level);
+                        int w = img.cols - border * 2;
+                        int nChunks = std::min(split, w);
+                        if (i >= nChunks)
+                            continue;
+                        int chunkSize = w / nChunks;
                         int start = border + i*chunkSize;
-                        int end = border + (i + 1) * chunkSize;
-                        if (remains > 0)
-                            if (i == split - 1)
-                            {
-                                end = img->cols - border;
-                            }
-                        detector->contextualSelfDissimilarity(*img, start, end, &saliency->at(level)[0]);
+                        int end = (i == nChunks - 1) ? img.cols - border : border + (i + 1) * chunkSize;
+                        detector->contextualSelfDissimilarity(img, start, end, &saliency->at(level)[0]);
                     }
                 }
 
                 MSDDetector_Impl* detector;
                 std::vector< std::vector<float> >* saliency;
-                cv::Mat* img;
-                int level;
+                std::vector<cv::Mat>* imgs;
                 int split;
                 int border;
-                int chunkSize;
-                int remains;
             };
 
             /**
@@ -232,11 +228,8 @@ namespace cv
                     fill(saliency[r].begin(), saliency[r].end(), 0.0f);
                 }
 
-                for (int r = 0; r < m_cur_n_scales; r++)
-                {
-                    int steps = cv::getNumThreads();
-                    parallel_for_(Range(0, steps), MSDSelfDissimilarityScan((*this), &saliency, m_scaleSpace[r], r, border, steps));
-                }
+                int steps = cv::getNumThreads();
+                parallel_for_(Range(0, m_cur_n_scales * steps), MSDSelfDissimilarityScan((*this), &saliency, m_scaleSpace, border, steps));
 
                 nonMaximaSuppression(saliency, keypoints);
 
@@ -286,7 +279,7 @@ namespace cv
              * @param den normalization factor (pre-multiplied by the number of elements of the input vector, assumed constant)
              * @return normalized average value
              */
-            inline float computeAvgDistance(std::vector<int> &minVals, int den)
+            inline float computeAvgDistance(const std::vector<int> &minVals, int den) const
             {
                 float avg_dist = 0.0f;
                 for (unsigned int i = 0; i < minVals.size(); i++)
@@ -303,7 +296,7 @@ namespace cv
              * @param xmax right-most range limit for the image pixels being processed
              * @param saliency output array being filled with the CSD value computed at each input pixel
              */
-            void contextualSelfDissimilarity(cv::Mat &img, int xmin, int xmax, float* saliency);
+            void contextualSelfDissimilarity(const cv::Mat &img, int xmin, int xmax, float* saliency) const;
 
             /**
              * Associates a canonical orientation (computed as in [1]) to each extracted key-point
@@ -313,14 +306,14 @@ namespace cv
              * @param circle pre-computed LUT used in the function
              * @return angle of the canonical orientation (in radians)
              */
-            float computeOrientation(cv::Mat &img, int x, int y, std::vector<cv::Point2f> circle);
+            float computeOrientation(const cv::Mat &img, int x, int y, const std::vector<cv::Point2f>& circle) const;
 
             /**
              * Computes the Non-Maxima Suppression (NMS) over the scale-space as in [1] for all elements of the image pyramid
              * @param saliency input saliency associated to each element of the image pyramid
              * @param keypoints key-points obtained as local maxima of the saliency
              */
-            void nonMaximaSuppression(std::vector< std::vector<float> > & saliency, std::vector<cv::KeyPoint> & keypoints);
+            void nonMaximaSuppression(const std::vector< std::vector<float> > & saliency, std::vector<cv::KeyPoint> & keypoints) const;
 
             /**
              * Computes the floating point interpolation of a key-point coordinates
@@ -331,11 +324,11 @@ namespace cv
              * @param p_res interpolated coordinates of the key-point referred to the lowest level of the pyramid (i.e. in the ref. frame of the input image)
              * @return false if the current key-point has to be rejected, true otherwise
              */
-            bool rescalePoint(int x, int y, int scale, std::vector< std::vector<float> > & saliency, cv::Point2f & p_res);
+            bool rescalePoint(int x, int y, int scale, const std::vector< std::vector<float> > & saliency, cv::Point2f & p_res) const;
 
         };
 
-        bool MSDDetector_Impl::rescalePoint(int i, int j, int scale, std::vector< std::vector<float> > & saliency, cv::Point2f &p_res)
+        bool MSDDetector_Impl::rescalePoint(int i, int j, int scale, const std::vector< std::vector<float> > & saliency, cv::Point2f &p_res) const
         {
 
             const float deriv_scale = 0.5f;
@@ -385,7 +378,7 @@ namespace cv
             return true;
         }
 
-        void MSDDetector_Impl::contextualSelfDissimilarity(cv::Mat &img, int xmin, int xmax, float* saliency)
+        void MSDDetector_Impl::contextualSelfDissimilarity(const cv::Mat &img, int xmin, int xmax, float* saliency) const
         {
             int r_s = m_patch_radius;
             int r_b = m_search_area_radius;
@@ -401,10 +394,14 @@ namespace cv
             int den = side_s * side_s * k;
 
             std::vector<int> minVals(k);
-            int *acc = new int[side_b * side_b];
-            int **vCol = new int *[w];
-            for (int i = 0; i < w; i++)
-                vCol[i] = new int[side_b * side_b];
+            // only the columns [xmin - r_s, xmax + r_s) are touched by this range
+            int nb = side_b * side_b;
+            AutoBuffer<int> accb(nb), vColb((xmax - xmin + 2 * r_s) * nb);
+            AutoBuffer<int*> vColPtrb(w);
+            int *acc = accb.data();
+            int **vCol = vColPtrb.data();
+            for (int i = xmin - r_s; i < xmax + r_s; i++)
+                vCol[i] = vColb.data() + (i - xmin + r_s) * nb;
 
             //first position
             int x = xmin;
@@ -580,14 +577,9 @@ namespace cv
                     saliency[y * w + x] = computeAvgDistance(minVals, den);
                 }
             }
-
-            for (int i = 0; i < w; i++)
-                delete[] vCol[i];
-            delete[] vCol;
-            delete[] acc;
         }
 
-        float MSDDetector_Impl::computeOrientation(cv::Mat &img, int x, int y, std::vector<cv::Point2f> circle)
+        float MSDDetector_Impl::computeOrientation(const cv::Mat &img, int x, int y, const std::vector<cv::Point2f>& circle) const
         {
             int temp;
 
@@ -668,9 +660,8 @@ namespace cv
             return bestAngle2;
         }
 
-        void MSDDetector_Impl::nonMaximaSuppression(std::vector< std::vector<float> > & saliency, std::vector<cv::KeyPoint> & keypoints)
+        void MSDDetector_Impl::nonMaximaSuppression(const std::vector< std::vector<float> > & saliency, std::vector<cv::KeyPoint> & keypoints) const
         {
-            cv::KeyPoint kp_temp;
             int border = m_search_area_radius + m_patch_radius;
 
             std::vector<cv::Point2f> orientPoints;
@@ -692,13 +683,23 @@ namespace cv
                 }
             }
 
+            // every row of every pyramid level is suppressed independently, the rows'
+            // keypoints are then concatenated in the sequential scan order
+            std::vector<int> firstRow(m_cur_n_scales + 1, 0);
             for (int r = 0; r < m_cur_n_scales; r++)
-            {
-                int cW = m_scaleSpace[r].cols;
-                int cH = m_scaleSpace[r].rows;
+                firstRow[r + 1] = firstRow[r] + std::max(m_scaleSpace[r].rows - 2 * border, 0);
+            std::vector< std::vector<cv::KeyPoint> > rowKeypoints(firstRow[m_cur_n_scales]);
 
-                for (int j = border; j < cH - border; j++)
+            parallel_for_(Range(0, firstRow[m_cur_n_scales]), [&](const Range& range)
+            {
+                for (int t = range.start; t < range.end; t++)
                 {
+                    int r = (int)(std::upper_bound(firstRow.begin(), firstRow.end(), t) - firstRow.begin()) - 1;
+                    int j = border + t - firstRow[r];
+                    int cW = m_scaleSpace[r].cols;
+                    int cH = m_scaleSpace[r].rows;
+                    cv::KeyPoint kp_temp;
+
                     for (int i = border; i < cW - border; i++)
                     {
                         if (saliency[r][j * cW + i] <= m_th_saliency)
@@ -762,12 +763,14 @@ namespace cv
                             if (m_compute_orientation)
                                 kp_temp.angle = computeOrientation(m_scaleSpace[r], i, j, orientPoints);
 
-                            keypoints.push_back(kp_temp);
+                            rowKeypoints[t].push_back(kp_temp);
                         }
                     }
                 }
-            }
+            });
 
+            for (size_t t = 0; t < rowKeypoints.size(); t++)
+                keypoints.insert(keypoints.end(), rowKeypoints[t].begin(), rowKeypoints[t].end());
         }
 
         Ptr<MSDDetector> MSDDetector::create(int m_patch_radius, int m_search_area_radius,
@@ -26,12 +26,14 @@ class TBMR_Impl CV_FINAL : public TBMR
             maxAreaRelative = _max_area_relative;
             scale = _scale;
             n_scale = _n_scale;
+            reuseBuffers = false;
         }
 
         uint minArea;
         float maxAreaRelative;
         int n_scale;
         float scale;
+        bool reuseBuffers;
     };
 
     explicit TBMR_Impl(const Params &_params) : params(_params) {}
@@ -63,6 +65,16 @@ class TBMR_Impl CV_FINAL : public TBMR
         params.n_scale = n_scales;
     }
     virtual int getNScales() const CV_OVERRIDE { return params.n_scale; }
+    virtual void setReuseBuffers(bool reuse) CV_OVERRIDE
+    {
+        params.reuseBuffers = reuse;
+        if (!reuse)
+            std::vector<ComponentTree>().swap(trees);
+    }
+    virtual bool getReuseBuffers() const CV_OVERRIDE
+    {
+        return params.reuseBuffers;
+    }
 
     virtual void detect(InputArray image,
                         CV_OUT std::vector<KeyPoint> &keypoints,
@@ -78,7 +90,24 @@ class TBMR_Impl CV_FINAL : public TBMR
                      OutputArray descriptors,
                      bool useProvidedKeypoints = false) CV_OVERRIDE;
 
-    CV_INLINE uint zfindroot(uint *parent, uint p)
+    // Component tree of one polarity along with the scratch buffers used to
+    // build and scan it. With reuseBuffers the trees are kept between calls,
+    // so consecutive frames of a video with the same size reuse all of their
+    // memory.
+    struct ComponentTree
+    {
+        // component tree representation (parent,S): see
+        // https://ieeexplore.ieee.org/document/6850018
+        Mat parent;
+        Mat S;
+        // moments: compound type of: (area, x, y, xy, xx, yy)
+        Mat imaAttributes;
+
+        std::vector<uint> zpar, root, rank, numSons, vecNodes, vecTbmrs;
+        std::vector<uchar> dejaVu, isSeen, isParentofLeaf;
+    };
+
+    static CV_INLINE uint zfindroot(uint *parent, uint p)
     {
         if (parent[p] == p)
             return p;
@@ -88,7 +117,7 @@ class TBMR_Impl CV_FINAL : public TBMR
 
     // Calculate the Component tree. Based on the order of S, it will be a
     // min or max tree.
-    void calcMinMaxTree(Mat ima)
+    static void calcMinMaxTree(const Mat &ima, ComponentTree &tree)
     {
         int rs = ima.rows;
         int cs = ima.cols;
@@ -99,21 +128,18 @@ class TBMR_Impl CV_FINAL : public TBMR
         }; // {-1,0}, {0,-1}, {0,1}, {1,0} yx
         std::array<Vec2i, 4> offsetsv = { Vec2i(0, -1), Vec2i(-1, 0),
                                           Vec2i(1, 0), Vec2i(0, 1) }; //  xy
-        AutoBuffer<uint> zparb(imSize);
-        AutoBuffer<uint> rootb(imSize);
-        AutoBuffer<uint> rankb(imSize);
-        memset(rankb.data(), 0, imSize * sizeof(uint));
-        uint* zpar = zparb.data();
-        uint *root = rootb.data();
-        uint *rank = rankb.data();
-        parent = Mat(rs, cs, CV_32S); // unsigned
-        AutoBuffer<bool> dejaVub(imSize);
-        memset(dejaVub.data(), 0, imSize * sizeof(bool));
-        bool* dejaVu = dejaVub.data();
-
-        const uint *S_ptr = S.ptr<const uint>();
-        uint *parent_ptr = parent.ptr<uint>();
-        Vec<uint, 6> *imaAttribute = imaAttributes.ptr<Vec<uint, 6>>();
+        tree.zpar.resize(imSize);
+        tree.root.resize(imSize);
+        tree.rank.assign(imSize, 0);
+        tree.dejaVu.assign(imSize, 0);
+        uint *zpar = tree.zpar.data();
+        uint *root = tree.root.data();
+        uint *rank = tree.rank.data();
+        uchar *dejaVu = tree.dejaVu.data();
+
+        const uint *S_ptr = tree.S.ptr<const uint>();
+        uint *parent_ptr = tree.parent.ptr<uint>(); // unsigned
+        Vec<uint, 6> *imaAttribute = tree.imaAttributes.ptr<Vec<uint, 6>>();
 
         for (int i = imSize - 1; i >= 0; --i)
         {
@@ -186,27 +212,25 @@ class TBMR_Impl CV_FINAL : public TBMR
         }
     }
 
-    void calculateTBMRs(const Mat &image, std::vector<Elliptic_KeyPoint> &tbmrs,
-                        const Mat &mask, float scale, int octave)
+    void calculateTBMRs(const Mat &image, ComponentTree &tree,
+                        std::vector<Elliptic_KeyPoint> &tbmrs,
+                        const Mat &mask, float scale, int octave) const
     {
         uint imSize = image.cols * image.rows;
         uint maxArea =
             static_cast<uint>(params.maxAreaRelative * imSize * scale);
         uint minArea = static_cast<uint>(params.minArea * scale);
 
-        if (parent.empty() || parent.size != image.size)
-            parent = Mat(image.rows, image.cols, CV_32S);
+        tree.parent.create(image.rows, image.cols, CV_32S);
+        tree.imaAttributes.create(image.rows, image.cols, CV_32SC(6));
 
-        if (imaAttributes.empty() || imaAttributes.size != image.size)
-            imaAttributes = Mat(image.rows, image.cols, CV_32SC(6));
-
-        calcMinMaxTree(image);
+        calcMinMaxTree(image, tree);
 
         const Vec<uint, 6> *imaAttribute =
-            imaAttributes.ptr<const Vec<uint, 6>>();
+            tree.imaAttributes.ptr<const Vec<uint, 6>>();
         const uint8_t *ima_ptr = image.ptr<const uint8_t>();
-        const uint *S_ptr = S.ptr<const uint>();
-        uint *parent_ptr = parent.ptr<uint>();
+        const uint *S_ptr = tree.S.ptr<const uint>();
+        uint *parent_ptr = tree.parent.ptr<uint>();
 
         // canonization
         for (uint i = 0; i < imSize; ++i)
@@ -229,13 +253,11 @@ class TBMR_Impl CV_FINAL : public TBMR
         // as final TBMRs
         //--------------------------------------------------------------------------
 
-        AutoBuffer<uint> numSonsb(imSize);
-        memset(numSonsb.data(), 0, imSize * sizeof(uint));
-        uint* numSons = numSonsb.data();
+        tree.numSons.assign(imSize, 0);
+        uint *numSons = tree.numSons.data();
         uint vecNodesSize = imaAttribute[S_ptr[0]][0];               // area
-        AutoBuffer<uint> vecNodesb(vecNodesSize);
-        memset(vecNodesb.data(), 0, vecNodesSize * sizeof(uint));
-        uint *vecNodes = vecNodesb.data(); // area
+        tree.vecNodes.assign(vecNodesSize, 0);
+        uint *vecNodes = tree.vecNodes.data(); // area
         uint numNodes = 0;
 
         // leaf to root propagation to select the canonized nodes
@@ -250,14 +272,12 @@ class TBMR_Impl CV_FINAL : public TBMR
             }
         }
 
-        AutoBuffer<bool> isSeenb(imSize);
-        memset(isSeenb.data(), 0, imSize * sizeof(bool));
-        bool *isSeen = isSeenb.data();
+        tree.isSeen.assign(imSize, 0);
+        uchar *isSeen = tree.isSeen.data();
 
         // parent of critical leaf node
-        AutoBuffer<bool> isParentofLeafb(imSize);
-        memset(isParentofLeafb.data(), 0, imSize * sizeof(bool));
-        bool* isParentofLeaf = isParentofLeafb.data();
+        tree.isParentofLeaf.assign(imSize, 0);
+        uchar *isParentofLeaf = tree.isParentofLeaf.data();
 
         for (uint i = 0; i < vecNodesSize; i++)
         {
@@ -267,8 +287,8 @@ class TBMR_Impl CV_FINAL : public TBMR
         }
 
         uint numTbmrs = 0;
-        AutoBuffer<uint> vecTbmrsb(numNodes);
-        uint* vecTbmrs = vecTbmrsb.data();
+        tree.vecTbmrs.resize(std::max(numNodes, 1u));
+        uint *vecTbmrs = tree.vecTbmrs.data();
         for (uint i = 0; i < vecNodesSize; i++)
         {
             uint p = vecNodes[i];
@@ -453,12 +473,10 @@ class TBMR_Impl CV_FINAL : public TBMR
 
     Mat tempsrc;
 
-    // component tree representation (parent,S): see
-    // https://ieeexplore.ieee.org/document/6850018
-    Mat parent;
-    Mat S;
-    // moments: compound type of: (area, x, y, xy, xx, yy)
-    Mat imaAttributes;
+    // max and min trees of every pyramid level, interleaved
+    std::vector<ComponentTree> trees;
+    // size of the frame the trees were built for
+    Size treesSize;
 
     Params params;
 };
@@ -517,20 +535,45 @@ void TBMR_Impl::detect(InputArray _image,
     MSDImagePyramid scaleSpacer(src, m_cur_n_scales, m_scale_factor);
     pyr = scaleSpacer.getImPyr();
 
-    int oct = 0;
-    for (auto &s : pyr)
-    {
-        float scale = ((float)s.cols) / pyr.begin()->cols;
-        std::vector<Elliptic_KeyPoint> kpts;
+    // the kept trees are only reused for frames of the same size
+    if (src.size() != treesSize)
+        std::vector<ComponentTree>().swap(trees);
+    treesSize = src.size();
 
-        // append max tree tbmrs
-        sortIdx(s.reshape(1, 1), S,
-                SortFlags::SORT_ASCENDING | SortFlags::SORT_EVERY_ROW);
-        calculateTBMRs(s, kpts, mask, scale, oct);
+    const int nLevels = (int)pyr.size();
+    if ((int)trees.size() < 2 * nLevels)
+        trees.resize(2 * nLevels);
 
-        // reverse instead of sort
-        flip(S, S, -1);
-        calculateTBMRs(s, kpts, mask, scale, oct);
+    // the max-tree uses the ascending pixel order, the min-tree the reverse
+    parallel_for_(Range(0, nLevels), [&](const Range &range) {
+        for (int l = range.start; l < range.end; l++)
+        {
+            sortIdx(pyr[l].reshape(1, 1), trees[2 * l].S,
+                    SortFlags::SORT_ASCENDING | SortFlags::SORT_EVERY_ROW);
+            flip(trees[2 * l].S, trees[2 * l + 1].S, -1);
+        }
+    });
+
+    // the trees of both polarities and of all levels are independent
+    std::vector<std::vector<Elliptic_KeyPoint>> treeKpts(2 * nLevels);
+    parallel_for_(Range(0, 2 * nLevels), [&](const Range &range) {
+        for (int t = range.start; t < range.end; t++)
+        {
+            const Mat &s = pyr[t / 2];
+            float scale = ((float)s.cols) / pyr.begin()->cols;
+            calculateTBMRs(s, trees[t], treeKpts[t], mask, scale, t / 2);
+        }
+    });
+
+    if (!params.reuseBuffers)
+        std::vector<ComponentTree>().swap(trees);
+
+    for (int oct = 0; oct < nLevels; oct++)
+    {
+        // append max tree tbmrs, then min tree tbmrs
+        std::vector<Elliptic_KeyPoint> &kpts = treeKpts[2 * oct];
+        kpts.insert(kpts.end(), treeKpts[2 * oct + 1].begin(),
+                    treeKpts[2 * oct + 1].end());
 
         if (oct == 0)
         {
@@ -556,8 +599,6 @@ void TBMR_Impl::detect(InputArray _image,
                 }
             }
         }
-
-        oct++;
     }
 }
 
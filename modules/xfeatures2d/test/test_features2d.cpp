@@ -91,6 +91,35 @@ TEST(Features2d_Detector_TBMR_Affine, regression)
     test.safe_run();
 }
 
+TEST(Features2d_Detector_TBMR, reuse_buffers)
+{
+    Mat image = imread(cvtest::findDataFile("features2d/tsukuba.png"), IMREAD_GRAYSCALE);
+    ASSERT_FALSE(image.empty());
+    Mat small;
+    resize(image, small, Size(), 0.5, 0.5, INTER_AREA);
+
+    Ptr<TBMR> detector = TBMR::create(60, 0.01f, 1.25f, 2);
+    EXPECT_FALSE(detector->getReuseBuffers());
+    detector->setReuseBuffers(true);
+    EXPECT_TRUE(detector->getReuseBuffers());
+
+    // same sized frames reuse the trees, a new size replaces them
+    const Mat frames[] = { image, image, small, image };
+    for (size_t i = 0; i < sizeof(frames)/sizeof(frames[0]); i++)
+    {
+        std::vector<KeyPoint> expected, keypoints;
+        TBMR::create(60, 0.01f, 1.25f, 2)->detect(frames[i], expected);
+        detector->detect(frames[i], keypoints);
+        ASSERT_EQ(expected.size(), keypoints.size()) << "frame " << i;
+        for (size_t k = 0; k < expected.size(); k++)
+        {
+            EXPECT_EQ(expected[k].pt, keypoints[k].pt) << "frame " << i;
+            EXPECT_EQ(expected[k].size, keypoints[k].size) << "frame " << i;
+            EXPECT_EQ(expected[k].angle, keypoints[k].angle) << "frame " << i;
+        }
+    }
+}
+
 /*
  * Descriptors
  */
@@ -185,6 +214,44 @@ TEST( Features2d_DescriptorExtractor_LATCH, regression )
     test.safe_run();
 }
 
+TEST( Features2d_DescriptorExtractor_LATCH, simd_matches_scalar_at_borders )
+{
+    Mat image(200, 240, CV_8UC1);
+    RNG rng(17);
+    rng.fill(image, RNG::UNIFORM, 0, 256);
+
+    for (int half_ssd_size = 3; half_ssd_size <= 12; half_ssd_size++)
+    {
+        // keypoints as close to the right and bottom borders as the border filter allows
+        const int border = 24 + half_ssd_size;
+        std::vector<KeyPoint> keypoints;
+        for (int i = border; i < image.rows - border; i += 7)
+            keypoints.push_back(KeyPoint((float)(image.cols - border - 1), (float)i, 7.f, (float)(i * 11 % 360)));
+        for (int j = border; j < image.cols - border; j += 7)
+            keypoints.push_back(KeyPoint((float)j, (float)(image.rows - border - 1), 7.f, (float)(j * 13 % 360)));
+        keypoints.push_back(KeyPoint((float)(image.cols - border - 1), (float)(image.rows - border - 1), 7.f, 45.f));
+
+        for (int rotation = 0; rotation < 2; rotation++)
+        {
+            Ptr<LATCH> latch = LATCH::create(32, rotation != 0, half_ssd_size, 0);
+
+            const bool useOptimized = cv::useOptimized();
+            std::vector<KeyPoint> keypointsScalar = keypoints, keypointsSIMD = keypoints;
+            Mat descScalar, descSIMD;
+            cv::setUseOptimized(false);
+            latch->compute(image, keypointsScalar, descScalar);
+            cv::setUseOptimized(true);
+            latch->compute(image, keypointsSIMD, descSIMD);
+            cv::setUseOptimized(useOptimized);
+
+            ASSERT_EQ(keypoints.size(), keypointsSIMD.size()) << "half_ssd_size=" << half_ssd_size;
+            ASSERT_EQ(descScalar.size(), descSIMD.size());
+            EXPECT_EQ(0, cvtest::norm(descScalar, descSIMD, NORM_HAMMING))
+                << "half_ssd_size=" << half_ssd_size << " rotationInvariance=" << rotation;
+        }
+    }
+}
+
 TEST(Features2d_DescriptorExtractor_BEBLID, regression )
 {
     CV_DescriptorExtractorTest<Hamming> test("descriptor-beblid", 1,
@@ -32,6 +32,33 @@ CV_EXPORTS_W void findEllipses(
     float scoreThreshold = 0.7f, float reliabilityThreshold = 0.5f,
     float centerDistanceThreshold = 0.05f
 );
+
+/** @brief Ellipse detector keeping its scratch buffers between calls.
+*
+* It runs the same detection as findEllipses(), but the intermediate images and the hash table of
+* the arc pairs are reused when it is called on a sequence of images of the same size.
+*/
+class CV_EXPORTS_W EllipseDetector : public Algorithm
+{
+public:
+    /** @brief Detects ellipses in an image.
+    *
+    @param image input image, could be gray or color. It is not modified.
+    @param ellipses output vector of found ellipses, in the same format as findEllipses().
+    */
+    CV_WRAP virtual void detect(InputArray image, OutputArray ellipses) = 0;
+};
+
+/** @brief Creates an EllipseDetector.
+*
+@param scoreThreshold float, the threshold of ellipse score.
+@param reliabilityThreshold float, the threshold of reliability.
+@param centerDistanceThreshold float, the threshold of center distance, relative to the image diagonal.
+*/
+CV_EXPORTS_W Ptr<EllipseDetector> createEllipseDetector(
+    float scoreThreshold = 0.7f, float reliabilityThreshold = 0.5f,
+    float centerDistanceThreshold = 0.05f
+);
 //! @} ximgproc
 }
 }
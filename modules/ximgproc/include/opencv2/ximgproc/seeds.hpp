@@ -98,6 +98,29 @@ public:
      */
     CV_WRAP virtual void iterate(InputArray img, int num_iterations=4) = 0;
 
+    /** @brief Calculates the superpixel segmentation of the next frame of a video, starting from
+    the labels of the previous call.
+
+    @param img Input image with the same properties as required by iterate().
+
+    @param num_iterations Number of pixel level iterations.
+
+    The block level updates are skipped and only pixel level updates are run, starting from the
+    segmentation computed by the previous iterate() or iterateWarmStart() call. This is cheaper
+    than iterate() and gives temporally more stable superpixels on video. If no previous
+    segmentation exists, iterate() is called instead.
+     */
+    CV_WRAP virtual void iterateWarmStart(InputArray img, int num_iterations=2) = 0;
+
+    /** @brief Enables the parallel pixel level updates.
+
+    The image is split into horizontal bands of superpixels and bands that are not adjacent are
+    updated concurrently. The result is deterministic, but slightly differs from the sequential
+    updates. Disabled by default.
+     */
+    CV_WRAP virtual void setParallelPixelUpdates(bool val) = 0;
+    CV_WRAP virtual bool getParallelPixelUpdates() const = 0;
+
     /** @brief Returns the segmentation labeling of the image.
 
     Each label represents a superpixel, and each pixel is assigned to one superpixel label.
@@ -129,6 +129,18 @@ public:
     CV_WRAP virtual void  setFGSSigma(float _sigma) = 0;
     /** @see setFGSLambda */
     CV_WRAP virtual float getFGSSigma() = 0;
+
+    /** @brief Precomputes the data that only depends on the reference image.
+
+    The edge map and the post-processing filter are computed once and reused by the following
+    interpolate() calls with the same from_image, which saves time when the same image is
+    interpolated with several sets of matches. Other images are processed without the prepared data,
+    so call prepare() again when the reference image changes, or with an empty image to release the
+    prepared data.
+
+    @param from_image reference image, 8-bit single-channel or three-channel.
+     */
+    CV_WRAP virtual void prepare(InputArray from_image) = 0;
 };
 
 /** @brief Factory method that creates an instance of the
@@ -256,6 +268,18 @@ public:
      *  @see setFGSSigma
      */
     CV_WRAP virtual float getFGSSigma() const = 0;
+
+    /** @brief Precomputes the data that only depends on the reference image.
+
+    The edge map, the superpixels and the post-processing filter are computed once and reused by the
+    following interpolate() calls with the same from_image, which saves time when the same image is
+    interpolated with several sets of matches. Other images are processed without the prepared data,
+    so call prepare() again when the reference image changes, or with an empty image to release the
+    prepared data.
+
+    @param from_image reference image, 8-bit single-channel or three-channel.
+     */
+    CV_WRAP virtual void prepare(InputArray from_image) = 0;
 };
 
 /** @brief Factory method that creates an instance of the
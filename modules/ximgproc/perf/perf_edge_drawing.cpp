@@ -0,0 +1,58 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace  {
+
+typedef TestBaseWithParam<Size> EdgeDrawingTest;
+
+static Mat makeEdgeDrawingImage(const Size& sz)
+{
+    Mat src(sz, CV_8UC1, Scalar::all(40));
+    RNG rng(0);
+    for (int i = 0; i < 64; i++)
+    {
+        Point center(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        int radius = rng.uniform(8, std::max(9, sz.height / 8));
+        circle(src, center, radius, Scalar::all(rng.uniform(100, 255)), 2);
+        Point p1(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        Point p2(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        line(src, p1, p2, Scalar::all(rng.uniform(100, 255)), 2);
+    }
+    return src;
+}
+
+PERF_TEST_P(EdgeDrawingTest, detectEdges, SZ_TYPICAL)
+{
+    Size sz = GetParam();
+    Mat src = makeEdgeDrawingImage(sz);
+    Ptr<EdgeDrawing> ed = createEdgeDrawing();
+
+    declare.in(src);
+
+    TEST_CYCLE() ed->detectEdges(src);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(EdgeDrawingTest, detectLinesAndEllipses, SZ_TYPICAL)
+{
+    Size sz = GetParam();
+    Mat src = makeEdgeDrawingImage(sz);
+    Ptr<EdgeDrawing> ed = createEdgeDrawing();
+    Mat lines, ellipses;
+
+    declare.in(src);
+
+    TEST_CYCLE()
+    {
+        ed->detectEdges(src);
+        ed->detectLines(lines);
+        ed->detectEllipses(ellipses);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
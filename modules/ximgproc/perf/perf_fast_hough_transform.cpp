@@ -78,4 +78,34 @@ PERF_TEST_P(srcSize_srcType_dstDepth, FastHoughTransform,
 
 #undef ALL_MAT_DEPHTS
 
+typedef tuple<Size, int> srcSize_angleRange_t;
+typedef perf::TestBaseWithParam<srcSize_angleRange_t> srcSize_angleRange;
+
+// document skew detection: binarized page scans at 150 and 300 dpi
+PERF_TEST_P(srcSize_angleRange, FastHoughTransform_document,
+            testing::Combine(
+                testing::Values(Size(1240, 1754), Size(2480, 3508)),
+                testing::Values((int)ARO_315_135, (int)ARO_CTR_VER)
+                )
+            )
+{
+    Size srcSize    = get<0>(GetParam());
+    int  angleRange = get<1>(GetParam());
+
+    Mat src(srcSize, CV_8UC1, Scalar::all(0));
+    for (int y = 40; y < srcSize.height - 40; y += 24)
+        line(src, Point(40, y), Point(srcSize.width - 40, y + srcSize.width / 50),
+             Scalar::all(1), 3);
+    Mat fht;
+
+    declare.in(src);
+
+    TEST_CYCLE_N(3)
+    {
+        FastHoughTransform(src, fht, CV_32S, angleRange);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
 }} // namespace
@@ -24,4 +24,22 @@ PERF_TEST_P(FindEllipsesTest, perf, Combine(SZ_TYPICAL, Values(CV_8U), Values(1,
 
     SANITY_CHECK_NOTHING();
 }
+
+PERF_TEST_P(FindEllipsesTest, detector, Combine(SZ_TYPICAL, Values(CV_8U), Values(1, 3)))
+{
+    FindEllipsesTestParam params = GetParam();
+    Size sz = get<0>(params);
+    int matType = get<1>(params);
+    int srcCn = get<2>(params);
+
+    Mat src(sz, CV_MAKE_TYPE(matType, srcCn));
+    Mat dst(sz, CV_32FC(6));
+    Ptr<EllipseDetector> detector = createEllipseDetector(0.7f, 0.5f, 0.05f);
+
+    declare.in(src, WARMUP_RNG).out(dst);
+
+    TEST_CYCLE() detector->detect(src, dst);
+
+    SANITY_CHECK_NOTHING();
+}
 }} // namespace
\ No newline at end of file
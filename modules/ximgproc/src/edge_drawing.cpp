@@ -22,8 +22,6 @@ mutable Mat_<uchar> dirImage;
 int gradThresh;
 int op;
 bool SumFlag;
-int* grads;
-bool PFmode;
 };
 
 void ComputeGradientBody::operator() (const Range& range) const
@@ -78,9 +76,6 @@ void ComputeGradientBody::operator() (const Range& range) const
 
             gradRow[x] = (ushort)sum;
 
-            if (PFmode)
-                grads[sum]++;
-
             if (sum >= gradThresh)
             {
                 if (gx >= gy)
@@ -92,6 +87,80 @@ void ComputeGradientBody::operator() (const Range& range) const
     }
 }
 
+struct ComputeAnchorPointsBody : ParallelLoopBody
+{
+void operator() (const Range& range) const CV_OVERRIDE;
+
+Mat_<ushort> gradImage;
+Mat_<uchar> dirImage;
+mutable Mat_<uchar> edgeImage;
+int gradThresh;
+int anchorThresh;
+int scanInterval;
+int stripeSize;
+vector<vector<Point> >* stripeAnchors;
+};
+
+void ComputeAnchorPointsBody::operator() (const Range& range) const
+{
+    const int height = gradImage.rows;
+    const int width = gradImage.cols;
+
+    for (int stripe = range.start; stripe < range.end; ++stripe)
+    {
+        // Anchors of each stripe are collected separately and concatenated in stripe order
+        // afterwards, so the result is identical to a sequential raster scan
+        vector<Point>& anchors = (*stripeAnchors)[stripe];
+        anchors.clear();
+
+        const int rowStart = std::max(2, stripe * stripeSize);
+        const int rowEnd = std::min(height - 2, (stripe + 1) * stripeSize);
+
+        for (int i = rowStart; i < rowEnd; i++)
+        {
+            int start = 2;
+            int inc = 1;
+            if (i % scanInterval != 0)
+            {
+                start = scanInterval;
+                inc = scanInterval;
+            }
+
+            const ushort* gradPrevRow = gradImage[i - 1];
+            const ushort* gradRow = gradImage[i];
+            const ushort* gradNextRow = gradImage[i + 1];
+            const uchar* dirRow = dirImage[i];
+            uchar* edgeRow = edgeImage[i];
+
+            for (int j = start; j < width - 2; j += inc)
+            {
+                if (gradRow[j] < gradThresh)
+                    continue;
+
+                int diff1, diff2;
+                if (dirRow[j] == EDGE_VERTICAL)
+                {
+                    // vertical edge
+                    diff1 = gradRow[j] - gradRow[j - 1];
+                    diff2 = gradRow[j] - gradRow[j + 1];
+                }
+                else
+                {
+                    // horizontal edge
+                    diff1 = gradRow[j] - gradPrevRow[j];
+                    diff2 = gradRow[j] - gradNextRow[j];
+                }
+
+                if (diff1 >= anchorThresh && diff2 >= anchorThresh)
+                {
+                    edgeRow[j] = ANCHOR_PIXEL;
+                    anchors.push_back(Point(j, i));
+                }
+            }
+        }
+    }
+}
+
 class EdgeDrawingImpl : public EdgeDrawing
 {
 public:
@@ -139,6 +208,7 @@ private:
     void ComputeAnchorPoints();
     void JoinAnchorPointsUsingSortedAnchors();
     int* sortAnchorsByGradValue1();
+    void ComputeGradientHistogram();
 
     static int LongestChain(Chain *chains, int root);
     static int RetrieveChainNos(Chain *chains, int root, int chainNos[]);
@@ -153,6 +223,17 @@ private:
     uchar *dirImg;    // pointer to direction image data
     ushort *gradImg;   // pointer to gradient image data
 
+    // Scratch buffers of edge linking and line fitting. They are kept between calls,
+    // so consecutive frames of the same size do not reallocate them.
+    vector<vector<Point> > stripeAnchors;
+    vector<int> chainNosBuf;
+    vector<Point> pixelsBuf;
+    vector<StackNode> stackBuf;
+    vector<Chain> chainsBuf;
+    vector<int> sortedAnchorsBuf;
+    vector<int> gradCountBuf;
+    vector<vector<EDLineSegment> > segmentLines;
+
     int op;           // edge detection operator
     int gradThresh;   // gradient threshold
     int anchorThresh; // anchor point threshold
@@ -167,11 +248,12 @@ private:
     NFALUT* nfa;
 
     int ComputeMinLineLength();
-    void SplitSegment2Lines(double* x, double* y, int noPixels, int segmentNo);
+    void SplitSegment2Lines(double* x, double* y, int noPixels, int segmentNo, vector<EDLineSegment>& segLines) const;
     void JoinCollinearLines();
 
     void ValidateLineSegments();
-    bool ValidateLineSegmentRect(int* x, int* y, EDLineSegment* ls);
+    bool ValidateLineSegment(int* x, int* y, EDLineSegment* ls) const;
+    bool ValidateLineSegmentRect(int* x, int* y, EDLineSegment* ls) const;
     bool TryToJoinTwoLineSegments(EDLineSegment* ls1, EDLineSegment* ls2, int changeIndex);
 
     static double ComputeMinDistance(double x1, double y1, double a, double b, int invert);
@@ -207,6 +289,17 @@ private:
     BufferManager* bm;
     Info* info;
 
+    // Result of fitting a single edge segment in detectEllipses()
+    struct SegmentFit
+    {
+        enum { NONE = 0, LINES = 1, CIRCLE = 2, ELLIPSE = 3 };
+        int type;
+        double xc, yc, r;
+        double circleFitError;
+        EllipseEquation eq;
+        double ellipseFitError;
+    };
+
     void GenerateCandidateCircles();
     void DetectArcs();
     void ValidateCircles(bool validate);
@@ -377,9 +470,11 @@ void EdgeDrawingImpl::detectEdges(InputArray src)
     height = srcImage.rows;
     width = srcImage.cols;
 
-    edgeImage = Mat(height, width, CV_8UC1, Scalar(0)); // initialize edge Image
-    gradImage = Mat(height, width, CV_16UC1); // gradImage contains short values
-    dirImage = Mat(height, width, CV_8UC1);
+    // create() keeps the previous allocation when the frame size does not change
+    edgeImage.create(height, width, CV_8UC1);
+    edgeImage.setTo(Scalar(0)); // initialize edge Image
+    gradImage.create(height, width, CV_16UC1); // gradImage contains short values
+    dirImage.create(height, width, CV_8UC1);
 
     if (params.Sigma < 1.0)
         smoothImage = srcImage;
@@ -406,6 +501,8 @@ void EdgeDrawingImpl::detectEdges(InputArray src)
 
     if (params.PFmode)
     {
+        ComputeGradientHistogram();
+
         // Compute probability function H
         int size = (width - 2) * (height - 2);
 
@@ -473,64 +570,58 @@ void EdgeDrawingImpl::ComputeGradient()
     body.gradThresh = gradThresh;
     body.SumFlag = params.SumFlag;
     body.op = op;
-    body.grads = grads;
-    body.PFmode = params.PFmode;
 
     parallel_for_(Range(1, smoothImage.rows - 1), body);
 }
 
-void EdgeDrawingImpl::ComputeAnchorPoints()
+// Histogram of gradient values of the inner pixels, used by the parameter free mode.
+// It is computed after the parallel gradient pass to avoid concurrent increments.
+void EdgeDrawingImpl::ComputeGradientHistogram()
 {
-    for (int i = 2; i < height - 2; i++)
+    for (int i = 1; i < height - 1; i++)
     {
-        int start = 2;
-        int inc = 1;
-        if (i % params.ScanInterval != 0)
-        {
-            start = params.ScanInterval;
-            inc = params.ScanInterval;
-        }
+        const ushort* gradRow = gradImg + i * width;
+        for (int j = 1; j < width - 1; j++)
+            grads[gradRow[j]]++;
+    }
+}
 
-        for (int j = start; j < width - 2; j += inc)
-        {
-            if (gradImg[i * width + j] < gradThresh)
-                continue;
+void EdgeDrawingImpl::ComputeAnchorPoints()
+{
+    const int stripeSize = 32;
+    const int noStripes = (height + stripeSize - 1) / stripeSize;
+    if ((int)stripeAnchors.size() < noStripes)
+        stripeAnchors.resize(noStripes);
 
-            if (dirImg[i * width + j] == EDGE_VERTICAL)
-            {
-                // vertical edge
-                int diff1 = gradImg[i * width + j] - gradImg[i * width + j - 1];
-                int diff2 = gradImg[i * width + j] - gradImg[i * width + j + 1];
-                if (diff1 >= anchorThresh && diff2 >= anchorThresh)
-                {
-                    edgeImg[i * width + j] = ANCHOR_PIXEL;
-                    anchorPoints.push_back(Point(j, i));
-                }
-            }
-            else
-            {
-                // horizontal edge
-                int diff1 = gradImg[i * width + j] - gradImg[(i - 1) * width + j];
-                int diff2 = gradImg[i * width + j] - gradImg[(i + 1) * width + j];
-                if (diff1 >= anchorThresh && diff2 >= anchorThresh)
-                {
-                    edgeImg[i * width + j] = ANCHOR_PIXEL;
-                    anchorPoints.push_back(Point(j, i));
-                }
-            }
-        }
-    }
+    ComputeAnchorPointsBody body;
+    body.gradImage = gradImage;
+    body.dirImage = dirImage;
+    body.edgeImage = edgeImage;
+    body.gradThresh = gradThresh;
+    body.anchorThresh = anchorThresh;
+    body.scanInterval = std::max(params.ScanInterval, 1);
+    body.stripeSize = stripeSize;
+    body.stripeAnchors = &stripeAnchors;
+
+    parallel_for_(Range(0, noStripes), body);
+
+    for (int stripe = 0; stripe < noStripes; stripe++)
+        anchorPoints.insert(anchorPoints.end(), stripeAnchors[stripe].begin(), stripeAnchors[stripe].end());
 
     anchorNos = (int)anchorPoints.size(); // get the total number of anchor points
 }
 
 void EdgeDrawingImpl::JoinAnchorPointsUsingSortedAnchors()
 {
-    int* chainNos = new int[(width + height) * 8];
+    chainNosBuf.resize((width + height) * 8);
+    pixelsBuf.resize(width * height);
+    stackBuf.resize(width * height);
+    chainsBuf.resize(width * height);
 
-    Point* pixels = new Point[width * height];
-    StackNode* stack = new StackNode[width * height];
-    Chain* chains = new Chain[width * height];
+    int* chainNos = &chainNosBuf[0];
+    Point* pixels = &pixelsBuf[0];
+    StackNode* stack = &stackBuf[0];
+    Chain* chains = &chainsBuf[0];
 
     // sort the anchor points by their gradient value in decreasing order
     int* pAnchors = sortAnchorsByGradValue1();
@@ -1179,19 +1270,13 @@ StartOfWhile:
     // because of one preallocation in the beginning, it will always empty
     segmentPoints.pop_back();
 
-    // Clean up
-    delete[] pAnchors;
-    delete[] chains;
-    delete[] stack;
-    delete[] chainNos;
-    delete[] pixels;
 }
 
 int* EdgeDrawingImpl::sortAnchorsByGradValue1()
 {
     int SIZE = 128 * 256;
-    int* C = new int[SIZE];
-    memset(C, 0, sizeof(int) * SIZE);
+    gradCountBuf.assign(SIZE, 0);
+    int* C = &gradCountBuf[0];
 
     // Count the number of grad values
     for (int i = 1; i < height - 1; i++)
@@ -1211,7 +1296,8 @@ int* EdgeDrawingImpl::sortAnchorsByGradValue1()
         C[i] += C[i - 1];
 
     int noAnchors = C[SIZE - 1];
-    int* A = new int[noAnchors];
+    sortedAnchorsBuf.resize(std::max(noAnchors, 1));
+    int* A = &sortedAnchorsBuf[0];
 
     for (int i = 1; i < height - 1; i++)
     {
@@ -1226,7 +1312,6 @@ int* EdgeDrawingImpl::sortAnchorsByGradValue1()
         }
     }
 
-    delete[] C;
     return A;
 }
 
@@ -1297,24 +1382,43 @@ void EdgeDrawingImpl::detectLines(OutputArray _lines)
     if (min_line_len < 9) // avoids small line segments in the result. Might be deleted!
         min_line_len = 9;
 
-    // Temporary buffers used during line fitting
-    double* x = new double[(width + height) * 8];
-    double* y = new double[(width + height) * 8];
-
     lines.clear();
     linesNo = 0;
 
-    // Use the whole segment
-    for (size_t segmentNumber = 0; segmentNumber < segmentPoints.size(); segmentNumber++)
+    // Segments are split to lines independently of each other. Lines of each segment
+    // are gathered separately and appended in segment order to keep the output stable.
+    const int noSegments = (int)segmentPoints.size();
+    if ((int)segmentLines.size() < noSegments)
+        segmentLines.resize(noSegments);
+
+    parallel_for_(Range(0, noSegments), [&](const Range& range)
     {
-        std::vector<Point> segment = segmentPoints[segmentNumber];
-        for (int k = 0; k < (int)segment.size(); k++)
+        // Temporary buffers used during line fitting
+        std::vector<double> x, y;
+
+        for (int segmentNumber = range.start; segmentNumber < range.end; segmentNumber++)
         {
-            x[k] = segment[k].x;
-            y[k] = segment[k].y;
+            const std::vector<Point>& segment = segmentPoints[segmentNumber];
+            const int noPixels = (int)segment.size();
+
+            segmentLines[segmentNumber].clear();
+            if (noPixels < min_line_len)
+                continue;
+
+            x.resize(noPixels);
+            y.resize(noPixels);
+            for (int k = 0; k < noPixels; k++)
+            {
+                x[k] = segment[k].x;
+                y[k] = segment[k].y;
+            }
+            SplitSegment2Lines(&x[0], &y[0], noPixels, segmentNumber, segmentLines[segmentNumber]);
         }
-        SplitSegment2Lines(x, y, (int)segment.size(), (int)segmentNumber);
-    }
+    });
+
+    for (int segmentNumber = 0; segmentNumber < noSegments; segmentNumber++)
+        lines.insert(lines.end(), segmentLines[segmentNumber].begin(), segmentLines[segmentNumber].end());
+    linesNo = (int)lines.size();
 
     JoinCollinearLines();
 
@@ -1335,9 +1439,6 @@ void EdgeDrawingImpl::detectLines(OutputArray _lines)
         segmentIndicesOfLines.push_back(lines[i].segmentNo);
     }
     Mat(linePoints).copyTo(_lines);
-
-    delete[] x;
-    delete[] y;
 }
 
 // Computes the minimum line length using the NFA formula given width & height values
@@ -1357,7 +1458,7 @@ int EdgeDrawingImpl::ComputeMinLineLength()
 // Given a full segment of pixels, splits the chain to lines
 // This code is used when we use the whole segment of pixels
 //
-void EdgeDrawingImpl::SplitSegment2Lines(double* x, double* y, int noPixels, int segmentNo)
+void EdgeDrawingImpl::SplitSegment2Lines(double* x, double* y, int noPixels, int segmentNo, vector<EDLineSegment>& segLines) const
 {
     // First pixel of the line segment within the segment of points
     int firstPixelIndex = 0;
@@ -1444,8 +1545,7 @@ void EdgeDrawingImpl::SplitSegment2Lines(double* x, double* y, int noPixels, int
                     break;
 
                 // Add the line segment to lines
-                lines.push_back(EDLineSegment(lastA, lastB, lastInvert, sx, sy, ex, ey, segmentNo, firstPixelIndex + noSkippedPixels, index - noSkippedPixels + 1));
-                linesNo++;
+                segLines.push_back(EDLineSegment(lastA, lastB, lastInvert, sx, sy, ex, ey, segmentNo, firstPixelIndex + noSkippedPixels, index - noSkippedPixels + 1));
                 len = index + 1;
 
                 break;
@@ -1517,114 +1617,115 @@ void EdgeDrawingImpl::ValidateLineSegments()
     {
         int lutSize = (width + height) / 8;
         double prob = 1.0 / 8;  // probability of alignment
+        delete nfa;
         nfa = new NFALUT(lutSize, prob, width, height);
     }
 
-    int* x = new int[(width + height) * 4];
-    int* y = new int[(width + height) * 4];
+    // Every line is validated independently, only the compaction below is sequential
+    std::vector<uchar> valid(linesNo);
+
+    parallel_for_(Range(0, linesNo), [&](const Range& range)
+    {
+        std::vector<int> x((width + height) * 4);
+        std::vector<int> y((width + height) * 4);
+
+        for (int i = range.start; i < range.end; i++)
+            valid[i] = ValidateLineSegment(&x[0], &y[0], &lines[i]);
+    });
 
     int noValidLines = 0;
 
     for (int i = 0; i < linesNo; i++)
     {
-        EDLineSegment* ls = &lines[i];
-
-        // Compute Line's angle
-        double lineAngle;
-
-        if (ls->invert == 0)
-        {
-            // y = a + bx
-            lineAngle = atan(ls->b);
-        }
-        else
+        if (valid[i])
         {
-            // x = a + by
-            lineAngle = atan(1.0 / ls->b);
+            if (i != noValidLines)
+                lines[noValidLines] = lines[i];
+            noValidLines++;
         }
+    }
 
-        if (lineAngle < 0)
-            lineAngle += CV_PI;
+    linesNo = noValidLines;
+}
 
-        Point* pixels = &(segmentPoints[ls->segmentNo][0]);
-        int noPixels = ls->len;
+bool EdgeDrawingImpl::ValidateLineSegment(int* x, int* y, EDLineSegment* ls) const
+{
+    // Compute Line's angle
+    double lineAngle;
 
-        bool valid = false;
+    if (ls->invert == 0)
+    {
+        // y = a + bx
+        lineAngle = atan(ls->b);
+    }
+    else
+    {
+        // x = a + by
+        lineAngle = atan(1.0 / ls->b);
+    }
 
-        // Accept very long lines without testing. They are almost never invalidated.
-        if (ls->len >= 80)
-        {
-            valid = true;
-            // Validate short line segments by a line support region rectangle having width=2
-        }
-        else if (ls->len <= 25)
-        {
-            valid = ValidateLineSegmentRect(x, y, ls);
-        }
-        else
-        {
-            // Longer line segments are first validated by a line support region rectangle having width=1 (for speed)
-            // If the line segment is still invalid, then a line support region rectangle having width=2 is tried
-            // If the line segment fails both tests, it is discarded
-            int aligned = 0;
-            int count = 0;
-            for (int j = 0; j < noPixels; j++)
-            {
-                int r = pixels[j].x;
-                int c = pixels[j].y;
+    if (lineAngle < 0)
+        lineAngle += CV_PI;
 
-                if (r <= 0 || r >= height - 1 || c <= 0 || c >= width - 1)
-                    continue;
+    const Point* pixels = &(segmentPoints[ls->segmentNo][0]);
+    int noPixels = ls->len;
 
-                count++;
+    // Accept very long lines without testing. They are almost never invalidated.
+    if (ls->len >= 80)
+        return true;
 
-                // compute gx & gy using the simple [-1 -1 -1]
-                //                                  [ 1  1  1]  filter in both directions
-                // Faster method below
-                // A B C
-                // D x E
-                // F G H
-                // gx = (C-A) + (E-D) + (H-F)
-                // gy = (F-A) + (G-B) + (H-C)
-                //
-                // To make this faster:
-                // com1 = (H-A)
-                // com2 = (C-F)
-                // Then: gx = com1 + com2 + (E-D) = (H-A) + (C-F) + (E-D) = (C-A) + (E-D) + (H-F)
-                //       gy = com2 - com1 + (G-B) = (H-A) - (C-F) + (G-B) = (F-A) + (G-B) + (H-C)
-                //
-                int com1 = srcImg[(r + 1) * width + c + 1] - srcImg[(r - 1) * width + c - 1];
-                int com2 = srcImg[(r - 1) * width + c + 1] - srcImg[(r + 1) * width + c - 1];
+    // Validate short line segments by a line support region rectangle having width=2
+    if (ls->len <= 25)
+        return ValidateLineSegmentRect(x, y, ls);
 
-                int gx = com1 + com2 + srcImg[r * width + c + 1] - srcImg[r * width + c - 1];
-                int gy = com1 - com2 + srcImg[(r + 1) * width + c] - srcImg[(r - 1) * width + c];
+    // Longer line segments are first validated by a line support region rectangle having width=1 (for speed)
+    // If the line segment is still invalid, then a line support region rectangle having width=2 is tried
+    // If the line segment fails both tests, it is discarded
+    int aligned = 0;
+    int count = 0;
+    for (int j = 0; j < noPixels; j++)
+    {
+        int r = pixels[j].x;
+        int c = pixels[j].y;
 
-                double pixelAngle = nfa->myAtan2((double)gx, (double)-gy);
-                double diff = fabs(lineAngle - pixelAngle);
+        if (r <= 0 || r >= height - 1 || c <= 0 || c >= width - 1)
+            continue;
 
-                if (diff <= precision || diff >= CV_PI - precision)
-                    aligned++;
-            }
+        count++;
 
-            // Check validation by NFA computation (fast due to LUT)
-            valid = nfa->checkValidationByNFA(count, aligned) || ValidateLineSegmentRect(x, y, ls);
-        }
+        // compute gx & gy using the simple [-1 -1 -1]
+        //                                  [ 1  1  1]  filter in both directions
+        // Faster method below
+        // A B C
+        // D x E
+        // F G H
+        // gx = (C-A) + (E-D) + (H-F)
+        // gy = (F-A) + (G-B) + (H-C)
+        //
+        // To make this faster:
+        // com1 = (H-A)
+        // com2 = (C-F)
+        // Then: gx = com1 + com2 + (E-D) = (H-A) + (C-F) + (E-D) = (C-A) + (E-D) + (H-F)
+        //       gy = com2 - com1 + (G-B) = (H-A) - (C-F) + (G-B) = (F-A) + (G-B) + (H-C)
+        //
+        int com1 = srcImg[(r + 1) * width + c + 1] - srcImg[(r - 1) * width + c - 1];
+        int com2 = srcImg[(r - 1) * width + c + 1] - srcImg[(r + 1) * width + c - 1];
 
-        if (valid)
-        {
-            if (i != noValidLines)
-                lines[noValidLines] = lines[i];
-            noValidLines++;
-        }
-    }
+        int gx = com1 + com2 + srcImg[r * width + c + 1] - srcImg[r * width + c - 1];
+        int gy = com1 - com2 + srcImg[(r + 1) * width + c] - srcImg[(r - 1) * width + c];
 
-    linesNo = noValidLines;
+        double pixelAngle = nfa->myAtan2((double)gx, (double)-gy);
+        double diff = fabs(lineAngle - pixelAngle);
 
-    delete[] x;
-    delete[] y;
+        if (diff <= precision || diff >= CV_PI - precision)
+            aligned++;
+    }
+
+    // Check validation by NFA computation (fast due to LUT)
+    return nfa->checkValidationByNFA(count, aligned) || ValidateLineSegmentRect(x, y, ls);
 }
 
-bool EdgeDrawingImpl::ValidateLineSegmentRect(int* x, int* y, EDLineSegment* ls)
+bool EdgeDrawingImpl::ValidateLineSegmentRect(int* x, int* y, EDLineSegment* ls) const
 {
     // Compute Line's angle
     double lineAngle;
@@ -2459,83 +2560,143 @@ void EdgeDrawingImpl::detectEllipses(OutputArray ellipses)
 
 #define CIRCLE_MIN_LINE_LEN 6
 
-    for (int i = 0; i < segmentNos; i++)
-    {
-        // Make note of the starting line number for this segment
-        segmentStartLines[i] = (int)lines.size();
+    // Circle/ellipse fitting of closed segments and line fitting of the others is done
+    // for all segments in parallel. The results are then collected sequentially below,
+    // because the pixel buffers referenced by the circles are handed out by the buffer manager.
+    if ((int)segmentLines.size() < segmentNos)
+        segmentLines.resize(segmentNos);
+    std::vector<SegmentFit> segmentFits(segmentNos);
 
-        int noPixels = (int)segmentPoints[i].size();
-
-        if (noPixels < 2 * CIRCLE_MIN_LINE_LEN)
-            continue;
-
-        double* x = bm->getX();
-        double* y = bm->getY();
+    parallel_for_(Range(0, segmentNos), [&](const Range& range)
+    {
+        std::vector<double> xBuf, yBuf;
 
-        for (int j = 0; j < noPixels; j++)
+        for (int i = range.start; i < range.end; i++)
         {
-            x[j] = segmentPoints[i][j].x;
-            y[j] = segmentPoints[i][j].y;
-        }
+            SegmentFit& fit = segmentFits[i];
+            fit.type = SegmentFit::LINES;
+            segmentLines[i].clear();
 
-        // If the segment is reasonably long, then see if the segment traverses the boundary of a closed shape
-        if (noPixels >= 4 * CIRCLE_MIN_LINE_LEN)
-        {
-            // If the end-points of the segment is close to each other, then assume a circular/elliptic structure
-            double dx = x[0] - x[noPixels - 1];
-            double dy = y[0] - y[noPixels - 1];
-            double d = sqrt(dx * dx + dy * dy);
-            double r = noPixels / CV_2PI;      // Assume a complete circle
+            int noPixels = (int)segmentPoints[i].size();
+
+            if (noPixels < 2 * CIRCLE_MIN_LINE_LEN)
+            {
+                fit.type = SegmentFit::NONE;
+                continue;
+            }
 
-            double maxDistanceBetweenEndPoints = std::max(3.0, r / 4.0);
+            xBuf.resize(noPixels);
+            yBuf.resize(noPixels);
+            double* x = &xBuf[0];
+            double* y = &yBuf[0];
 
-            // If almost closed loop, then try to fit a circle/ellipse
-            if (d <= maxDistanceBetweenEndPoints)
+            for (int j = 0; j < noPixels; j++)
             {
-                double xc, yc, circleFitError = 1e10;
+                x[j] = segmentPoints[i][j].x;
+                y[j] = segmentPoints[i][j].y;
+            }
 
-                CircleFit(x, y, noPixels, &xc, &yc, &r, &circleFitError);
+            // If the segment is reasonably long, then see if the segment traverses the boundary of a closed shape
+            if (noPixels >= 4 * CIRCLE_MIN_LINE_LEN)
+            {
+                // If the end-points of the segment is close to each other, then assume a circular/elliptic structure
+                double dx = x[0] - x[noPixels - 1];
+                double dy = y[0] - y[noPixels - 1];
+                double d = sqrt(dx * dx + dy * dy);
+                double r = noPixels / CV_2PI;      // Assume a complete circle
 
-                EllipseEquation eq;
-                double ellipseFitError = 1e10;
+                double maxDistanceBetweenEndPoints = std::max(3.0, r / 4.0);
 
-                if (circleFitError > LONG_ARC_ERROR)
+                // If almost closed loop, then try to fit a circle/ellipse
+                if (d <= maxDistanceBetweenEndPoints)
                 {
-                    // Try fitting an ellipse
-                    if (EllipseFit(x, y, noPixels, &eq))
-                        ellipseFitError = ComputeEllipseError(&eq, x, y, noPixels);
-                }
+                    double xc, yc, circleFitError = 1e10;
 
-                if (circleFitError <= LONG_ARC_ERROR)
-                {
-                    addCircle(circles1, noCircles1, xc, yc, r, circleFitError, x, y, noPixels);
-                    bm->move(noPixels);
-                    continue;
-                }
-                else if (ellipseFitError <= ELLIPSE_ERROR)
-                {
-                    double major, minor;
-                    ComputeEllipseCenterAndAxisLengths(&eq, &xc, &yc, &major, &minor);
+                    CircleFit(x, y, noPixels, &xc, &yc, &r, &circleFitError);
+
+                    EllipseEquation eq;
+                    double ellipseFitError = 1e10;
 
-                    // Assume major is longer. Otherwise, swap
-                    if (minor > major)
+                    if (circleFitError > LONG_ARC_ERROR)
                     {
-                        double tmp = major;
-                        major = minor;
-                        minor = tmp;
+                        // Try fitting an ellipse
+                        if (EllipseFit(x, y, noPixels, &eq))
+                            ellipseFitError = ComputeEllipseError(&eq, x, y, noPixels);
                     }
 
-                    if (major < 8 * minor)
+                    fit.xc = xc;
+                    fit.yc = yc;
+                    fit.r = r;
+                    fit.circleFitError = circleFitError;
+
+                    if (circleFitError <= LONG_ARC_ERROR)
                     {
-                        addCircle(circles1, noCircles1, xc, yc, r, circleFitError, &eq, ellipseFitError, x, y, noPixels);
-                        bm->move(noPixels);
+                        fit.type = SegmentFit::CIRCLE;
+                        continue;
+                    }
+                    else if (ellipseFitError <= ELLIPSE_ERROR)
+                    {
+                        double major, minor;
+                        ComputeEllipseCenterAndAxisLengths(&eq, &xc, &yc, &major, &minor);
+
+                        // Assume major is longer. Otherwise, swap
+                        if (minor > major)
+                        {
+                            double tmp = major;
+                            major = minor;
+                            minor = tmp;
+                        }
+
+                        fit.type = major < 8 * minor ? SegmentFit::ELLIPSE : SegmentFit::NONE;
+                        fit.xc = xc;
+                        fit.yc = yc;
+                        fit.eq = eq;
+                        fit.ellipseFitError = ellipseFitError;
+                        continue;
                     }
-                    continue;
                 }
             }
+            // Otherwise, split to lines
+            SplitSegment2Lines(x, y, noPixels, i, segmentLines[i]);
+        }
+    });
+
+    for (int i = 0; i < segmentNos; i++)
+    {
+        // Make note of the starting line number for this segment
+        segmentStartLines[i] = (int)lines.size();
+
+        const SegmentFit& fit = segmentFits[i];
+
+        if (fit.type == SegmentFit::LINES)
+        {
+            lines.insert(lines.end(), segmentLines[i].begin(), segmentLines[i].end());
+            continue;
+        }
+
+        if (fit.type == SegmentFit::NONE)
+            continue;
+
+        int noPixels = (int)segmentPoints[i].size();
+        double* x = bm->getX();
+        double* y = bm->getY();
+
+        for (int j = 0; j < noPixels; j++)
+        {
+            x[j] = segmentPoints[i][j].x;
+            y[j] = segmentPoints[i][j].y;
+        }
+
+        if (fit.type == SegmentFit::CIRCLE)
+        {
+            addCircle(circles1, noCircles1, fit.xc, fit.yc, fit.r, fit.circleFitError, x, y, noPixels);
+        }
+        else
+        {
+            EllipseEquation eq = fit.eq;
+            addCircle(circles1, noCircles1, fit.xc, fit.yc, fit.r, fit.circleFitError, &eq, fit.ellipseFitError, x, y, noPixels);
         }
-        // Otherwise, split to lines
-        SplitSegment2Lines(x, y, noPixels, i);
+        bm->move(noPixels);
     }
 
     min_line_len = params.MinLineLength;
@@ -42,6 +42,7 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/hal.hpp"
 
 namespace cv { namespace ximgproc {
 
@@ -49,39 +50,107 @@ namespace cv { namespace ximgproc {
     typedef __int32 int32_t;
 #endif
 
+template<typename T>
+struct HoughHal { };
+#define SPECIALIZE_HOUGHHAL(T, suffix)                                        \
+    template<>                                                                \
+    struct HoughHal<T> {                                                      \
+        static void add(T *pDst, const T *pSrc0, const T *pSrc1, int len) {   \
+            const size_t step = len * sizeof(T);                              \
+            hal::add##suffix(pSrc0, step, pSrc1, step, pDst, step, len, 1, 0);\
+        }                                                                     \
+        static void min(T *pDst, const T *pSrc0, const T *pSrc1, int len) {   \
+            const size_t step = len * sizeof(T);                              \
+            hal::min##suffix(pSrc0, step, pSrc1, step, pDst, step, len, 1, 0);\
+        }                                                                     \
+        static void max(T *pDst, const T *pSrc0, const T *pSrc1, int len) {   \
+            const size_t step = len * sizeof(T);                              \
+            hal::max##suffix(pSrc0, step, pSrc1, step, pDst, step, len, 1, 0);\
+        }                                                                     \
+        static void ave(T *pDst, const T *pSrc0, const T *pSrc1, int len) {   \
+            const size_t step = len * sizeof(T);                              \
+            double scalars[3] = { 0.5, 0.5, 0.0 };                            \
+            hal::addWeighted##suffix(pSrc0, step, pSrc1, step, pDst, step,    \
+                                     len, 1, scalars);                        \
+        }                                                                     \
+    };
+SPECIALIZE_HOUGHHAL(uchar,  8u)
+SPECIALIZE_HOUGHHAL(schar,  8s)
+SPECIALIZE_HOUGHHAL(ushort, 16u)
+SPECIALIZE_HOUGHHAL(short,  16s)
+SPECIALIZE_HOUGHHAL(int,    32s)
+SPECIALIZE_HOUGHHAL(float,  32f)
+SPECIALIZE_HOUGHHAL(double, 64f)
+#undef SPECIALIZE_HOUGHHAL
+
+// The row operations call the vectorized HAL kernels directly instead of
+// wrapping every (usually short) row segment into Mat headers.
 template<typename T, int D, HoughOp Op>
 struct HoughOperator { };
-#define SPECIALIZE_HOUGHOP(TOp, body)                                         \
+#define SPECIALIZE_HOUGHOP(TOp, func)                                         \
     template<typename T, int D>                                               \
     struct HoughOperator<T, D, TOp> {                                         \
         static void operate(T *pDst, T *pSrc0, T* pSrc1, int len) {           \
-            Mat dst (Size(1, len), D, pDst);                                  \
-            Mat src0(Size(1, len), D, pSrc0);                                 \
-            Mat src1(Size(1, len), D, pSrc1);                                 \
-            body;                                                             \
+            if (len > 0)                                                      \
+                HoughHal<T>::func(pDst, pSrc0, pSrc1, len);                   \
         }                                                                     \
     };
-SPECIALIZE_HOUGHOP(FHT_ADD, add(src0, src1, dst));
-SPECIALIZE_HOUGHOP(FHT_MIN, min(src0, src1, dst));
-SPECIALIZE_HOUGHOP(FHT_MAX, max(src0, src1, dst));
-SPECIALIZE_HOUGHOP(FHT_AVE, addWeighted(src0, 0.5, src1, 0.5, 0.0, dst));
+SPECIALIZE_HOUGHOP(FHT_ADD, add);
+SPECIALIZE_HOUGHOP(FHT_MIN, min);
+SPECIALIZE_HOUGHOP(FHT_MAX, max);
+SPECIALIZE_HOUGHOP(FHT_AVE, ave);
 #undef SPECIALIZE_HOUGHOP
 
 //----------------------fht----------------------------------------------------
 
-template <typename T, int D, HoughOp OP>
-void fhtCore(Mat     &img0,
-             Mat     &img1,
-             int32_t  y0,
-             int32_t  h,
-             bool     isPositiveShift,
-             int      level,
-             double   aspl)
+// Node of the recursive dyadic decomposition: rows [y0, y0 + h) at a given level
+struct FhtNode
+{
+    int32_t y0;
+    int32_t h;
+    int     level;
+};
+
+// Collects the nodes of the recursion tree grouped by depth. Within a depth the
+// nodes cover disjoint row ranges and are sorted by y0.
+static void fhtCollectNodes(std::vector<std::vector<FhtNode> > &stages,
+                            int32_t y0,
+                            int32_t h,
+                            int     level,
+                            int     depth)
 {
     if (level <= 0)
         return;
 
     CV_Assert(h > 0);
+    if ((int)stages.size() <= depth)
+        stages.resize(depth + 1);
+    FhtNode node = { y0, h, level };
+    stages[depth].push_back(node);
+
+    if (h == 1)
+        return;
+
+    const int32_t k = h >> 1;
+    fhtCollectNodes(stages, y0, k, level - 1, depth + 1);
+    fhtCollectNodes(stages, y0 + k, h - k, level - 1, depth + 1);
+}
+
+// Computes rows [y0 + sBegin, y0 + sEnd) of img0 for the given node from the
+// results of its children, which are stored in img1
+template <typename T, int D, HoughOp OP>
+static void fhtNodeRows(Mat           &img0,
+                        Mat           &img1,
+                        const FhtNode &node,
+                        int32_t        sBegin,
+                        int32_t        sEnd,
+                        bool           isPositiveShift,
+                        double         aspl)
+{
+    const int32_t y0 = node.y0;
+    const int32_t h = node.h;
+    const int level = node.level;
+
     if (h == 1)
     {
         if ((aspl != 0.0) && (level == 1))
@@ -105,11 +174,6 @@ void fhtCore(Mat     &img0,
         return;
     }
     const int32_t k = h >> 1;
-    fhtCore<T, D, OP>(img1, img0, y0, k,
-                      isPositiveShift, level - 1, aspl);
-    fhtCore<T, D, OP>(img1, img0, y0 + k, h - k,
-                      isPositiveShift, level - 1, aspl);
-
     int au = 2 * k - 2;
     int ad = 2 * h - 2 * k - 2;
     int b = h - 1;
@@ -117,7 +181,7 @@ void fhtCore(Mat     &img0,
     int w = img0.cols;
     int wm = (h / w + 1) * w;
 
-    for (int32_t s = 0; s < h; s++)
+    for (int32_t s = sBegin; s < sEnd; s++)
     {
         int su = (s * au + b) / d;
         int sd = (s * ad + b) / d;
@@ -203,6 +267,42 @@ void fhtCore(Mat     &img0,
     }
 }
 
+template <typename T, int D, HoughOp OP>
+void fhtCore(Mat     &img0,
+             Mat     &img1,
+             bool     isPositiveShift,
+             int      level,
+             double   aspl)
+{
+    std::vector<std::vector<FhtNode> > stages;
+    fhtCollectNodes(stages, 0, img0.rows, level, 0);
+
+    // The butterfly stages are processed bottom-up. Within a stage every output row
+    // depends only on rows of the same node in the previous stage, so the rows of all
+    // nodes of a stage are processed in parallel. The images swap their roles at each
+    // stage (ping-pong), exactly as in the recursive formulation.
+    for (int depth = (int)stages.size() - 1; depth >= 0; depth--)
+    {
+        const std::vector<FhtNode> &nodes = stages[depth];
+        Mat &dst = (depth & 1) ? img1 : img0;
+        Mat &src = (depth & 1) ? img0 : img1;
+        const double nstripes = std::max(1.0, (double)img0.rows * img0.cols / (1 << 16));
+
+        parallel_for_(Range(0, img0.rows), [&](const Range &range)
+        {
+            std::vector<FhtNode>::const_iterator it = nodes.begin();
+            while (it != nodes.end() && it->y0 + it->h <= range.start)
+                ++it;
+            for (; it != nodes.end() && it->y0 < range.end; ++it)
+            {
+                const int32_t sBegin = std::max(range.start - it->y0, 0);
+                const int32_t sEnd = std::min(range.end - it->y0, it->h);
+                fhtNodeRows<T, D, OP>(dst, src, *it, sBegin, sEnd, isPositiveShift, aspl);
+            }
+        }, nstripes);
+    }
+}
+
 template <typename T, int D, HoughOp Op>
 void fhtVoT(Mat    &img0,
             Mat    &img1,
@@ -213,7 +313,7 @@ void fhtVoT(Mat    &img0,
     for (int thres = 1; img0.rows > thres; thres <<= 1)
         level++;
 
-    fhtCore<T, D, Op>(img0, img1, 0, img0.rows, isPositiveShift, level, aspl);
+    fhtCore<T, D, Op>(img0, img1, isPositiveShift, level, aspl);
 }
 
 template <typename T, int D>
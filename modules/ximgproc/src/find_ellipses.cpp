@@ -6,6 +6,7 @@
 #include <opencv2/core.hpp>
 #include <unordered_map>
 #include <numeric>
+#include <algorithm>
 
 namespace cv {
 namespace ximgproc {
@@ -181,6 +182,62 @@ struct EllipseData {
     std::vector<float> Sa, Sb;
 };
 
+// accumulators used to estimate the remaining ellipse parameters, one set per thread
+struct EllipseAccumulators {
+    std::vector<int> accN, accR, accA;
+
+    EllipseAccumulators(int sizeN, int sizeR, int sizeA)
+            : accN(sizeN), accR(sizeR), accA(sizeA) {}
+};
+
+// arcs sorted by one coordinate of their first or last point, used to select
+// the arcs satisfying the constraints on position without testing all of them
+class ArcIndex {
+    std::vector<std::pair<int, ushort> > _keys;
+
+public:
+    ArcIndex(const VVP &arcs, bool lastPoint, bool coordY) {
+        _keys.reserve(arcs.size());
+        for (size_t n = 0; n < arcs.size(); n++) {
+            const Point &p = lastPoint ? arcs[n].back() : arcs[n].front();
+            _keys.push_back(std::make_pair(coordY ? p.y : p.x, ushort(n)));
+        }
+        std::sort(_keys.begin(), _keys.end());
+    }
+
+    // get the arcs whose coordinate is at most (or at least) bound, in increasing order
+    void query(float bound, bool atMost, std::vector<ushort> &arcs) const {
+        auto split = std::partition_point(_keys.begin(), _keys.end(),
+                                          [bound, atMost](const std::pair<int, ushort> &k) {
+                                              return atMost ? k.first <= bound : k.first < bound;
+                                          });
+        arcs.clear();
+        if (atMost) {
+            for (auto it = _keys.begin(); it != split; ++it)
+                arcs.push_back(it->second);
+        } else {
+            for (auto it = split; it != _keys.end(); ++it)
+                arcs.push_back(it->second);
+        }
+        std::sort(arcs.begin(), arcs.end());
+    }
+};
+
+// look up the data of a pair of arcs, first in the shared hash table and then in the
+// pairs computed by the current thread
+static bool findPairData(uint key, const std::unordered_map<uint, EllipseData> &data,
+                         const std::unordered_map<uint, EllipseData> &newData,
+                         EllipseData &pairData) {
+    auto it = data.find(key);
+    if (it == data.end()) {
+        it = newData.find(key);
+        if (it == newData.end())
+            return false;
+    }
+    pairData = it->second;
+    return true;
+}
+
 // implement of ellipse detector
 class EllipseDetectorImpl {
 
@@ -213,12 +270,12 @@ class EllipseDetectorImpl {
     Size _imgSize; // input image size
 
     int ACC_N_SIZE, ACC_R_SIZE, ACC_A_SIZE; // size of accumulator
-    int *accN, *accR, *accA; // pointer to accumulator
 
-public:
-    float countsOfFindEllipse;
-    float countsOfGetFastCenter;
+    // buffers reused between the calls of detect
+    Mat1b _dp, _dn; // arcs along positive and negative diagonal
+    std::unordered_map<uint, EllipseData> _centers; // hash map for reusing already computed EllipseData
 
+public:
     EllipseDetectorImpl();
 
     ~EllipseDetectorImpl() = default;
@@ -253,7 +310,7 @@ private:
 
     void
     findEllipses(Point2f &center, VP &edge_i, VP &edge_j, VP &edge_k, EllipseData &data_ij,
-                 EllipseData &data_ik, std::vector<Ellipse> &ellipses);
+                 EllipseData &data_ik, EllipseAccumulators &acc, std::vector<Ellipse> &ellipses);
 
     static Point2f getCenterCoordinates(EllipseData &data_ij, EllipseData &data_ik);
 
@@ -349,7 +406,6 @@ float EllipseDetectorImpl::getMedianSlope(std::vector<Point2f> &med, Point2f &ce
 
 void EllipseDetectorImpl::getFastCenter(std::vector<Point> &e1, std::vector<Point> &e2,
                                         EllipseData &data) {
-    countsOfGetFastCenter++;
     data.isValid = true;
 
     auto size_1 = unsigned(e1.size());
@@ -826,94 +882,115 @@ void EllipseDetectorImpl::getTriplets124(VVP &pi, VVP &pj, VVP &pk,
                                          std::vector<Ellipse> &ellipses) {
     // get arcs length
     auto sz_i = ushort(pi.size());
-    auto sz_j = ushort(pj.size());
-    auto sz_k = ushort(pk.size());
 
-    // for each edge i
-    for (ushort i = 0; i < sz_i; i++) {
-        VP &edge_i = pi[i];
-        auto sz_ei = ushort(edge_i.size());
+    // arcs j and k are looked up in indices sorted by the coordinate used in the
+    // constraints on position, instead of testing all of them for every arc i
+    ArcIndex index_j(pj, true, false);
+    ArcIndex index_k(pk, true, true);
+
+    // the arcs i are processed in parallel. The keys of all pairs computed for arc i
+    // contain i, so the pairs are collected per arc i and merged into the shared
+    // hash table afterwards, which is only read inside the parallel loop
+    std::vector<std::unordered_map<uint, EllipseData> > newPairs(sz_i);
+    std::vector<std::vector<Ellipse> > found(sz_i);
+
+    parallel_for_(Range(0, sz_i), [&](const Range &range) {
+        EllipseAccumulators acc(ACC_N_SIZE, ACC_R_SIZE, ACC_A_SIZE);
+        std::vector<ushort> cand_j, cand_k;
+
+        // for each edge i
+        for (int ii = range.start; ii < range.end; ii++) {
+            auto i = ushort(ii);
+            VP &edge_i = pi[i];
+            auto sz_ei = ushort(edge_i.size());
+
+            Point &pif = edge_i[0];
+            Point &pim = edge_i[sz_ei / 2];
+            Point &pil = edge_i[sz_ei - 1];
+
+            // candidate arcs satisfying the constraints on position
+            index_j.query(pif.x + _positionThreshold, true, cand_j);
+            index_k.query(pil.y - _positionThreshold, false, cand_k);
+            std::unordered_map<uint, EllipseData> &pairs_i = newPairs[i];
+            std::vector<Ellipse> &ellipses_i = found[i];
+
+            // 1 -> reverse 1
+            VP rev_i(edge_i.size());
+            reverse_copy(edge_i.begin(), edge_i.end(), rev_i.begin());
+
+            // for each edge j
+            for (ushort j : cand_j) {
+                VP &edge_j = pj[j];
+                auto sz_ej = ushort(edge_j.size());
+
+                Point &pjf = edge_j[0];
+                Point &pjm = edge_j[sz_ej / 2];
+                Point &pjl = edge_j[sz_ej - 1];
 
-        Point &pif = edge_i[0];
-        Point &pim = edge_i[sz_ei / 2];
-        Point &pil = edge_i[sz_ei - 1];
+                // constraints on position
+                if (pjl.x > pif.x + _positionThreshold)
+                    continue;
 
-        // 1 -> reverse 1
-        VP rev_i(edge_i.size());
-        reverse_copy(edge_i.begin(), edge_i.end(), rev_i.begin());
+                // constraints on CNC
+                const float CNC_THRESHOLD = 0.3f;
+                if (fabs(valueOfPoints(T124) - 1) > CNC_THRESHOLD)
+                    continue;
 
-        // for each edge j
-        for (ushort j = 0; j < sz_j; ++j) {
-            VP &edge_j = pj[j];
-            auto sz_ej = ushort(edge_j.size());
+                uint key_ij = generateKey(PAIR_12, i, j);
 
-            Point &pjf = edge_j[0];
-            Point &pjm = edge_j[sz_ej / 2];
-            Point &pjl = edge_j[sz_ej - 1];
+                // for each edge k
+                for (ushort k : cand_k) {
+                    VP &edge_k = pk[k];
+                    auto sz_ek = ushort(edge_k.size());
 
-            // constraints on position
-            if (pjl.x > pif.x + _positionThreshold)
-                continue;
+                    Point &pkl = edge_k[sz_ek - 1];
 
-            // constraints on CNC
-            const float CNC_THRESHOLD = 0.3f;
-            if (fabs(valueOfPoints(T124) - 1) > CNC_THRESHOLD)
-                continue;
-
-            uint key_ij = generateKey(PAIR_12, i, j);
+                    // constraints on position
+                    if (pkl.y < pil.y - _positionThreshold)
+                        continue;
 
-            // for each edge k
-            for (ushort k = 0; k < sz_k; ++k) {
-                VP &edge_k = pk[k];
-                auto sz_ek = ushort(edge_k.size());
+                    uint key_ik = generateKey(PAIR_14, i, k);
 
-                Point &pkl = edge_k[sz_ek - 1];
+                    // find centers
+                    EllipseData data_ij, data_ik;
 
-                // constraints on position
-                if (pkl.y < pil.y - _positionThreshold)
-                    continue;
+                    // if the data for the pair i-j have not been computed yet
+                    if (!findPairData(key_ij, data, pairs_i, data_ij)) {
+                        getFastCenter(edge_j, rev_i, data_ij);
+                        // insert computed data in the hash table
+                        pairs_i.insert(std::pair<uint, EllipseData>(key_ij, data_ij));
+                    }
 
-                uint key_ik = generateKey(PAIR_14, i, k);
+                    // if the data for the pair i-k have not been computed yet
+                    if (!findPairData(key_ik, data, pairs_i, data_ik)) {
+                        getFastCenter(edge_i, edge_k, data_ik);
+                        // insert computed data in the hash table
+                        pairs_i.insert(std::pair<uint, EllipseData>(key_ik, data_ik));
+                    }
 
-                // find centers
-                EllipseData data_ij, data_ik;
+                    // invalid centers
+                    if (!data_ij.isValid || !data_ik.isValid)
+                        continue;
 
-                // if the data for the pair i-j have not been computed yet
-                if (data.count(key_ij) == 0) {
-                    getFastCenter(edge_j, rev_i, data_ij);
-                    // insert computed data in the hash table
-                    data.insert(std::pair<uint, EllipseData>(key_ij, data_ij));
-                } else {
-                    // otherwise, just lookup the data in the hash table
-                    data_ij = data.at(key_ij);
-                }
+                    // selection strategy - Step 3.
+                    // the computed centers are not close enough
+                    if (pointDistance2(data_ij.Cab, data_ik.Cab) > _maxCenterDistance2)
+                        continue;
 
-                // if the data for the pair i-k have not been computed yet
-                if (data.count(key_ik) == 0) {
-                    getFastCenter(edge_i, edge_k, data_ik);
-                    // insert computed data in the hash table
-                    data.insert(std::pair<uint, EllipseData>(key_ik, data_ik));
-                } else {
-                    // otherwise, just lookup the data in the hash table
-                    data_ik = data.at(key_ik);
+                    // find ellipse parameters
+                    // get the coordinates of the center (xc, yc)
+                    Point2f center = getCenterCoordinates(data_ij, data_ik);
+                    // find remaining parameters (A, B, rho)
+                    findEllipses(center, edge_i, edge_j, edge_k, data_ij, data_ik, acc, ellipses_i);
                 }
-
-                // invalid centers
-                if (!data_ij.isValid || !data_ik.isValid)
-                    continue;
-
-                // selection strategy - Step 3.
-                // the computed centers are not close enough
-                if (pointDistance2(data_ij.Cab, data_ik.Cab) > _maxCenterDistance2)
-                    continue;
-
-                // find ellipse parameters
-                // get the coordinates of the center (xc, yc)
-                Point2f center = getCenterCoordinates(data_ij, data_ik);
-                // find remaining parameters (A, B, rho)
-                findEllipses(center, edge_i, edge_j, edge_k, data_ij, data_ik, ellipses);
             }
         }
+    });
+
+    // merge in the order of the sequential search
+    for (ushort i = 0; i < sz_i; i++) {
+        data.insert(newPairs[i].begin(), newPairs[i].end());
+        ellipses.insert(ellipses.end(), found[i].begin(), found[i].end());
     }
 }
 
@@ -922,100 +999,121 @@ void EllipseDetectorImpl::getTriplets231(VVP &pi, VVP &pj, VVP &pk,
                                          std::vector<Ellipse> &ellipses) {
     // get arc length
     auto sz_i = ushort(pi.size());
-    auto sz_j = ushort(pj.size());
-    auto sz_k = ushort(pk.size());
-
-    // for each edge i
-    for (ushort i = 0; i < sz_i; i++) {
-        VP &edge_i = pi[i];
-        auto sz_ei = ushort(edge_i.size());
 
-        Point &pif = edge_i[0];
-        Point &pim = edge_i[sz_ei / 2];
-        Point &pil = edge_i[sz_ei - 1];
+    // arcs j and k are looked up in indices sorted by the coordinate used in the
+    // constraints on position, instead of testing all of them for every arc i
+    ArcIndex index_j(pj, false, true);
+    ArcIndex index_k(pk, false, false);
+
+    // the arcs i are processed in parallel. The keys of all pairs computed for arc i
+    // contain i, so the pairs are collected per arc i and merged into the shared
+    // hash table afterwards, which is only read inside the parallel loop
+    std::vector<std::unordered_map<uint, EllipseData> > newPairs(sz_i);
+    std::vector<std::vector<Ellipse> > found(sz_i);
+
+    parallel_for_(Range(0, sz_i), [&](const Range &range) {
+        EllipseAccumulators acc(ACC_N_SIZE, ACC_R_SIZE, ACC_A_SIZE);
+        std::vector<ushort> cand_j, cand_k;
+
+        // for each edge i
+        for (int ii = range.start; ii < range.end; ii++) {
+            auto i = ushort(ii);
+            VP &edge_i = pi[i];
+            auto sz_ei = ushort(edge_i.size());
+
+            Point &pif = edge_i[0];
+            Point &pim = edge_i[sz_ei / 2];
+            Point &pil = edge_i[sz_ei - 1];
+
+            // candidate arcs satisfying the constraints on position
+            index_j.query(pif.y - _positionThreshold, false, cand_j);
+            index_k.query(pil.x - _positionThreshold, false, cand_k);
+            std::unordered_map<uint, EllipseData> &pairs_i = newPairs[i];
+            std::vector<Ellipse> &ellipses_i = found[i];
+
+            // 2 -> reverse 2
+            VP rev_i(edge_i.size());
+            reverse_copy(edge_i.begin(), edge_i.end(), rev_i.begin());
+
+            // for each edge j
+            for (ushort j : cand_j) {
+                VP &edge_j = pj[j];
+                auto sz_ej = ushort(edge_j.size());
+
+                Point &pjf = edge_j[0];
+                Point &pjm = edge_j[sz_ej / 2];
+                Point &pjl = edge_j[sz_ej - 1];
 
-        // 2 -> reverse 2
-        VP rev_i(edge_i.size());
-        reverse_copy(edge_i.begin(), edge_i.end(), rev_i.begin());
+                // constraints on position
+                if (pjf.y < pif.y - _positionThreshold)
+                    continue;
 
-        // for each edge j
-        for (ushort j = 0; j < sz_j; ++j) {
-            VP &edge_j = pj[j];
-            auto sz_ej = ushort(edge_j.size());
+                // constraints on CNC
+                const float CNC_THRESHOLD = 0.3f;
+                if (fabs(valueOfPoints(T231) - 1) > CNC_THRESHOLD)
+                    continue;
 
-            Point &pjf = edge_j[0];
-            Point &pjm = edge_j[sz_ej / 2];
-            Point &pjl = edge_j[sz_ej - 1];
+                // 3 -> reverse 3
+                VP rev_j(edge_j.size());
+                reverse_copy(edge_j.begin(), edge_j.end(), rev_j.begin());
 
-            // constraints on position
-            if (pjf.y < pif.y - _positionThreshold)
-                continue;
+                uint key_ij = generateKey(PAIR_23, i, j);
 
-            // constraints on CNC
-            const float CNC_THRESHOLD = 0.3f;
-            if (fabs(valueOfPoints(T231) - 1) > CNC_THRESHOLD)
-                continue;
+                // for each edge k
+                for (ushort k : cand_k) {
+                    VP &edge_k = pk[k];
 
-            // 3 -> reverse 3
-            VP rev_j(edge_j.size());
-            reverse_copy(edge_j.begin(), edge_j.end(), rev_j.begin());
+                    Point &pkf = edge_k[0];
 
-            uint key_ij = generateKey(PAIR_23, i, j);
+                    // constraints on position
+                    if (pkf.x < pil.x - _positionThreshold)
+                        continue;
 
-            // for each edge k
-            for (ushort k = 0; k < sz_k; ++k) {
-                VP &edge_k = pk[k];
+                    uint key_ik = generateKey(PAIR_12, k, i);
 
-                Point &pkf = edge_k[0];
+                    // find centers
+                    EllipseData data_ij, data_ik;
 
-                // constraints on position
-                if (pkf.x < pil.x - _positionThreshold)
-                    continue;
+                    // if the data for the pair i-j have not been computed yet
+                    if (!findPairData(key_ij, data, pairs_i, data_ij)) {
+                        getFastCenter(rev_i, rev_j, data_ij);
+                        // insert computed date in the hash table
+                        pairs_i.insert(std::pair<uint, EllipseData>(key_ij, data_ij));
+                    }
 
-                uint key_ik = generateKey(PAIR_12, k, i);
+                    // if the data for the pair i-k have not been computed yet
+                    if (!findPairData(key_ik, data, pairs_i, data_ik)) {
+                        // 1 -> reverse 1
+                        VP rev_k(edge_k.size());
+                        reverse_copy(edge_k.begin(), edge_k.end(), rev_k.begin());
 
-                // find centers
-                EllipseData data_ij, data_ik;
+                        getFastCenter(edge_i, rev_k, data_ik);
+                        pairs_i.insert(std::pair<uint, EllipseData>(key_ik, data_ik));
+                    }
 
-                // if the data for the pair i-j have not been computed yet
-                if (data.count(key_ij) == 0) {
-                    getFastCenter(rev_i, rev_j, data_ij);
-                    // insert computed date in the hash table
-                    data.insert(std::pair<uint, EllipseData>(key_ij, data_ij));
-                } else {
-                    // otherwise, just lookup the data in the hash table
-                    data_ij = data.at(key_ij);
-                }
+                    // invalid centers
+                    if (!data_ij.isValid || !data_ik.isValid)
+                        continue;
 
-                // if the data for the pair i-k have not been computed yet
-                if (data.count(key_ik) == 0) {
-                    // 1 -> reverse 1
-                    VP rev_k(edge_k.size());
-                    reverse_copy(edge_k.begin(), edge_k.end(), rev_k.begin());
+                    // selection strategy - Step 3.
+                    // the computed centers are not close enough
+                    if (pointDistance2(data_ij.Cab, data_ik.Cab) > _maxCenterDistance2)
+                        continue;
 
-                    getFastCenter(edge_i, rev_k, data_ik);
-                    data.insert(std::pair<uint, EllipseData>(key_ik, data_ik));
-                } else {
-                    // otherwise, just lookup the data in the hash table
-                    data_ik = data.at(key_ik);
+                    // find ellipse parameters
+                    // get the coordinates of the center (xc, yc)
+                    Point2f center = getCenterCoordinates(data_ij, data_ik);
+                    // find remaining parameters (A, B, rho)
+                    findEllipses(center, edge_i, edge_j, edge_k, data_ij, data_ik, acc, ellipses_i);
                 }
-
-                // invalid centers
-                if (!data_ij.isValid || !data_ik.isValid)
-                    continue;
-
-                // selection strategy - Step 3.
-                // the computed centers are not close enough
-                if (pointDistance2(data_ij.Cab, data_ik.Cab) > _maxCenterDistance2)
-                    continue;
-
-                // find ellipse parameters
-                // get the coordinates of the center (xc, yc)
-                Point2f center = getCenterCoordinates(data_ij, data_ik);
-                // find remaining parameters (A, B, rho)
-                findEllipses(center, edge_i, edge_j, edge_k, data_ij, data_ik, ellipses);
             }
         }
+    });
+
+    // merge in the order of the sequential search
+    for (ushort i = 0; i < sz_i; i++) {
+        data.insert(newPairs[i].begin(), newPairs[i].end());
+        ellipses.insert(ellipses.end(), found[i].begin(), found[i].end());
     }
 }
 
@@ -1024,101 +1122,122 @@ void EllipseDetectorImpl::getTriplets342(VVP &pi, VVP &pj, VVP &pk,
                                          std::vector<Ellipse> &ellipses) {
     // get arcs length
     auto sz_i = ushort(pi.size());
-    auto sz_j = ushort(pj.size());
-    auto sz_k = ushort(pk.size());
-
-    // for each edge i
-    for (ushort i = 0; i < sz_i; i++) {
-        VP &edge_i = pi[i];
-        auto sz_ei = ushort(edge_i.size());
 
-        Point &pif = edge_i[0];
-        Point &pim = edge_i[sz_ei / 2];
-        Point &pil = edge_i[sz_ei - 1];
+    // arcs j and k are looked up in indices sorted by the coordinate used in the
+    // constraints on position, instead of testing all of them for every arc i
+    ArcIndex index_j(pj, false, false);
+    ArcIndex index_k(pk, false, true);
+
+    // the arcs i are processed in parallel. The keys of all pairs computed for arc i
+    // contain i, so the pairs are collected per arc i and merged into the shared
+    // hash table afterwards, which is only read inside the parallel loop
+    std::vector<std::unordered_map<uint, EllipseData> > newPairs(sz_i);
+    std::vector<std::vector<Ellipse> > found(sz_i);
+
+    parallel_for_(Range(0, sz_i), [&](const Range &range) {
+        EllipseAccumulators acc(ACC_N_SIZE, ACC_R_SIZE, ACC_A_SIZE);
+        std::vector<ushort> cand_j, cand_k;
+
+        // for each edge i
+        for (int ii = range.start; ii < range.end; ii++) {
+            auto i = ushort(ii);
+            VP &edge_i = pi[i];
+            auto sz_ei = ushort(edge_i.size());
+
+            Point &pif = edge_i[0];
+            Point &pim = edge_i[sz_ei / 2];
+            Point &pil = edge_i[sz_ei - 1];
+
+            // candidate arcs satisfying the constraints on position
+            index_j.query(pil.x - _positionThreshold, false, cand_j);
+            index_k.query(pif.y + _positionThreshold, true, cand_k);
+            std::unordered_map<uint, EllipseData> &pairs_i = newPairs[i];
+            std::vector<Ellipse> &ellipses_i = found[i];
 
-        // 3 -> reverse 3
-        VP rev_i(edge_i.size());
-        reverse_copy(edge_i.begin(), edge_i.end(), rev_i.begin());
+            // 3 -> reverse 3
+            VP rev_i(edge_i.size());
+            reverse_copy(edge_i.begin(), edge_i.end(), rev_i.begin());
 
-        // for each edge j
-        for (ushort j = 0; j < sz_j; ++j) {
-            VP &edge_j = pj[j];
-            auto sz_ej = ushort(edge_j.size());
+            // for each edge j
+            for (ushort j : cand_j) {
+                VP &edge_j = pj[j];
+                auto sz_ej = ushort(edge_j.size());
 
-            Point &pjf = edge_j[0];
-            Point &pjm = edge_j[sz_ej / 2];
-            Point &pjl = edge_j[sz_ej - 1];
+                Point &pjf = edge_j[0];
+                Point &pjm = edge_j[sz_ej / 2];
+                Point &pjl = edge_j[sz_ej - 1];
 
-            // constraints on position
-            if (pjf.x < pil.x - _positionThreshold)
-                continue;
+                // constraints on position
+                if (pjf.x < pil.x - _positionThreshold)
+                    continue;
 
-            // constraints on CNC
-            const float CNC_THRESHOLD = 0.3f;
-            if (fabs(valueOfPoints(T342) - 1) > CNC_THRESHOLD)
-                continue;
+                // constraints on CNC
+                const float CNC_THRESHOLD = 0.3f;
+                if (fabs(valueOfPoints(T342) - 1) > CNC_THRESHOLD)
+                    continue;
 
-            // 4 -> reverse 4
-            VP rev_j(edge_j.size());
-            reverse_copy(edge_j.begin(), edge_j.end(), rev_j.begin());
+                // 4 -> reverse 4
+                VP rev_j(edge_j.size());
+                reverse_copy(edge_j.begin(), edge_j.end(), rev_j.begin());
 
-            uint key_ij = generateKey(PAIR_34, i, j);
+                uint key_ij = generateKey(PAIR_34, i, j);
 
-            // for each edge k
-            for (ushort k = 0; k < sz_k; ++k) {
-                VP &edge_k = pk[k];
+                // for each edge k
+                for (ushort k : cand_k) {
+                    VP &edge_k = pk[k];
 
-                Point &pkf = edge_k[0];
+                    Point &pkf = edge_k[0];
 
-                // constraints on position
-                if (pkf.y > pif.y + _positionThreshold)
-                    continue;
+                    // constraints on position
+                    if (pkf.y > pif.y + _positionThreshold)
+                        continue;
 
-                uint key_ik = generateKey(PAIR_23, k, i);
+                    uint key_ik = generateKey(PAIR_23, k, i);
 
-                // find centers
-                EllipseData data_ij, data_ik;
+                    // find centers
+                    EllipseData data_ij, data_ik;
 
-                // if the data for the pair i-j have not been computed yet
-                if (data.count(key_ij) == 0) {
-                    getFastCenter(edge_i, rev_j, data_ij);
-                    // insert computed data in the hash table
-                    data.insert(std::pair<uint, EllipseData>(key_ij, data_ij));
-                } else {
-                    // otherwise, just lookup the data in the hash table
-                    data_ij = data.at(key_ij);
-                }
+                    // if the data for the pair i-j have not been computed yet
+                    if (!findPairData(key_ij, data, pairs_i, data_ij)) {
+                        getFastCenter(edge_i, rev_j, data_ij);
+                        // insert computed data in the hash table
+                        pairs_i.insert(std::pair<uint, EllipseData>(key_ij, data_ij));
+                    }
 
-                // if the data for the pair i-k have not been computed yet
-                if (data.count(key_ik) == 0) {
-                    // 2 -> reverse 2
-                    VP rev_k(edge_k.size());
-                    reverse_copy(edge_k.begin(), edge_k.end(), rev_k.begin());
+                    // if the data for the pair i-k have not been computed yet
+                    if (!findPairData(key_ik, data, pairs_i, data_ik)) {
+                        // 2 -> reverse 2
+                        VP rev_k(edge_k.size());
+                        reverse_copy(edge_k.begin(), edge_k.end(), rev_k.begin());
 
-                    getFastCenter(rev_i, rev_k, data_ik);
-                    data.insert(std::pair<uint, EllipseData>(key_ik, data_ik));
-                } else {
-                    // otherwise, just lookup the data in the hash table
-                    data_ik = data.at(key_ik);
-                }
+                        getFastCenter(rev_i, rev_k, data_ik);
+                        pairs_i.insert(std::pair<uint, EllipseData>(key_ik, data_ik));
+                    }
 
-                // invalid centers
-                if (!data_ij.isValid || !data_ik.isValid)
-                    continue;
+                    // invalid centers
+                    if (!data_ij.isValid || !data_ik.isValid)
+                        continue;
 
-                // selection strategy - Step 3.
-                // the computed centers are not close enough
-                if (pointDistance2(data_ij.Cab, data_ik.Cab) > _maxCenterDistance2)
-                    continue;
+                    // selection strategy - Step 3.
+                    // the computed centers are not close enough
+                    if (pointDistance2(data_ij.Cab, data_ik.Cab) > _maxCenterDistance2)
+                        continue;
 
-                // find ellipse parameters
-                // get the coordinates of the center (xc, yc)
-                Point2f center = getCenterCoordinates(data_ij, data_ik);
-                // find remaining parameters (A, B, rho)
-                findEllipses(center, edge_i, edge_j, edge_k, data_ij, data_ik, ellipses);
+                    // find ellipse parameters
+                    // get the coordinates of the center (xc, yc)
+                    Point2f center = getCenterCoordinates(data_ij, data_ik);
+                    // find remaining parameters (A, B, rho)
+                    findEllipses(center, edge_i, edge_j, edge_k, data_ij, data_ik, acc, ellipses_i);
+                }
             }
+
         }
+    });
 
+    // merge in the order of the sequential search
+    for (ushort i = 0; i < sz_i; i++) {
+        data.insert(newPairs[i].begin(), newPairs[i].end());
+        ellipses.insert(ellipses.end(), found[i].begin(), found[i].end());
     }
 }
 
@@ -1127,94 +1246,115 @@ void EllipseDetectorImpl::getTriplets413(VVP &pi, VVP &pj, VVP &pk,
                                          std::vector<Ellipse> &ellipses) {
     // get arch length
     auto sz_i = ushort(pi.size());
-    auto sz_j = ushort(pj.size());
-    auto sz_k = ushort(pk.size());
 
-    // for each edge i
-    for (ushort i = 0; i < sz_i; i++) {
-        VP &edge_i = pi[i];
-        auto sz_ei = ushort(edge_i.size());
-
-        Point &pif = edge_i[0];
-        Point &pim = edge_i[sz_ei / 2];
-        Point &pil = edge_i[sz_ei - 1];
+    // arcs j and k are looked up in indices sorted by the coordinate used in the
+    // constraints on position, instead of testing all of them for every arc i
+    ArcIndex index_j(pj, true, true);
+    ArcIndex index_k(pk, true, false);
+
+    // the arcs i are processed in parallel. The keys of all pairs computed for arc i
+    // contain i, so the pairs are collected per arc i and merged into the shared
+    // hash table afterwards, which is only read inside the parallel loop
+    std::vector<std::unordered_map<uint, EllipseData> > newPairs(sz_i);
+    std::vector<std::vector<Ellipse> > found(sz_i);
+
+    parallel_for_(Range(0, sz_i), [&](const Range &range) {
+        EllipseAccumulators acc(ACC_N_SIZE, ACC_R_SIZE, ACC_A_SIZE);
+        std::vector<ushort> cand_j, cand_k;
+
+        // for each edge i
+        for (int ii = range.start; ii < range.end; ii++) {
+            auto i = ushort(ii);
+            VP &edge_i = pi[i];
+            auto sz_ei = ushort(edge_i.size());
+
+            Point &pif = edge_i[0];
+            Point &pim = edge_i[sz_ei / 2];
+            Point &pil = edge_i[sz_ei - 1];
+
+            // candidate arcs satisfying the constraints on position
+            index_j.query(pil.y + _positionThreshold, true, cand_j);
+            index_k.query(pif.x + _positionThreshold, true, cand_k);
+            std::unordered_map<uint, EllipseData> &pairs_i = newPairs[i];
+            std::vector<Ellipse> &ellipses_i = found[i];
 
-        // 4 -> reverse 4
-        VP rev_i(edge_i.size());
-        reverse_copy(edge_i.begin(), edge_i.end(), rev_i.begin());
+            // 4 -> reverse 4
+            VP rev_i(edge_i.size());
+            reverse_copy(edge_i.begin(), edge_i.end(), rev_i.begin());
 
-        // for each edge j
-        for (ushort j = 0; j < sz_j; ++j) {
-            VP &edge_j = pj[j];
-            auto sz_ej = ushort(edge_j.size());
+            // for each edge j
+            for (ushort j : cand_j) {
+                VP &edge_j = pj[j];
+                auto sz_ej = ushort(edge_j.size());
 
-            Point &pjf = edge_j[0];
-            Point &pjm = edge_j[sz_ej / 2];
-            Point &pjl = edge_j[sz_ej - 1];
+                Point &pjf = edge_j[0];
+                Point &pjm = edge_j[sz_ej / 2];
+                Point &pjl = edge_j[sz_ej - 1];
 
-            // constraints on position
-            if (pjl.y > pil.y + _positionThreshold)
-                continue;
+                // constraints on position
+                if (pjl.y > pil.y + _positionThreshold)
+                    continue;
 
-            // constraints on CNC
-            const float CNC_THRESHOLD = 0.3f;
-            if (fabs(valueOfPoints(T413) - 1) > CNC_THRESHOLD)
-                continue;
+                // constraints on CNC
+                const float CNC_THRESHOLD = 0.3f;
+                if (fabs(valueOfPoints(T413) - 1) > CNC_THRESHOLD)
+                    continue;
 
-            uint key_ij = generateKey(PAIR_14, j, i);
+                uint key_ij = generateKey(PAIR_14, j, i);
 
-            // for each edge k
-            for (ushort k = 0; k < sz_k; ++k) {
-                VP &edge_k = pk[k];
-                auto sz_ek = ushort(edge_k.size());
+                // for each edge k
+                for (ushort k : cand_k) {
+                    VP &edge_k = pk[k];
+                    auto sz_ek = ushort(edge_k.size());
 
-                Point &pkl = edge_k[sz_ek - 1];
+                    Point &pkl = edge_k[sz_ek - 1];
 
-                // constraints on position
-                if (pkl.x > pif.x + _positionThreshold)
-                    continue;
+                    // constraints on position
+                    if (pkl.x > pif.x + _positionThreshold)
+                        continue;
 
-                uint key_ik = generateKey(PAIR_34, k, i);
+                    uint key_ik = generateKey(PAIR_34, k, i);
 
-                // find centers
-                EllipseData data_ij, data_ik;
+                    // find centers
+                    EllipseData data_ij, data_ik;
 
-                // if the data for the pair i-j have not been computed yet
-                if (data.count(key_ij) == 0) {
-                    getFastCenter(edge_i, edge_j, data_ij);
-                    // insert computed date in the hash table
-                    data.insert(std::pair<uint, EllipseData>(key_ij, data_ij));
-                } else {
-                    // otherwise, just lookup the data in the hash table
-                    data_ij = data.at(key_ij);
-                }
+                    // if the data for the pair i-j have not been computed yet
+                    if (!findPairData(key_ij, data, pairs_i, data_ij)) {
+                        getFastCenter(edge_i, edge_j, data_ij);
+                        // insert computed date in the hash table
+                        pairs_i.insert(std::pair<uint, EllipseData>(key_ij, data_ij));
+                    }
 
-                // if the data for the pair i-k have not been computed yet
-                if (data.count(key_ik) == 0) {
-                    getFastCenter(rev_i, edge_k, data_ik);
-                    data.insert(std::pair<uint, EllipseData>(key_ik, data_ik));
-                } else {
-                    // otherwise, just lookup the data in the hash table
-                    data_ik = data.at(key_ik);
-                }
+                    // if the data for the pair i-k have not been computed yet
+                    if (!findPairData(key_ik, data, pairs_i, data_ik)) {
+                        getFastCenter(rev_i, edge_k, data_ik);
+                        pairs_i.insert(std::pair<uint, EllipseData>(key_ik, data_ik));
+                    }
 
-                // invalid centers
-                if (!data_ij.isValid || !data_ik.isValid)
-                    continue;
+                    // invalid centers
+                    if (!data_ij.isValid || !data_ik.isValid)
+                        continue;
 
-                // selection strategy - Step 3.
-                // the computed centers are not close enough
-                if (pointDistance2(data_ij.Cab, data_ik.Cab) > _maxCenterDistance2)
-                    continue;
+                    // selection strategy - Step 3.
+                    // the computed centers are not close enough
+                    if (pointDistance2(data_ij.Cab, data_ik.Cab) > _maxCenterDistance2)
+                        continue;
 
-                // find ellipse parameters
-                // get the coordinates of the center (xc, yc)
-                Point2f center = getCenterCoordinates(data_ij, data_ik);
-                // find remaining parameters (A, B, rho)
-                findEllipses(center, edge_i, edge_j, edge_k, data_ij, data_ik, ellipses);
+                    // find ellipse parameters
+                    // get the coordinates of the center (xc, yc)
+                    Point2f center = getCenterCoordinates(data_ij, data_ik);
+                    // find remaining parameters (A, B, rho)
+                    findEllipses(center, edge_i, edge_j, edge_k, data_ij, data_ik, acc, ellipses_i);
 
+                }
             }
         }
+    });
+
+    // merge in the order of the sequential search
+    for (ushort i = 0; i < sz_i; i++) {
+        data.insert(newPairs[i].begin(), newPairs[i].end());
+        ellipses.insert(ellipses.end(), found[i].begin(), found[i].end());
     }
 }
 
@@ -1474,56 +1614,49 @@ void EllipseDetectorImpl::preProcessing(Mat1b &image, Mat1b &dp, Mat1b &dn) {
 }
 
 void EllipseDetectorImpl::detect(Mat1b &image, std::vector<Ellipse> &ellipses) {
-    countsOfFindEllipse = 0, countsOfGetFastCenter = 0;
-
     // set the image size
     _imgSize = image.size();
 
     // initialize temporary data structures
-    Mat1b dp = Mat1b::zeros(_imgSize); // arcs along positive diagonal
-    Mat1b dn = Mat1b::zeros(_imgSize); // arcs along negative diagonal
+    _dp.create(_imgSize);
+    _dp.setTo(Scalar::all(0));
+    _dn.create(_imgSize);
+    _dn.setTo(Scalar::all(0));
+    _centers.clear();
 
     // initialize accumulator dimensions
     ACC_N_SIZE = 101, ACC_R_SIZE = 180, ACC_A_SIZE = max(_imgSize.height, _imgSize.width);
 
-    // allocate accumulators
-    accN = new int[ACC_N_SIZE], accR = new int[ACC_R_SIZE], accA = new int[ACC_A_SIZE];
-
     // other temporary
     VVP points_1, points_2, points_3, points_4; // vector of points, one for each convexity class
-    std::unordered_map<uint, EllipseData> centers; // hash map for reusing already computed EllipseData
 
     // preprocessing
     // find edge point with coarse convexity along positive (dp) or negative (dn) diagonal
-    preProcessing(image, dp, dn);
+    preProcessing(image, _dp, _dn);
 
     // detect edge and find convexity
-    detectEdges13(dp, points_1, points_3);
-    detectEdges24(dn, points_2, points_4);
+    detectEdges13(_dp, points_1, points_3);
+    detectEdges24(_dn, points_2, points_4);
 
     // find triplets
-    getTriplets124(points_1, points_2, points_4, centers, ellipses);
-    getTriplets231(points_2, points_3, points_1, centers, ellipses);
-    getTriplets342(points_3, points_4, points_2, centers, ellipses);
-    getTriplets413(points_4, points_1, points_3, centers, ellipses);
+    getTriplets124(points_1, points_2, points_4, _centers, ellipses);
+    getTriplets231(points_2, points_3, points_1, _centers, ellipses);
+    getTriplets342(points_3, points_4, points_2, _centers, ellipses);
+    getTriplets413(points_4, points_1, points_3, _centers, ellipses);
 
     // sort by score
     sort(ellipses.begin(), ellipses.end());
 
-    // free accumulator memory
-    delete[]accN;
-    delete[]accR;
-    delete[]accA;
-
     // cluster detections
     clusterEllipses(ellipses);
 }
 
 void EllipseDetectorImpl::findEllipses(Point2f &center, VP &edge_i, VP &edge_j, VP &edge_k,
                                        EllipseData &data_ij, EllipseData &data_ik,
+                                       EllipseAccumulators &acc,
                                        std::vector<Ellipse> &ellipses) {
-    countsOfFindEllipse++;
     // find ellipse parameters
+    int *accN = acc.accN.data(), *accR = acc.accR.data(), *accA = acc.accA.data();
 
     // 0-initialize accumulators
     memset(accN, 0, sizeof(int) * ACC_N_SIZE);
@@ -1937,47 +2070,75 @@ void EllipseDetectorImpl::clusterEllipses(std::vector<Ellipse> &ellipses) {
     clusters.swap(ellipses);
 }
 
+class EllipseDetectorWithBuffers : public EllipseDetector {
+public:
+    EllipseDetectorWithBuffers(float scoreThreshold, float reliabilityThreshold,
+                               float centerDistanceThreshold)
+            : _scoreThreshold(scoreThreshold), _reliabilityThreshold(reliabilityThreshold),
+              _centerDistanceThreshold(centerDistanceThreshold) {}
+
+    void detect(InputArray image, OutputArray ellipses) CV_OVERRIDE {
+        // check image empty and type
+        CV_Assert(
+                !image.empty() && (image.isMat() || image.isUMat()));
+
+        // check ellipses type
+        int type = CV_32FC(6);
+        if (ellipses.fixedType()) {
+            type = ellipses.type();
+            CV_CheckType(type, type == CV_32FC(6), "Wrong type of output ellipses");
+        }
+
+        // set class parameters
+        Size imgSize = image.size();
+        float maxCenterDistance =
+                sqrt(float(imgSize.width * imgSize.width + imgSize.height * imgSize.height)) *
+                _centerDistanceThreshold;
+        _edi.setParameters(maxCenterDistance, _scoreThreshold, _reliabilityThreshold);
+
+        // the image is smoothed in place, so it is always copied to the gray buffer
+        if (image.channels() != 1)
+            cvtColor(image, _grayImage, COLOR_BGR2GRAY);
+        else
+            image.copyTo(_grayImage);
+
+        // detect - ellipse format
+        _ellipseResults.clear();
+        _edi.detect(_grayImage, _ellipseResults);
+
+        // convert - ellipse format to std::vector<Vec6f>
+        std::vector<Vec6f> _ellipses;
+        for (size_t i = 0; i < _ellipseResults.size(); i++) {
+            Ellipse tmpEll = _ellipseResults[i];
+            Vec6f tmpVec(tmpEll.center.x, tmpEll.center.y, tmpEll.a, tmpEll.b, tmpEll.score,
+                         tmpEll.radius);
+            _ellipses.push_back(tmpVec);
+        }
+        Mat(_ellipses).copyTo(ellipses);
+    }
+
+private:
+    float _scoreThreshold, _reliabilityThreshold, _centerDistanceThreshold;
+    EllipseDetectorImpl _edi;
+    Mat1b _grayImage;
+    std::vector<Ellipse> _ellipseResults;
+};
+
+Ptr<EllipseDetector> createEllipseDetector(
+        float scoreThreshold, float reliabilityThreshold,
+        float centerDistanceThreshold) {
+    return makePtr<EllipseDetectorWithBuffers>(scoreThreshold, reliabilityThreshold,
+                                               centerDistanceThreshold);
+}
+
 // find ellipses in images
 void findEllipses(
         InputArray image, OutputArray ellipses,
         float scoreThreshold, float reliabilityThreshold,
         float centerDistanceThreshold) {
-
-    // check image empty and type
-    CV_Assert(
-            !image.empty() && (image.isMat() || image.isUMat()));
-
-    // check ellipses type
-    int type = CV_32FC(6);
-    if (ellipses.fixedType()) {
-        type = ellipses.type();
-        CV_CheckType(type, type == CV_32FC(6), "Wrong type of output ellipses");
-    }
-
-    // set class parameters
-    Size imgSize = image.size();
-    float maxCenterDistance =
-            sqrt(float(imgSize.width * imgSize.width + imgSize.height * imgSize.height)) *
-            centerDistanceThreshold;
-    EllipseDetectorImpl edi;
-    edi.setParameters(maxCenterDistance, scoreThreshold, reliabilityThreshold);
-
-    // detect - ellipse format
-    std::vector<Ellipse> ellipseResults;
-    Mat1b grayImage = image.getMat();
-    if (image.channels() != 1)
-        cvtColor(image, grayImage, COLOR_BGR2GRAY);
-    edi.detect(grayImage, ellipseResults);
-
-    // convert - ellipse format to std::vector<Vec6f>
-    std::vector<Vec6f> _ellipses;
-    for (size_t i = 0; i < ellipseResults.size(); i++) {
-        Ellipse tmpEll = ellipseResults[i];
-        Vec6f tmpVec(tmpEll.center.x, tmpEll.center.y, tmpEll.a, tmpEll.b, tmpEll.score,
-                     tmpEll.radius);
-        _ellipses.push_back(tmpVec);
-    }
-    Mat(_ellipses).copyTo(ellipses);
+    EllipseDetectorWithBuffers detector(scoreThreshold, reliabilityThreshold,
+                                        centerDistanceThreshold);
+    detector.detect(image, ellipses);
 }
 } // namespace ximgproc
 } // namespace cv
@@ -40,6 +40,7 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 /******************************************************************************\
 *                            SEEDS Superpixels                                *
@@ -82,7 +83,10 @@ public:
     virtual int getNumberOfSuperpixels() CV_OVERRIDE { return nrLabels(seeds_top_level); }
 
     virtual void iterate(InputArray img, int num_iterations = 4) CV_OVERRIDE;
+    virtual void iterateWarmStart(InputArray img, int num_iterations = 2) CV_OVERRIDE;
 
+    virtual void setParallelPixelUpdates(bool val) CV_OVERRIDE { parallel_pixel_updates = val; }
+    virtual bool getParallelPixelUpdates() const CV_OVERRIDE { return parallel_pixel_updates; }
 
     virtual void getLabels(OutputArray labels_out) CV_OVERRIDE;
     virtual void getLabelContourMask(OutputArray image, bool thick_line = false) CV_OVERRIDE;
@@ -91,6 +95,7 @@ private:
     /* initialization */
     void initialize(int num_superpixels, int num_levels);
     void initImage(InputArray img);
+    void readImage(InputArray img);
     void assignLabels();
     void computeHistograms(int until_level = -1);
     template<typename _Tp>
@@ -109,6 +114,22 @@ private:
     inline void updateLabels();
     // main loop for pixel updating
     void updatePixels();
+    // pixel updates of image rows [y_start, y_end). Only pixels between two superpixels
+    // whose top level grid row lies in [owner_start, owner_end) are updated, owner_start < 0
+    // means all superpixels are allowed.
+    void updatePixelsRange(int y_start, int y_end, int owner_start, int owner_end);
+    void updateBorderPixels();
+    inline bool ownsLabel(int label, int owner_start, int owner_end) const {
+        if( owner_start < 0 )
+            return true;
+        int row = label / nr_wh[2 * seeds_top_level];
+        return row >= owner_start && row < owner_end;
+    }
+    // first image row that is assigned to the given grid row of the level
+    inline int gridRowStart(int level, int row) const {
+        int nr_h = nr_wh[2 * level + 1];
+        return (row * height + nr_h - 1) / nr_h;
+    }
 
 
     /* block operations */
@@ -154,6 +175,10 @@ private:
     bool seeds_double_step;
     int seeds_prior;
 
+    bool parallel_pixel_updates;
+    bool labels_valid; // labels hold the result of a previous iterate() call
+    int pixel_update_count; // number of updatePixels() calls, selects the band phase
+
     // keep one labeling for each level
     vector<int> nr_wh; // [2*level]/[2*level+1] number of labels in x-direction/y-direction
 
@@ -201,6 +226,9 @@ SuperpixelSEEDSImpl::SuperpixelSEEDSImpl(int image_width, int image_height, int
     nr_channels = image_channels;
     seeds_double_step = double_step;
     seeds_prior = std::min(prior, 5);
+    parallel_pixel_updates = false;
+    labels_valid = false;
+    pixel_update_count = 0;
 
     histogram_size = nr_bins;
     for (int i = 1; i < nr_channels; ++i)
@@ -233,6 +261,31 @@ void SuperpixelSEEDSImpl::iterate(InputArray img, int num_iterations)
 
     for (int i = 0; i < num_iterations; ++i)
         updatePixels();
+
+    labels_valid = true;
+}
+
+void SuperpixelSEEDSImpl::iterateWarmStart(InputArray img, int num_iterations)
+{
+    if( !labels_valid )
+    {
+        iterate(img, num_iterations);
+        return;
+    }
+
+    // keep the labeling of the previous frame and rebuild the top level
+    // histograms from the new image, the block levels are not needed anymore
+    readImage(img);
+
+    int nr_labels = nrLabels(seeds_top_level);
+    memset(histogram[seeds_top_level], 0,
+            sizeof(HISTN) * histogram_size_aligned * nr_labels);
+    memset(T[seeds_top_level], 0, sizeof(HISTN) * nr_labels);
+    for (int i = 0; i < width * height; ++i)
+        addPixel(seeds_top_level, labels[i], i);
+
+    for (int i = 0; i < num_iterations; ++i)
+        updatePixels();
 }
 void SuperpixelSEEDSImpl::getLabels(OutputArray labels_out)
 {
@@ -339,17 +392,20 @@ void SuperpixelSEEDSImpl::initImageBins(const Mat& img, int max_value)
     int img_height = img.size().height;
     int channels = img.channels();
 
-    for (int y = 0; y < img_height; ++y)
+    parallel_for_(Range(0, img_height), [&](const Range& range)
     {
-        for (int x = 0; x < img_width; ++x)
+        for (int y = range.start; y < range.end; ++y)
         {
-            const _Tp* ptr = img.ptr<_Tp>(y, x);
-            int bin = 0;
-            for (int i = 0; i < channels; ++i)
-                bin = bin * nr_bins + (int) ptr[i] * nr_bins / max_value;
-            image_bins[y * img_width + x] = bin;
+            for (int x = 0; x < img_width; ++x)
+            {
+                const _Tp* ptr = img.ptr<_Tp>(y, x);
+                int bin = 0;
+                for (int i = 0; i < channels; ++i)
+                    bin = bin * nr_bins + (int) ptr[i] * nr_bins / max_value;
+                image_bins[y * img_width + x] = bin;
+            }
         }
-    }
+    });
 }
 
 /* specialization for float: max_value is assumed to be 1.0f */
@@ -360,20 +416,35 @@ void SuperpixelSEEDSImpl::initImageBins<float>(const Mat& img, int)
     int img_height = img.size().height;
     int channels = img.channels();
 
-    for (int y = 0; y < img_height; ++y)
+    parallel_for_(Range(0, img_height), [&](const Range& range)
     {
-        for (int x = 0; x < img_width; ++x)
+        for (int y = range.start; y < range.end; ++y)
         {
-            const float* ptr = img.ptr<float>(y, x);
-            int bin = 0;
-            for(int i=0; i<channels; ++i)
-                bin = bin * nr_bins + std::min((int)(ptr[i] * (float)nr_bins), nr_bins-1);
-            image_bins[y*img_width + x] = bin;
+            for (int x = 0; x < img_width; ++x)
+            {
+                const float* ptr = img.ptr<float>(y, x);
+                int bin = 0;
+                for(int i=0; i<channels; ++i)
+                    bin = bin * nr_bins + std::min((int)(ptr[i] * (float)nr_bins), nr_bins-1);
+                image_bins[y*img_width + x] = bin;
+            }
         }
-    }
+    });
 }
 
 void SuperpixelSEEDSImpl::initImage(InputArray img)
+{
+    seeds_current_level = seeds_nr_levels - 2;
+    forwardbackward = true;
+
+    assignLabels();
+
+    readImage(img);
+
+    computeHistograms();
+}
+
+void SuperpixelSEEDSImpl::readImage(InputArray img)
 {
     Mat src;
 
@@ -401,10 +472,6 @@ void SuperpixelSEEDSImpl::initImage(InputArray img)
       CV_Error( Error::StsInternal, "Invalid InputArray." );
 
     int depth = src.depth();
-    seeds_current_level = seeds_nr_levels - 2;
-    forwardbackward = true;
-
-    assignLabels();
 
     CV_Assert(src.size().width == width && src.size().height == height);
     CV_Assert(depth == CV_8U || depth == CV_16U || depth == CV_32F);
@@ -423,8 +490,6 @@ void SuperpixelSEEDSImpl::initImage(InputArray img)
         initImageBins<float>(src, 1);
         break;
     }
-
-    computeHistograms();
 }
 
 // adds labeling to all the blocks at all levels and sets the correct parents
@@ -457,9 +522,16 @@ void SuperpixelSEEDSImpl::computeHistograms(int until_level)
         memset(T[level], 0, sizeof(HISTN) * nr_labels);
     }
 
-    // build histograms on the first level by adding the pixels to the blocks
-    for (int i = 0; i < width * height; ++i)
-        addPixel(0, labels_bottom[i], i);
+    // build histograms on the first level by adding the pixels to the blocks.
+    // a row of level 0 blocks covers a disjoint set of image rows, so the rows of
+    // blocks can be filled in parallel
+    parallel_for_(Range(0, nr_wh[1]), [&](const Range& range)
+    {
+        int y_start = gridRowStart(0, range.start);
+        int y_end = range.end == nr_wh[1] ? height : gridRowStart(0, range.end);
+        for (int i = y_start * width; i < y_end * width; ++i)
+            addPixel(0, labels_bottom[i], i);
+    });
 
     // build histograms on the upper levels by adding the histogram from the level below
     for (int level = 1; level < until_level; level++)
@@ -636,13 +708,54 @@ int SuperpixelSEEDSImpl::goDownOneLevel()
 }
 
 void SuperpixelSEEDSImpl::updatePixels()
+{
+    // Each superpixel is owned by the band of top level grid rows it was initialized in.
+    // A band only moves pixels between superpixels it owns, so bands of the same parity
+    // never touch the same histograms and (being separated by a band of the other parity)
+    // never read or write the same labels. The band phase is shifted by one grid row every
+    // other call, so superpixels of neighbouring bands are also updated against each other.
+    const int band_rows = 2;
+    const int nr_top_h = nr_wh[2 * seeds_top_level + 1];
+    const int shift = (pixel_update_count++ & 1) ? band_rows / 2 : 0;
+    const int nr_bands = (nr_top_h + shift + band_rows - 1) / band_rows;
+
+    if( parallel_pixel_updates && nr_bands >= 3 )
+    {
+        for (int parity = 0; parity < 2; parity++)
+        {
+            int nr_parity_bands = (nr_bands - parity + 1) / 2;
+            parallel_for_(Range(0, nr_parity_bands), [&](const Range& range)
+            {
+                for (int i = range.start; i < range.end; i++)
+                {
+                    int band = 2 * i + parity;
+                    int owner_start = std::max(band * band_rows - shift, 0);
+                    int owner_end = std::min((band + 1) * band_rows - shift, nr_top_h);
+                    int y_start = std::max(gridRowStart(seeds_top_level, owner_start), 1);
+                    int y_end = owner_end == nr_top_h ? height - 1
+                            : std::min(gridRowStart(seeds_top_level, owner_end), height - 1);
+                    updatePixelsRange(y_start, y_end, owner_start, owner_end);
+                }
+            });
+        }
+    }
+    else
+    {
+        updatePixelsRange(1, height - 1, -1, -1);
+    }
+    forwardbackward = !forwardbackward;
+
+    updateBorderPixels();
+}
+
+void SuperpixelSEEDSImpl::updatePixelsRange(int y_start, int y_end, int owner_start, int owner_end)
 {
     int labelA;
     int labelB;
     int priorA = 0;
     int priorB = 0;
 
-    for (int y = 1; y < height - 1; y++)
+    for (int y = y_start; y < y_end; y++)
     {
         for (int x = 1; x < width - 2; x++)
         {
@@ -650,7 +763,8 @@ void SuperpixelSEEDSImpl::updatePixels()
             labelA = labels[(y) * width + (x)];
             labelB = labels[(y) * width + (x + 1)];
 
-            if( labelA != labelB )
+            if( labelA != labelB && ownsLabel(labelA, owner_start, owner_end)
+                    && ownsLabel(labelB, owner_start, owner_end) )
             {
                 int a22 = labelA;
                 int a23 = labelB;
@@ -734,14 +848,16 @@ void SuperpixelSEEDSImpl::updatePixels()
         } // for x
     } // for y
 
+    const int y_end_v = std::min(y_end, height - 2);
     for (int x = 1; x < width - 1; x++)
     {
-        for (int y = 1; y < height - 2; y++)
+        for (int y = y_start; y < y_end_v; y++)
         {
 
             labelA = labels[(y) * width + (x)];
             labelB = labels[(y + 1) * width + (x)];
-            if( labelA != labelB )
+            if( labelA != labelB && ownsLabel(labelA, owner_start, owner_end)
+                    && ownsLabel(labelB, owner_start, owner_end) )
             {
                 int a22 = labelA;
                 int a32 = labelB;
@@ -825,9 +941,13 @@ void SuperpixelSEEDSImpl::updatePixels()
             } // labelA != labelB
         } // for y
     } // for x
-    forwardbackward = !forwardbackward;
+}
+
+void SuperpixelSEEDSImpl::updateBorderPixels()
+{
+    int labelA;
+    int labelB;
 
-    // update border pixels
     for (int x = 0; x < width; x++)
     {
         labelA = labels[x];
@@ -882,15 +1002,14 @@ void SuperpixelSEEDSImpl::addBlock(int level, int label, int sublevel,
 
     //add the (sublevel, sublabel) block to the block (level, label)
     int n = 0;
-#if CV_SSSE3
+#if CV_SIMD128
     const int loop_end = histogram_size - 3;
     for (; n < loop_end; n += 4)
     {
         //this does exactly the same as the loop peeling below, but 4 elements at a time
-        __m128 h_labelp = _mm_load_ps(h_label + n);
-        __m128 h_sublabelp = _mm_load_ps(h_sublabel + n);
-        h_labelp = _mm_add_ps(h_labelp, h_sublabelp);
-        _mm_store_ps(h_label + n, h_labelp);
+        v_float32x4 h_labelp = v_load_aligned(h_label + n);
+        v_float32x4 h_sublabelp = v_load_aligned(h_sublabel + n);
+        v_store_aligned(h_label + n, h_labelp + h_sublabelp);
     }
 #endif
 
@@ -914,15 +1033,14 @@ void SuperpixelSEEDSImpl::deleteBlockToplevel(int label, int sublevel, int subla
 
     //do the reverse operation of add_block_toplevel
     int n = 0;
-#if CV_SSSE3
+#if CV_SIMD128
     const int loop_end = histogram_size - 3;
     for (; n < loop_end; n += 4)
     {
         //this does exactly the same as the loop peeling below, but 4 elements at a time
-        __m128 h_labelp = _mm_load_ps(h_label + n);
-        __m128 h_sublabelp = _mm_load_ps(h_sublabel + n);
-        h_labelp = _mm_sub_ps(h_labelp, h_sublabelp);
-        _mm_store_ps(h_label + n, h_labelp);
+        v_float32x4 h_labelp = v_load_aligned(h_label + n);
+        v_float32x4 h_sublabelp = v_load_aligned(h_sublabel + n);
+        v_store_aligned(h_label + n, h_labelp - h_sublabelp);
     }
 #endif
 
@@ -937,8 +1055,11 @@ void SuperpixelSEEDSImpl::deleteBlockToplevel(int label, int sublevel, int subla
 
 void SuperpixelSEEDSImpl::updateLabels()
 {
-    for (int i = 0; i < width * height; ++i)
-        labels[i] = parent[0][labels_bottom[i]];
+    parallel_for_(Range(0, height), [&](const Range& range)
+    {
+        for (int i = range.start * width; i < range.end * width; ++i)
+            labels[i] = parent[0][labels_bottom[i]];
+    });
 }
 
 bool SuperpixelSEEDSImpl::probability(int image_idx, int label1, int label2,
@@ -1109,12 +1230,12 @@ float SuperpixelSEEDSImpl::intersectConf(int level1, int label1A, int label1B,
      */
 
     int n = 0;
-#if CV_SSSE3
-    __m128 count1Ap = _mm_set1_ps(count1A);
-    __m128 count2p = _mm_set1_ps(count2);
-    __m128 count1Bp = _mm_set1_ps(count1B);
-    __m128 sumAp = _mm_set1_ps(0.0f);
-    __m128 sumBp = _mm_set1_ps(0.0f);
+#if CV_SIMD128
+    v_float32x4 count1Ap = v_setall_f32(count1A);
+    v_float32x4 count2p = v_setall_f32(count2);
+    v_float32x4 count1Bp = v_setall_f32(count1B);
+    v_float32x4 sumAp = v_setzero_f32();
+    v_float32x4 sumBp = v_setzero_f32();
 
     const int loop_end = histogram_size - 3;
     for(; n < loop_end; n += 4)
@@ -1122,41 +1243,18 @@ float SuperpixelSEEDSImpl::intersectConf(int level1, int label1A, int label1B,
         //this does exactly the same as the loop peeling below, but 4 elements at a time
 
         // normal
-        __m128 h1Ap = _mm_load_ps(h1A + n);
-        __m128 h1Bp = _mm_load_ps(h1B + n);
-        __m128 h2p = _mm_load_ps(h2 + n);
-
-        __m128 h1ApC2 = _mm_mul_ps(h1Ap, count2p);
-        __m128 h2pC1A = _mm_mul_ps(h2p, count1Ap);
-        __m128 maskA = _mm_cmple_ps(h1ApC2, h2pC1A);
-        __m128 sum1AddA = _mm_and_ps(maskA, h1ApC2);
-        __m128 sum2AddA = _mm_andnot_ps(maskA, h2pC1A);
-        sumAp = _mm_add_ps(sumAp, sum1AddA);
-        sumAp = _mm_add_ps(sumAp, sum2AddA);
+        v_float32x4 h1Ap = v_load_aligned(h1A + n);
+        v_float32x4 h1Bp = v_load_aligned(h1B + n);
+        v_float32x4 h2p = v_load_aligned(h2 + n);
+
+        sumAp += v_min(h1Ap * count2p, h2p * count1Ap);
 
         // del
-        __m128 diffp = _mm_sub_ps(h1Bp, h2p);
-        __m128 h1BpC2 = _mm_mul_ps(diffp, count2p);
-        __m128 h2pC1B = _mm_mul_ps(h2p, count1Bp);
-        __m128 maskB = _mm_cmple_ps(h1BpC2, h2pC1B);
-        __m128 sum1AddB = _mm_and_ps(maskB, h1BpC2);
-        __m128 sum2AddB = _mm_andnot_ps(maskB, h2pC1B);
-        sumBp = _mm_add_ps(sumBp, sum1AddB);
-        sumBp = _mm_add_ps(sumBp, sum2AddB);
+        sumBp += v_min((h1Bp - h2p) * count2p, h2p * count1Bp);
     }
-    // merge results (quite expensive)
-    float sum1Asse;
-    sumAp = _mm_hadd_ps(sumAp, sumAp);
-    sumAp = _mm_hadd_ps(sumAp, sumAp);
-    _mm_store_ss(&sum1Asse, sumAp);
-
-    float sum1Bsse;
-    sumBp = _mm_hadd_ps(sumBp, sumBp);
-    sumBp = _mm_hadd_ps(sumBp, sumBp);
-    _mm_store_ss(&sum1Bsse, sumBp);
-
-    sumA += sum1Asse;
-    sumB += sum1Bsse;
+    // merge results
+    sumA += v_reduce_sum(sumAp);
+    sumB += v_reduce_sum(sumBp);
 #endif
 
     //loop peeling
@@ -59,6 +59,7 @@ struct SparseMatch
 bool operator<(const SparseMatch& lhs,const SparseMatch& rhs);
 
 static void computeGradientMagnitude(Mat& src, Mat& dst);
+static bool isPreparedImage(const Mat& prepared, const Mat& src);
 static void weightedLeastSquaresAffineFit(int* labels, float* weights, int count, float lambda, const SparseMatch* matches, Mat& dst);
 static void generateHypothesis(int* labels, int count, RNG& rng, unsigned char* is_used, SparseMatch* matches, Mat& dst);
 static void verifyHypothesis(int* labels, float* weights, int count, SparseMatch* matches, float eps, float lambda, Mat& hypothesis_transform, Mat& old_transform, float& old_weighted_num_inliers);
@@ -71,6 +72,8 @@ struct node
     node(int l,float d): dist(d), label(l) {}
 };
 
+static void getKNNMatches(const vector<node>* g, int match_num, int k, Mat& NNlabels, Mat& NNdistances);
+
 
 
 class EdgeAwareInterpolatorImpl CV_FINAL : public EdgeAwareInterpolator
@@ -78,6 +81,7 @@ class EdgeAwareInterpolatorImpl CV_FINAL : public EdgeAwareInterpolator
 public:
     static Ptr<EdgeAwareInterpolatorImpl> create();
     void interpolate(InputArray from_image, InputArray from_points, InputArray to_image, InputArray to_points, OutputArray dense_flow) CV_OVERRIDE;
+    void prepare(InputArray from_image) CV_OVERRIDE;
 
 protected:
     int match_num;
@@ -88,6 +92,11 @@ protected:
     Mat NNdistances;
     Mat labels;
     Mat costMap;
+    //data prepared for the reference image:
+    Mat preparedImage;
+    Mat preparedGradient;
+    Ptr<FastGlobalSmootherFilter> preparedFGS;
+    float preparedFGSLambda, preparedFGSSigma;
     //tunable parameters:
     float lambda;
     int k;
@@ -104,22 +113,12 @@ protected:
     RNG rngs[ransac_num_stripes];
 
     void init();
-    void preprocessData(Mat& src, vector<SparseMatch>& matches);
+    void preprocessData(Mat& src, vector<SparseMatch>& matches, bool use_prepared);
     void geodesicDistanceTransform(Mat& distances, Mat& cost_map);
     void buildGraph(Mat& distances, Mat& cost_map);
     void ransacInterpolation(vector<SparseMatch>& matches, Mat& dst_dense_flow);
 
 protected:
-    struct GetKNNMatches_ParBody : public ParallelLoopBody
-    {
-        EdgeAwareInterpolatorImpl* inst;
-        int num_stripes;
-        int stripe_sz;
-
-        GetKNNMatches_ParBody(EdgeAwareInterpolatorImpl& _inst, int _num_stripes);
-        void operator () (const Range& range) const CV_OVERRIDE;
-    };
-
     struct RansacInterpolation_ParBody : public ParallelLoopBody
     {
         EdgeAwareInterpolatorImpl* inst;
@@ -161,6 +160,7 @@ void EdgeAwareInterpolatorImpl::init()
     fgs_sigma     = 1.5f;
     regularization_coef = 0.01f;
     costMap = Mat();
+    preparedFGSLambda = preparedFGSSigma = 0.0f;
 }
 
 Ptr<EdgeAwareInterpolatorImpl> EdgeAwareInterpolatorImpl::create()
@@ -212,19 +212,49 @@ void EdgeAwareInterpolatorImpl::interpolate(InputArray from_image, InputArray fr
     NNdistances = Scalar(0.0f);
     g = new vector<node>[match_num];
 
-    preprocessData(src,matches_vector);
+    bool use_prepared = isPreparedImage(preparedImage, src);
+    preprocessData(src,matches_vector,use_prepared);
 
     dense_flow.create(from_image.size(),CV_32FC2);
     Mat dst = dense_flow.getMat();
     ransacInterpolation(matches_vector,dst);
     if(use_post_proc)
-        fastGlobalSmootherFilter(src,dst,dst,fgs_lambda,fgs_sigma);
+    {
+        if(use_prepared)
+        {
+            if(preparedFGS.empty() || preparedFGSLambda!=fgs_lambda || preparedFGSSigma!=fgs_sigma)
+            {
+                preparedFGS = createFastGlobalSmootherFilter(preparedImage,fgs_lambda,fgs_sigma);
+                preparedFGSLambda = fgs_lambda;
+                preparedFGSSigma  = fgs_sigma;
+            }
+            preparedFGS->filter(dst,dst);
+        }
+        else
+            fastGlobalSmootherFilter(src,dst,dst,fgs_lambda,fgs_sigma);
+    }
 
     costMap.release();
     delete[] g;
 }
 
-void EdgeAwareInterpolatorImpl::preprocessData(Mat& src, vector<SparseMatch>& matches)
+void EdgeAwareInterpolatorImpl::prepare(InputArray from_image)
+{
+    preparedFGS.release();
+    if(from_image.empty())
+    {
+        preparedImage.release();
+        preparedGradient.release();
+        return;
+    }
+    CV_Assert( (from_image.depth() == CV_8U) && (from_image.channels() == 3 || from_image.channels() == 1) );
+
+    from_image.copyTo(preparedImage);
+    preparedGradient.create(preparedImage.size(), CV_32FC1);
+    computeGradientMagnitude(preparedImage, preparedGradient);
+}
+
+void EdgeAwareInterpolatorImpl::preprocessData(Mat& src, vector<SparseMatch>& matches, bool use_prepared)
 {
     Mat distances(h,w,CV_32F);
     distances = Scalar(INF);
@@ -239,17 +269,23 @@ void EdgeAwareInterpolatorImpl::preprocessData(Mat& src, vector<SparseMatch>& ma
         labels.at<int>(y,x) = (int)i;
     }
 
-    if (costMap.empty())
+    Mat gradient;
+    if (!costMap.empty())
     {
-        costMap.create(h, w, CV_32FC1);
-        computeGradientMagnitude(src, costMap);
+        CV_Assert(costMap.cols == w && costMap.rows == h);
+        gradient = costMap;
     }
+    else if (use_prepared)
+        gradient = preparedGradient;
     else
-        CV_Assert(costMap.cols == w && costMap.rows == h);
-    costMap = (1000.0f-lambda) + lambda* costMap;
-    geodesicDistanceTransform(distances, costMap);
-    buildGraph(distances, costMap);
-    parallel_for_(Range(0,getNumThreads()),GetKNNMatches_ParBody(*this,getNumThreads()));
+    {
+        gradient.create(h, w, CV_32FC1);
+        computeGradientMagnitude(src, gradient);
+    }
+    Mat cost_map = (1000.0f-lambda) + lambda* gradient;
+    geodesicDistanceTransform(distances, cost_map);
+    buildGraph(distances, cost_map);
+    getKNNMatches(g, match_num, k, NNlabels, NNdistances);
 }
 
 void EdgeAwareInterpolatorImpl::geodesicDistanceTransform(Mat& distances, Mat& cost_map)
@@ -468,6 +504,14 @@ struct nodeHeap
         memset(heap_pos,0,sizeof(int)*num_labels);
     }
 
+    // same as clear(), but only touches the nodes left in the heap
+    void reset()
+    {
+        for(int i=1;i<=size;i++)
+            heap_pos[heap[i].label] = 0;
+        size=0;
+    }
+
     inline bool empty()
     {
         return (size==0);
@@ -565,52 +609,66 @@ struct nodeHeap
     }
 };
 
-EdgeAwareInterpolatorImpl::GetKNNMatches_ParBody::GetKNNMatches_ParBody(EdgeAwareInterpolatorImpl& _inst, int _num_stripes):
-inst(&_inst),num_stripes(_num_stripes)
+struct GetKNNMatches_ParBody : public ParallelLoopBody
 {
-    stripe_sz = (int)ceil(inst->match_num/(double)num_stripes);
-}
+    const vector<node>* g;
+    int match_num;
+    int k;
+    Mat* NNlabels;
+    Mat* NNdistances;
 
-void EdgeAwareInterpolatorImpl::GetKNNMatches_ParBody::operator() (const Range& range) const
-{
-    int start = std::min(range.start * stripe_sz, inst->match_num);
-    int end   = std::min(range.end   * stripe_sz, inst->match_num);
-    nodeHeap q((int)inst->match_num);
-    int num_expanded_vertices;
-    unsigned char* expanded_flag = new unsigned char[inst->match_num];
-    node* neighbors;
+    GetKNNMatches_ParBody(const vector<node>* _g, int _match_num, int _k, Mat& _NNlabels, Mat& _NNdistances):
+    g(_g), match_num(_match_num), k(_k), NNlabels(&_NNlabels), NNdistances(&_NNdistances) {}
 
-    for(int i=start;i<end;i++)
+    void operator () (const Range& range) const CV_OVERRIDE
     {
-        if(inst->g[i].empty())
-            continue;
+        nodeHeap q(match_num);
+        int num_expanded_vertices;
+        vector<unsigned char> expanded_flag(match_num, 0);
+        const node* neighbors;
 
-        num_expanded_vertices = 0;
-        memset(expanded_flag,0,inst->match_num);
-        q.clear();
-        q.add(node((int)i,0.0f));
-        int* NNlabels_row    = inst->NNlabels.ptr<int>(i);
-        float* NNdistances_row = inst->NNdistances.ptr<float>(i);
-        while(num_expanded_vertices<inst->k && !q.empty())
+        for(int i=range.start;i<range.end;i++)
         {
-            node vert_for_expansion = q.getMin();
-            expanded_flag[vert_for_expansion.label] = 1;
-
-            //write the expanded vertex to the dst:
-            NNlabels_row[num_expanded_vertices] = vert_for_expansion.label;
-            NNdistances_row[num_expanded_vertices] = vert_for_expansion.dist;
-            num_expanded_vertices++;
+            if(g[i].empty())
+                continue;
 
-            //update the heap:
-            neighbors = &inst->g[vert_for_expansion.label].front();
-            for(int j=0;j<(int)inst->g[vert_for_expansion.label].size();j++)
+            num_expanded_vertices = 0;
+            q.add(node((int)i,0.0f));
+            int* NNlabels_row    = NNlabels->ptr<int>(i);
+            float* NNdistances_row = NNdistances->ptr<float>(i);
+            while(num_expanded_vertices<k && !q.empty())
             {
-                if(!expanded_flag[neighbors[j].label])
-                    q.updateNode(node(neighbors[j].label,vert_for_expansion.dist+neighbors[j].dist));
+                node vert_for_expansion = q.getMin();
+                expanded_flag[vert_for_expansion.label] = 1;
+
+                //write the expanded vertex to the dst:
+                NNlabels_row[num_expanded_vertices] = vert_for_expansion.label;
+                NNdistances_row[num_expanded_vertices] = vert_for_expansion.dist;
+                num_expanded_vertices++;
+
+                //update the heap:
+                neighbors = &g[vert_for_expansion.label].front();
+                for(int j=0;j<(int)g[vert_for_expansion.label].size();j++)
+                {
+                    if(!expanded_flag[neighbors[j].label])
+                        q.updateNode(node(neighbors[j].label,vert_for_expansion.dist+neighbors[j].dist));
+                }
             }
+
+            // only the expanded vertices and the ones left in the heap were touched,
+            // so the buffers are reset without sweeping all the matches
+            for(int j=0;j<num_expanded_vertices;j++)
+                expanded_flag[NNlabels_row[j]] = 0;
+            q.reset();
         }
     }
-    delete[] expanded_flag;
+};
+
+// finds the k nearest matches of every match in the geodesic graph g
+static void getKNNMatches(const vector<node>* g, int match_num, int k, Mat& NNlabels, Mat& NNdistances)
+{
+    // small stripes balance the load, as the search is cheap for isolated matches
+    parallel_for_(Range(0,match_num),GetKNNMatches_ParBody(g,match_num,k,NNlabels,NNdistances),getNumThreads()*8.0);
 }
 
 static void weightedLeastSquaresAffineFit(int* labels, float* weights, int count, float lambda, const SparseMatch* matches, Mat& dst)
@@ -713,6 +771,14 @@ static void verifyHypothesis(int* labels, float* weights, int count, SparseMatch
     }
 }
 
+// The data prepared by prepare() is only valid for the very image it was computed from
+static bool isPreparedImage(const Mat& prepared, const Mat& src)
+{
+    if (prepared.empty() || prepared.size() != src.size() || prepared.type() != src.type())
+        return false;
+    return norm(prepared, src, NORM_INF) == 0;
+}
+
 static void computeGradientMagnitude(Mat& src, Mat& dst)
 {
     Mat dx, dy;
@@ -906,6 +972,7 @@ class RICInterpolatorImpl CV_FINAL : public RICInterpolator
 public:
     static Ptr<RICInterpolatorImpl> create();
     void interpolate(InputArray from_image, InputArray from_points, InputArray to_image, InputArray to_points, OutputArray dense_flow) CV_OVERRIDE;
+    void prepare(InputArray from_image) CV_OVERRIDE;
 
 protected:
     // internal buffers
@@ -915,6 +982,16 @@ protected:
     Mat NNdistances;
     Mat labels;
     Mat costMap;
+    // data prepared for the reference image
+    Mat preparedImage;
+    Mat preparedGradient;
+    Mat preparedSpLabels, preparedSpPos, preparedSpItems;
+    int preparedSpCnt;
+    int preparedSpSize;
+    float preparedSpRuler;
+    SLICType preparedSlicType;
+    Ptr<FastGlobalSmootherFilter> preparedFGS;
+    float preparedFGSLambda, preparedFGSSigma;
     static const int distance_transform_num_iter = 1;
     float lambda;
 
@@ -938,6 +1015,7 @@ protected:
     void buildGraph(Mat& distances, Mat& cost_map);
     void geodesicDistanceTransform(Mat& distances, Mat& cost_map);
     int  overSegmentaion(const Mat & img, Mat & outLabels, const int spSize);
+    void prepareSuperpixels();
     void superpixelNeighborConstruction(const Mat & labels, int labelCnt, Mat& outNeighbor);
     void superpixelLayoutAnalysis(const Mat & labels, int labelCnt, Mat & outCenterPositions, Mat & outNodeItemLists);
     void findSupportMatches(vector<int> & srcIds, int srcCnt, int supportCnt, Mat & matNN,
@@ -1007,6 +1085,11 @@ void RICInterpolatorImpl::init()
     fgs_sigma = 1.5f;
     slic_type = SLIC;
     costMap = Mat();
+    preparedSpCnt = 0;
+    preparedSpSize = 0;
+    preparedSpRuler = 0.f;
+    preparedSlicType = SLIC;
+    preparedFGSLambda = preparedFGSSigma = 0.f;
 }
 
 struct MinHeap
@@ -1142,6 +1225,7 @@ void RICInterpolatorImpl::interpolate(InputArray from_image, InputArray from_poi
 
     Mat src = from_image.getMat();
     Size src_size = src.size();
+    bool use_prepared = isPreparedImage(preparedImage, src);
 
     labels = Mat(src_size, CV_32SC1);
     labels.setTo(-1);
@@ -1153,76 +1237,59 @@ void RICInterpolatorImpl::interpolate(InputArray from_image, InputArray from_poi
     Mat matDistanceMap(src_size, CV_32FC1);
     matDistanceMap.setTo(1e10);
 
-    if (costMap.empty())
+    Mat gradient;
+    if (!costMap.empty())
     {
-        costMap.create(src_size, CV_32FC1);
-        computeGradientMagnitude(src, costMap);
+        CV_Assert(costMap.rows == src.rows && costMap.cols == src.cols );
+        gradient = costMap;
     }
+    else if (use_prepared)
+        gradient = preparedGradient;
     else
-        CV_Assert(costMap.rows == src.rows && costMap.cols == src.cols );
+    {
+        gradient.create(src_size, CV_32FC1);
+        computeGradientMagnitude(src, gradient);
+    }
 
-    costMap = (1000.0f - lambda) + lambda * costMap;
+    Mat cost_map = (1000.0f - lambda) + lambda * gradient;
 
     for (unsigned int i = 0; i < matches_vector.size(); i++)
     {
         const SparseMatch & p = matches_vector[i];
         Point pos(static_cast<int>(p.reference_image_pos.x), static_cast<int>(p.reference_image_pos.y));
         labels.at<int>(pos) = i;
-        matDistanceMap.at<float>(pos) = costMap.at<float>(pos);
+        matDistanceMap.at<float>(pos) = cost_map.at<float>(pos);
     }
 
-    geodesicDistanceTransform(matDistanceMap, costMap);
+    geodesicDistanceTransform(matDistanceMap, cost_map);
 
+    // the graph buffers are kept between the calls, but the edges of the previous matches are dropped
     g.resize(match_num);
-    buildGraph(matDistanceMap, costMap);
-    parallel_for_(Range(0, getNumThreads()), [&](const Range & range)
-    {
-        int stripe_sz = (int)ceil(match_num / (double)getNumThreads());
-        int start = std::min(range.start * stripe_sz, match_num);
-        int end = std::min(range.end   * stripe_sz, match_num);
-        nodeHeap q((int)match_num);
-        int num_expanded_vertices;
-        vector<unsigned int> expanded_flag(match_num);
-        node* neighbors;
-        for (int i = start; i < end; i++)
-        {
-            if (g[i].empty())
-                continue;
-            num_expanded_vertices = 0;
-            fill(expanded_flag.begin(), expanded_flag.end(), 0);
-            q.clear();
-            q.add(node((int)i, 0.0f));
-            int* NNlabels_row = NNlabels.ptr<int>(i);
-            float* NNdistances_row = NNdistances.ptr<float>(i);
-            while (num_expanded_vertices < max_neighbors && !q.empty())
-            {
-                node vert_for_expansion = q.getMin();
-                expanded_flag[vert_for_expansion.label] = 1;
-
-                //write the expanded vertex to the dst:
-                NNlabels_row[num_expanded_vertices] = vert_for_expansion.label;
-                NNdistances_row[num_expanded_vertices] = vert_for_expansion.dist;
-                num_expanded_vertices++;
-
-                //update the heap:
-                neighbors = &g[vert_for_expansion.label].front();
-                for (int j = 0; j < (int)g[vert_for_expansion.label].size(); j++)
-                {
-                    if (!expanded_flag[neighbors[j].label])
-                        q.updateNode(node(neighbors[j].label, vert_for_expansion.dist + neighbors[j].dist));
-                }
-            }
-        }
-    });
+    for (size_t i = 0; i < g.size(); i++)
+        g[i].clear();
+    buildGraph(matDistanceMap, cost_map);
+    getKNNMatches(&g[0], match_num, max_neighbors, NNlabels, NNdistances);
 
     Mat spLabels;
     Mat spNN;
     Mat spPos;
     Mat spItems;
+    int spCnt;
 
-    int spCnt = overSegmentaion(src, spLabels, sp_size);
+    if (use_prepared)
+    {
+        prepareSuperpixels();
+        spLabels = preparedSpLabels;
+        spPos = preparedSpPos;
+        spItems = preparedSpItems;
+        spCnt = preparedSpCnt;
+    }
+    else
+    {
+        spCnt = overSegmentaion(src, spLabels, sp_size);
+        superpixelLayoutAnalysis(spLabels, spCnt, spPos, spItems);
+    }
     superpixelNeighborConstruction(spLabels, spCnt, spNN);
-    superpixelLayoutAnalysis(spLabels, spCnt, spPos, spItems);
 
     vector<int> srcMatchIds(spCnt);
     for (int i = 0; i < spCnt; i++)
@@ -1307,14 +1374,60 @@ void RICInterpolatorImpl::interpolate(InputArray from_image, InputArray from_poi
 
     if (use_global_smoother_filter)
     {
-        if (prevGrey.empty())
-            cvtColor(src, prevGrey, COLOR_BGR2GRAY);
-        fastGlobalSmootherFilter(prevGrey, dst, dst, fgs_lambda, fgs_sigma);
+        if (use_prepared)
+        {
+            if (preparedFGS.empty() || preparedFGSLambda != fgs_lambda || preparedFGSSigma != fgs_sigma)
+            {
+                Mat guide;
+                cvtColor(preparedImage, guide, COLOR_BGR2GRAY);
+                preparedFGS = createFastGlobalSmootherFilter(guide, fgs_lambda, fgs_sigma);
+                preparedFGSLambda = fgs_lambda;
+                preparedFGSSigma = fgs_sigma;
+            }
+            preparedFGS->filter(dst, dst);
+        }
+        else
+        {
+            if (prevGrey.empty())
+                cvtColor(src, prevGrey, COLOR_BGR2GRAY);
+            fastGlobalSmootherFilter(prevGrey, dst, dst, fgs_lambda, fgs_sigma);
+        }
     }
     dst.copyTo(dense_flow.getMat());
     costMap.release();
 }
 
+void RICInterpolatorImpl::prepare(InputArray from_image)
+{
+    preparedFGS.release();
+    preparedSpLabels.release();
+    if (from_image.empty())
+    {
+        preparedImage.release();
+        preparedGradient.release();
+        return;
+    }
+    CV_Assert(from_image.depth() == CV_8U);
+    CV_Assert((from_image.channels() == 3 || from_image.channels() == 1));
+
+    from_image.copyTo(preparedImage);
+    preparedGradient.create(preparedImage.size(), CV_32FC1);
+    computeGradientMagnitude(preparedImage, preparedGradient);
+    prepareSuperpixels();
+}
+
+void RICInterpolatorImpl::prepareSuperpixels()
+{
+    // the superpixels are computed again only if their parameters have changed
+    if (!preparedSpLabels.empty() && preparedSpSize == sp_size && preparedSpRuler == sp_ruler && preparedSlicType == slic_type)
+        return;
+    preparedSpCnt = overSegmentaion(preparedImage, preparedSpLabels, sp_size);
+    superpixelLayoutAnalysis(preparedSpLabels, preparedSpCnt, preparedSpPos, preparedSpItems);
+    preparedSpSize = sp_size;
+    preparedSpRuler = sp_ruler;
+    preparedSlicType = slic_type;
+}
+
 void RICInterpolatorImpl::geodesicDistanceTransform(Mat& distances, Mat& cost_map)
 {
     float c1 = 1.0f / 2.0f;
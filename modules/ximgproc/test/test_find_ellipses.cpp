@@ -40,4 +40,27 @@ TEST(FindEllipsesTest, EllipsesOnly)
         EXPECT_TRUE(has_match) << "Wrong ellipse center:" << Point2f(ell[0], ell[1]);
     }
 }
+
+TEST(FindEllipsesTest, ReusedDetector)
+{
+    std::string picture_name = "cv/imgproc/stuff.jpg";
+    std::string filename = cvtest::TS::ptr()->get_data_path() + picture_name;
+    Mat src = imread(filename, IMREAD_GRAYSCALE);
+    EXPECT_FALSE(src.empty()) << "Invalid test image: " << filename;
+    Mat srcCopy = src.clone();
+
+    std::vector<Vec6f> ells;
+    ximgproc::findEllipses(src, ells, 0.7f, 0.75f, 0.02f);
+    // the input image is not modified
+    EXPECT_EQ(0, cvtest::norm(src, srcCopy, NORM_INF));
+
+    Ptr<ximgproc::EllipseDetector> detector = ximgproc::createEllipseDetector(0.7f, 0.75f, 0.02f);
+    for (int iter = 0; iter < 2; iter++) {
+        std::vector<Vec6f> ellsReused;
+        detector->detect(src, ellsReused);
+        ASSERT_EQ(ells.size(), ellsReused.size());
+        for (size_t i = 0; i < ells.size(); i++)
+            EXPECT_EQ(ells[i], ellsReused[i]);
+    }
+}
 }}
\ No newline at end of file
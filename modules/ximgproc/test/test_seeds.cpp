@@ -0,0 +1,60 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+static Mat runSEEDS(const Mat& labImg, bool parallel, bool warmStart)
+{
+    Ptr<SuperpixelSEEDS> seeds = createSuperpixelSEEDS(labImg.cols, labImg.rows, labImg.channels(), 400, 4);
+    seeds->setParallelPixelUpdates(parallel);
+    seeds->iterate(labImg, 4);
+    if (warmStart)
+        seeds->iterateWarmStart(labImg, 2);
+    int numSuperpixels = seeds->getNumberOfSuperpixels();
+    EXPECT_GT(numSuperpixels, 100);
+    EXPECT_LE(numSuperpixels, 400);
+    Mat labels;
+    seeds->getLabels(labels);
+    EXPECT_EQ(labImg.size(), labels.size());
+    double minLabel = 0, maxLabel = 0;
+    minMaxLoc(labels, &minLabel, &maxLabel);
+    EXPECT_GE(minLabel, 0);
+    EXPECT_LT(maxLabel, numSuperpixels);
+    return labels;
+}
+
+TEST(ximgproc_SuperpixelSEEDS, smoke)
+{
+    Mat img = imread(cvtest::findDataFile("cv/shared/lena.png"), IMREAD_COLOR);
+    Mat labImg;
+    cvtColor(img, labImg, COLOR_BGR2Lab);
+    runSEEDS(labImg, false, false);
+}
+
+TEST(ximgproc_SuperpixelSEEDS, parallel_is_deterministic)
+{
+    Mat img = imread(cvtest::findDataFile("cv/shared/lena.png"), IMREAD_COLOR);
+    Mat labImg;
+    cvtColor(img, labImg, COLOR_BGR2Lab);
+    const int threads = getNumThreads();
+    setNumThreads(1);
+    Mat labelsSerial = runSEEDS(labImg, true, false);
+    setNumThreads(threads);
+    Mat labelsParallel = runSEEDS(labImg, true, false);
+    EXPECT_EQ(0, cvtest::norm(labelsSerial, labelsParallel, NORM_INF));
+}
+
+TEST(ximgproc_SuperpixelSEEDS, warm_start)
+{
+    Mat img = imread(cvtest::findDataFile("cv/shared/lena.png"), IMREAD_COLOR);
+    Mat labImg;
+    cvtColor(img, labImg, COLOR_BGR2Lab);
+    Mat labels = runSEEDS(labImg, false, false);
+    Mat labelsWarm = runSEEDS(labImg, false, true);
+    // refining the same frame must keep most of the pixels in their superpixel
+    EXPECT_GT(countNonZero(labels == labelsWarm), (int)(labImg.total() * 9 / 10));
+}
+
+}} // namespace
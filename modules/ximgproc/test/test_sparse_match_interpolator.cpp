@@ -158,6 +158,66 @@ TEST(InterpolatorTest, RICReferenceAccuracy)
     EXPECT_LE(cv::norm(res_flow, ref_flow, NORM_L1) , MAX_MEAN_DIF*res_flow.total());
 }
 
+TEST(InterpolatorTest, PreparedImage)
+{
+    string dir = getDataDir() + "cv/sparse_match_interpolator";
+
+    Mat src = imread(getDataDir() + "cv/optflow/RubberWhale1.png", IMREAD_COLOR);
+    ASSERT_FALSE(src.empty());
+
+    std::ifstream file((dir + "/RubberWhale_sparse_matches.txt").c_str());
+    float from_x, from_y, to_x, to_y;
+    vector<Point2f> from_points;
+    vector<Point2f> to_points;
+
+    while (file >> from_x >> from_y >> to_x >> to_y)
+    {
+        from_points.push_back(Point2f(from_x, from_y));
+        to_points.push_back(Point2f(to_x, to_y));
+    }
+    ASSERT_FALSE(from_points.empty());
+
+    // a second set of matches for the same image
+    vector<Point2f> from_points_half, to_points_half;
+    for (size_t i = 0; i < from_points.size(); i += 2)
+    {
+        from_points_half.push_back(from_points[i]);
+        to_points_half.push_back(to_points[i]);
+    }
+
+    Mat ref_flow, ref_flow_half, res_flow;
+
+    Ptr<EdgeAwareInterpolator> eai = createEdgeAwareInterpolator();
+    eai->interpolate(src, from_points, Mat(), to_points, ref_flow);
+    eai->interpolate(src, from_points_half, Mat(), to_points_half, ref_flow_half);
+    eai->prepare(src);
+    eai->interpolate(src, from_points, Mat(), to_points, res_flow);
+    EXPECT_EQ(0, cvtest::norm(res_flow, ref_flow, NORM_INF));
+    eai->interpolate(src, from_points_half, Mat(), to_points_half, res_flow);
+    EXPECT_EQ(0, cvtest::norm(res_flow, ref_flow_half, NORM_INF));
+
+    Ptr<RICInterpolator> ric = createRICInterpolator();
+    ric->interpolate(src, from_points, Mat(), to_points, ref_flow);
+    ric->interpolate(src, from_points_half, Mat(), to_points_half, ref_flow_half);
+    ric->prepare(src);
+    ric->interpolate(src, from_points, Mat(), to_points, res_flow);
+    EXPECT_EQ(0, cvtest::norm(res_flow, ref_flow, NORM_INF));
+    ric->interpolate(src, from_points_half, Mat(), to_points_half, res_flow);
+    EXPECT_EQ(0, cvtest::norm(res_flow, ref_flow_half, NORM_INF));
+
+    // another image of the same size must not use the data prepared for src
+    Mat other;
+    flip(src, other, 1);
+    Mat ref_flow_other;
+    createEdgeAwareInterpolator()->interpolate(other, from_points, Mat(), to_points, ref_flow_other);
+    eai->interpolate(other, from_points, Mat(), to_points, res_flow);
+    EXPECT_EQ(0, cvtest::norm(res_flow, ref_flow_other, NORM_INF));
+
+    createRICInterpolator()->interpolate(other, from_points, Mat(), to_points, ref_flow_other);
+    ric->interpolate(other, from_points, Mat(), to_points, res_flow);
+    EXPECT_EQ(0, cvtest::norm(res_flow, ref_flow_other, NORM_INF));
+}
+
 TEST_P(InterpolatorTest, MultiThreadReproducibility)
 {
     if (cv::getNumberOfCPUs() == 1)
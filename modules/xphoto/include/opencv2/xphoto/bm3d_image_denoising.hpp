@@ -109,6 +109,9 @@ namespace cv
         This function expected to be applied to grayscale images. Advanced usage of this function
         can be manual denoising of colored image in different colorspaces.
 
+        Images larger than 1024x1024 are processed in overlapping tiles, so the working memory
+        does not grow with the image size beyond the input and output images.
+
         @sa
         fastNlMeansDenoising
         */
@@ -162,6 +165,9 @@ namespace cv
         This function expected to be applied to grayscale images. Advanced usage of this function
         can be manual denoising of colored image in different colorspaces.
 
+        Images larger than 1024x1024 are processed in overlapping tiles, so the working memory
+        does not grow with the image size beyond the input and output images.
+
         @sa
         fastNlMeansDenoising
         */
@@ -0,0 +1,48 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+#ifdef OPENCV_ENABLE_NONFREE
+
+namespace opencv_test { namespace {
+
+CV_ENUM(Bm3dNormType, NORM_L2, NORM_L1)
+
+typedef tuple<Size, Bm3dNormType> Size_Bm3dNorm_t;
+typedef perf::TestBaseWithParam<Size_Bm3dNorm_t> Size_Bm3dNorm;
+
+PERF_TEST_P( Size_Bm3dNorm, bm3dDenoising,
+    testing::Values(
+        make_tuple(Size(512, 512), NORM_L2),
+        make_tuple(Size(512, 512), NORM_L1),
+        make_tuple(Size(2048, 1536), NORM_L2)
+    )
+)
+{
+    Size size = get<0>(GetParam());
+    int normType = get<1>(GetParam());
+
+    Mat original = imread(getDataPath("cv/shared/lena.png"), IMREAD_GRAYSCALE);
+    ASSERT_FALSE(original.empty());
+
+    Mat src;
+    resize(original, src, size, 0.0, 0.0, INTER_LINEAR);
+    Mat noise(size, CV_16SC1);
+    randn(noise, 0, 10);
+    src.convertTo(src, CV_16SC1);
+    add(src, noise, src);
+    src.convertTo(src, CV_8UC1);
+
+    Mat dst;
+
+    declare.in(src).out(dst);
+
+    TEST_CYCLE_N(1) xphoto::bm3dDenoising(src, dst, 10, 4, 16, 2500, 400, 8, 1, 2.0f, normType, xphoto::BM3D_STEPALL);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
+
+#endif
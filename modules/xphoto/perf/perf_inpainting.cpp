@@ -0,0 +1,73 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+CV_ENUM(InpaintFSRMode, xphoto::INPAINT_FSR_FAST, xphoto::INPAINT_FSR_BEST)
+
+typedef tuple<Size, InpaintFSRMode> Size_FSRMode_t;
+typedef perf::TestBaseWithParam<Size_FSRMode_t> Size_FSRMode;
+
+PERF_TEST_P( Size_FSRMode, inpaint_fsr,
+    testing::Values(
+        make_tuple(Size(256, 256), xphoto::INPAINT_FSR_FAST),
+        make_tuple(Size(512, 512), xphoto::INPAINT_FSR_FAST),
+        make_tuple(Size(256, 256), xphoto::INPAINT_FSR_BEST)
+    )
+)
+{
+    Size size = get<0>(GetParam());
+    int mode = get<1>(GetParam());
+
+    Mat original_ = imread(getDataPath("cv/shared/lena.png"), IMREAD_COLOR);
+    Mat mask_ = imread(getDataPath("cv/inpaint/mask.png"), IMREAD_GRAYSCALE);
+    ASSERT_FALSE(original_.empty());
+    ASSERT_FALSE(mask_.empty());
+
+    Mat original, mask;
+    resize(original_, original, size, 0.0, 0.0, INTER_AREA);
+    resize(mask_, mask, size, 0.0, 0.0, INTER_NEAREST);
+
+    Mat mask_valid = (mask == 0);
+    Mat im_distorted(size, original.type(), Scalar::all(0));
+    original.copyTo(im_distorted, mask_valid);
+    Mat reconstructed;
+
+    declare.in(im_distorted, mask_valid).out(reconstructed);
+
+    TEST_CYCLE_N(1) xphoto::inpaint(im_distorted, mask_valid, reconstructed, mode);
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef perf::TestBaseWithParam<Size> InpaintShiftMap;
+
+PERF_TEST_P( InpaintShiftMap, inpaint_shiftmap, testing::Values(Size(128, 128), Size(256, 256)) )
+{
+    Size size = GetParam();
+
+    Mat original_ = imread(getDataPath("cv/shared/lena.png"), IMREAD_COLOR);
+    Mat mask_ = imread(getDataPath("cv/inpaint/mask.png"), IMREAD_GRAYSCALE);
+    ASSERT_FALSE(original_.empty());
+    ASSERT_FALSE(mask_.empty());
+
+    Mat original, mask, lab;
+    resize(original_, original, size, 0.0, 0.0, INTER_AREA);
+    resize(mask_, mask, size, 0.0, 0.0, INTER_NEAREST);
+    cvtColor(original, lab, COLOR_BGR2Lab);
+
+    Mat mask_valid = (mask == 0);
+    Mat im_distorted(size, lab.type(), Scalar::all(0));
+    lab.copyTo(im_distorted, mask_valid);
+    Mat reconstructed;
+
+    declare.in(im_distorted, mask_valid).out(reconstructed);
+
+    TEST_CYCLE_N(1) xphoto::inpaint(im_distorted, mask_valid, reconstructed, xphoto::INPAINT_SHIFTMAP);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
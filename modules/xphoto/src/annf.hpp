@@ -76,10 +76,7 @@ private:
     public:
         bool operator () (const int &x, const int &y) const
         {
-            cv::Vec <Tp, cn> u = main->data[main->idx[x]];
-            cv::Vec <Tp, cn> v = main->data[main->idx[y]];
-
-            return  u[dimIdx] < v[dimIdx];
+            return main->data[x][dimIdx] < main->data[y][dimIdx];
         }
 
         KDTreeComparator(const KDTree <Tp, cn> *_main, int _dimIdx)
@@ -90,15 +87,20 @@ private:
     const int leafNumber; // maximum number of point per leaf
     const int zeroThresh; // radius of prohibited shifts
 
-    std::vector <cv::Vec <Tp, cn> > data;
-    std::vector <int> idx;
-    std::vector <cv::Point2i> nodes;
+    std::vector <cv::Vec <Tp, cn> > data;  // points in image order
+    std::vector <int> idx;                 // image index of the points in leaf order
+    std::vector <cv::Point2i> nodes;       // leaf range of each point
+
+    /** flat copies of the points and their coordinates in leaf order,
+        so that a leaf is scanned as a contiguous block **/
+    std::vector <cv::Vec <Tp, cn> > leafData;
+    std::vector <cv::Point2i> leafPos;
 
     int getMaxSpreadN(const int left, const int right) const;
     void operator =(const KDTree <Tp, cn> &) const {};
 
 public:
-    void updateDist(const int leaf, const int &idx0, int &bestIdx, double &dist);
+    void updateDist(const int leaf, const int &idx0, int &bestIdx, double &dist) const;
 
     KDTree(const cv::Mat &data, const int leafNumber = 8, const int zeroThresh = 16);
     ~KDTree(){};
@@ -111,11 +113,14 @@ getMaxSpreadN(const int left, const int right) const
                     minValue = data[ idx[left] ];
 
     for (int i = left + 1; i < right; ++i)
+    {
+        const cv::Vec<Tp, cn> &v = data[ idx[i] ];
         for (int j = 0; j < cn; ++j)
         {
-            minValue[j] = std::min( minValue[j], data[idx[i]][j] );
-            maxValue[j] = std::max( maxValue[j], data[idx[i]][j] );
+            minValue[j] = std::min( minValue[j], v[j] );
+            maxValue[j] = std::max( maxValue[j], v[j] );
         }
+    }
     cv::Vec<Tp, cn> spread = maxValue - minValue;
 
     Tp *begIt = &spread[0];
@@ -131,6 +136,7 @@ KDTree(const cv::Mat &img, const int _leafNumber, const int _zeroThresh)
     int imgch = img.channels();
     CV_Assert( img.isContinuous() && imgch <= cn);
 
+    data.resize( img.total() );
     for(size_t i = 0; i < img.total(); i++)
     {
         cv::Vec<Tp, cn> v = cv::Vec<Tp, cn>::all((Tp)0);
@@ -138,12 +144,12 @@ KDTree(const cv::Mat &img, const int _leafNumber, const int _zeroThresh)
         {
             v[c] = *((Tp*)(img.data) + i*imgch + c);
         }
-        data.push_back(v);
+        data[i] = v;
     }
 
-    generate_seq( std::back_inserter(idx), 0, int(data.size()) );
-    std::fill_n( std::back_inserter(nodes),
-        int(data.size()), cv::Point2i(0, 0) );
+    idx.resize( data.size() );
+    generate_seq( idx.begin(), 0, int(data.size()) );
+    nodes.assign( data.size(), cv::Point2i(0, 0) );
 
     std::stack <int> left, right;
     left.push( 0 );
@@ -166,26 +172,34 @@ KDTree(const cv::Mat &img, const int _leafNumber, const int _zeroThresh)
         int dimIdx = getMaxSpreadN(_left, _right);
         KDTreeComparator comp( this, dimIdx );
 
-        std::vector<int> _idx(idx.begin(), idx.end());
         std::nth_element(/**/
-            _idx.begin() +  _left,
-            _idx.begin() +    nth,
-            _idx.begin() + _right, comp
+            idx.begin() +  _left,
+            idx.begin() +    nth,
+            idx.begin() + _right, comp
                          /**/);
-        idx = _idx;
 
           left.push(_left); right.push(nth + 1);
         left.push(nth + 1);  right.push(_right);
     }
+
+    leafData.resize( idx.size() );
+    leafPos.resize( idx.size() );
+    for (size_t k = 0; k < idx.size(); ++k)
+    {
+        leafData[k] = data[ idx[k] ];
+        leafPos[k] = cv::Point2i( idx[k]%width, idx[k]/width );
+    }
 }
 
 template <typename Tp, int cn> void KDTree <Tp, cn>::
-updateDist(const int leaf, const int &idx0, int &bestIdx, double &dist)
+updateDist(const int leaf, const int &idx0, int &bestIdx, double &dist) const
 {
+    const int y = idx0/width, x = idx0%width;
+    const cv::Vec <Tp, cn> &query = data[idx0];
+
     for (int k = nodes[leaf].x; k < nodes[leaf].y; ++k)
     {
-        int y = idx0/width, ny = idx[k]/width;
-        int x = idx0%width, nx = idx[k]%width;
+        int nx = leafPos[k].x, ny = leafPos[k].y;
 
         if (abs(ny - y) < zeroThresh &&
             abs(nx - x) < zeroThresh)
@@ -194,7 +208,7 @@ updateDist(const int leaf, const int &idx0, int &bestIdx, double &dist)
             ny >= height - 1 || ny < 1 )
             continue;
 
-        double ndist = norm2(data[idx0], data[idx[k]]);
+        double ndist = norm2(query, leafData[k]);
 
         if (ndist < dist)
         {
@@ -231,26 +245,60 @@ static void dominantTransforms(const cv::Mat &img, std::vector <cv::Point2i> &tr
 
     KDTree <float, 24> kdTree(whs, leafNum, zeroThresh);
     std::vector <int> annf( whs.total(), 0 );
+    std::vector <double> annfDist( whs.total(), std::numeric_limits <double>::max() );
 
     /** Propagation-assisted kd-tree search **/
 
-    for (int i = 0; i < whs.rows; ++i)
-        for (int j = 0; j < whs.cols; ++j)
+    // The rows are split into bands of fixed height, so the result
+    // does not depend on the number of threads. Each band is scanned
+    // independently, then the first row of every band is refined by
+    // propagation from the last row of the band above.
+    const int bandHeight = 32;
+    const int nBands = (whs.rows + bandHeight - 1)/bandHeight;
+    const int cols = whs.cols;
+
+    cv::parallel_for_(cv::Range(0, nBands), [&](const cv::Range &range)
+    {
+        for (int b = range.start; b < range.end; ++b)
         {
-            double dist = std::numeric_limits <double>::max();
-            int current = i*whs.cols + j;
+            int rowStart = b*bandHeight, rowEnd = std::min(rowStart + bandHeight, whs.rows);
 
-            int dy[] = {0, 1, 0}, dx[] = {0, 0, 1};
-            for (int k = 0; k < int( sizeof(dy)/sizeof(int) ); ++k)
-                if ( i - dy[k] >= 0 && j - dx[k] >= 0 )
+            for (int i = rowStart; i < rowEnd; ++i)
+                for (int j = 0; j < cols; ++j)
                 {
-                    int neighbor = (i - dy[k])*whs.cols + (j - dx[k]);
-                    int leafIdx = (dx[k] == 0 && dy[k] == 0)
-                        ? neighbor : annf[neighbor] + dy[k]*whs.cols + dx[k];
-                    kdTree.updateDist(leafIdx, current,
-                                annf[i*whs.cols + j], dist);
+                    int current = i*cols + j;
+                    double &dist = annfDist[current];
+
+                    int dy[] = {0, 1, 0}, dx[] = {0, 0, 1};
+                    for (int k = 0; k < int( sizeof(dy)/sizeof(int) ); ++k)
+                        if ( i - dy[k] >= rowStart && j - dx[k] >= 0 )
+                        {
+                            int neighbor = (i - dy[k])*cols + (j - dx[k]);
+                            int leafIdx = (dx[k] == 0 && dy[k] == 0)
+                                ? neighbor : annf[neighbor] + dy[k]*cols + dx[k];
+                            kdTree.updateDist(leafIdx, current, annf[current], dist);
+                        }
                 }
         }
+    });
+
+    cv::parallel_for_(cv::Range(1, nBands), [&](const cv::Range &range)
+    {
+        for (int b = range.start; b < range.end; ++b)
+        {
+            int i = b*bandHeight;
+
+            for (int j = 0; j < cols; ++j)
+            {
+                int current = i*cols + j;
+                double &dist = annfDist[current];
+
+                kdTree.updateDist(annf[current - cols] + cols, current, annf[current], dist);
+                if (j > 0)
+                    kdTree.updateDist(annf[current - 1] + 1, current, annf[current], dist);
+            }
+        }
+    });
 
     /** Local maxima extraction **/
 
@@ -43,6 +43,7 @@
 #define __OPENCV_BM3D_DENOISING_INVOKER_COMMONS_HPP__
 
 #include "bm3d_denoising_invoker_structs.hpp"
+#include "bm3d_denoising_transforms_1D.hpp"
 
 // std::isnan is a part of C++11 and it is not supported in MSVS2010/2012
 #if defined _MSC_VER && _MSC_VER < 1800 /* MSVC 2013 */
@@ -74,6 +75,55 @@ inline bool isPowerOf2(int x)
     return (x > 0) && !(x & (x - 1));
 }
 
+#if CV_SIMD128
+inline static v_int32x4 v_load_expand_bm3d(const uchar *ptr)
+{
+    return v_reinterpret_as_s32(v_load_expand_q(ptr));
+}
+
+inline static v_int32x4 v_load_expand_bm3d(const ushort *ptr)
+{
+    return v_reinterpret_as_s32(v_load_expand(ptr));
+}
+#endif
+
+// Moves the block matching distances of one row of the search window one pixel
+// to the right: the column sum that leaves the block is replaced by the new one,
+// which is in turn updated from the column sum of the row above.
+template <typename D, typename T>
+inline static void updateDistSumsRow(
+    int *distSumsRow,
+    int *colDistSumsRow,
+    int *lastColDistSumsRow,
+    const T &a_up,
+    const T &a_down,
+    const T *b_up_ptr,
+    const T *b_down_ptr,
+    const int &searchWindowSize)
+{
+    int x = 0;
+#if CV_SIMD128
+    const v_int32x4 v_a_up = v_setall_s32((int)a_up);
+    const v_int32x4 v_a_down = v_setall_s32((int)a_down);
+    for (; x <= searchWindowSize - 4; x += 4)
+    {
+        v_int32x4 v_colDistSums = v_load(lastColDistSumsRow + x) + D::v_calcUpDownDist(
+            v_a_up, v_a_down, v_load_expand_bm3d(b_up_ptr + x), v_load_expand_bm3d(b_down_ptr + x));
+
+        v_store(distSumsRow + x, v_load(distSumsRow + x) - v_load(colDistSumsRow + x) + v_colDistSums);
+        v_store(colDistSumsRow + x, v_colDistSums);
+        v_store(lastColDistSumsRow + x, v_colDistSums);
+    }
+#endif
+    for (; x < searchWindowSize; x++)
+    {
+        distSumsRow[x] -= colDistSumsRow[x];
+        colDistSumsRow[x] = lastColDistSumsRow[x] +
+            D::template calcUpDownDist<T>(a_up, a_down, b_up_ptr[x], b_down_ptr[x]);
+        distSumsRow[x] += colDistSumsRow[x];
+        lastColDistSumsRow[x] = colDistSumsRow[x];
+    }
+}
 
 template <typename T>
 inline static void shrink(T &val, T &nonZeroCount, const T &threshold)
@@ -116,6 +166,41 @@ inline static T HardThreshold(BlockMatch<T, DT, CT> *z, const int &n, T *&thrMap
     return nonZeroCount;
 }
 
+// Forward 1D transform, hard thresholding and inverse 1D transform of a group of N
+// blocks for all the blockSizeSq coefficients. Coefficients are processed several
+// at once when a vectorized transform is available for the type.
+template <int N, typename T, typename DT, typename CT>
+inline static T HardThresholdGroup(
+    BlockMatch<T, DT, CT> *z,
+    const int &blockSizeSq,
+    T *&thrMap,
+    void (*forwardTransform)(BlockMatch<T, DT, CT> *, const int &),
+    void (*inverseTransform)(BlockMatch<T, DT, CT> *, const int &))
+{
+    typedef HaarTransform1DLanes<T, N> Lanes;
+    T nonZeroCount = 0;
+
+    int n = 0;
+    if (Lanes::width > 0)
+    {
+        for (; n <= blockSizeSq - (int)Lanes::width; n += Lanes::width)
+        {
+            Lanes::forward(z, n);
+            for (int k = 0; k < (int)Lanes::width; ++k)
+                nonZeroCount += HardThreshold<N>(z, n + k, thrMap);
+            Lanes::inverse(z, n);
+        }
+    }
+    for (; n < blockSizeSq; ++n)
+    {
+        forwardTransform(z, n);
+        nonZeroCount += HardThreshold<N>(z, n, thrMap);
+        inverseTransform(z, n);
+    }
+
+    return nonZeroCount;
+}
+
 template <int N, typename T, typename DT, typename CT>
 inline static int WienerFiltering(BlockMatch<T, DT, CT> *zSrc, BlockMatch<T, DT, CT> *zBasic, const int &n, T *&thrMap)
 {
@@ -159,6 +244,43 @@ inline static int WienerFiltering(BlockMatch<T, DT, CT> *zSrc, BlockMatch<T, DT,
 }
 
 
+// Same as HardThresholdGroup, but applies Wiener filtering of the basic estimate
+// using the transformed source blocks.
+template <int N, typename T, typename DT, typename CT>
+inline static int WienerFilteringGroup(
+    BlockMatch<T, DT, CT> *zSrc,
+    BlockMatch<T, DT, CT> *zBasic,
+    const int &blockSizeSq,
+    T *&thrMap,
+    void (*forwardTransform)(BlockMatch<T, DT, CT> *, const int &),
+    void (*inverseTransform)(BlockMatch<T, DT, CT> *, const int &))
+{
+    typedef HaarTransform1DLanes<T, N> Lanes;
+    int wienerCoeffs = 0;
+
+    int n = 0;
+    if (Lanes::width > 0)
+    {
+        for (; n <= blockSizeSq - (int)Lanes::width; n += Lanes::width)
+        {
+            Lanes::forward(zSrc, n);
+            Lanes::forward(zBasic, n);
+            for (int k = 0; k < (int)Lanes::width; ++k)
+                wienerCoeffs += WienerFiltering<N>(zSrc, zBasic, n + k, thrMap);
+            Lanes::inverse(zBasic, n);
+        }
+    }
+    for (; n < blockSizeSq; ++n)
+    {
+        forwardTransform(zSrc, n);
+        forwardTransform(zBasic, n);
+        wienerCoeffs += WienerFiltering<N>(zSrc, zBasic, n, thrMap);
+        inverseTransform(zBasic, n);
+    }
+
+    return wienerCoeffs;
+}
+
 }  // namespace xphoto
 }  // namespace cv
 
@@ -255,21 +255,16 @@ void Bm3dDenoisingInvokerStep1<T, D, WT, TT, TC>::operator() (const Range& range
                         int *colDistSumsRow = colDistSums.row_ptr(firstColNum, y);
                         int *lastColDistSumsRow = lastColDistSums.row_ptr(i, y);
 
-                        const T *b_up_ptr = srcExtended_.ptr<T>(start_by + y);
-                        const T *b_down_ptr = srcExtended_.ptr<T>(start_by + y + blockSize);
+                        const T *b_up_ptr = srcExtended_.ptr<T>(start_by + y) + start_bx;
+                        const T *b_down_ptr = srcExtended_.ptr<T>(start_by + y + blockSize) + start_bx;
+
+                        // Remove from current pixel sum column sum with index "firstColNum"
+                        // and add the updated one
+                        updateDistSumsRow<D, T>(distSumsRow, colDistSumsRow, lastColDistSumsRow,
+                            a_up, a_down, b_up_ptr, b_down_ptr, searchWindowSize);
 
                         for (TT x = 0; x < searchWindowSize; x++)
                         {
-                            // Remove from current pixel sum column sum with index "firstColNum"
-                            distSumsRow[x] -= colDistSumsRow[x];
-
-                            const int bx = start_bx + x;
-                            colDistSumsRow[x] = lastColDistSumsRow[x] +
-                                D::template calcUpDownDist<T>(a_up, a_down, b_up_ptr[bx], b_down_ptr[bx]);
-
-                            distSumsRow[x] += colDistSumsRow[x];
-                            lastColDistSumsRow[x] = colDistSumsRow[x];
-
                             if (x == halfSearchWindowSize && y == halfSearchWindowSize)
                                 continue;
 
@@ -304,28 +299,16 @@ void Bm3dDenoisingInvokerStep1<T, D, WT, TT, TC>::operator() (const Range& range
             switch (elementSize)
             {
             case 16:
-                for (int n = 0; n < blockSizeSq; n++)
-                {
-                    TC::forwardTransform16(bm, n);
-                    sumNonZero += HardThreshold<16>(bm, n, thrMapPtr1D);
-                    TC::inverseTransform16(bm, n);
-                }
+                sumNonZero += HardThresholdGroup<16>(
+                    bm, blockSizeSq, thrMapPtr1D, TC::forwardTransform16, TC::inverseTransform16);
                 break;
             case 8:
-                for (int n = 0; n < blockSizeSq; n++)
-                {
-                    TC::forwardTransform8(bm, n);
-                    sumNonZero += HardThreshold<8>(bm, n, thrMapPtr1D);
-                    TC::inverseTransform8(bm, n);
-                }
+                sumNonZero += HardThresholdGroup<8>(
+                    bm, blockSizeSq, thrMapPtr1D, TC::forwardTransform8, TC::inverseTransform8);
                 break;
             case 4:
-                for (int n = 0; n < blockSizeSq; n++)
-                {
-                    TC::forwardTransform4(bm, n);
-                    sumNonZero += HardThreshold<4>(bm, n, thrMapPtr1D);
-                    TC::inverseTransform4(bm, n);
-                }
+                sumNonZero += HardThresholdGroup<4>(
+                    bm, blockSizeSq, thrMapPtr1D, TC::forwardTransform4, TC::inverseTransform4);
                 break;
             case 2:
                 for (int n = 0; n < blockSizeSq; n++)
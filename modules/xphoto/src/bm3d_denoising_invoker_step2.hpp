@@ -267,21 +267,16 @@ void Bm3dDenoisingInvokerStep2<T, D, WT, TT, TC>::operator() (const Range& range
                         int *colDistSumsRow = colDistSums.row_ptr(firstColNum, y);
                         int *lastColDistSumsRow = lastColDistSums.row_ptr(i, y);
 
-                        const T *b_up_ptr = basicExtended_.ptr<T>(start_by + y);
-                        const T *b_down_ptr = basicExtended_.ptr<T>(start_by + y + blockSize);
+                        const T *b_up_ptr = basicExtended_.ptr<T>(start_by + y) + start_bx;
+                        const T *b_down_ptr = basicExtended_.ptr<T>(start_by + y + blockSize) + start_bx;
+
+                        // Remove from current pixel sum column sum with index "firstColNum"
+                        // and add the updated one
+                        updateDistSumsRow<D, T>(distSumsRow, colDistSumsRow, lastColDistSumsRow,
+                            a_up, a_down, b_up_ptr, b_down_ptr, searchWindowSize);
 
                         for (TT x = 0; x < searchWindowSize; x++)
                         {
-                            // Remove from current pixel sum column sum with index "firstColNum"
-                            distSumsRow[x] -= colDistSumsRow[x];
-
-                            const int bx = start_bx + x;
-                            colDistSumsRow[x] = lastColDistSumsRow[x] +
-                                D::template calcUpDownDist<T>(a_up, a_down, b_up_ptr[bx], b_down_ptr[bx]);
-
-                            distSumsRow[x] += colDistSumsRow[x];
-                            lastColDistSumsRow[x] = colDistSumsRow[x];
-
                             if (x == halfSearchWindowSize && y == halfSearchWindowSize)
                                 continue;
 
@@ -318,31 +313,16 @@ void Bm3dDenoisingInvokerStep2<T, D, WT, TT, TC>::operator() (const Range& range
             switch (elementSize)
             {
             case 16:
-                for (int n = 0; n < blockSizeSq; n++)
-                {
-                    TC::forwardTransform16(bmSrc, n);
-                    TC::forwardTransform16(bmBasic, n);
-                    wienerCoefficients += WienerFiltering<16>(bmSrc, bmBasic, n, thrMapPtr1D);
-                    TC::inverseTransform16(bmBasic, n);
-                }
+                wienerCoefficients += WienerFilteringGroup<16>(
+                    bmSrc, bmBasic, blockSizeSq, thrMapPtr1D, TC::forwardTransform16, TC::inverseTransform16);
                 break;
             case 8:
-                for (int n = 0; n < blockSizeSq; n++)
-                {
-                    TC::forwardTransform8(bmSrc, n);
-                    TC::forwardTransform8(bmBasic, n);
-                    wienerCoefficients += WienerFiltering<8>(bmSrc, bmBasic, n, thrMapPtr1D);
-                    TC::inverseTransform8(bmBasic, n);
-                }
+                wienerCoefficients += WienerFilteringGroup<8>(
+                    bmSrc, bmBasic, blockSizeSq, thrMapPtr1D, TC::forwardTransform8, TC::inverseTransform8);
                 break;
             case 4:
-                for (int n = 0; n < blockSizeSq; n++)
-                {
-                    TC::forwardTransform4(bmSrc, n);
-                    TC::forwardTransform4(bmBasic, n);
-                    wienerCoefficients += WienerFiltering<4>(bmSrc, bmBasic, n, thrMapPtr1D);
-                    TC::inverseTransform4(bmBasic, n);
-                }
+                wienerCoefficients += WienerFilteringGroup<4>(
+                    bmSrc, bmBasic, blockSizeSq, thrMapPtr1D, TC::forwardTransform4, TC::inverseTransform4);
                 break;
             case 2:
                 for (int n = 0; n < blockSizeSq; n++)
@@ -42,6 +42,9 @@
 #ifndef __OPENCV_BM3D_DENOISING_TRANSFORMS_1D_HPP__
 #define __OPENCV_BM3D_DENOISING_TRANSFORMS_1D_HPP__
 
+#include "opencv2/core/hal/intrin.hpp"
+#include "bm3d_denoising_invoker_structs.hpp"
+
 namespace cv
 {
 namespace xphoto
@@ -370,6 +373,203 @@ public:
     }
 };
 
+/// 1D transformations of fixed array size applied to several adjacent coefficients
+/// of the group at once. The generic version processes nothing (width is zero), so
+/// the callers fall back to the scalar transforms above.
+template <typename T, int N>
+struct HaarTransform1DLanes
+{
+    enum { width = 0 };
+
+    template <typename DT, typename CT>
+    inline static void forward(BlockMatch<T, DT, CT> * /*z*/, const int & /*n*/) {}
+
+    template <typename DT, typename CT>
+    inline static void inverse(BlockMatch<T, DT, CT> * /*z*/, const int & /*n*/) {}
+};
+
+#if CV_SIMD128
+
+// (a + b + 1) >> 1, (a + b) >> 1 and (a - b) >> 1 computed without leaving 16 bits,
+// bit-exact with the same expressions evaluated in int and stored as short.
+inline v_int16x8 v_haarSumRound(const v_int16x8 &a, const v_int16x8 &b)
+{
+    return v_add_wrap(v_add_wrap(a >> 1, b >> 1), (a | b) & v_setall_s16(1));
+}
+
+inline v_int16x8 v_haarHalf(const v_int16x8 &a, const v_int16x8 &b)
+{
+    return v_add_wrap(v_add_wrap(a >> 1, b >> 1), (a & b) & v_setall_s16(1));
+}
+
+inline v_int16x8 v_haarHalfDiff(const v_int16x8 &a, const v_int16x8 &b)
+{
+    return v_sub_wrap(v_sub_wrap(a >> 1, b >> 1), (b & ~a) & v_setall_s16(1));
+}
+
+template <>
+struct HaarTransform1DLanes<short, 4>
+{
+    enum { width = 8 };
+
+    template <typename DT, typename CT>
+    inline static void forward(BlockMatch<short, DT, CT> *z, const int &n)
+    {
+        v_int16x8 z0 = v_load(z[0].data() + n), z1 = v_load(z[1].data() + n);
+        v_int16x8 z2 = v_load(z[2].data() + n), z3 = v_load(z[3].data() + n);
+
+        v_int16x8 sum0 = v_haarSumRound(z0, z1);
+        v_int16x8 sum1 = v_haarSumRound(z2, z3);
+
+        v_store(z[0].data() + n, v_haarSumRound(sum0, sum1));
+        v_store(z[1].data() + n, v_sub_wrap(sum0, sum1));
+        v_store(z[2].data() + n, v_sub_wrap(z0, z1));
+        v_store(z[3].data() + n, v_sub_wrap(z2, z3));
+    }
+
+    template <typename DT, typename CT>
+    inline static void inverse(BlockMatch<short, DT, CT> *z, const int &n)
+    {
+        v_int16x8 src0 = v_load(z[0].data() + n) << 1;
+        v_int16x8 src1 = v_load(z[1].data() + n);
+        v_int16x8 src2 = v_load(z[2].data() + n);
+        v_int16x8 src3 = v_load(z[3].data() + n);
+
+        v_int16x8 sum0 = v_add_wrap(src0, src1);
+        v_int16x8 dif0 = v_sub_wrap(src0, src1);
+
+        v_store(z[0].data() + n, v_haarHalf(sum0, src2));
+        v_store(z[1].data() + n, v_haarHalfDiff(sum0, src2));
+        v_store(z[2].data() + n, v_haarHalf(dif0, src3));
+        v_store(z[3].data() + n, v_haarHalfDiff(dif0, src3));
+    }
+};
+
+template <>
+struct HaarTransform1DLanes<short, 8>
+{
+    enum { width = 8 };
+
+    template <typename DT, typename CT>
+    inline static void forward(BlockMatch<short, DT, CT> *z, const int &n)
+    {
+        v_int16x8 src[8];
+        for (int i = 0; i < 8; ++i)
+            src[i] = v_load(z[i].data() + n);
+
+        v_int16x8 sum[4];
+        for (int i = 0; i < 4; ++i)
+        {
+            sum[i] = v_haarSumRound(src[2 * i], src[2 * i + 1]);
+            v_store(z[4 + i].data() + n, v_sub_wrap(src[2 * i], src[2 * i + 1]));
+        }
+
+        v_int16x8 sum00 = v_haarSumRound(sum[0], sum[1]);
+        v_int16x8 sum11 = v_haarSumRound(sum[2], sum[3]);
+
+        v_store(z[0].data() + n, v_haarSumRound(sum00, sum11));
+        v_store(z[1].data() + n, v_sub_wrap(sum00, sum11));
+        v_store(z[2].data() + n, v_sub_wrap(sum[0], sum[1]));
+        v_store(z[3].data() + n, v_sub_wrap(sum[2], sum[3]));
+    }
+
+    template <typename DT, typename CT>
+    inline static void inverse(BlockMatch<short, DT, CT> *z, const int &n)
+    {
+        v_int16x8 src[8];
+        for (int i = 0; i < 8; ++i)
+            src[i] = v_load(z[i].data() + n);
+        src[0] = src[0] << 1;
+
+        v_int16x8 sum0 = v_add_wrap(src[0], src[1]);
+        v_int16x8 dif0 = v_sub_wrap(src[0], src[1]);
+
+        v_int16x8 half[4];
+        half[0] = v_add_wrap(sum0, src[2]);
+        half[1] = v_sub_wrap(sum0, src[2]);
+        half[2] = v_add_wrap(dif0, src[3]);
+        half[3] = v_sub_wrap(dif0, src[3]);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            v_store(z[2 * i].data() + n, v_haarHalf(half[i], src[4 + i]));
+            v_store(z[2 * i + 1].data() + n, v_haarHalfDiff(half[i], src[4 + i]));
+        }
+    }
+};
+
+template <>
+struct HaarTransform1DLanes<short, 16>
+{
+    enum { width = 8 };
+
+    template <typename DT, typename CT>
+    inline static void forward(BlockMatch<short, DT, CT> *z, const int &n)
+    {
+        v_int16x8 src[16];
+        for (int i = 0; i < 16; ++i)
+            src[i] = v_load(z[i].data() + n);
+
+        v_int16x8 sum[8];
+        for (int i = 0; i < 8; ++i)
+        {
+            sum[i] = v_haarSumRound(src[2 * i], src[2 * i + 1]);
+            v_store(z[8 + i].data() + n, v_sub_wrap(src[2 * i], src[2 * i + 1]));
+        }
+
+        v_int16x8 sum2[4];
+        for (int i = 0; i < 4; ++i)
+        {
+            sum2[i] = v_haarSumRound(sum[2 * i], sum[2 * i + 1]);
+            v_store(z[4 + i].data() + n, v_sub_wrap(sum[2 * i], sum[2 * i + 1]));
+        }
+
+        v_int16x8 sum000 = v_haarSumRound(sum2[0], sum2[1]);
+        v_int16x8 sum111 = v_haarSumRound(sum2[2], sum2[3]);
+        v_int16x8 dif000 = v_sub_wrap(sum2[0], sum2[1]);
+        v_int16x8 dif111 = v_sub_wrap(sum2[2], sum2[3]);
+
+        // Same coefficients as the scalar ForwardTransform16
+        v_store(z[0].data() + n, v_haarSumRound(sum000, sum111));
+        v_store(z[1].data() + n, v_sub_wrap(dif000, dif111));
+        v_store(z[2].data() + n, dif000);
+        v_store(z[3].data() + n, dif111);
+    }
+
+    template <typename DT, typename CT>
+    inline static void inverse(BlockMatch<short, DT, CT> *z, const int &n)
+    {
+        v_int16x8 src[16];
+        for (int i = 0; i < 16; ++i)
+            src[i] = v_load(z[i].data() + n);
+        src[0] = src[0] << 1;
+
+        v_int16x8 sum0 = v_add_wrap(src[0], src[1]);
+        v_int16x8 dif0 = v_sub_wrap(src[0], src[1]);
+
+        v_int16x8 half2[4];
+        half2[0] = v_add_wrap(sum0, src[2]);
+        half2[1] = v_sub_wrap(sum0, src[2]);
+        half2[2] = v_add_wrap(dif0, src[3]);
+        half2[3] = v_sub_wrap(dif0, src[3]);
+
+        v_int16x8 half3[8];
+        for (int i = 0; i < 4; ++i)
+        {
+            half3[2 * i] = v_add_wrap(half2[i], src[4 + i]);
+            half3[2 * i + 1] = v_sub_wrap(half2[i], src[4 + i]);
+        }
+
+        for (int i = 0; i < 8; ++i)
+        {
+            v_store(z[2 * i].data() + n, v_haarHalf(half3[i], src[8 + i]));
+            v_store(z[2 * i + 1].data() + n, v_haarHalfDiff(half3[i], src[8 + i]));
+        }
+    }
+};
+
+#endif
+
 }  // namespace xphoto
 }  // namespace cv
 
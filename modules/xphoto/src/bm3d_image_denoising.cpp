@@ -57,6 +57,27 @@ namespace xphoto
 
 #ifdef OPENCV_ENABLE_NONFREE
 
+// Images larger than this are denoised tile by tile, so the extended copies of
+// the source and the basic estimate kept by the invokers are bounded by the tile
+// size instead of the image size.
+static const int BM3D_TILE_SIZE = 1024;
+
+// Calls fn(roi, tile) for every tile of the image. The roi is the tile extended by
+// the margin, the result of the roi is only kept inside the tile.
+template <typename Fn>
+static void forEachBm3dTile(const Size& size, const int &tileSize, const int &margin, Fn fn)
+{
+    for (int y = 0; y < size.height; y += tileSize)
+    {
+        for (int x = 0; x < size.width; x += tileSize)
+        {
+            Rect tile(x, y, std::min(tileSize, size.width - x), std::min(tileSize, size.height - y));
+            Rect roi(tile.tl() - Point(margin, margin), tile.br() + Point(margin, margin));
+            fn(roi & Rect(Point(0, 0), size), tile);
+        }
+    }
+}
+
 template<typename ST, typename D, typename TT>
 static void bm3dDenoising_(
     const Mat& src,
@@ -72,40 +93,65 @@ static void bm3dDenoising_(
     const float &beta,
     const int &step)
 {
-    double granularity = (double)std::max(1., (double)src.total() / (1 << 16));
+    // Patches matched from a reference up to half the search window away are aggregated,
+    // so the tiles are extended by that much to get the same pixels near the tile borders.
+    // Both sizes are multiples of the sliding step to keep the reference grid aligned.
+    const int margin = (searchWindowSize / 2 + templateWindowSize + slidingStep - 1) / slidingStep * slidingStep;
+    const int tileSize = std::max(slidingStep, BM3D_TILE_SIZE / slidingStep * slidingStep);
 
     switch (CV_MAT_CN(src.type())) {
     case 1:
         if (step == BM3D_STEP1 || step == BM3D_STEPALL)
         {
-            parallel_for_(cv::Range(0, src.rows),
-                Bm3dDenoisingInvokerStep1<ST, D, float, TT, HaarTransform<ST, TT> >(
-                    src,
-                    basic,
-                    templateWindowSize,
-                    searchWindowSize,
-                    h,
-                    hBMStep1,
-                    groupSize,
-                    slidingStep,
-                    beta),
-                granularity);
+            forEachBm3dTile(src.size(), tileSize, margin, [&](const Rect& roi, const Rect& tile)
+            {
+                Mat srcRoi = src(roi);
+                Mat basicRoi = (roi == tile) ? basic(roi) : Mat(roi.size(), basic.type());
+                double granularity = (double)std::max(1., (double)roi.area() / (1 << 16));
+
+                parallel_for_(cv::Range(0, roi.height),
+                    Bm3dDenoisingInvokerStep1<ST, D, float, TT, HaarTransform<ST, TT> >(
+                        srcRoi,
+                        basicRoi,
+                        templateWindowSize,
+                        searchWindowSize,
+                        h,
+                        hBMStep1,
+                        groupSize,
+                        slidingStep,
+                        beta),
+                    granularity);
+
+                if (roi != tile)
+                    basicRoi(tile - roi.tl()).copyTo(basic(tile));
+            });
         }
         if (step == BM3D_STEP2 || step == BM3D_STEPALL)
         {
-            parallel_for_(cv::Range(0, src.rows),
-                Bm3dDenoisingInvokerStep2<ST, D, float, TT, HaarTransform<ST, TT> >(
-                    src,
-                    basic,
-                    dst,
-                    templateWindowSize,
-                    searchWindowSize,
-                    h,
-                    hBMStep2,
-                    groupSize,
-                    slidingStep,
-                    beta),
-                granularity);
+            forEachBm3dTile(src.size(), tileSize, margin, [&](const Rect& roi, const Rect& tile)
+            {
+                Mat srcRoi = src(roi);
+                Mat basicRoi = basic(roi);
+                Mat dstRoi = (roi == tile) ? dst(roi) : Mat(roi.size(), dst.type());
+                double granularity = (double)std::max(1., (double)roi.area() / (1 << 16));
+
+                parallel_for_(cv::Range(0, roi.height),
+                    Bm3dDenoisingInvokerStep2<ST, D, float, TT, HaarTransform<ST, TT> >(
+                        srcRoi,
+                        basicRoi,
+                        dstRoi,
+                        templateWindowSize,
+                        searchWindowSize,
+                        h,
+                        hBMStep2,
+                        groupSize,
+                        slidingStep,
+                        beta),
+                    granularity);
+
+                if (roi != tile)
+                    dstRoi(tile - roi.tl()).copyTo(dst(tile));
+            });
         }
         break;
     default:
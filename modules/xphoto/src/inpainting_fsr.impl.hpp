@@ -92,10 +92,67 @@ icvStandardDeviation(const Mat& distorted_block_2d, const Mat& error_mask_2d) {
     return sigma_n;
 }
 
+// buffers of icvExtrapolateBlock, kept per thread so that the blocks do not reallocate their DFT planes
+struct fsr_scratch
+{
+    Mat w, W, W_padded, f, fw, Rw_full, G, g;
+    std::vector<Mat> Rw_channels;
+    Mat Rw_mag, projection_distances;
+};
+
+// frequency weighting of the projection distances, it only depends on the fft size
+static void
+icvFrequencyWeighting(int fft_size, Mat& frequency_weighting)
+{
+    frequency_weighting.create(fft_size, fft_size / 2 + 1, CV_64F);
+    for (int y = 0; y < fft_size; ++y)
+    {
+        for (int x = 0; x < (fft_size / 2 + 1); ++x)
+        {
+            double y2 = fft_size / 2.0 - std::abs(y - fft_size / 2.0);
+            double x2 = fft_size / 2.0 - std::abs(x - fft_size / 2.0);
+            frequency_weighting.at<double>(y, x) = 1 - std::sqrt(x2*x2 + y2 * y2)*std::sqrt(2) / fft_size;
+        }
+    }
+}
+
+// Rw -= coef * W_shifted1 (+ conj(coef) * W_shifted2), the shifted spectra are read from the 2x2 tiled spectrum
+static void
+icvSubtractBasisSpectrum(Mat& Rw, const Mat& W_padded, int fft_size, std::complex<double> coef, int u, int v, int u_cj, int v_cj)
+{
+    const double cr = coef.real(), ci = coef.imag();
+    for (int y = 0; y < Rw.rows; ++y)
+    {
+        double* rw = Rw.ptr<double>(y);
+        const double* w1 = W_padded.ptr<double>(fft_size - u + y) + 2 * (fft_size - v);
+        if (u_cj != -1 && v_cj != -1)
+        {
+            const double* w2 = W_padded.ptr<double>(fft_size - u_cj + y) + 2 * (fft_size - v_cj);
+            for (int x = 0; x < 2 * Rw.cols; x += 2)
+            {
+                double re = (cr*w1[x] - ci*w1[x + 1]) + (cr*w2[x] + ci*w2[x + 1]);
+                double im = (ci*w1[x] + cr*w1[x + 1]) + (-ci*w2[x] + cr*w2[x + 1]);
+                rw[x] -= re;
+                rw[x + 1] -= im;
+            }
+        }
+        else
+        {
+            for (int x = 0; x < 2 * Rw.cols; x += 2)
+            {
+                rw[x] -= cr*w1[x] - ci*w1[x + 1];
+                rw[x + 1] -= ci*w1[x] + cr*w1[x + 1];
+            }
+        }
+    }
+}
+
 static void
-icvExtrapolateBlock(Mat& distorted_block, Mat& error_mask, fsr_parameters& fsr_params, double rho, double normedStdDev, Mat& extrapolated_block)
+icvExtrapolateBlock(const Mat& distorted_block, const Mat& error_mask, const fsr_parameters& fsr_params, double rho, double normedStdDev,
+                    const Mat& frequency_weighting, fsr_scratch& scratch, Mat& extrapolated_block)
 {
     double fft_size = fsr_params.fft_size;
+    const int fft = fsr_params.fft_size;
     double orthogonality_correction = fsr_params.orthogonality_correction;
     int M = distorted_block.rows;
     int N = distorted_block.cols;
@@ -103,7 +160,9 @@ icvExtrapolateBlock(Mat& distorted_block, Mat& error_mask, fsr_parameters& fsr_p
     int fft_y_offset = cvFloor((fft_size - M) / 2);
 
     // weighting function
-    Mat w = Mat::zeros(fsr_params.fft_size, fsr_params.fft_size, CV_64F);
+    Mat& w = scratch.w;
+    w.create(fft, fft, CV_64F);
+    w.setTo(Scalar::all(0));
     error_mask.copyTo(w(Range(fft_y_offset, fft_y_offset + M), Range(fft_x_offset, fft_x_offset + N)));
     for (int u = 0; u < fft_size; ++u)
     {
@@ -112,34 +171,30 @@ icvExtrapolateBlock(Mat& distorted_block, Mat& error_mask, fsr_parameters& fsr_p
             w.at<double>(u, v) *= std::pow(rho, std::sqrt(std::pow(u + 0.5 - (fft_y_offset + M / 2), 2) + std::pow(v + 0.5 - (fft_x_offset + N / 2), 2)));
         }
     }
-    Mat W;
+    Mat& W = scratch.W;
     dft(w, W, DFT_COMPLEX_OUTPUT);
-    Mat W_padded;
-    hconcat(W, W, W_padded);
-    vconcat(W_padded, W_padded, W_padded);
+    Mat& W_padded = scratch.W_padded;
+    W_padded.create(2 * fft, 2 * fft, CV_64FC2);
+    W.copyTo(W_padded(Rect(0, 0, fft, fft)));
+    W.copyTo(W_padded(Rect(fft, 0, fft, fft)));
+    W.copyTo(W_padded(Rect(0, fft, fft, fft)));
+    W.copyTo(W_padded(Rect(fft, fft, fft, fft)));
 
-    // frequency weighting
-    Mat frequency_weighting = Mat::ones(fsr_params.fft_size, fsr_params.fft_size / 2 + 1, CV_64F);
-    for (int y = 0; y < fft_size; ++y)
-    {
-        for (int x = 0; x < (fft_size / 2 + 1); ++x)
-        {
-            double y2 = fft_size / 2 - std::abs(y - fft_size / 2);
-            double x2 = fft_size / 2 - std::abs(x - fft_size / 2);
-            frequency_weighting.at<double>(y, x) = 1 - std::sqrt(x2*x2 + y2 * y2)*std::sqrt(2) / fft_size;
-        }
-    }
     // pad image to fft window size
-    Mat f(Size(fsr_params.fft_size, fsr_params.fft_size), CV_64F, Scalar::all(0));
+    Mat& f = scratch.f;
+    f.create(fft, fft, CV_64F);
+    f.setTo(Scalar::all(0));
     distorted_block.copyTo(f(Range(fft_y_offset, fft_y_offset + M), Range(fft_x_offset, fft_x_offset + N)));
 
     // create initial model
-    Mat G = Mat::zeros(fsr_params.fft_size, fsr_params.fft_size, CV_64FC2); // complex
+    Mat& G = scratch.G; // complex
+    G.create(fft, fft, CV_64FC2);
+    G.setTo(Scalar::all(0));
 
     // calculate initial residual
-    Mat Rw_tmp, Rw;
-    dft(f.mul(w), Rw_tmp, DFT_COMPLEX_OUTPUT);
-    Rw = Rw_tmp(Range(0, fsr_params.fft_size), Range(0, fsr_params.fft_size / 2 + 1));
+    multiply(f, w, scratch.fw);
+    dft(scratch.fw, scratch.Rw_full, DFT_COMPLEX_OUTPUT);
+    Mat Rw = scratch.Rw_full(Range(0, fft), Range(0, fft / 2 + 1));
 
     // estimate ideal number of iterations (GenserIWSSIP2017)
     // calculate stddev if not available (e.g., for smallest block size)
@@ -154,15 +209,14 @@ icvExtrapolateBlock(Mat& distorted_block, Mat& error_mask, fsr_parameters& fsr_p
         num_iters = fsr_params.max_iter;
     }
 
+    Mat& projection_distances = scratch.projection_distances;
+    std::vector<Mat>& channels = scratch.Rw_channels;
     int iter_counter = 0;
     while (iter_counter < num_iters)
     { // Spectral Constrained FSE (GenserIWSSIP2018)
-        Mat projection_distances(Rw.size(), CV_64F);
-        Mat Rw_mag = Mat(Rw.size(), CV_64F);
-        std::vector<Mat> channels(2);
         split(Rw, channels);
-        magnitude(channels[0], channels[1], Rw_mag);
-        projection_distances = Rw_mag.mul(frequency_weighting);
+        magnitude(channels[0], channels[1], scratch.Rw_mag);
+        multiply(scratch.Rw_mag, frequency_weighting, projection_distances);
 
         double minVal, maxVal;
         int maxLocx = -1;
@@ -171,9 +225,10 @@ icvExtrapolateBlock(Mat& distorted_block, Mat& error_mask, fsr_parameters& fsr_p
 
         for (int y = 0; y < projection_distances.rows; ++y)
         { // assure that first appearance of max Value is selected
+            const double* row = projection_distances.ptr<double>(y);
             for (int x = 0; x < projection_distances.cols; ++x)
             {
-                if (std::abs(projection_distances.at<double>(y, x) - maxVal) < 0.001)
+                if (std::abs(row[x] - maxVal) < 0.001)
                 {
                     maxLocy = y;
                     maxLocx = x;
@@ -239,52 +294,30 @@ icvExtrapolateBlock(Mat& distorted_block, Mat& error_mask, fsr_parameters& fsr_p
         }
 
         /// add coef to model and update residual
+        std::complex< double> expansion_coefficient = orthogonality_correction * Rw.at< std::complex<double> >(u, v) / W.at<std::complex<double> >(0, 0);
+        G.at< std::complex<double> >(u, v) += fft_size * fft_size * expansion_coefficient;
         if (u_cj != -1 && v_cj != -1)
         {
-            std::complex< double> expansion_coefficient = orthogonality_correction * Rw.at< std::complex<double> >(u, v) / W.at<std::complex<double> >(0, 0);
-            G.at< std::complex<double> >(u, v) += fft_size * fft_size * expansion_coefficient;
             G.at< std::complex<double> >(u_cj, v_cj) = std::conj(G.at< std::complex<double> >(u, v));
-
-            Mat expansion_mat(Rw.size(), CV_64FC2, Scalar(expansion_coefficient.real(), expansion_coefficient.imag()));
-            Mat W_tmp1 = W_padded(Range(fsr_params.fft_size - u, fsr_params.fft_size - u + Rw.rows), Range(fsr_params.fft_size - v, fsr_params.fft_size - v + Rw.cols));
-            Mat W_tmp2 = W_padded(Range(fsr_params.fft_size - u_cj, fsr_params.fft_size - u_cj + Rw.rows), Range(fsr_params.fft_size - v_cj, fsr_params.fft_size - v_cj + Rw.cols));
-            Mat res_1(W_tmp1.size(), W_tmp1.type());
-            mulSpectrums(expansion_mat, W_tmp1, res_1, 0);
-            expansion_mat.setTo(Scalar(expansion_coefficient.real(), -expansion_coefficient.imag()));
-            Mat res_2(W_tmp1.size(), W_tmp1.type());
-            mulSpectrums(expansion_mat, W_tmp2, res_2, 0);
-            Rw -= res_1 + res_2;
-
             ++iter_counter; // ... as two basis functions were added
         }
-        else
-        {
-            std::complex<double> expansion_coefficient = orthogonality_correction * Rw.at< std::complex<double> >(u, v) / W.at< std::complex<double> >(0, 0);
-            G.at< std::complex<double> >(u, v) += fft_size * fft_size * expansion_coefficient;
-            Mat expansion_mat(Rw.size(), CV_64FC2, Scalar(expansion_coefficient.real(), expansion_coefficient.imag()));
-            Mat W_tmp = W_padded(Range(fsr_params.fft_size - u, fsr_params.fft_size - u + Rw.rows), Range(fsr_params.fft_size - v, fsr_params.fft_size - v + Rw.cols));
-            Mat res_tmp(W_tmp.size(), W_tmp.type());
-            mulSpectrums(expansion_mat, W_tmp, res_tmp, 0);
-            Rw -= res_tmp;
-
-        }
+        icvSubtractBasisSpectrum(Rw, W_padded, fft, expansion_coefficient, u, v, u_cj, v_cj);
         ++iter_counter;
     }
 
     // get pixels from model
-    Mat g;
+    Mat& g = scratch.g;
     idft(G, g, DFT_SCALE);
 
     // extract reconstructed pixels
-    Mat g_real(M, N, CV_64F);
+    extrapolated_block.create(M, N, CV_64F);
     for (int x = 0; x < M; ++x)
     {
         for (int y = 0; y < N; ++y)
         {
-            g_real.at<double>(x, y) = g.at< std::complex<double> >(fft_y_offset + x, fft_x_offset + y).real();
+            extrapolated_block.at<double>(x, y) = g.at< std::complex<double> >(fft_y_offset + x, fft_x_offset + y).real();
         }
     }
-    g_real.copyTo(extrapolated_block);
     Mat orig_samples;
     error_mask.convertTo(orig_samples, CV_8U);
     distorted_block.copyTo(extrapolated_block, orig_samples); // copy where orig_samples is nonzero
@@ -406,6 +439,10 @@ icvDetermineProcessingOrder(
 
     double threshold_stddev = threshold_stddev_LUT[0];
 
+    Mat frequency_weighting;
+    icvFrequencyWeighting(fft_size, frequency_weighting);
+    TLSData<fsr_scratch> scratch_tls;
+
     std::vector< std::tuple< int, int > > set_later;
     int img_height = sampled_img.rows;
     int img_width = sampled_img.cols;
@@ -439,6 +476,7 @@ icvDetermineProcessingOrder(
         Mat proc_array = Mat::zeros(blocks_per_column, blocks_per_line, CV_64F);
         Mat sigma_n_array = Mat::zeros(blocks_per_column, blocks_per_line, CV_64F);
         Mat set_process_this_block_size = Mat::zeros(blocks_per_column, blocks_per_line, CV_64F);
+        Mat level_map(blocks_per_column, blocks_per_line, CV_32S);
         if (block_size > block_size_min)
         {
             if (block_size < block_size_max)
@@ -651,35 +689,80 @@ icvDetermineProcessingOrder(
                 all_blocks_finished = 1;
             }
             // blockwise extrapolation of all blocks that can be processed in parallel
+            // the blocks of the list are not neighbours, but the extrapolation area of a block can still reach into the
+            // core of another block of the list. Such pairs keep their list order by going to successive levels, the
+            // blocks of a level are independent and the result is the same as extrapolating the list sequentially.
+            std::vector< std::vector<int> > levels;
+            level_map.setTo(Scalar::all(-1));
+            const int reach = border_width / block_size + 1;
             for (bl_counter = 0; bl_counter < max_bl_counter; ++bl_counter)
             {
                 int yblock_counter = std::get<0>(block_list[bl_counter]);
                 int xblock_counter = std::get<1>(block_list[bl_counter]);
+                Rect area(xblock_counter*block_size - border_width, yblock_counter*block_size - border_width, block_size + 2 * border_width, block_size + 2 * border_width);
+                int level = 0;
+                for (int y = std::max(0, yblock_counter - reach); y <= std::min(blocks_per_column - 1, yblock_counter + reach); ++y)
+                {
+                    for (int x = std::max(0, xblock_counter - reach); x <= std::min(blocks_per_line - 1, xblock_counter + reach); ++x)
+                    {
+                        int other_level = level_map.at<int>(y, x);
+                        if (other_level >= level && (area & Rect(x*block_size, y*block_size, block_size, block_size)).area() > 0)
+                        {
+                            level = other_level + 1;
+                        }
+                    }
+                }
+                level_map.at<int>(yblock_counter, xblock_counter) = level;
+                if (level >= (int)levels.size())
+                {
+                    levels.resize(level + 1);
+                }
+                levels[level].push_back(bl_counter);
+            }
 
-                // calculation of the extrapolation area's borders
-                int left_border = std::min(xblock_counter*block_size, border_width);
-                int top_border = std::min(yblock_counter*block_size, border_width);
-                int right_border = std::max(0, std::min(img_width - (xblock_counter + 1)*block_size, border_width));
-                int bottom_border = std::max(0, std::min(img_height - (yblock_counter + 1)*block_size, border_width));
-
-                // extract blocks from images
-                Mat distorted_block_2d = reconstructed_img(Range(yblock_counter*block_size - top_border, std::min(img_height, (yblock_counter*block_size + block_size + bottom_border))), Range(xblock_counter*block_size - left_border, std::min(img_width, (xblock_counter*block_size + block_size + right_border))));
-                Mat error_mask_2d = sampling_mask(Range(yblock_counter*block_size - top_border, std::min(img_height, (yblock_counter*block_size + block_size + bottom_border))), Range(xblock_counter*block_size - left_border, std::min(img_width, xblock_counter*block_size + block_size + right_border)));
-                // get actual stddev value as it is needed to estimate the
-                // best number of iterations
-                double sigma_n_a = sigma_n_array.at<double>(yblock_counter, xblock_counter);
-
-                // actual extrapolation
-                Mat extrapolated_block_2d;
-                icvExtrapolateBlock(distorted_block_2d, error_mask_2d, fsr_params, rho, sigma_n_a, extrapolated_block_2d);
-
-                // update image and mask
-                extrapolated_block_2d(Range(top_border, extrapolated_block_2d.rows - bottom_border), Range(left_border, extrapolated_block_2d.cols - right_border)).copyTo(reconstructed_img(Range(yblock_counter*block_size, std::min(img_height, (yblock_counter + 1)*block_size)), Range(xblock_counter*block_size, std::min(img_width, (xblock_counter + 1)*block_size))));
-
-                Mat signs;
-                icvSgnMat(error_mask_2d(Range(top_border, error_mask_2d.rows - bottom_border), Range(left_border, error_mask_2d.cols - right_border)), signs);
-                Mat tmp_mask = error_mask_2d(Range(top_border, error_mask_2d.rows - bottom_border), Range(left_border, error_mask_2d.cols - right_border)) + (1 - signs) *conc_weighting;
-                tmp_mask.copyTo(sampling_mask(Range(yblock_counter*block_size, std::min(img_height, (yblock_counter + 1)*block_size)), Range(xblock_counter*block_size, std::min(img_width, (xblock_counter + 1)*block_size))));
+            for (size_t level = 0; level < levels.size(); ++level)
+            {
+                const std::vector<int>& level_blocks = levels[level];
+                parallel_for_(Range(0, (int)level_blocks.size()), [&](const Range& range)
+                {
+                    fsr_scratch& scratch = *scratch_tls.get();
+                    for (int i = range.start; i < range.end; ++i)
+                    {
+                        int yblock_counter = std::get<0>(block_list[level_blocks[i]]);
+                        int xblock_counter = std::get<1>(block_list[level_blocks[i]]);
+
+                        // calculation of the extrapolation area's borders
+                        int left_border = std::min(xblock_counter*block_size, border_width);
+                        int top_border = std::min(yblock_counter*block_size, border_width);
+                        int right_border = std::max(0, std::min(img_width - (xblock_counter + 1)*block_size, border_width));
+                        int bottom_border = std::max(0, std::min(img_height - (yblock_counter + 1)*block_size, border_width));
+
+                        // extract blocks from images
+                        Mat distorted_block_2d = reconstructed_img(Range(yblock_counter*block_size - top_border, std::min(img_height, (yblock_counter*block_size + block_size + bottom_border))), Range(xblock_counter*block_size - left_border, std::min(img_width, (xblock_counter*block_size + block_size + right_border))));
+                        Mat error_mask_2d = sampling_mask(Range(yblock_counter*block_size - top_border, std::min(img_height, (yblock_counter*block_size + block_size + bottom_border))), Range(xblock_counter*block_size - left_border, std::min(img_width, xblock_counter*block_size + block_size + right_border)));
+                        // get actual stddev value as it is needed to estimate the
+                        // best number of iterations
+                        double sigma_n_a = sigma_n_array.at<double>(yblock_counter, xblock_counter);
+
+                        // actual extrapolation
+                        Mat extrapolated_block_2d;
+                        icvExtrapolateBlock(distorted_block_2d, error_mask_2d, fsr_params, rho, sigma_n_a, frequency_weighting, scratch, extrapolated_block_2d);
+
+                        // update image and mask
+                        extrapolated_block_2d(Range(top_border, extrapolated_block_2d.rows - bottom_border), Range(left_border, extrapolated_block_2d.cols - right_border)).copyTo(reconstructed_img(Range(yblock_counter*block_size, std::min(img_height, (yblock_counter + 1)*block_size)), Range(xblock_counter*block_size, std::min(img_width, (xblock_counter + 1)*block_size))));
+
+                        Mat signs;
+                        icvSgnMat(error_mask_2d(Range(top_border, error_mask_2d.rows - bottom_border), Range(left_border, error_mask_2d.cols - right_border)), signs);
+                        Mat tmp_mask = error_mask_2d(Range(top_border, error_mask_2d.rows - bottom_border), Range(left_border, error_mask_2d.cols - right_border)) + (1 - signs) *conc_weighting;
+                        tmp_mask.copyTo(sampling_mask(Range(yblock_counter*block_size, std::min(img_height, (yblock_counter + 1)*block_size)), Range(xblock_counter*block_size, std::min(img_width, (xblock_counter + 1)*block_size))));
+                    }
+                });
+            }
+
+            for (bl_counter = 0; bl_counter < max_bl_counter; ++bl_counter)
+            {
+                int yblock_counter = std::get<0>(block_list[bl_counter]);
+                int xblock_counter = std::get<1>(block_list[bl_counter]);
 
                 // update nen-array
                 nen_array.at<double>(yblock_counter, xblock_counter) = -1;
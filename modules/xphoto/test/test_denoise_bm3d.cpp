@@ -157,6 +157,37 @@ namespace opencv_test { namespace {
         ASSERT_LT(cvtest::norm(result, expected, cv::NORM_L2), 200);
     }
 
+    TEST(xphoto_DenoisingBm3dGrayscale, regression_L2_tiled)
+    {
+        std::string folder = std::string(cvtest::TS::ptr()->get_data_path()) + "cv/xphoto/bm3d_image_denoising/";
+        std::string original_path = folder + "lena_noised_gaussian_sigma=10.png";
+        std::string expected_path = folder + "lena_noised_denoised_bm3d_wiener_grayscale_l2_tw=4_sw=16_h=10_bm=400.png";
+
+        cv::Mat original = cv::imread(original_path, cv::IMREAD_GRAYSCALE);
+        cv::Mat expected = cv::imread(expected_path, cv::IMREAD_GRAYSCALE);
+
+        ASSERT_FALSE(original.empty()) << "Could not load input image " << original_path;
+        ASSERT_FALSE(expected.empty()) << "Could not load reference image " << expected_path;
+
+        // Large enough to be processed in tiles. The tile border crosses the last copy of the image.
+        cv::Mat large;
+        cv::repeat(original, 3, 3, large);
+        large = large(cv::Rect(256, 256, 1280, 1280)).clone();
+
+        cv::Mat result;
+        cv::xphoto::bm3dDenoising(large, result, 10, 4, 16, 2500, 400, 8, 1, 0.0f, cv::NORM_L2, cv::xphoto::BM3D_STEPALL);
+        ASSERT_EQ(large.size(), result.size());
+
+        // Skip the pixels whose neighbourhood differs from the reference because of the repetition
+        const int border = 16;
+        cv::Rect inner(border, border, original.cols - border, original.rows - border);
+        cv::Mat resultCopy = result(cv::Rect(768, 768, original.cols, original.rows));
+
+        DUMP(result, expected_path + ".res.tiled.png");
+
+        ASSERT_LT(cvtest::norm(resultCopy(inner), expected(inner), cv::NORM_L2), 200);
+    }
+
 #ifdef TEST_TRANSFORMS
 
     TEST(xphoto_DenoisingBm3dKaiserWindow, regression_4)
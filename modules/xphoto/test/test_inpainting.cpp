@@ -51,6 +51,11 @@ TEST(xphoto_inpaint, smoke_FSR_BEST)  // fast smoke test, input doesn't fit well
     test_inpainting(Size(128, 128), INPAINT_FSR_BEST, 30);
 }
 
+TEST(xphoto_inpaint, smoke_SHIFTMAP)  // fast smoke test, input doesn't fit well for tested algorithm
+{
+    test_inpainting(Size(128, 128), INPAINT_SHIFTMAP, 25);
+}
+
 TEST(xphoto_inpaint, smoke_grayscale_FSR_FAST)  // fast smoke test, input doesn't fit well for tested algorithm
 {
     test_inpainting(Size(128, 128), INPAINT_FSR_FAST, 30, IMREAD_GRAYSCALE);
@@ -70,6 +75,11 @@ TEST(xphoto_inpaint, regression_FSR_BEST)
     applyTestTag(CV_TEST_TAG_VERYLONG);  // add --test_tag_enable=verylong to run this test
     test_inpainting(Size(512, 512), INPAINT_FSR_BEST, 39.6);
 }
+TEST(xphoto_inpaint, regression_SHIFTMAP)
+{
+    applyTestTag(CV_TEST_TAG_LONG);
+    test_inpainting(Size(512, 512), INPAINT_SHIFTMAP, 30);
+}
 
 
 }} // namespace